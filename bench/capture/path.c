@@ -0,0 +1,342 @@
+/*
+ * Host harness for the firmware's capture path (main/capture.h).
+ *
+ *   cc -O2 -I main bench/capture/path.c main/deauth.c main/hopstat.c \
+ *       main/classify.c main/macfilt.c -o path
+ *   ./path FRAMES REPEAT
+ *
+ * Builds every variant in CAP_VARIANTS, as sniffer.c does, and feeds
+ * generated traffic through them for a set of configurations. Each
+ * configuration is replayed through the variant the firmware would pick and
+ * through the generic one, calling them through a pointer as the driver
+ * does. The first configuration is the firmware's default after boot. Hops switch as the scan task switches them, and a third of the
+ * frames in the 2 ms after a switch still carry the previous channel.
+ * Around t = 2 s one station floods deauth frames.
+ *
+ * The clock is the replay's, not a timer, so both runs see the same times;
+ * on the device the specialized variants also skip the esp_timer read. One
+ * JSON line is printed per configuration, with the best of REPEAT passes:
+ *
+ *   {"config", "variant", "frames", "forwarded", "bytes", "anomalies",
+ *    "same", "ns_specialized", "ns_generic"}
+ *
+ * "same" is whether both runs forwarded the same frames, truncated alike,
+ * and raised the same anomalies.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sched.h"
+#include "deauth.h"
+#include "hopstat.h"
+#include "classify.h"
+#include "macfilt.h"
+
+/* what the firmware keeps in sniffer.c */
+static bool               scanning = true;
+static deauth_det_t       deauth_det;
+static hopstat_t          hop_stats;
+static hopstat_guard_t    hop_guard;
+static uint32_t           hop_switched_us;
+static const sched_hop_t *cur_hop;
+static const sched_hop_t *prev_hop;
+static clf_t             *clf;
+static bool               clf_on = false;
+static macfilt_t          mac_filter;
+
+/* what the output would have sent */
+typedef struct {
+    uint32_t forwarded;
+    uint64_t bytes;
+    uint32_t anomalies;
+    uint32_t detections;
+    uint64_t digest;
+} sink_t;
+
+static sink_t   sink;
+static uint32_t clock_us;
+static const void *frames_base;
+
+static void digest(uint64_t v)
+{
+    sink.digest = (sink.digest ^ v) * 0x100000001b3ull;   /* FNV-1a, by word */
+}
+
+static void sink_frame(uint32_t index, uint16_t len, uint16_t snaplen)
+{
+    uint16_t cap = snaplen && snaplen < len ? snaplen : len;
+    sink.forwarded++;
+    sink.bytes += cap;
+    digest(((uint64_t)index << 16) | cap);
+}
+
+static void sink_anomaly(uint32_t timestamp, uint8_t flags)
+{
+    sink.anomalies++;
+    digest(((uint64_t)1 << 63) | ((uint64_t)flags << 32) | timestamp);
+}
+
+#define CAP_LOCK(name)      ((void)0)
+#define CAP_UNLOCK(name)    ((void)0)
+#define CAP_NOW_US()        clock_us
+#define CAP_NOW_MS()        (clock_us / 1000)
+#define CAP_SEND_FRAME(f, snaplen) \
+    sink_frame((uint32_t)((f) - (const cap_frame_t *)frames_base), (f)->len, (snaplen))
+#define CAP_SEND_ANOMALY(report, timestamp) \
+    sink_anomaly((timestamp), (report)->flags)
+#define CAP_SEND_DETECTION(f, label, x, confidence, suppressed) \
+    (sink.detections++, digest(((uint64_t)(label) << 8) | (confidence)))
+
+#include "capture.h"
+
+typedef void (*capture_cb_t)(const cap_frame_t *f);
+
+#define CAP_DEFINE(name, feats) \
+    static void capture_##name(const cap_frame_t *f) { cap_run(f, (feats)); }
+CAP_VARIANTS(CAP_DEFINE)
+
+#define CAP_NAME(name, feats)   #name,
+#define CAP_FEATS(name, feats)  (feats),
+#define CAP_CB(name, feats)     capture_##name,
+static const char *const capture_names[] = { CAP_VARIANTS(CAP_NAME) };
+static const unsigned capture_feats[] = { CAP_VARIANTS(CAP_FEATS) };
+static const capture_cb_t capture_cbs[] = { CAP_VARIANTS(CAP_CB) };
+#define CAP_NUM_VARIANTS    (int)(sizeof(capture_feats) / sizeof(capture_feats[0]))
+
+/* -------- configurations -------- */
+
+typedef struct {
+    const char     *name;
+    const char     *channels;       /* comma separated */
+    uint16_t        dwell_ms;
+    uint8_t         type_mask;      /* per hop, as for SET_SCHEDULE */
+    int8_t          rssi_min;
+    uint16_t        snaplen;
+    int             deauth;         /* threshold, 0 = off, -1 = deauth_init's */
+    uint8_t         guard;          /* HOP_GUARD_* */
+    bool            macfilt;        /* allow a quarter of the stations */
+} config_t;
+
+#define ALL_CHANNELS    "1,2,3,4,5,6,7,8,9,10,11,12,13"
+
+/* the first is what the firmware runs after boot: 1-13 x 2500 ms, app_main's detector */
+static const config_t configs[] = {
+    { "default",                  ALL_CHANNELS, 2500, 0,    SCHED_RSSI_ANY, 0,   -1, HOP_GUARD_OFF,     false },
+    { "single channel",           "6",          100,  0,    SCHED_RSSI_ANY, 0,   0,  HOP_GUARD_OFF,     false },
+    { "single channel, deauth",   "6",          100,  0,    SCHED_RSSI_ANY, 0,   20, HOP_GUARD_OFF,     false },
+    { "all channels",             ALL_CHANNELS, 100,  0,    SCHED_RSSI_ANY, 0,   0,  HOP_GUARD_OFF,     false },
+    { "all channels, deauth",     ALL_CHANNELS, 100,  0,    SCHED_RSSI_ANY, 0,   20, HOP_GUARD_OFF,     false },
+    { "1/6/11 drop guard",        "1,6,11",     100,  0,    SCHED_RSSI_ANY, 0,   20, HOP_GUARD_DROP,    false },
+    { "1/6/11 mgmt, snaplen",     "1,6,11",     100,  0x01, SCHED_RSSI_ANY, 128, 0,  HOP_GUARD_OFF,     false },
+    { "1/6/11 rssi, deauth",      "1,6,11",     100,  0,    -70,            0,   20, HOP_GUARD_RELABEL, false },
+    { "all channels, mac filter", ALL_CHANNELS, 100,  0,    SCHED_RSSI_ANY, 0,   20, HOP_GUARD_OFF,     true },
+};
+#define NUM_CONFIGS (int)(sizeof(configs) / sizeof(configs[0]))
+
+#define SPACING_US      80          /* mean gap between frames */
+#define NUM_PAYLOADS    4096
+#define NUM_STATIONS    64
+#define MAX_FRAME       400
+
+static sched_hop_t hops[SCHED_MAX_HOPS];
+static int         num_hops;
+
+static int parse_config(const config_t *c)
+{
+    const char *s = c->channels;
+    num_hops = 0;
+    while (*s && num_hops < SCHED_MAX_HOPS) {
+        sched_hop_t *h = &hops[num_hops++];
+        memset(h, 0, sizeof(*h));
+        h->channel   = (uint8_t)strtoul(s, (char **)&s, 10);
+        h->dwell_ms  = c->dwell_ms;
+        h->type_mask = c->type_mask;
+        h->snaplen   = c->snaplen;
+        h->rssi_min  = c->rssi_min;
+        if (*s == ',') s++;
+    }
+    return num_hops;
+}
+
+static uint32_t rng = 1;
+
+static uint32_t rand32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint8_t payloads[NUM_PAYLOADS][MAX_FRAME];
+static uint16_t payload_len[NUM_PAYLOADS];
+
+static void station(uint8_t *p, uint32_t i)
+{
+    static const uint8_t oui[3] = { 0x02, 0x11, 0x22 };
+    memcpy(p, oui, 3);
+    p[3] = 0;
+    p[4] = (uint8_t)(i >> 8);
+    p[5] = (uint8_t)i;
+}
+
+/* beacons, probe requests, data, QoS data and acks; the last one is a deauth */
+static void make_payloads(void)
+{
+    static const uint8_t fc0[] = { 0x80, 0x80, 0x40, 0x08, 0x08, 0x88, 0x88, 0xD4 };
+    for (int i = 0; i < NUM_PAYLOADS; i++) {
+        uint8_t *p = payloads[i];
+        uint8_t kind = (i == NUM_PAYLOADS - 1) ? 0xC0 : fc0[rand32() % sizeof(fc0)];
+        uint16_t len = kind == 0xD4 ? 10 : (uint16_t)(24 + rand32() % (MAX_FRAME - 24));
+        if (kind == 0xC0) len = 26;
+        for (int b = 0; b < len; b++) p[b] = (uint8_t)rand32();
+        p[0] = kind;
+        p[1] = 0;
+        station(p + 4, rand32() % NUM_STATIONS);
+        if (len >= 24) {
+            station(p + 10, kind == 0xC0 ? 0 : rand32() % NUM_STATIONS);
+            memcpy(p + 16, p + 10, 6);
+        }
+        payload_len[i] = len;
+    }
+}
+
+static cap_frame_t *frames;
+static int16_t     *switch_to;      /* hop switched to before the frame, or -1 */
+
+static void make_frames(int n)
+{
+    uint32_t t = 0;
+    int hop = -1, prev = -1;
+    uint32_t switched = 0, next_switch = 0;
+    for (int i = 0; i < n; i++) {
+        t += 1 + rand32() % (2 * SPACING_US);
+        switch_to[i] = -1;
+        if (hop < 0 || (num_hops > 1 && t >= next_switch)) {
+            prev = hop;
+            hop = (hop + 1) % num_hops;
+            switched = t;
+            next_switch = t + hops[hop].dwell_ms * 1000u;
+            switch_to[i] = (int16_t)hop;
+        }
+        /* a deauth flood from one station between 2 and 3 s */
+        bool flood = t >= 2000000 && t < 3000000 && rand32() % 4 == 0;
+        int pl = flood ? NUM_PAYLOADS - 1 : (int)(rand32() % (NUM_PAYLOADS - 1));
+        uint8_t ch = hops[hop].channel;
+        if (prev >= 0 && t - switched < 2000 && rand32() % 3 == 0) ch = hops[prev].channel;
+        frames[i] = (cap_frame_t){
+            .payload   = payloads[pl],
+            .len       = payload_len[pl],
+            .channel   = ch,
+            .rssi      = (int8_t)(-30 - (int)(rand32() % 60)),
+            .mgmt      = (payloads[pl][0] & 0x0C) == 0,
+            .timestamp = t,
+        };
+    }
+}
+
+static void reset_state(const config_t *c)
+{
+    deauth_config_t cfg = {
+        .threshold = (uint16_t)c->deauth,
+        .window_ms = 1000,
+        .report_ms = 500,
+        .suppress  = true,
+    };
+    if (c->deauth < 0) deauth_init(&deauth_det);
+    else deauth_configure(&deauth_det, &cfg);
+    hopstat_reset(&hop_stats);
+    hop_guard.guard_us = 1500;
+    hop_guard.mode = c->guard;
+    cur_hop = prev_hop = NULL;
+    memset(&sink, 0, sizeof(sink));
+    sink.digest = 0xcbf29ce484222325ull;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(const config_t *c, capture_cb_t cb, int n, int repeat)
+{
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        reset_state(c);
+        double t0 = now_s();
+        for (int i = 0; i < n; i++) {
+            const cap_frame_t *f = &frames[i];
+            if (switch_to[i] >= 0) {
+                prev_hop = cur_hop;
+                cur_hop = &hops[switch_to[i]];
+                hop_switched_us = f->timestamp;
+            }
+            clock_us = f->timestamp;
+            cb(f);
+        }
+        double dt = now_s() - t0;
+        if (dt < best) best = dt;
+    }
+    return best * 1e9 / n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s FRAMES REPEAT\n", argv[0]);
+        return 2;
+    }
+    int n = atoi(argv[1]);
+    int repeat = atoi(argv[2]);
+    if (n < 1 || repeat < 1) return 2;
+
+    frames = malloc((size_t)n * sizeof(*frames));
+    switch_to = malloc((size_t)n * sizeof(*switch_to));
+    if (!frames || !switch_to) return 1;
+    frames_base = frames;
+    make_payloads();
+
+    for (int k = 0; k < NUM_CONFIGS; k++) {
+        const config_t *c = &configs[k];
+        parse_config(c);
+        make_frames(n);
+
+        macfilt_free(&mac_filter);
+        if (c->macfilt) {
+            /* stations 0..15, as a BULK_KIND_MAC_FILTER blob would list them */
+            uint8_t blob[2 + 16 * 6];
+            blob[0] = MACFILT_ALLOW;
+            blob[1] = 16;
+            for (int i = 0; i < 16; i++) station(blob + 2 + i * 6, (uint32_t)i);
+            if (!macfilt_parse(blob, sizeof(blob), &mac_filter)) return 1;
+        }
+
+        /* as capture_install picks it */
+        reset_state(c);
+        unsigned needed = cap_sched_features(hops, num_hops);
+        if (deauth_det.cfg.threshold) needed |= CAP_DEAUTH;
+        if (clf_on) needed |= CAP_CLF;
+        if (mac_filter.mode != MACFILT_OFF) needed |= CAP_MACFILT;
+        int v = cap_pick(capture_feats, CAP_NUM_VARIANTS, needed);
+
+        double ns_spec = run(c, capture_cbs[v], n, repeat);
+        sink_t spec = sink;
+        double ns_gen = run(c, capture_cbs[CAP_NUM_VARIANTS - 1], n, repeat);
+        bool same = spec.forwarded == sink.forwarded && spec.bytes == sink.bytes &&
+                    spec.anomalies == sink.anomalies && spec.digest == sink.digest;
+
+        printf("{\"config\": \"%s\", \"variant\": \"%s\", \"frames\": %d, \"forwarded\": %u, "
+               "\"bytes\": %llu, \"anomalies\": %u, \"same\": %s, "
+               "\"ns_specialized\": %.2f, \"ns_generic\": %.2f}\n",
+               c->name, capture_names[v], n, spec.forwarded, (unsigned long long)spec.bytes,
+               spec.anomalies, same ? "true" : "false", ns_spec, ns_gen);
+    }
+    free(frames);
+    free(switch_to);
+    return 0;
+}
@@ -0,0 +1,372 @@
+#!/usr/bin/env python3
+"""Train beacon classifiers, then score held-out traffic with the firmware's code.
+
+    python3 bench/classify/run.py [--seconds 10] [--aps 40] [--repeat 5]
+    python3 bench/classify/run.py --train a.pcapng --test b.pcapng --targets @targets.txt
+
+Trains a decision tree and a logistic model with lib/py ``classify`` on one
+capture, then scores another with main/classify.c in a host build
+(bench/classify/score.c, built with $CC), after passing each model through
+the firmware's bulk transfer as a BULK_KIND_CLASSIFIER upload. Without captures, both are
+synthetic. Several device families beacon with their own element layout,
+rates, HT capabilities and vendor elements, and the target family shares
+its chipset's vendor element with a decoy. Half of the targets have
+renamed SSIDs and half use random (locally administered) addresses, so
+SSID and OUI rules miss them. Train and test use different devices.
+
+Checks that the firmware scores every frame exactly as ``Model.score``
+does, and that its hold-off decisions match a replay of the table (which
+lets a transmitter through early only when its set is full). Prints per-beacon precision and recall, and the share of target
+transmitters detected, for the models and for SSID and OUI rules (on
+synthetic traffic only), with the firmware's time per frame. Exits
+non-zero on a failed check.
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+from typing import Callable, Dict, List, Set, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+sys.path.insert(0, ROOT)
+
+from lib.py.classify import Model, extract, train_logistic, train_tree  # noqa: E402
+from lib.py.mac import mac_from_bytes  # noqa: E402
+
+REC_HDR = struct.Struct("<IH")  # time_ms, len; then the frame
+RESULT = struct.Struct("<BBBxH")  # scored, confidence, reported, suppressed
+
+Record = Tuple[int, bytes]  # time_ms, frame
+
+TARGET_OUI = 0xB4E3F9
+TARGET_SSID = "Flock-"
+
+
+def ie(eid: int, data: bytes) -> bytes:
+    return bytes([eid, len(data)]) + data
+
+
+def vendor(oui: int, rest: bytes) -> bytes:
+    return ie(221, oui.to_bytes(3, "big") + rest)
+
+
+RATES_B = bytes([0x82, 0x84, 0x8B, 0x96, 0x0C, 0x12, 0x18, 0x24])
+RATES_G = bytes([0x82, 0x84, 0x8B, 0x96, 0x24, 0x30, 0x48, 0x6C])
+EXT_RATES = bytes([0x30, 0x48, 0x60, 0x6C])
+RSN = bytes.fromhex("0100000fac040100000fac040100000fac020000")
+WMM = bytes.fromhex("0050f2020101000003a4000027a4000042435e0062322f00")
+
+
+def ht_cap(info: int) -> bytes:
+    return ie(45, info.to_bytes(2, "little") + bytes(24))
+
+
+# family: (name, target, oui, interval, element builder(rnd, ssid, ch, variant) -> (elements, rsn),
+#          capability bits each AP sets with some probability)
+def _target(rnd, ssid, ch, v):
+    rsn = rnd.random() < 0.7
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00") + ie(42, b"\x04")
+    out += ie(50, EXT_RATES) + ht_cap((0x01AD, 0x01AC, 0x19EC)[v]) + ie(61, bytes(22))
+    if v == 1:
+        out += ie(127, bytes(8))
+    if rsn:
+        out += ie(48, RSN)
+    return out + vendor(0x00E04C, b"\x02\x00\x00") + ie(221, WMM), rsn
+
+
+def _realtek_camera(rnd, ssid, ch, v):
+    # same chipset and SDK as the targets, another maker's firmware
+    rsn = rnd.random() < 0.7
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(50, EXT_RATES) + ht_cap((0x01AD, 0x19EC, 0x01AC)[v]) + ie(61, bytes(22))
+    if rsn:
+        out += ie(48, RSN)
+    if v == 2:
+        out += ie(127, bytes(8))
+    return out + vendor(0x00E04C, b"\x02\x00\x00") + ie(221, WMM), rsn
+
+
+def _realtek_router(rnd, ssid, ch, v):
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(7, b"US\x20\x01\x0b\x1e") + ie(42, b"\x00") + ie(50, EXT_RATES) + ie(48, RSN)
+    out += ht_cap((0x19EC, 0x01AD, 0x01AC)[v]) + ie(61, bytes(22))
+    if rnd.random() < 0.6:
+        out += vendor(0x0050F2, b"\x04" + bytes(12))
+    return out + vendor(0x00E04C, b"\x02\x00\x00") + ie(221, WMM), True
+
+
+def _broadcom_router(rnd, ssid, ch, v):
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(7, b"US\x20\x01\x0b\x1e") + ie(42, b"\x00") + ie(50, EXT_RATES) + ie(48, RSN)
+    out += ht_cap(0x09EF) + ie(61, bytes(22)) + ie(127, bytes(8)) + ie(191, bytes(12))
+    out += vendor(0x001018, b"\x02\x00\x10\x00\x00") + ie(221, WMM)
+    if v:
+        out += vendor(0x0050F2, b"\x04" + bytes(12))
+    return out, True
+
+
+def _phone(rnd, ssid, ch, v):
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(42, b"\x04") + ie(50, EXT_RATES) + ie(48, RSN) + ht_cap(0x006F) + ie(61, bytes(22))
+    out += ie(127, bytes(8 + v)) + vendor(0x0017F2, b"\x0a\x00\x01\x04") + ie(221, WMM)
+    return out, True
+
+
+def _esp(rnd, ssid, ch, v):
+    rsn = rnd.random() < 0.5
+    out = ie(0, ssid) + ie(1, RATES_G) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(7, b"CN\x20\x01\x0d\x14") + ht_cap((0x012C, 0x01AD, 0x012C)[v]) + ie(61, bytes(22))
+    if rsn:
+        out += ie(48, RSN)
+    return out + vendor(0x18FE34, b"\x01\x00") + ie(221, WMM), rsn
+
+
+def _mesh(rnd, ssid, ch, v):
+    out = ie(0, ssid) + ie(1, RATES_B) + ie(3, bytes([ch])) + ie(5, b"\x00\x01\x00\x00")
+    out += ie(7, b"US\x20\x01\x0b\x1e") + ie(48, RSN) + ie(54, b"\x12\x34\x01") + ht_cap(0x09EF)
+    out += ie(61, bytes(22)) + ie(127, bytes(10)) + ie(255, bytes([35]) + bytes(20))
+    return out + vendor(0x00037F, b"\x01\x01\x00\x00") + ie(221, WMM), True
+
+
+CAP_ESS, CAP_PRIVACY, CAP_SHORT_PREAMBLE, CAP_SPECTRUM, CAP_SHORT_SLOT, CAP_RM = (
+    0x0001, 0x0010, 0x0020, 0x0100, 0x0400, 0x1000)
+
+FAMILIES = [
+    ("target", True, TARGET_OUI, 100, _target, {CAP_SHORT_SLOT: 0.9, CAP_SHORT_PREAMBLE: 0.3}),
+    ("realtek-camera", False, 0x00E04C, 100, _realtek_camera, {CAP_SHORT_SLOT: 0.9, CAP_SHORT_PREAMBLE: 0.3}),
+    ("realtek-router", False, 0x00E04C, 100, _realtek_router, {CAP_SHORT_SLOT: 1.0, CAP_SHORT_PREAMBLE: 0.8}),
+    ("broadcom-router", False, 0x001018, 100, _broadcom_router, {CAP_SHORT_SLOT: 1.0, CAP_RM: 0.7}),
+    ("phone-hotspot", False, 0x0017F2, 100, _phone, {CAP_SHORT_SLOT: 1.0, CAP_SHORT_PREAMBLE: 1.0}),
+    ("esp-iot", False, 0x18FE34, 100, _esp, {CAP_SHORT_SLOT: 0.5, CAP_SHORT_PREAMBLE: 0.5}),
+    ("mesh", False, 0x00037F, 200, _mesh, {CAP_SHORT_SLOT: 1.0, CAP_RM: 1.0, CAP_SPECTRUM: 0.5}),
+]
+
+
+def synthesize(seed: int, aps: int, seconds: float) -> Tuple[List[Record], Set[int], Dict[int, str], Set[int]]:
+    """Beacons of `aps` devices per family. Returns records, targets, SSIDs, and
+    the target transmitters an SSID or OUI rule would miss."""
+    rnd = random.Random(seed)
+    records: List[Record] = []
+    targets: Set[int] = set()
+    ssids: Dict[int, str] = {}
+    for name, target, oui, interval, build, cap_odds in FAMILIES:
+        for _ in range(aps):
+            if rnd.random() < 0.5:
+                mac = (rnd.getrandbits(48) & ~(1 << 40)) | (1 << 41)  # random, locally administered
+            else:
+                mac = oui << 24 | rnd.getrandbits(24)
+            renamed = rnd.random() < 0.5
+            if target and not renamed:
+                ssid = f"{TARGET_SSID}{rnd.getrandbits(24):06X}"
+            else:
+                ssid = "".join(rnd.choice("abcdefghijkmnpqrstuvwxyz0123456789-_") for _ in range(rnd.randint(4, 20)))
+            ssids[mac] = ssid
+            if target:
+                targets.add(mac)
+            ch = rnd.choice((1, 6, 11))
+            elems, rsn = build(rnd, ssid.encode(), ch, rnd.randrange(3))
+            caps = CAP_ESS | (CAP_PRIVACY if rsn else 0)
+            for bit, odds in cap_odds.items():
+                caps |= bit if rnd.random() < odds else 0
+            hdr = b"\x80\x00\x00\x00" + b"\xff" * 6 + mac.to_bytes(6, "big") * 2 + b"\x00\x00"
+            t = rnd.random() * interval * 1.024
+            while t < seconds * 1000:
+                fixed = struct.pack("<QHH", int(t * 1000), interval, caps)
+                records.append((int(t), hdr + fixed + elems))
+                t += interval * 1.024
+    # some data frames and probe requests, which are not scored
+    for _ in range(len(records) // 4):
+        t = int(rnd.random() * seconds * 1000)
+        sa = rnd.getrandbits(48).to_bytes(6, "big")
+        if rnd.random() < 0.5:
+            records.append((t, b"\x08\x01\x00\x00" + b"\x00" * 6 + sa + b"\x00" * 6 + b"\x00\x00" + bytes(60)))
+        else:
+            records.append((t, b"\x40\x00\x00\x00" + b"\xff" * 6 + sa + b"\xff" * 6 + b"\x00\x00" + ie(0, b"")))
+    records.sort(key=lambda r: r[0])
+    return records, targets, ssids, {m for m in targets if not ssids[m].startswith(TARGET_SSID)}
+
+
+def read_capture(path: str) -> List[Record]:
+    from lib.py.pcapng import PcapngReader
+
+    with PcapngReader(path) as r:
+        return [(f.timestamp_us // 1000, bytes(f.raw)) for f in r.frames()]
+
+
+def samples(records: List[Record], targets: Set[int]):
+    seen = set()
+    xs, ys = [], []
+    for _, raw in records:
+        x = extract(raw)
+        if x is None:
+            continue
+        key = (raw[10:16], x)
+        if key in seen:
+            continue
+        seen.add(key)
+        xs.append(x)
+        ys.append(mac_from_bytes(raw[10:16]) in targets)
+    return xs, ys
+
+
+def rates(records: List[Record], targets: Set[int], hit: Callable[[int, bytes], bool]) -> Tuple[float, float, float]:
+    """Per-beacon precision and recall, and the share of target transmitters hit at least once."""
+    tp = fp = fn = 0
+    found: Set[int] = set()
+    for i, (_, raw) in enumerate(records):
+        if extract(raw) is None:
+            continue
+        mac = mac_from_bytes(raw[10:16])
+        h = hit(i, raw)
+        y = mac in targets
+        tp += h and y
+        fp += h and not y
+        fn += y and not h
+        if h and y:
+            found.add(mac)
+    return (tp / (tp + fp) if tp + fp else 1.0, tp / (tp + fn) if tp + fn else 1.0,
+            len(found) / len(targets) if targets else 1.0)
+
+
+def check_holdoff(records: List[Record], results: List[Tuple[int, int, int, int]], model: Model) -> List[str]:
+    """Replay the firmware's direct-mapped hold-off table; the reports must match it exactly."""
+    bad: List[str] = []
+    sets: Dict[int, List[List[int]]] = {}  # set -> ways of [hash, last_ms, suppressed]
+    last: Dict[bytes, int] = {}
+    early = 0
+    for (t, raw), (scored, conf, reported, suppressed) in zip(records, results):
+        if not scored or conf < model.threshold:
+            continue
+        mac = raw[10:16]
+        want, held = True, 0
+        if model.holdoff_ms:
+            h = 2166136261
+            for b in mac:
+                h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+            h = h or 1
+            ways = sets.setdefault((h ^ h >> 16) & 63, [[0, 0, 0] for _ in range(4)])
+            slot = next((w for w in ways if w[0] == h), None)
+            if slot is not None and (t - slot[1]) & 0xFFFFFFFF < model.holdoff_ms:
+                slot[2] = min(slot[2] + 1, 0xFFFF)
+                want = False
+            else:
+                if slot is not None:
+                    held = slot[2]
+                else:
+                    empty = [w for w in ways if not w[0]]
+                    slot = empty[0] if empty else max(ways, key=lambda w: (t - w[1]) & 0xFFFFFFFF)
+                    if slot[0] and (t - slot[1]) & 0xFFFFFFFF < model.holdoff_ms:
+                        slot = None  # set full: reported, not tracked
+                if slot is not None:
+                    slot[:] = [h, t, 0]
+        if bool(reported) != want or (want and suppressed != held):
+            bad.append(f"{mac.hex(':')} at {t} ms: reported={reported} suppressed={suppressed}, "
+                       f"expected {int(want)}/{held}")
+        if want:
+            early += model.holdoff_ms and mac in last and t - last[mac] < model.holdoff_ms
+            last[mac] = t
+    if early:
+        print(f"  {early} reports within the hold-off, from full sets")
+    return bad
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/classify/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--train", nargs="+", metavar="PCAPNG", help="Labeled training captures (default: synthetic)")
+    ap.add_argument("--test", nargs="+", metavar="PCAPNG", help="Labeled test captures")
+    ap.add_argument("--targets", help="Target transmitters for the captures: comma-separated or @FILE")
+    ap.add_argument("--aps", type=int, default=40, help="Synthetic devices per family (default: 40)")
+    ap.add_argument("--seconds", type=float, default=10, help="Synthetic beaconing time (default: 10)")
+    ap.add_argument("--repeat", type=int, default=5, help="Timed passes, best kept (default: 5)")
+    args = ap.parse_args()
+
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        print("no C compiler", file=sys.stderr)
+        return 1
+
+    rules = {}
+    if args.train:
+        if not (args.test and args.targets):
+            ap.error("--train needs --test and --targets")
+        from lib.py.classify import _targets
+
+        targets = train_targets = _targets(args.targets)
+        train = [r for p in args.train for r in read_capture(p)]
+        test = [r for p in args.test for r in read_capture(p)]
+        missed: Set[int] = set()
+    else:
+        train, train_targets, _, _ = synthesize(1, args.aps, args.seconds)
+        test, targets, ssids, missed = synthesize(2, args.aps, args.seconds)
+        rules["SSID rule"] = lambda i, raw: ssids.get(mac_from_bytes(raw[10:16]), "").startswith(TARGET_SSID)
+        rules["OUI rule"] = lambda i, raw: mac_from_bytes(raw[10:16]) >> 24 == TARGET_OUI
+
+    xs, ys = samples(train, train_targets)
+    print(f"train: {len(xs)} distinct beacons, {sum(ys)} from targets; "
+          f"test: {len(test)} frames from {len(targets)} targets and others\n")
+    models = {
+        "tree": train_tree(xs, ys, max_depth=6),
+        "logistic": train_logistic(xs, ys, max_terms=24),
+    }
+
+    failed = False
+    print(f"{'model':<10} {'precision':>9} {'recall':>7} {'targets':>8} {'steps':>6} {'bytes':>6} {'ns/frame':>9}  check")
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, "score")
+        main_dir = os.path.join(ROOT, "main")
+        subprocess.run([cc, "-O2", "-I", main_dir, os.path.join(HERE, "score.c"),
+                        os.path.join(main_dir, "classify.c"), os.path.join(main_dir, "bulk.c"), "-o", exe],
+                       check=True)
+        rec_path = os.path.join(tmp, "test.rec")
+        with open(rec_path, "wb") as f:
+            for t, raw in test:
+                f.write(REC_HDR.pack(t & 0xFFFFFFFF, len(raw)) + raw)
+
+        for name, model in models.items():
+            blob = model.to_blob()
+            model_path = os.path.join(tmp, f"{name}.bin")
+            with open(model_path, "wb") as f:
+                f.write(blob)
+            out_path = os.path.join(tmp, "out.bin")
+            res = json.loads(subprocess.run([exe, model_path, rec_path, out_path, str(args.repeat)],
+                                            check=True, capture_output=True, text=True).stdout)
+            with open(out_path, "rb") as f:
+                data = f.read()
+            results = [RESULT.unpack_from(data, i * RESULT.size) for i in range(len(data) // RESULT.size)]
+
+            bad: List[str] = []
+            if len(results) != len(test):
+                bad.append(f"{len(results)} results for {len(test)} frames")
+            for (t, raw), (scored, conf, _, _) in zip(test, results):
+                x = extract(raw)
+                if (x is not None) != bool(scored) or (x is not None and model.score(x) != conf):
+                    bad.append(f"frame at {t} ms: firmware {conf if scored else None}, "
+                               f"host {model.score(x) if x else None}")
+                    break
+            bad += check_holdoff(test, results, model)
+            failed |= bool(bad)
+
+            p, r, share = rates(test, targets, lambda i, raw: results[i][1] >= model.threshold)
+            ns = res["seconds"] / max(1, res["records"]) * 1e9
+            print(f"{name:<10} {p:>9.3f} {r:>7.3f} {share:>8.3f} {model.steps():>6} {len(blob):>6} {ns:>9.1f}"
+                  f"  {'ok' if not bad else 'FAIL'}")
+            for m in bad[:3]:
+                print(f"  {m}")
+
+    for name, rule in rules.items():
+        p, r, share = rates(test, targets, rule)
+        print(f"{name:<10} {p:>9.3f} {r:>7.3f} {share:>8.3f}")
+    if missed:
+        print(f"\n{len(missed)} of {len(targets)} targets have renamed SSIDs")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
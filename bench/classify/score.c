@@ -0,0 +1,161 @@
+/*
+ * Host harness for the firmware's beacon classifier (main/classify.c).
+ *
+ *   cc -O2 -I main bench/classify/score.c main/classify.c main/bulk.c -o score
+ *   ./score MODEL IN OUT [REPEAT]
+ *
+ * MODEL is a blob as uploaded with BULK_KIND_CLASSIFIER. It goes through
+ * the firmware's bulk transfer (main/bulk.c) in 256-byte chunks, as the
+ * clients send it, before clf_parse. IN is a recording
+ * of 802.11 frames, one record each:
+ *
+ *   u32 time_ms, u16 len, u8 frame[len]     (little-endian)
+ *
+ * Each frame goes through clf_extract, clf_score and clf_admit as in the
+ * packet handler, and OUT gets one 6-byte result per record:
+ *
+ *   u8 scored, u8 confidence, u8 reported, u8 0, u16 suppressed
+ *
+ * The pass is timed REPEAT times (best kept) and one JSON line is printed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "classify.h"
+#include "bulk.h"
+
+#define REC_HDR 6
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(n > 0 ? (size_t)n : 1);
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)n;
+    return buf;
+}
+
+/* Pass blob through a BULK_KIND_CLASSIFIER transfer; the committed copy, or NULL. */
+static uint8_t *upload(const uint8_t *blob, size_t len, uint32_t *out_len)
+{
+    bulk_t b = {0};
+    if (bulk_begin(&b, BULK_KIND_CLASSIFIER, (uint32_t)len, bulk_crc32(0, blob, len)) != BULK_OK)
+        return NULL;
+    for (size_t off = 0; off < len; off += 256) {
+        size_t n = len - off < 256 ? len - off : 256;
+        if (bulk_chunk(&b, (uint32_t)off, blob + off, n) != off + n) {
+            bulk_abort(&b);
+            return NULL;
+        }
+    }
+    uint8_t *out = NULL;
+    return bulk_commit(&b, &out, out_len) == BULK_OK ? out : NULL;
+}
+
+typedef struct {
+    uint32_t records, scored, hits, reported;
+} result_t;
+
+/* One pass over the recording; out (if not NULL) receives the results. */
+static result_t run(const uint8_t *rec, size_t rec_len, const clf_model_t *m, FILE *out)
+{
+    static clf_t c;
+    result_t r = {0};
+    clf_configure(&c, m);
+
+    for (size_t pos = 0; pos + REC_HDR <= rec_len;) {
+        uint32_t t;
+        uint16_t len;
+        memcpy(&t, rec + pos, 4);
+        memcpy(&len, rec + pos + 4, 2);
+        const uint8_t *frame = rec + pos + REC_HDR;
+        pos += REC_HDR + len;
+        if (pos > rec_len) break;
+
+        r.records++;
+        uint8_t res[6] = {0};
+        clf_features_t x;
+        if (clf_extract(frame, len, &x)) {
+            uint16_t suppressed = 0;
+            uint8_t conf = clf_score(&c.model, &x);
+            bool report = conf >= c.model.threshold && clf_admit(&c, frame + 10, t, &suppressed);
+            r.scored++;
+            r.hits += conf >= c.model.threshold;
+            r.reported += report;
+            res[0] = 1;
+            res[1] = conf;
+            res[2] = report;
+            memcpy(res + 4, &suppressed, 2);
+        }
+        if (out) fwrite(res, 1, sizeof(res), out);
+    }
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s MODEL IN OUT [REPEAT]\n", argv[0]);
+        return 2;
+    }
+    size_t blob_len, rec_len;
+    uint8_t *blob = read_file(argv[1], &blob_len);
+    uint8_t *rec = read_file(argv[2], &rec_len);
+    if (!blob || !rec) {
+        perror(!blob ? argv[1] : argv[2]);
+        return 1;
+    }
+    uint32_t up_len;
+    uint8_t *up = upload(blob, blob_len, &up_len);
+    if (!up) {
+        fprintf(stderr, "%s: bulk transfer refused\n", argv[1]);
+        return 1;
+    }
+    static clf_model_t m;
+    if (!clf_parse(up, up_len, &m)) {
+        fprintf(stderr, "%s: malformed model\n", argv[1]);
+        return 1;
+    }
+    free(up);
+    int repeat = argc > 4 ? atoi(argv[4]) : 1;
+
+    FILE *out = fopen(argv[3], "wb");
+    if (!out) {
+        perror(argv[3]);
+        return 1;
+    }
+    result_t r = run(rec, rec_len, &m, out);
+    fclose(out);
+
+    double best = 1e9;
+    for (int i = 0; i < repeat; i++) {
+        double t0 = now_s();
+        run(rec, rec_len, &m, NULL);
+        double dt = now_s() - t0;
+        if (dt < best) best = dt;
+    }
+
+    printf("{\"records\": %u, \"scored\": %u, \"hits\": %u, \"reported\": %u, \"seconds\": %.6f}\n",
+           r.records, r.scored, r.hits, r.reported, best);
+    free(blob);
+    free(rec);
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Host harness for the firmware's CSI filter and packer (main/csi.c).
+ *
+ *   cc -O2 -I main bench/csi/pack.c main/csi.c -o pack
+ *   ./pack IN OUT BITS INTERVAL_MS [REPEAT] [MATCH...]
+ *
+ * IN is a recording of CSI buffers, one record each:
+ *
+ *   u32 time_ms, u8 mac[6], u16 len, int8 values[len]     (little-endian)
+ *
+ * Each record goes through csi_matches, csi_admit and csi_pack as in the
+ * CSI callback, and every forwarded report is written to OUT as a CSI
+ * event payload (csi_meta_t + packed data, timestamp = time_ms * 1000).
+ * MATCH is aa:bb:cc (OUI) or aa:bb:cc:dd:ee:ff. The pass is timed REPEAT
+ * times (best kept) and one JSON line is printed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "csi.h"
+
+/* mirrors csi_meta_t in protocol.h, which pulls in ESP-IDF headers */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;
+    uint8_t  mac[6];
+    uint8_t  channel;
+    int8_t   rssi;
+    int8_t   noise_floor;
+    uint8_t  rate;
+    uint8_t  flags;
+    uint8_t  bits;
+    uint8_t  shift;
+    uint8_t  _reserved;
+    uint16_t sig_len;
+    uint16_t csi_len;
+    uint16_t suppressed;
+} csi_meta_t;
+
+_Static_assert(sizeof(csi_meta_t) == 24, "csi_meta_t must be 24 bytes");
+
+#define REC_HDR 12
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(n > 0 ? (size_t)n : 1);
+    if (buf && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)n;
+    return buf;
+}
+
+static int parse_match(const char *s, csi_match_t *m)
+{
+    unsigned v[6];
+    int n = sscanf(s, "%x:%x:%x:%x:%x:%x", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+    if (n != 3 && n != 6) return -1;
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < n; i++) m->addr[i] = (uint8_t)v[i];
+    m->prefix = (uint8_t)n;
+    return 0;
+}
+
+typedef struct {
+    uint32_t records, matched, forwarded;
+    uint64_t in_bytes, out_bytes;
+} result_t;
+
+/* One pass over the recording; out (if not NULL) receives the event payloads. */
+static result_t run(const uint8_t *rec, size_t rec_len, const csi_config_t *cfg, FILE *out)
+{
+    static csi_t c;
+    static uint8_t packed[CSI_MAX_LEN];
+    result_t r = {0};
+    csi_configure(&c, cfg);
+
+    for (size_t pos = 0; pos + REC_HDR <= rec_len;) {
+        uint32_t t;
+        uint16_t len;
+        memcpy(&t, rec + pos, 4);
+        const uint8_t *mac = rec + pos + 4;
+        memcpy(&len, rec + pos + 10, 2);
+        const int8_t *values = (const int8_t *)(rec + pos + REC_HDR);
+        pos += REC_HDR + len;
+        if (pos > rec_len) break;
+        if (len > CSI_MAX_LEN) len = CSI_MAX_LEN;
+
+        r.records++;
+        r.in_bytes += len;
+        if (!csi_matches(&c.cfg, mac)) continue;
+        r.matched++;
+        uint16_t suppressed;
+        if (!csi_admit(&c, mac, t, &suppressed)) continue;
+
+        csi_meta_t meta = {0};
+        size_t n = csi_pack(values, len, cfg->bits, packed, &meta.shift);
+        r.forwarded++;
+        r.out_bytes += sizeof(meta) + n;
+        if (out) {
+            meta.timestamp  = t * 1000u;
+            memcpy(meta.mac, mac, 6);
+            meta.bits       = cfg->bits;
+            meta.csi_len    = len;
+            meta.suppressed = suppressed;
+            uint16_t plen = (uint16_t)(sizeof(meta) + n);
+            fwrite(&plen, 2, 1, out);
+            fwrite(&meta, sizeof(meta), 1, out);
+            fwrite(packed, 1, n, out);
+        }
+    }
+    return r;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s IN OUT BITS INTERVAL_MS [REPEAT] [MATCH...]\n", argv[0]);
+        return 2;
+    }
+    size_t rec_len;
+    uint8_t *rec = read_file(argv[1], &rec_len);
+    if (!rec) {
+        perror(argv[1]);
+        return 1;
+    }
+    csi_config_t cfg = {
+        .bits        = (uint8_t)atoi(argv[3]),
+        .interval_ms = (uint16_t)atoi(argv[4]),
+    };
+    int repeat = argc > 5 ? atoi(argv[5]) : 1;
+    for (int i = 6; i < argc && cfg.num_match < CSI_MAX_MATCH; i++) {
+        if (parse_match(argv[i], &cfg.match[cfg.num_match]) < 0) {
+            fprintf(stderr, "bad MATCH %s\n", argv[i]);
+            return 2;
+        }
+        cfg.num_match++;
+    }
+
+    /* OUT holds u16 length-prefixed payloads */
+    FILE *out = fopen(argv[2], "wb");
+    if (!out) {
+        perror(argv[2]);
+        return 1;
+    }
+    result_t r = run(rec, rec_len, &cfg, out);
+    fclose(out);
+
+    double best = 1e9;
+    for (int i = 0; i < repeat; i++) {
+        double t0 = now_s();
+        run(rec, rec_len, &cfg, NULL);
+        double dt = now_s() - t0;
+        if (dt < best) best = dt;
+    }
+
+    printf("{\"records\": %u, \"matched\": %u, \"forwarded\": %u, \"in_bytes\": %llu, "
+           "\"out_bytes\": %llu, \"seconds\": %.6f}\n",
+           r.records, r.matched, r.forwarded, (unsigned long long)r.in_bytes,
+           (unsigned long long)r.out_bytes, best);
+    free(rec);
+    return 0;
+}
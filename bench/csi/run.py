@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Run recorded CSI buffers through the firmware's filter and packer, then decode.
+
+    python3 bench/csi/run.py [--recording FILE] [--reports 20000] [--repeat 5]
+
+Packs with main/csi.c in a host build (bench/csi/pack.c, built with $CC) and
+decodes the output with lib/py ``CsiReport``. Without ``--recording`` a
+synthetic one is generated: 16 transmitters reporting every 10 ms, each a
+multipath channel over 64 subcarriers (128 values) with its own gain, so
+some reports use the whole int8 range and some only a few bits.
+
+Each configuration is checked. 8-bit reports must decode to the recorded
+values exactly. 4-bit values must be within half a quantization step, or
+clamped at the top of the range. The rate limit must forward at most one
+report per transmitter per interval, and suppressed counts must add up.
+The filter must forward only matching transmitters. Sizes are per report,
+including the 24-byte metadata; SNR is that of the decoded values against
+the recorded ones. Exits non-zero on a failed check.
+"""
+
+import argparse
+import cmath
+import json
+import math
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+from typing import Dict, List, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+sys.path.insert(0, ROOT)
+
+from lib.py.csi import CsiReport, CSI_SIZE, CSI_BITS_4  # noqa: E402
+from lib.py.mac import mac_from_bytes  # noqa: E402
+
+REC_HDR = struct.Struct("<I6sH")  # time_ms, mac, len; then len int8 values
+
+Record = Tuple[int, bytes, bytes]  # time_ms, mac, values
+
+
+def synthesize(n: int, transmitters: int = 16, subcarriers: int = 64, period_ms: int = 10) -> List[Record]:
+    rnd = random.Random(1)
+    txs = []
+    for i in range(transmitters):
+        oui = b"\x24\x0a\xc4" if i % 2 == 0 else b"\x02\x00\x00"
+        mac = oui + bytes([0, 0, i])
+        taps = [(rnd.uniform(0, 8), cmath.rect(rnd.uniform(0.2, 1.0), rnd.uniform(0, 2 * math.pi)))
+                for _ in range(3)]
+        gain = 127 * 2 ** -rnd.uniform(0, 4)  # 8 to 127 at the strongest subcarrier
+        txs.append((mac, taps, gain, rnd.uniform(0, period_ms)))
+    out: List[Record] = []
+    t = 0.0
+    while len(out) < n:
+        for mac, taps, gain, phase in txs:
+            h = [sum(g * cmath.exp(-2j * math.pi * k * d / subcarriers) for d, g in taps)
+                 for k in range(subcarriers)]
+            peak = max(abs(x) for x in h) or 1.0
+            vals = bytearray()
+            for x in h:
+                x = x / peak * gain + complex(rnd.gauss(0, 1), rnd.gauss(0, 1))
+                for v in (x.imag, x.real):  # imaginary part first, as the driver reports
+                    vals.append(max(-128, min(127, round(v))) & 0xFF)
+            out.append((int(t + phase), mac, bytes(vals)))
+        # slow drift of every channel between reports
+        txs = [(mac, [(d + rnd.gauss(0, 0.01), g * cmath.rect(1, rnd.gauss(0, 0.05))) for d, g in taps], gain, phase)
+               for mac, taps, gain, phase in txs]
+        t += period_ms
+    out.sort(key=lambda r: r[0])
+    return out[:n]
+
+
+def write_recording(records: List[Record], path: str) -> None:
+    with open(path, "wb") as f:
+        for t, mac, vals in records:
+            f.write(REC_HDR.pack(t, mac, len(vals)) + vals)
+
+
+def read_recording(path: str) -> List[Record]:
+    with open(path, "rb") as f:
+        data = f.read()
+    out, pos = [], 0
+    while pos + REC_HDR.size <= len(data):
+        t, mac, n = REC_HDR.unpack_from(data, pos)
+        pos += REC_HDR.size
+        out.append((t, mac, data[pos : pos + n]))
+        pos += n
+    return out
+
+
+def read_reports(path: str) -> List[CsiReport]:
+    with open(path, "rb") as f:
+        data = f.read()
+    out, pos = [], 0
+    while pos + 2 <= len(data):
+        (n,) = struct.unpack_from("<H", data, pos)
+        payload = data[pos + 2 : pos + 2 + n]
+        out.append(CsiReport(payload[:CSI_SIZE], payload[CSI_SIZE:]))
+        pos += 2 + n
+    return out
+
+
+def signed(b: bytes) -> List[int]:
+    return [v - 256 if v > 127 else v for v in b]
+
+
+def check(records: List[Record], reports: List[CsiReport], bits: int, interval: int,
+          oui: bytes) -> Tuple[List[str], float]:
+    """Failed checks and the SNR (dB) of the decoded values."""
+    bad: List[str] = []
+    # replay the admission decisions to pair each report with its record
+    by_mac: Dict[int, List[Record]] = {}
+    matched = 0
+    for r in records:
+        if oui and r[1][:3] != oui:
+            continue
+        matched += 1
+        by_mac.setdefault(mac_from_bytes(r[1]), []).append(r)
+    sig = err = 0.0
+    last: Dict[int, int] = {}
+    held = 0
+    pos: Dict[int, int] = {}
+    for rep in reports:
+        if oui and rep.mac >> 24 != int.from_bytes(oui, "big"):
+            bad.append(f"{rep!r} does not match the filter")
+            continue
+        t = rep.timestamp_us // 1000
+        if interval and rep.mac in last and t - last[rep.mac] < interval:
+            bad.append(f"{rep!r} within {interval} ms of the previous one")
+        recs = by_mac[rep.mac]
+        i = pos.get(rep.mac, 0)
+        while i < len(recs) and recs[i][0] != t:
+            i += 1
+        if i == len(recs):
+            bad.append(f"{rep!r} has no recorded buffer")
+            continue
+        skipped = i - pos.get(rep.mac, 0)
+        if interval and rep.mac in last and rep.suppressed != skipped:
+            bad.append(f"{rep!r} suppressed={rep.suppressed}, {skipped} held back")
+        held += rep.suppressed
+        pos[rep.mac] = i + 1
+        last[rep.mac] = t
+
+        orig, got = signed(recs[i][2]), list(rep.values())
+        if len(got) != len(orig):
+            bad.append(f"{rep!r} decoded {len(got)} values of {len(orig)}")
+            continue
+        step = 1 << rep.shift if rep.bits == CSI_BITS_4 else 0
+        for o, g in zip(orig, got):
+            e = abs(o - g)
+            if bits != CSI_BITS_4 and e:
+                bad.append(f"{rep!r} 8-bit value {g} != {o}")
+                break
+            if bits == CSI_BITS_4 and e > step // 2 and not (g == 7 * step and o > g):
+                bad.append(f"{rep!r} value {o} decoded as {g} (shift {rep.shift})")
+                break
+            sig += o * o
+            err += e * e
+    if not interval and len(reports) != matched:
+        bad.append(f"{len(reports)} reports forwarded of {matched} matching")
+    if interval and len(reports) + held > matched:
+        bad.append(f"{len(reports)} forwarded + {held} suppressed > {matched} matching")
+    snr = 10 * math.log10(sig / err) if err else math.inf
+    return bad, snr
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/csi/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--recording", metavar="FILE", help="Recorded CSI buffers (see pack.c); default synthetic")
+    ap.add_argument("--reports", type=int, default=20000, help="Synthetic reports (default: 20000)")
+    ap.add_argument("--repeat", type=int, default=5, help="Timed passes, best kept (default: 5)")
+    ap.add_argument("--save", metavar="FILE", help="Also write the synthetic recording to FILE")
+    args = ap.parse_args()
+
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        print("no C compiler", file=sys.stderr)
+        return 1
+    failed = False
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, "pack")
+        subprocess.run([cc, "-O2", "-I", os.path.join(ROOT, "main"), os.path.join(HERE, "pack.c"),
+                        os.path.join(ROOT, "main", "csi.c"), "-o", exe], check=True)
+        if args.recording:
+            rec_path = args.recording
+            records = read_recording(rec_path)
+        else:
+            records = synthesize(args.reports)
+            rec_path = args.save or os.path.join(tmp, "synthetic.rec")
+            write_recording(records, rec_path)
+        raw = sum(CSI_SIZE + len(v) for _, _, v in records) / max(1, len(records))
+        print(f"{len(records)} recorded buffers, {raw - CSI_SIZE:.0f} values each on average\n")
+        print(f"{'config':<20} {'fwd':>7} {'B/report':>9} {'ratio':>6} {'SNR dB':>7} {'ns/report':>10}  check")
+
+        oui = records[0][1][:3] if records else b""
+        configs = [
+            ("8-bit", 8, 0, b""),
+            ("4-bit", 4, 0, b""),
+            ("8-bit, 100 ms", 8, 100, b""),
+            ("4-bit, 100 ms", 4, 100, b""),
+            (f"4-bit, OUI {oui.hex(':')}", 4, 0, oui),
+        ]
+        for name, bits, interval, match in configs:
+            out_path = os.path.join(tmp, "out.bin")
+            cmd = [exe, rec_path, out_path, str(bits), str(interval), str(args.repeat)]
+            if match:
+                cmd.append(match.hex(":"))
+            res = json.loads(subprocess.run(cmd, check=True, capture_output=True, text=True).stdout)
+            reports = read_reports(out_path)
+            bad, snr = check(records, reports, bits, interval, match)
+            failed |= bool(bad)
+            per = res["out_bytes"] / max(1, res["forwarded"])
+            ns = res["seconds"] / max(1, res["records"]) * 1e9
+            print(f"{name:<20} {res['forwarded']:>7} {per:>9.1f} {per / raw:>6.2f} {snr:>7.1f} {ns:>10.1f}"
+                  f"  {'ok' if not bad else 'FAIL'}")
+            for m in bad[:3]:
+                print(f"  {m}")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
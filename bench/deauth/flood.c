@@ -0,0 +1,130 @@
+/*
+ * Host harness for the firmware's deauth/disassoc flood detector
+ * (main/deauth.c).
+ *
+ *   cc -O2 -I main bench/deauth/flood.c main/deauth.c -o flood
+ *   ./flood THRESHOLD WINDOW_MS REPORT_MS SUPPRESS [REPEAT] < frames
+ *
+ * Each input line is one frame, in time order:
+ *
+ *   t_ms subtype pair reason
+ *
+ * subtype is 12 (deauth) or 10 (disassoc). pair numbers a (BSSID, target):
+ * BSSID 02:00:00:00:pp:01 and target 02:00:00:00:pp:02, or broadcast when
+ * pair is negative (BSSID from -pair). Each frame goes through
+ * deauth_is_candidate and deauth_observe as in the packet handler, and one
+ * line is printed per frame:
+ *
+ *   act flags window_count deauth disassoc suppressed duration_ms num_reasons
+ *
+ * act is the DEAUTH_ACT_* bits; the other fields are those of the report,
+ * or 0 without one. With REPEAT, the frames are then replayed REPEAT times
+ * (best kept) and one JSON line follows with the time per frame.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "deauth.h"
+
+#define FRAME_LEN   26
+
+typedef struct {
+    uint32_t t_ms;
+    uint8_t  frame[FRAME_LEN];
+} rec_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 802.11 header (addr1 = target, addr2 = addr3 = BSSID) and the reason code */
+static void build(rec_t *r, uint32_t t_ms, unsigned subtype, int pair, unsigned reason)
+{
+    uint8_t *f = r->frame;
+    unsigned p = (unsigned)(pair < 0 ? -pair : pair);
+    memset(f, 0, FRAME_LEN);
+    r->t_ms = t_ms;
+    f[0] = (uint8_t)(subtype << 4);
+    static const uint8_t base[6] = { 0x02, 0, 0, 0, 0, 0 };
+    memcpy(f + 4, base, 6);
+    memcpy(f + 10, base, 6);
+    f[8] = f[14] = (uint8_t)p;
+    f[9] = 0x02;
+    f[15] = 0x01;
+    if (pair < 0) memset(f + 4, 0xFF, 6);
+    memcpy(f + 16, f + 10, 6);
+    f[24] = (uint8_t)reason;
+    f[25] = (uint8_t)(reason >> 8);
+}
+
+static void replay(deauth_det_t *d, const deauth_config_t *cfg, const rec_t *recs, size_t n,
+                   FILE *out)
+{
+    deauth_configure(d, cfg);
+    for (size_t i = 0; i < n; i++) {
+        const rec_t *r = &recs[i];
+        deauth_report_t rep;
+        memset(&rep, 0, sizeof(rep));
+        int act = 0;
+        if (deauth_is_candidate(r->frame, FRAME_LEN))
+            act = deauth_observe(d, r->frame, FRAME_LEN, 6, -50, r->t_ms, &rep);
+        if (!out) continue;
+        if (!(act & DEAUTH_ACT_REPORT)) memset(&rep, 0, sizeof(rep));
+        fprintf(out, "%d %u %u %u %u %u %u %u\n", act, rep.flags, rep.window_count,
+                rep.deauth_count, rep.disassoc_count, rep.suppressed, rep.duration_ms,
+                rep.num_reasons);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s THRESHOLD WINDOW_MS REPORT_MS SUPPRESS [REPEAT] < frames\n",
+                argv[0]);
+        return 2;
+    }
+    deauth_config_t cfg = {
+        .threshold = (uint16_t)atoi(argv[1]),
+        .window_ms = (uint16_t)atoi(argv[2]),
+        .report_ms = (uint16_t)atoi(argv[3]),
+        .suppress  = atoi(argv[4]) != 0,
+    };
+    int repeat = argc > 5 ? atoi(argv[5]) : 0;
+
+    size_t n = 0, cap = 1024;
+    rec_t *recs = malloc(cap * sizeof(*recs));
+    unsigned t, subtype, reason;
+    int pair;
+    while (recs && scanf("%u %u %d %u", &t, &subtype, &pair, &reason) == 4) {
+        if (n == cap) {
+            cap *= 2;
+            recs = realloc(recs, cap * sizeof(*recs));
+            if (!recs) break;
+        }
+        build(&recs[n++], t, subtype, pair, reason);
+    }
+    if (!recs) return 1;
+
+    static deauth_det_t d;
+    replay(&d, &cfg, recs, n, stdout);
+
+    if (repeat > 0 && n > 0) {
+        double best = 1e9;
+        for (int i = 0; i < repeat; i++) {
+            double t0 = now_s();
+            replay(&d, &cfg, recs, n, NULL);
+            double dt = now_s() - t0;
+            if (dt < best) best = dt;
+        }
+        printf("{\"frames\": %zu, \"ns_per_frame\": %.2f, \"evictions\": %u}\n", n, best * 1e9 / n,
+               d.evictions);
+    }
+    free(recs);
+    return 0;
+}
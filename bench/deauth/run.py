@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+"""Replay synthetic deauth/disassoc floods through the firmware's detector.
+
+    python3 bench/deauth/run.py [--frames 1000000] [--repeat 5]
+
+Builds bench/deauth/flood.c with $CC over main/deauth.c and runs a set of
+generated scenarios through it: steady rates just below and above the
+threshold, floods that stop and start again, report intervals, suppression,
+broadcast floods mixed with disassoc frames, and a flood that has to hold
+its table entry against more pairs than the table has room for. Each
+scenario checks when the detector reports and which frames it drops.
+
+Then times the detector on a mix of many pairs, most of them quiet. Exits
+non-zero on a failed check.
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import Callable, List, NamedTuple, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+
+DEAUTH = 12
+DISASSOC = 10
+ACT_REPORT = 1
+ACT_SUPPRESS = 2
+ONSET = 1
+
+Frame = Tuple[int, int, int, int]  # t_ms, subtype, pair, reason
+
+
+class Result(NamedTuple):
+    act: int
+    flags: int
+    window_count: int
+    deauth: int
+    disassoc: int
+    suppressed: int
+    duration_ms: int
+    num_reasons: int
+
+
+class Config(NamedTuple):
+    threshold: int = 20
+    window_ms: int = 1000
+    report_ms: int = 5000
+    suppress: bool = False
+
+
+def steady(pair: int, rate: int, start_ms: int, end_ms: int, subtype: int = DEAUTH,
+           reason: int = 7) -> List[Frame]:
+    """Frames at a fixed rate (per second) over [start_ms, end_ms)."""
+    out, k = [], 0
+    while start_ms + k * 1000 // rate < end_ms:
+        out.append((start_ms + k * 1000 // rate, subtype, pair, reason))
+        k += 1
+    return out
+
+
+def run_flood(exe: str, cfg: Config, frames: List[Frame], repeat: int = 0) -> Tuple[List[Result], dict]:
+    frames = sorted(frames, key=lambda f: f[0])
+    text = "".join(f"{t} {s} {p} {r}\n" for t, s, p, r in frames)
+    out = subprocess.run([exe, str(cfg.threshold), str(cfg.window_ms), str(cfg.report_ms),
+                          str(int(cfg.suppress)), str(repeat)],
+                         input=text, check=True, capture_output=True, text=True).stdout
+    results, timing = [], {}
+    for line in out.splitlines():
+        if line.startswith("{"):
+            timing = json.loads(line)
+        else:
+            results.append(Result(*(int(x) for x in line.split())))
+    return results, timing
+
+
+def reports(res: List[Result]) -> List[Tuple[int, Result]]:
+    return [(i, r) for i, r in enumerate(res) if r.act & ACT_REPORT]
+
+
+# each check takes the sorted frames and the detector's results and returns an error or ""
+Check = Callable[[List[Frame], List[Result]], str]
+
+
+def below_threshold(frames: List[Frame], res: List[Result]) -> str:
+    return f"{len(reports(res))} reports" if reports(res) else ""
+
+
+def crossing(frames: List[Frame], res: List[Result]) -> str:
+    # 25/s from t = 0: the 20th frame of the first window is the onset, and only it reports
+    rep = reports(res)
+    if not rep or rep[0][0] != 19:
+        return f"onset at frame {rep[0][0] if rep else None}, wanted 19"
+    i, r = rep[0]
+    if r.flags != ONSET or r.window_count != 20 or r.deauth != 20 or r.duration_ms != frames[i][0]:
+        return f"onset report {r}"
+    if len(rep) != 1:
+        return f"{len(rep)} reports within one report interval"
+    return ""
+
+
+def expiry(frames: List[Frame], res: List[Result]) -> str:
+    # 40/s for 3 s, quiet 1.5 s, 40/s again: the flood ends in the gap, the second is a new onset
+    rep = reports(res)
+    onsets = [(i, r) for i, r in rep if r.flags & ONSET]
+    if len(onsets) != 2:
+        return f"{len(onsets)} onsets, wanted 2"
+    i, r = onsets[1]
+    if frames[i][0] < 4500:
+        return f"second onset at {frames[i][0]} ms, before the second flood"
+    if r.deauth != r.window_count or r.duration_ms > 1000:
+        return f"second onset carries the first flood's counts: {r}"
+    return ""
+
+
+def slow_decay(frames: List[Frame], res: List[Result]) -> str:
+    # 40/s for 2 s, then 10/s: the first window below threshold ends the flood, no second onset
+    onsets = [i for i, r in reports(res) if r.flags & ONSET]
+    return f"{len(onsets)} onsets, wanted 1" if len(onsets) != 1 else ""
+
+
+def interval(report_ms: int) -> Check:
+    def check(frames: List[Frame], res: List[Result]) -> str:
+        # 50/s for 10 s: onset at 380 ms, then one report per report_ms while it lasts
+        rep = reports(res)
+        times = [frames[i][0] for i, _ in rep]
+        if report_ms == 0:
+            return f"{len(rep)} reports, wanted the onset only" if len(rep) != 1 else ""
+        # each repeat comes with the first frame once report_ms has passed
+        step = frames[1][0] - frames[0][0]
+        gaps = [b - a for a, b in zip(times, times[1:])] + [frames[-1][0] + step - times[-1]]
+        if any(g < report_ms for g in gaps[:-1]):
+            return f"reports {min(gaps)} ms apart, limit {report_ms}"
+        if any(g >= report_ms + step for g in gaps):
+            return f"a report {max(gaps)} ms after the last, limit {report_ms}"
+        if any(r.flags & ONSET for _, r in rep[1:]):
+            return "repeat report flagged as onset"
+        return ""
+    return check
+
+
+def suppression(frames: List[Frame], res: List[Result]) -> str:
+    # 40/s for 3 s, suppress on: frames up to and including the onset pass, later ones drop
+    onset = next((i for i, r in reports(res) if r.flags & ONSET), None)
+    if onset is None:
+        return "no onset"
+    dropped = [i for i, r in enumerate(res) if r.act & ACT_SUPPRESS]
+    if any(i <= onset for i in dropped):
+        return "frame suppressed before the onset"
+    if dropped != list(range(onset + 1, len(res))):
+        return f"{len(dropped)} of {len(res) - onset - 1} flood frames suppressed"
+    for i, r in reports(res)[1:]:
+        if r.suppressed != sum(1 for j in dropped if j <= i):
+            return f"report at frame {i} counts {r.suppressed} suppressed"
+    return ""
+
+
+def suppression_ends(frames: List[Frame], res: List[Result]) -> str:
+    # the flood ends after a quiet second; the next frames pass again
+    late = [r for (t, _, _, _), r in zip(frames, res) if t >= 5000]
+    return "frames dropped after the flood ended" if any(r.act & ACT_SUPPRESS for r in late) else ""
+
+
+def mixed(frames: List[Frame], res: List[Result]) -> str:
+    # broadcast deauth and disassoc with five reason codes, both count towards the threshold
+    rep = reports(res)
+    if not rep:
+        return "no onset"
+    i, r = rep[0]
+    if r.deauth + r.disassoc != 20 or not r.deauth or not r.disassoc:
+        return f"onset counts {r.deauth}+{r.disassoc}"
+    if r.num_reasons != 4:
+        return f"{r.num_reasons} reasons kept, wanted 4"
+    return ""
+
+
+def eviction(frames: List[Frame], res: List[Result]) -> str:
+    # one flood among 100 single-frame pairs: it keeps its entry, so it reports once and never re-onsets
+    flood = [(f, r) for f, r in zip(frames, res) if f[2] == 1]
+    onsets = sum(1 for _, r in flood if r.act & ACT_REPORT and r.flags & ONSET)
+    return f"{onsets} onsets for the flood" if onsets != 1 else ""
+
+
+def scenarios(rng: random.Random) -> List[Tuple[str, Config, List[Frame], Check]]:
+    noise = [(rng.randrange(100, 9000), DEAUTH, p, 3) for p in range(2, 102)]
+    mix = [(t, DEAUTH if k % 3 else DISASSOC, -5, 1 + k % 5)
+           for k, (t, _, _, _) in enumerate(steady(0, 30, 0, 2000))]
+    return [
+        ("19/s, threshold 20", Config(), steady(1, 19, 0, 5000), below_threshold),
+        ("25/s crosses at frame 20", Config(), steady(1, 25, 0, 1000), crossing),
+        ("flood, gap, flood", Config(report_ms=0),
+         steady(1, 40, 0, 3000) + steady(1, 40, 4500, 6000), expiry),
+        ("flood decays to 10/s", Config(report_ms=0),
+         steady(1, 40, 0, 2000) + steady(1, 10, 2000, 6000), slow_decay),
+        ("report every 1000 ms", Config(report_ms=1000), steady(1, 50, 0, 10000), interval(1000)),
+        ("report every 250 ms", Config(report_ms=250), steady(1, 50, 0, 10000), interval(250)),
+        ("onset only", Config(report_ms=0), steady(1, 50, 0, 10000), interval(0)),
+        ("suppress", Config(report_ms=1000, suppress=True), steady(1, 40, 0, 3000), suppression),
+        ("suppress ends", Config(suppress=True),
+         steady(1, 40, 0, 3000) + steady(1, 5, 5000, 7000), suppression_ends),
+        ("broadcast, mixed subtypes", Config(), mix, mixed),
+        ("flood holds its entry", Config(report_ms=0), steady(1, 40, 0, 9000) + noise, eviction),
+    ]
+
+
+def timing_frames(rng: random.Random, n: int) -> List[Frame]:
+    # 200 pairs sending now and then, one of them flooding
+    frames, t = [], 0
+    for _ in range(n):
+        t += rng.randrange(0, 3)
+        pair = 1 if rng.random() < 0.3 else rng.randrange(2, 202)
+        frames.append((t, DEAUTH if rng.random() < 0.8 else DISASSOC, pair, rng.randrange(1, 9)))
+    return frames
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/deauth/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--frames", type=int, default=1000000, help="Frames in the timed mix (default: 1000000)")
+    ap.add_argument("--repeat", type=int, default=5, help="Timed passes, best kept (default: 5)")
+    args = ap.parse_args()
+
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        print("no C compiler", file=sys.stderr)
+        return 1
+    rng = random.Random(1)
+    ok = True
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, "flood")
+        main_dir = os.path.join(ROOT, "main")
+        subprocess.run([cc, "-O2", "-I", main_dir, os.path.join(HERE, "flood.c"),
+                        os.path.join(main_dir, "deauth.c"), "-o", exe], check=True)
+
+        print("detector scenarios:")
+        for name, cfg, frames, check in scenarios(rng):
+            frames = sorted(frames, key=lambda f: f[0])
+            res, _ = run_flood(exe, cfg, frames)
+            err = check(frames, res)
+            ok &= not err
+            print(f"  {name:<28} {len(frames):>5} frames, {len(reports(res)):>3} reports  "
+                  f"{'ok' if not err else 'FAIL: ' + err}")
+
+        _, timing = run_flood(exe, Config(report_ms=1000, suppress=True),
+                              timing_frames(rng, args.frames), args.repeat)
+        print(f"\n{timing['frames']} frames over 200 pairs: {timing['ns_per_frame']:.1f} ns per frame, "
+              f"{timing['evictions']} evictions")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
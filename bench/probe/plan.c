@@ -0,0 +1,85 @@
+/*
+ * Host harness for the firmware's probe scheduling (main/sched.c and
+ * main/probe.c).
+ *
+ *   cc -O2 -I main bench/probe/plan.c main/sched.c main/probe.c -o plan
+ *   ./plan SCHEDULE RATE NUM_SSIDS BROADCAST SECONDS
+ *
+ * SCHEDULE is ch:dwell_ms,... as for hopsim. The scan task loop is replayed
+ * with a fake clock: every Wi-Fi slot calls probe_dwell at its start and
+ * builds the granted frames, and one line is printed per dwell:
+ *
+ *   t_ms channel probes bytes
+ *
+ * SSIDs are "ssid0".."ssidN-1"; the source address is 02:00:00:00:00:01.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sched.h"
+#include "probe.h"
+
+static int parse_schedule(const char *s, sched_hop_t *hops)
+{
+    int n = 0;
+    while (*s && n < SCHED_MAX_HOPS) {
+        unsigned ch, dwell;
+        int used;
+        if (sscanf(s, "%u:%u%n", &ch, &dwell, &used) != 2 || !dwell) return -1;
+        memset(&hops[n], 0, sizeof(hops[n]));
+        hops[n].channel  = (uint8_t)ch;
+        hops[n].dwell_ms = (uint16_t)dwell;
+        hops[n].rssi_min = SCHED_RSSI_ANY;
+        n++;
+        s += used;
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 6) {
+        fprintf(stderr, "usage: %s SCHEDULE RATE NUM_SSIDS BROADCAST SECONDS\n", argv[0]);
+        return 2;
+    }
+    static sched_hop_t hops[SCHED_MAX_HOPS];
+    int num_hops = parse_schedule(argv[1], hops);
+    if (num_hops <= 0) {
+        fprintf(stderr, "bad SCHEDULE %s\n", argv[1]);
+        return 2;
+    }
+
+    probe_config_t cfg = {
+        .src       = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+        .rate      = (uint16_t)atoi(argv[2]),
+        .num_ssids = (uint8_t)atoi(argv[3]),
+        .flags     = atoi(argv[4]) ? PROBE_FLAG_BROADCAST : 0,
+    };
+    if (cfg.num_ssids > PROBE_MAX_SSIDS) cfg.num_ssids = PROBE_MAX_SSIDS;
+    for (int i = 0; i < cfg.num_ssids; i++)
+        cfg.ssids[i].len = (uint8_t)snprintf((char *)cfg.ssids[i].ssid, PROBE_MAX_SSID_LEN, "ssid%d", i);
+    uint32_t end_ms = (uint32_t)(atof(argv[5]) * 1000);
+
+    static sched_t sched;
+    static probe_t probe;
+    static uint8_t frame[PROBE_MAX_FRAME];
+    sched_init(&sched, hops, num_hops);
+    probe_configure(&probe, &cfg, 0);
+
+    for (uint32_t now = 0; now < end_ms;) {
+        sched_slot_t slot;
+        sched_next(&sched, now, &slot);
+        if (slot.radio == SCHED_RADIO_WIFI) {
+            int n = probe_dwell(&probe, now);
+            size_t bytes = 0;
+            for (int i = 0; i < n; i++) bytes += probe_build(&probe, i, slot.channel, frame);
+            printf("%u %u %d %zu\n", now, slot.channel, n, bytes);
+        }
+        now += slot.duration_ms;
+    }
+    return 0;
+}
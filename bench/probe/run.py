@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Time to first detection with and without active probing.
+
+    python3 bench/probe/run.py [--seconds 1800] [--rate 20] [--horizon 30]
+
+First checks that lib/py hopsim's probing model grants probes exactly as
+the firmware does: bench/probe/plan.c (built with $CC) replays the scan
+task over main/sched.c and main/probe.c with a fake clock, and its
+per-dwell output must match ``hopsim.probe_grants`` for a set of
+schedules, rates and SSID lists.
+
+Then evaluates schedules on generated traffic (APs beaconing every 1-3
+TU x 100, on channels 1/6/11) for the APs, which are the devices that
+answer probes: detection probability and mean time to first detection
+within the horizon, passive and probing. Exits non-zero on a mismatch.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+sys.path.insert(0, ROOT)
+
+from lib.py.hopsim import (  # noqa: E402
+    DEFAULT_SCHEDULE, Probing, TrafficIndex, evaluate, format_schedule, generate, generated_aps,
+    parse_schedule, probe_grants,
+)
+
+# (schedule, rate, ssids, broadcast)
+PLANS = [
+    ("1:100,6:100,11:100", 20, 0, 0),
+    ("1:100,6:100,11:100", 5, 2, 1),
+    ("1:50,6:50,11:50", 20, 3, 0),
+    ("1:2500,6:2500,11:2500", 1, 4, 1),
+    ("1:30,6:70,11:200,36:100", 7, 1, 1),
+    ("6:40", 200, 4, 1),
+]
+
+SCHEDULES = [
+    "1:2500,6:2500,11:2500",
+    "1:500,6:500,11:500",
+    "1:200,6:200,11:200",
+    "1:100,6:100,11:100",
+    "1:50,6:50,11:50",
+]
+
+
+def check_plans(exe: str, seconds: float) -> bool:
+    ok = True
+    for sched, rate, ssids, broadcast in PLANS:
+        out = subprocess.run([exe, sched, str(rate), str(ssids), str(broadcast), str(seconds)],
+                             check=True, capture_output=True, text=True).stdout
+        got = [tuple(int(x) for x in line.split()[:3]) for line in out.splitlines()]
+        wanted = ssids + (1 if broadcast or not ssids else 0)
+        model = probe_grants(parse_schedule(sched), Probing(rate, frozenset(), wanted), seconds)
+        sent = sum(n for _, _, n in got)
+        same = got == model
+        ok &= same
+        print(f"  {sched:<24} rate={rate:<3} ssids={ssids} broadcast={broadcast}: "
+              f"{len(got)} dwells, {sent} probes  {'ok' if same else 'MISMATCH'}")
+        if not same:
+            i = next((i for i, (a, b) in enumerate(zip(got, model)) if a != b), min(len(got), len(model)))
+            print(f"    dwell {i}: firmware {got[i:i + 1]}, model {model[i:i + 1]}")
+    return ok
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/probe/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--seconds", type=float, default=1800, help="Generated traffic (default: 1800)")
+    ap.add_argument("--rate", type=int, default=20, help="Probes per second (default: 20)")
+    ap.add_argument("--horizon", type=float, default=30, help="Detection horizon in seconds (default: 30)")
+    ap.add_argument("--switch-ms", type=float, default=5.0, help="Dead time per hop (default: 5)")
+    ap.add_argument("--response-ms", type=float, default=5.0, help="Probe to response (default: 5)")
+    ap.add_argument("--starts", type=int, default=64, help="Start times per schedule (default: 64)")
+    args = ap.parse_args()
+
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        print("no C compiler", file=sys.stderr)
+        return 1
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, "plan")
+        main_dir = os.path.join(ROOT, "main")
+        subprocess.run([cc, "-O2", "-I", main_dir, os.path.join(HERE, "plan.c"),
+                        os.path.join(main_dir, "sched.c"), os.path.join(main_dir, "probe.c"), "-o", exe],
+                       check=True)
+        print("firmware vs hopsim probe grants:")
+        ok = check_plans(exe, 60)
+
+    aps = generated_aps()
+    index = TrafficIndex(generate(args.seconds), aps)
+    probing = Probing(args.rate, frozenset(aps), 1, args.response_ms)
+    print(f"\n{len(aps)} APs, {args.rate} probes/s, horizon {args.horizon:g} s\n")
+    print(f"{'schedule':<28} {'p passive':>9} {'ttd passive':>12} {'p probe':>8} {'ttd probe':>10} {'gain':>6}")
+    for s in [parse_schedule(x) for x in SCHEDULES] + [DEFAULT_SCHEDULE]:
+        p0, t0 = evaluate(index, s, args.switch_ms, args.horizon, args.starts)
+        p1, t1 = evaluate(index, s, args.switch_ms, args.horizon, args.starts, probing=probing)
+        name = format_schedule(s) if s is not DEFAULT_SCHEDULE else "default (1-13 x 2500)"
+        print(f"{name:<28} {p0:>9.3f} {t0 * 1000:>10.0f}ms {p1:>8.3f} {t1 * 1000:>8.0f}ms {t0 / t1:>5.1f}x")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Check how the firmware's scheduler splits the radio between Wi-Fi and BLE.
+
+    python3 bench/sched/run.py [--seconds 600]
+
+Builds bench/sched/split.c with $CC over main/sched.c and replays the scan
+task with a fake clock for a set of hop schedules and BLE windows. Some
+runs have late wakeups and some start just below the 32-bit millisecond
+wrap. For each run it checks three things. There is a BLE window after
+every BLE_EVERY Wi-Fi hops, and the hops follow the schedule in order. The
+scheduler charges each radio exactly the time its slots were held, late
+wakeups included. Without them, the duty cycle it reports is the one the
+configuration asks for. Prints the Wi-Fi and BLE shares, and exits
+non-zero on a failed check.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import List, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+
+WIFI = 0
+BLE = 1
+
+# (schedule, ble window ms, ble every, start ms, overrun ms)
+RUNS = [
+    ("1:2500,6:2500,11:2500", 0, 1, 0, 0),
+    ("1:2500,6:2500,11:2500", 500, 1, 0, 0),
+    ("1:100,6:100,11:100", 50, 3, 0, 0),
+    ("1:100,6:100,11:100", 30, 1, 0, 7),
+    ("1:30,6:70,11:200,36:100", 100, 2, 0, 3),
+    ("6:250", 250, 1, 2**32 - 20000, 0),
+    ("1:50,6:50,11:50", 20, 4, 2**32 - 1000, 5),
+    ("-", 300, 1, 0, 0),
+]
+
+
+def parse_schedule(text: str) -> List[Tuple[int, int]]:
+    if text == "-":
+        return []
+    return [(int(c), int(d)) for c, d in (e.split(":") for e in text.split(","))]
+
+
+def check(sched: str, window: int, every: int, overrun: int, out: str) -> Tuple[str, float, float]:
+    hops = parse_schedule(sched)
+    slots, acct = [], None
+    for line in out.splitlines():
+        if line.startswith("="):
+            acct = [int(x) for x in line.split()[1:]]
+        else:
+            slots.append(tuple(int(x) for x in line.split()))
+    if acct is None or not slots:
+        return "no output", 0, 0
+
+    # the expected sequence: every hops in order, then a BLE window (if on)
+    hop_idx, since_ble = 0, 0
+    held = [0, 0]
+    prev_end = slots[0][0]
+    for i, (start, radio, channel, duration, hold) in enumerate(slots):
+        if start != prev_end:
+            return f"slot {i} starts at {start}, previous ended at {prev_end}", 0, 0
+        prev_end = (start + hold) & 0xFFFFFFFF
+        ble_due = window > 0 and (not hops or since_ble >= every)
+        if ble_due:
+            want = (BLE, 0, window)
+            since_ble = 0
+        else:
+            ch, dwell = hops[hop_idx]
+            want = (WIFI, ch, dwell)
+            hop_idx = (hop_idx + 1) % len(hops)
+            since_ble += 1
+        if (radio, channel, duration) != want:
+            return f"slot {i} is {(radio, channel, duration)}, wanted {want}", 0, 0
+        held[radio] += hold
+
+    wifi_ms, ble_ms, wifi_pm, ble_pm = acct
+    if [wifi_ms, ble_ms] != held:
+        return f"charged wifi {wifi_ms} ble {ble_ms} ms, held {held[0]} and {held[1]}", 0, 0
+    total = wifi_ms + ble_ms
+    if (wifi_pm, ble_pm) != (wifi_ms * 1000 // total, ble_ms * 1000 // total):
+        return f"duty {wifi_pm}/{ble_pm} permille for {wifi_ms}/{ble_ms} ms", 0, 0
+
+    # without overruns the split is the configured one, up to the last partial round
+    cycle_wifi = every * sum(d for _, d in hops) / len(hops) if hops else 0
+    cycle = cycle_wifi + window
+    want_ble = window / cycle if cycle else 0
+    if not overrun and abs(ble_ms / total - want_ble) > 0.01 + max(s[3] for s in slots) / total:
+        return f"BLE share {ble_ms / total:.3f}, configured {want_ble:.3f}", 0, 0
+    return "", wifi_pm / 10, ble_pm / 10
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/sched/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--seconds", type=float, default=600, help="Replayed time per run (default: 600)")
+    args = ap.parse_args()
+
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        print("no C compiler", file=sys.stderr)
+        return 1
+    ok = True
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = os.path.join(tmp, "split")
+        main_dir = os.path.join(ROOT, "main")
+        subprocess.run([cc, "-O2", "-I", main_dir, os.path.join(HERE, "split.c"),
+                        os.path.join(main_dir, "sched.c"), "-o", exe], check=True)
+        print(f"{'schedule':<26} {'ble':>9} {'start':>10} {'late':>5} {'wifi':>6} {'ble':>6}  check")
+        for sched, window, every, start, overrun in RUNS:
+            out = subprocess.run([exe, sched, str(window), str(every), str(args.seconds), str(start),
+                                  str(overrun)], check=True, capture_output=True, text=True).stdout
+            err, wifi, ble = check(sched, window, every, overrun, out)
+            ok &= not err
+            ble_cfg = f"{window}/{every}" if window else "off"
+            print(f"{sched:<26} {ble_cfg:>9} {start:>10} {overrun:>5} {wifi:>5.1f}% {ble:>5.1f}%  "
+                  f"{'ok' if not err else 'FAIL: ' + err}")
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,90 @@
+/*
+ * Host harness for the firmware's radio scheduler (main/sched.c).
+ *
+ *   cc -O2 -I main bench/sched/split.c main/sched.c -o split
+ *   ./split SCHEDULE BLE_WINDOW_MS BLE_EVERY SECONDS [START_MS [OVERRUN_MS]]
+ *
+ * SCHEDULE is ch:dwell_ms,... as for hopsim, or "-" for no Wi-Fi hops. The
+ * scan task loop is replayed with a fake clock starting at START_MS (which
+ * may sit just below the 32-bit wrap): each slot is held for its duration
+ * plus a pseudo-random 0..OVERRUN_MS, as a late wakeup would, before
+ * sched_next is called again. One line is printed per slot:
+ *
+ *   start_ms radio channel duration_ms held_ms
+ *
+ * and after sched_stop, one line with the scheduler's accounting:
+ *
+ *   = wifi_ms ble_ms wifi_permille ble_permille
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sched.h"
+
+static int parse_schedule(const char *s, sched_hop_t *hops)
+{
+    int n = 0;
+    if (strcmp(s, "-") == 0) return 0;
+    while (*s && n < SCHED_MAX_HOPS) {
+        unsigned ch, dwell;
+        int used;
+        if (sscanf(s, "%u:%u%n", &ch, &dwell, &used) != 2 || !dwell) return -1;
+        memset(&hops[n], 0, sizeof(hops[n]));
+        hops[n].channel  = (uint8_t)ch;
+        hops[n].dwell_ms = (uint16_t)dwell;
+        hops[n].rssi_min = SCHED_RSSI_ANY;
+        n++;
+        s += used;
+        if (*s == ',') s++;
+        else if (*s) return -1;
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s SCHEDULE BLE_WINDOW_MS BLE_EVERY SECONDS [START_MS [OVERRUN_MS]]\n",
+                argv[0]);
+        return 2;
+    }
+    static sched_hop_t hops[SCHED_MAX_HOPS];
+    int n = parse_schedule(argv[1], hops);
+    if (n < 0) {
+        fprintf(stderr, "bad schedule: %s\n", argv[1]);
+        return 2;
+    }
+    uint16_t window = (uint16_t)atoi(argv[2]);
+    uint8_t every = (uint8_t)atoi(argv[3]);
+    uint32_t span = (uint32_t)(atof(argv[4]) * 1000);
+    uint32_t now = argc > 5 ? (uint32_t)strtoul(argv[5], NULL, 10) : 0;
+    uint32_t overrun = argc > 6 ? (uint32_t)atoi(argv[6]) : 0;
+    if (n == 0 && window == 0) {
+        fprintf(stderr, "nothing to schedule\n");
+        return 2;
+    }
+
+    sched_t s;
+    sched_init(&s, hops, n);
+    sched_set_ble(&s, window, every);
+
+    uint32_t rng = 1, elapsed = 0;
+    while (elapsed < span) {
+        sched_slot_t slot;
+        sched_next(&s, now, &slot);
+        uint32_t held = slot.duration_ms;
+        if (overrun) {
+            rng = rng * 1103515245u + 12345u;
+            held += (rng >> 16) % (overrun + 1);
+        }
+        printf("%u %d %u %u %u\n", now, (int)slot.radio, slot.channel, slot.duration_ms, held);
+        now += held;
+        elapsed += held;
+    }
+    sched_stop(&s, now);
+    printf("= %u %u %u %u\n", s.radio_ms[SCHED_RADIO_WIFI], s.radio_ms[SCHED_RADIO_BLE],
+           sched_duty_permille(&s, SCHED_RADIO_WIFI), sched_duty_permille(&s, SCHED_RADIO_BLE));
+    return 0;
+}
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""Golden device-to-host byte streams with their expected decoded output.
+
+    python3 bench/wire/corpus.py            # rewrite bench/wire/corpus/
+
+Every stream is built message by message, so its expected output is known
+by construction rather than taken from any of the decoders under test. The
+edge-case streams are committed under ``corpus/``; the throughput streams
+are regenerated by ``run.py`` (deterministic, too large to commit).
+
+Expected output (``<name>.json``):
+
+    bytes      stream length
+    messages   decoded messages of at least the 4-byte header
+    digest     CRC-32 chained over every such message as u32 LE length + bytes
+    frames     frame events a client delivers (payload and frame_len complete)
+    ble_adv    BLE advert events a client delivers
+    anomalies  anomaly events a client delivers
+    dropped    frames lost: sequence gaps plus device-reported frame losses
+    decoded    [type, flags, hex] per message (edge-case streams only)
+"""
+
+import json
+import os
+import random
+import struct
+import sys
+import zlib
+from typing import Callable, Dict, List, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+CORPUS_DIR = os.path.join(HERE, "corpus")
+
+HDR_SIZE = 4
+META_FMT = "<IHBbbBBBHH"  # frame_meta_t
+META_SIZE = 16
+BLE_META_SIZE = 14
+ANOMALY_SIZE = 56
+
+MSG_RSP_ACK = 0x81
+MSG_RSP_STATS = 0x84
+MSG_RSP_BULK_ACK = 0x85
+MSG_EVT_FRAME = 0xC0
+MSG_EVT_BLE_ADV = 0xC1
+MSG_EVT_ANOMALY = 0xC2
+MSG_EVT_LOSS = 0xC3
+LOSS_HDR = 8  # loss_meta_t before the counts
+LOSS_REASONS = 6
+LOSS_FRAME_REASONS = 3
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """Reference encoder, independent of the implementations under test."""
+    out = bytearray([0])
+    code_idx, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_idx] = code
+                code_idx, code = len(out), 1
+                out.append(0)
+        else:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+class Stream:
+    """A device byte stream and the output a correct client derives from it."""
+
+    def __init__(self):
+        self.wire = bytearray()
+        self.decoded: List[bytes] = []
+        self.frames = 0
+        self.ble_adv = 0
+        self.anomalies = 0
+        self.seq_dropped = 0
+        self.loss = [0] * LOSS_REASONS  # latest cumulative device counts
+        self._seq_expect = None
+
+    # -- well-formed framing --
+
+    def message(self, msg_type: int, payload: bytes, flags: int = 0, length: int = None) -> None:
+        """Append one COBS frame; ``length`` overrides the header's payload_len."""
+        raw = struct.pack("<BBH", msg_type, flags, len(payload) if length is None else length) + payload
+        self.wire += cobs_encode(raw) + b"\0"
+        self.decoded.append(raw)
+        self._account(raw)
+
+    def frame(self, raw80211: bytes, seq: int, channel: int = 6, rssi: int = -50, ts: int = 0) -> None:
+        meta = struct.pack(META_FMT, ts, len(raw80211), channel, rssi, -95, 0, 0, 0, seq, 0)
+        self.message(MSG_EVT_FRAME, meta + raw80211)
+
+    def ble(self, addr: bytes, data: bytes, rssi: int = -60, ts: int = 0) -> None:
+        meta = struct.pack("<I6sBbBB", ts, addr, 0, rssi, 0, len(data))
+        self.message(MSG_EVT_BLE_ADV, meta + data)
+
+    # -- damage: bytes that must decode to nothing --
+
+    def raw(self, data: bytes) -> None:
+        """Append bytes verbatim; the caller guarantees they yield no message."""
+        self.wire += data
+
+    def short(self, decoded: bytes) -> None:
+        """A valid COBS frame shorter than the header: decodes, then dropped."""
+        assert len(decoded) < HDR_SIZE
+        self.wire += cobs_encode(decoded) + b"\0"
+
+    def overrun(self, code: int, have: int) -> None:
+        """A COBS block whose code byte runs past the delimiter: rejected."""
+        assert 1 <= have < code - 1
+        self.wire += bytes([code]) + bytes(range(1, have + 1)) + b"\0"
+
+    # -- client-side rules (lib/py/sniffer_client.py, lib/ts/src/client.ts) --
+
+    def _account(self, raw: bytes) -> None:
+        msg_type = raw[0]
+        (plen,) = struct.unpack_from("<H", raw, 2)
+        payload = raw[HDR_SIZE : HDR_SIZE + plen]
+        if msg_type == MSG_EVT_FRAME:
+            if len(payload) < META_SIZE:
+                return
+            (frame_len,) = struct.unpack_from("<H", payload, 4)
+            if len(payload) - META_SIZE < frame_len:
+                return
+            (seq,) = struct.unpack_from("<H", payload, 12)
+            if self._seq_expect is not None and seq != self._seq_expect:
+                gap = (seq - self._seq_expect) & 0xFFFF
+                if gap < 0x8000:
+                    self.seq_dropped += gap
+            self._seq_expect = (seq + 1) & 0xFFFF
+            self.frames += 1
+        elif msg_type == MSG_EVT_BLE_ADV:
+            if len(payload) >= BLE_META_SIZE and len(payload) - BLE_META_SIZE >= payload[BLE_META_SIZE - 1]:
+                self.ble_adv += 1
+        elif msg_type == MSG_EVT_ANOMALY:
+            if len(raw) >= HDR_SIZE + ANOMALY_SIZE:
+                self.anomalies += 1
+        elif msg_type == MSG_EVT_LOSS:
+            n = min((len(raw) - HDR_SIZE - LOSS_HDR) // 4, LOSS_REASONS)
+            if n > 0:
+                self.loss[:n] = struct.unpack_from(f"<{n}I", raw, HDR_SIZE + LOSS_HDR)
+
+    def expected(self, with_decoded: bool) -> Dict:
+        crc = 0
+        for m in self.decoded:
+            crc = zlib.crc32(m, zlib.crc32(struct.pack("<I", len(m)), crc))
+        out = {
+            "bytes": len(self.wire),
+            "messages": len(self.decoded),
+            "digest": f"{crc:08x}",
+            "frames": self.frames,
+            "ble_adv": self.ble_adv,
+            "anomalies": self.anomalies,
+            "dropped": self.seq_dropped + sum(self.loss[:LOSS_FRAME_REASONS]),
+        }
+        if with_decoded:
+            out["decoded"] = [[m[0], m[1], m[HDR_SIZE:].hex()] for m in self.decoded]
+        return out
+
+
+def beacon(src: bytes, seq: int, ssid: bytes = b"flock-01") -> bytes:
+    return (b"\x80\x00\x00\x00" + b"\xff" * 6 + src + src + struct.pack("<H", (seq & 0xFFF) << 4)
+            + b"\0" * 8 + b"\x64\x00\x11\x04" + bytes([0, len(ssid)]) + ssid)
+
+
+def nonzero(n: int, start: int = 1) -> bytes:
+    return bytes((start + i) % 255 + 1 for i in range(n))
+
+
+# ---- edge cases (committed) ----
+
+
+def zero_length() -> Stream:
+    s = Stream()
+    s.message(MSG_RSP_ACK, b"")                 # header only, all zeros but the type
+    s.message(0x00, b"")                        # type 0: the whole message is zeros
+    s.frame(b"", seq=0)                         # frame event with an empty 802.11 frame
+    s.ble(b"\x01\x02\x03\x04\x05\x06", b"")     # advert with no AD data
+    s.message(MSG_EVT_ANOMALY, bytes(ANOMALY_SIZE))
+    s.frame(b"", seq=1)
+    return s
+
+
+def runs_254() -> Stream:
+    """Runs of non-zero bytes around COBS's 254-byte block limit."""
+    s = Stream()
+    seq = 0
+    for n in (252, 253, 254, 255, 256, 507, 508, 509, 762):
+        # non-zero header bytes too: the run starts at the message type
+        s.message(0xEE, nonzero(n - HDR_SIZE), flags=0x11, length=0x1111)
+        s.frame(nonzero(n), seq=seq)
+        seq += 1
+    # a message that ends exactly on a block boundary
+    s.message(0xEE, nonzero(254 - HDR_SIZE), flags=0x11, length=0x1111)
+    s.message(0xEE, nonzero(2 * 254 - HDR_SIZE), flags=0x11, length=0x1111)
+    return s
+
+
+def zeros() -> Stream:
+    s = Stream()
+    for n in (1, 2, 253, 254, 255, 600):
+        s.frame(bytes(n), seq=n)  # every byte becomes a code byte
+    s.message(MSG_RSP_STATS, bytes(24))
+    return s
+
+
+def truncated() -> Stream:
+    s = Stream()
+    s.frame(beacon(b"\x02\0\0\0\0\x01", 1), seq=0)
+    meta = struct.pack(META_FMT, 0, 100, 6, -50, -95, 0, 0, 0, 1, 0)
+    s.message(MSG_EVT_FRAME, meta + bytes(40))                   # frame_len past the payload
+    s.message(MSG_EVT_FRAME, meta[:10])                           # meta cut short
+    s.message(MSG_EVT_FRAME, meta + nonzero(100), length=60)      # payload_len cuts the frame
+    s.message(MSG_EVT_BLE_ADV, struct.pack("<I6sBbBB", 0, b"\x01" * 6, 0, -60, 0, 31) + b"\x02\x01\x06")
+    s.message(MSG_EVT_ANOMALY, bytes(ANOMALY_SIZE - 1))
+    s.short(b"")                                                  # empty message body
+    s.short(b"\xc0\x00\x10")
+    s.overrun(0x20, 5)                                            # COBS block cut by the delimiter
+    s.overrun(0xFF, 200)
+    s.raw(b"\0\0\0")                                              # empty frames between delimiters
+    s.frame(beacon(b"\x02\0\0\0\0\x01", 2), seq=1)
+    return s
+
+
+def resync() -> Stream:
+    """Capture starting mid-message, plus garbage between messages."""
+    s = Stream()
+    s.raw(b"\x30\x41\x42\x43")                   # tail of an earlier message: overruns
+    s.raw(b"\0")
+    for i in range(5):
+        s.frame(beacon(b"\x02\0\0\0\0\x02", i), seq=10 + i)
+        s.overrun(0x09, 3)
+    s.message(MSG_RSP_BULK_ACK, struct.pack("<I", 4096))
+    return s
+
+
+def seq_gaps() -> Stream:
+    s = Stream()
+    src = b"\x02\0\0\0\0\x03"
+    for seq in (0, 1, 2, 5, 6, 100, 0xFFFE, 0xFFFF, 0, 3, 2, 4, 0x9000, 0x9001):
+        s.frame(beacon(src, seq), seq=seq)  # 0x9000 is a forward jump, 2 after 3 goes back
+    return s
+
+
+def mixed() -> Stream:
+    rnd = random.Random(86)
+    s = Stream()
+    seq = 0
+    for i in range(60):
+        k = rnd.randrange(10)
+        if k < 5:
+            s.frame(beacon(bytes([2, 0, 0, 0, 0, rnd.randrange(8)]), seq), seq=seq, channel=1 + i % 13)
+            seq += 1
+        elif k < 7:
+            s.ble(rnd.randbytes(6), rnd.randbytes(rnd.randrange(32)))
+        elif k == 7:
+            s.message(MSG_EVT_ANOMALY, rnd.randbytes(ANOMALY_SIZE))
+        elif k == 8:
+            s.message(rnd.choice((MSG_RSP_ACK, MSG_RSP_STATS, MSG_RSP_BULK_ACK)), rnd.randbytes(rnd.randrange(25)))
+        else:
+            s.message(0xF7, rnd.randbytes(rnd.randrange(40)))  # unknown type: decoded, ignored
+    return s
+
+
+def loss() -> Stream:
+    s = Stream()
+    src = b"\x02\0\0\0\0\x04"
+
+    def event(*counts: int, seq_first: int = 0, seq_last: int = 0) -> None:
+        s.message(MSG_EVT_LOSS, struct.pack(f"<IHH{len(counts)}I", 0, seq_first, seq_last, *counts))
+
+    for seq in range(3):
+        s.frame(beacon(src, seq), seq=seq)
+    event(4, 1, 0, 0, 2, 0, seq_first=1, seq_last=3)
+    s.frame(beacon(src, 5), seq=5)                         # transit gap on top of device losses
+    event(40000, 1, 1, 7, 2, 1, seq_first=6, seq_last=6)   # cumulative, past the 0x8000 gap limit
+    s.message(MSG_EVT_LOSS, struct.pack("<IHH", 0, 6, 6))  # no counts: ignored
+    event(40001, 2)                                        # partial: the rest keep their values
+    event(40002, 3, 1, 7, 2, 1, 99)                        # extra counts from a newer firmware
+    s.frame(beacon(src, 6), seq=6)
+    return s
+
+
+def large() -> Stream:
+    rnd = random.Random(1500)
+    s = Stream()
+    for seq in range(8):
+        s.frame(b"\x08\x02" + rnd.randbytes(2298), seq=seq)  # maximum MPDU body
+    return s
+
+
+EDGE_CASES: Dict[str, Callable[[], Stream]] = {
+    "zero_length": zero_length,
+    "runs_254": runs_254,
+    "zeros": zeros,
+    "truncated": truncated,
+    "resync": resync,
+    "seq_gaps": seq_gaps,
+    "mixed": mixed,
+    "loss": loss,
+    "large": large,
+}
+
+
+# ---- throughput (generated by run.py) ----
+
+
+def beacons(n: int) -> Stream:
+    """Beacon events from 2000 transmitters, the common case."""
+    rnd = random.Random(1)
+    macs = [bytes([0x02]) + rnd.randbytes(5) for _ in range(2000)]
+    s = Stream()
+    for i in range(n):
+        s.frame(beacon(macs[rnd.randrange(2000)], i), seq=i & 0xFFFF, channel=1 + i % 13, ts=i * 100)
+    return s
+
+
+def acks(n: int) -> Stream:
+    """Ten-byte control frames: per-message overhead dominates."""
+    s = Stream()
+    for i in range(n):
+        s.frame(b"\xd4\x00\x00\x00\x02\x00\x00\x00\x00" + bytes([i & 0xFF | 1]), seq=i & 0xFFFF, ts=i * 10)
+    return s
+
+
+def data_frames(n: int) -> Stream:
+    """1500-byte data frames with random bodies: per-byte cost dominates."""
+    rnd = random.Random(3)
+    s = Stream()
+    for i in range(n):
+        s.frame(b"\x08\x01" + rnd.randbytes(1498), seq=i & 0xFFFF, ts=i * 1000)
+    return s
+
+
+THROUGHPUT: Dict[str, Tuple[Callable[[int], Stream], int]] = {
+    "beacons": (beacons, 200_000),
+    "acks": (acks, 500_000),
+    "data_1500": (data_frames, 10_000),
+}
+
+
+def write(stream: Stream, directory: str, name: str, with_decoded: bool) -> str:
+    path = os.path.join(directory, name + ".bin")
+    with open(path, "wb") as f:
+        f.write(stream.wire)
+    exp = stream.expected(with_decoded)
+    decoded = exp.pop("decoded", None)
+    lines = [f"  {json.dumps(k)}: {json.dumps(v)}" for k, v in exp.items()]
+    if decoded is not None:  # one message per line, so diffs stay readable
+        lines.append('  "decoded": [\n' + ",\n".join(f"    {json.dumps(m)}" for m in decoded) + "\n  ]")
+    with open(os.path.join(directory, name + ".json"), "w") as f:
+        f.write("{\n" + ",\n".join(lines) + "\n}\n")
+    return path
+
+
+def main() -> None:
+    os.makedirs(CORPUS_DIR, exist_ok=True)
+    for name, build in EDGE_CASES.items():
+        s = build()
+        write(s, CORPUS_DIR, name, True)
+        print(f"{name:<12} {len(s.wire):>7} bytes  {len(s.decoded):>4} messages  {s.frames:>3} frames")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
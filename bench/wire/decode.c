@@ -0,0 +1,142 @@
+/*
+ * Host harness for the firmware's COBS decoder (main/cobs.c).
+ *
+ *   cc -O2 -I main bench/wire/decode.c main/cobs.c -o decode
+ *   ./decode STREAM [CHUNK] [REPEAT]
+ *
+ * Runs the stream through the same accumulate / split-on-0x00 / decode loop
+ * as proto_rx_task, fed CHUNK bytes per read, REPEAT times, and prints one
+ * JSON line: message count and digest (see corpus.py) and the best time.
+ * The firmware loop caps messages at RX_ACCUM_SIZE because it only ever
+ * receives commands; here the cap is the largest device event.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cobs.h"
+
+#define ACCUM_SIZE  (64 * 1024)
+#define HDR_SIZE    4
+
+typedef struct {
+    uint32_t messages;
+    uint64_t bytes;         /* decoded bytes */
+    uint32_t crc;
+    int      digest;        /* fold messages into crc */
+} result_t;
+
+static uint32_t crc_table[256];
+
+static void crc_init(void)
+{
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void on_message(result_t *r, const uint8_t *msg, int len)
+{
+    if (len < HDR_SIZE) return;
+    r->messages++;
+    r->bytes += (uint64_t)len;
+    if (r->digest) {
+        uint8_t le[4] = { (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24) };
+        r->crc = crc32_update(r->crc, le, 4);
+        r->crc = crc32_update(r->crc, msg, (size_t)len);
+    }
+}
+
+static void run(const uint8_t *stream, size_t size, size_t chunk, result_t *r,
+                uint8_t *accum, uint8_t *decoded)
+{
+    size_t accum_len = 0;
+
+    for (size_t off = 0; off < size; off += chunk) {
+        size_t n = size - off < chunk ? size - off : chunk;
+        const uint8_t *rx = stream + off;
+
+        for (size_t i = 0; i < n; i++) {
+            if (rx[i] == 0x00) {
+                if (accum_len > 0) {
+                    int dec_len = cobs_decode(accum, accum_len, decoded);
+                    if (dec_len > 0) on_message(r, decoded, dec_len);
+                    accum_len = 0;
+                }
+            } else if (accum_len < ACCUM_SIZE) {
+                accum[accum_len++] = rx[i];
+            } else {
+                accum_len = 0;  /* overflow: discard and wait for next delimiter */
+            }
+        }
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s STREAM [CHUNK] [REPEAT]\n", argv[0]);
+        return 2;
+    }
+    size_t chunk  = argc > 2 ? (size_t)strtoul(argv[2], NULL, 0) : 4096;
+    int    repeat = argc > 3 ? atoi(argv[3]) : 3;
+    if (chunk == 0) chunk = 1;
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *stream = malloc(size > 0 ? (size_t)size : 1);
+    if (!stream || fread(stream, 1, (size_t)size, f) != (size_t)size) {
+        fprintf(stderr, "%s: read failed\n", argv[1]);
+        return 1;
+    }
+    fclose(f);
+
+    uint8_t *accum   = malloc(ACCUM_SIZE);
+    uint8_t *decoded = malloc(ACCUM_SIZE);
+    crc_init();
+
+    /* correctness pass with the digest, then timed passes without it */
+    result_t check = { .digest = 1 };
+    run(stream, (size_t)size, chunk, &check, accum, decoded);
+
+    double best = 1e30;
+    for (int i = 0; i < repeat; i++) {
+        result_t r = { 0 };
+        double t0 = now_s();
+        run(stream, (size_t)size, chunk, &r, accum, decoded);
+        double dt = now_s() - t0;
+        if (dt < best) best = dt;
+        if (r.messages != check.messages) return 1;
+    }
+
+    printf("{\"impl\": \"c\", \"messages\": %u, \"digest\": \"%08x\", \"seconds\": %.6f}\n",
+           check.messages, check.crc, best);
+    free(stream);
+    free(accum);
+    free(decoded);
+    return 0;
+}
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Run every protocol decoder against the wire corpus, side by side.
+
+    python3 bench/wire/run.py [--impl c,py,ts] [--scale 0.2]
+    python3 bench/wire/run.py --save base.json        # record throughput
+    python3 bench/wire/run.py --compare base.json     # fail on regressions
+
+Implementations:
+
+    c    main/cobs.c in the firmware's RX loop (bench/wire/decode.c, built with $CC)
+    py   lib/py SnifferClient.feed() (lib/py/bench/wire.py)
+    ts   lib/ts SnifferClient.feed() (lib/ts/bench/wire.mjs, built first with `npm run build`)
+
+Edge-case streams from ``corpus/`` are checked at 1-, 7- and 4096-byte read
+sizes. Generated throughput streams are checked and timed. Each result must
+match the expected output in every field the implementation reports. Exits
+non-zero on a mismatch or, with ``--compare``, on a throughput drop beyond
+``--tolerance``.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import Dict, List, Optional
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(os.path.dirname(HERE))
+sys.path.insert(0, HERE)
+
+import corpus  # noqa: E402
+
+EDGE_CHUNKS = (1, 7, 4096)
+CHECKED = ("messages", "digest", "frames", "ble_adv", "anomalies", "dropped")
+
+
+def build_c(tmp: str) -> Optional[List[str]]:
+    cc = os.environ.get("CC", "cc")
+    if shutil.which(cc) is None:
+        return None
+    exe = os.path.join(tmp, "decode_c")
+    subprocess.run(
+        [cc, "-O2", "-I", os.path.join(ROOT, "main"), os.path.join(HERE, "decode.c"),
+         os.path.join(ROOT, "main", "cobs.c"), "-o", exe],
+        check=True,
+    )
+    return [exe]
+
+
+def build_ts() -> bool:
+    """Compile lib/ts/src into dist (not tracked), so wire.mjs never runs a stale build."""
+    npm = shutil.which("npm")
+    if npm is None:
+        return False
+    r = subprocess.run([npm, "run", "--silent", "build"], cwd=os.path.join(ROOT, "lib", "ts"),
+                       capture_output=True, text=True)
+    if r.returncode:
+        print(r.stdout + r.stderr, file=sys.stderr, end="")
+    return r.returncode == 0
+
+
+def harnesses(tmp: str, wanted: List[str], node: str) -> Dict[str, List[str]]:
+    """Command prefix per implementation; each takes STREAM CHUNK REPEAT."""
+    out: Dict[str, List[str]] = {}
+    for impl in wanted:
+        if impl == "c":
+            cmd = build_c(tmp)
+            if cmd is None:
+                print("c: no C compiler, skipped", file=sys.stderr)
+                continue
+            out["c"] = cmd
+        elif impl == "py":
+            out["py"] = [sys.executable, "-m", "lib.py.bench.wire"]
+        elif impl == "ts":
+            if shutil.which(node) is None or not build_ts():
+                print("ts: needs node and a working `npm run build` in lib/ts, skipped", file=sys.stderr)
+                continue
+            out["ts"] = [node, os.path.join(ROOT, "lib", "ts", "bench", "wire.mjs")]
+    return out
+
+
+def run_one(cmd: List[str], impl: str, path: str, chunk: int, repeat: int) -> Dict:
+    if impl == "py":
+        args = cmd + [path, "--chunk", str(chunk), "--repeat", str(repeat)]
+    else:
+        args = cmd + [path, str(chunk), str(repeat)]
+    res = subprocess.run(args, cwd=ROOT, capture_output=True, text=True)
+    if res.returncode != 0:
+        return {"error": (res.stderr or res.stdout).strip().splitlines()[-1:] or ["exit %d" % res.returncode]}
+    return json.loads(res.stdout.strip().splitlines()[-1])
+
+
+def mismatches(result: Dict, expected: Dict) -> List[str]:
+    if "error" in result:
+        return [f"failed: {result['error'][0]}"]
+    return [f"{k}={result[k]} (expected {expected[k]})" for k in CHECKED if k in result and result[k] != expected[k]]
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(prog="bench/wire/run.py", description=__doc__.split("\n")[0])
+    ap.add_argument("--impl", default="c,py,ts", help="Comma-separated implementations (default: c,py,ts)")
+    ap.add_argument("--repeat", type=int, default=3, help="Timed passes per stream, best kept (default: 3)")
+    ap.add_argument("--chunk", type=int, default=4096, help="Bytes per read for throughput streams")
+    ap.add_argument("--scale", type=float, default=1.0, help="Throughput stream size factor (default: 1.0)")
+    ap.add_argument("--node", default="node", help="Node.js executable (default: node)")
+    ap.add_argument("--save", metavar="FILE", help="Write throughput results as a baseline")
+    ap.add_argument("--compare", metavar="FILE", help="Fail if throughput drops below a saved baseline")
+    ap.add_argument("--tolerance", type=float, default=0.25, help="Allowed drop for --compare (default: 0.25)")
+    args = ap.parse_args()
+
+    failed = False
+    with tempfile.TemporaryDirectory() as tmp:
+        impls = harnesses(tmp, args.impl.split(","), args.node)
+        if not impls:
+            print("no implementation available", file=sys.stderr)
+            return 1
+
+        print("correctness (edge cases at read sizes " + ", ".join(map(str, EDGE_CHUNKS)) + ")")
+        for name in corpus.EDGE_CASES:
+            path = os.path.join(corpus.CORPUS_DIR, name + ".bin")
+            with open(os.path.join(corpus.CORPUS_DIR, name + ".json")) as f:
+                expected = json.load(f)
+            status = []
+            for impl, cmd in impls.items():
+                bad = []
+                for chunk in EDGE_CHUNKS:
+                    bad += [f"chunk {chunk}: {m}" for m in mismatches(run_one(cmd, impl, path, chunk, 1), expected)]
+                status.append(f"{impl} {'ok' if not bad else 'FAIL'}")
+                for m in bad[:3]:
+                    print(f"  {name}: {impl} {m}")
+                failed |= bool(bad)
+            print(f"  {name:<12} {'  '.join(status)}")
+
+        print(f"\nthroughput (best of {args.repeat}, {args.chunk}-byte reads)")
+        print(f"  {'stream':<10} {'impl':<4} {'MB/s':>8} {'kmsg/s':>9}  {'vs c':>6}")
+        results: Dict[str, Dict[str, float]] = {}
+        for name, (build, n) in corpus.THROUGHPUT.items():
+            stream = build(max(1, int(n * args.scale)))
+            path = corpus.write(stream, tmp, name, False)
+            expected = stream.expected(False)
+            results[name] = {}
+            base = None
+            for impl, cmd in impls.items():
+                r = run_one(cmd, impl, path, args.chunk, args.repeat)
+                bad = mismatches(r, expected)
+                if bad:
+                    failed = True
+                    print(f"  {name:<10} {impl:<4} FAIL {'; '.join(bad)}")
+                    continue
+                mbps = expected["bytes"] / r["seconds"] / 1e6
+                kmsg = expected["messages"] / r["seconds"] / 1e3
+                results[name][impl] = round(mbps, 2)
+                base = base if base is not None else (mbps if impl == "c" else None)
+                rel = f"{mbps / base:6.2f}" if base else "     -"
+                print(f"  {name:<10} {impl:<4} {mbps:8.1f} {kmsg:9.0f}  {rel}")
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(results, f, indent=1)
+            f.write("\n")
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        print(f"\nagainst {args.compare} (tolerance {args.tolerance:.0%})")
+        for name, per in baseline.items():
+            for impl, old in per.items():
+                new = results.get(name, {}).get(impl)
+                if new is None:
+                    continue
+                change = new / old - 1
+                slow = change < -args.tolerance
+                failed |= slow
+                print(f"  {name:<10} {impl:<4} {old:8.1f} -> {new:8.1f} MB/s  {change:+6.0%}{'  REGRESSION' if slow else ''}")
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
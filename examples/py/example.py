@@ -33,4 +33,4 @@ with SnifferClient(PORT, on_frame=on_frame) as s:
     s.stop()
 
     print(f"Total frames captured: {s.frame_count}")
-    print(f"Frames dropped (estimated): {s.dropped}")
+    print(f"Frames dropped: {s.dropped}")
@@ -1,19 +1,52 @@
 from .sniffer_client import (
     SnifferClient,
     SnifferError,
+    Hop,
     FILTER_ALL,
     FILTER_MGMT,
     FILTER_CTRL,
     FILTER_DATA,
+    MACFILT_OFF,
+    MACFILT_ALLOW,
+    MACFILT_DENY,
+    LOSS_REASON_NAMES,
+    HOP_GUARD_OFF,
+    HOP_GUARD_DROP,
+    HOP_GUARD_RELABEL,
 )
 from .frame import Frame
+from .ble import BleAdv
+from .anomaly import Anomaly
+from .csi import CsiReport, CSI_BITS_8, CSI_BITS_4
+from .classify import Detection, Model
+from .mac import mac_str, mac_parse, oui, is_multicast, is_local
 
 __all__ = [
     "SnifferClient",
     "SnifferError",
+    "Hop",
     "Frame",
+    "BleAdv",
+    "Anomaly",
+    "CsiReport",
+    "CSI_BITS_8",
+    "CSI_BITS_4",
+    "Detection",
+    "Model",
+    "mac_str",
+    "mac_parse",
+    "oui",
+    "is_multicast",
+    "is_local",
     "FILTER_ALL",
     "FILTER_MGMT",
     "FILTER_CTRL",
     "FILTER_DATA",
+    "MACFILT_OFF",
+    "MACFILT_ALLOW",
+    "MACFILT_DENY",
+    "LOSS_REASON_NAMES",
+    "HOP_GUARD_OFF",
+    "HOP_GUARD_DROP",
+    "HOP_GUARD_RELABEL",
 ]
@@ -3,11 +3,48 @@
 
 import argparse
 import signal
+import struct
 import sys
 import threading
-
-from .sniffer_client import SnifferClient, SnifferError, FILTER_MGMT, FILTER_CTRL, FILTER_DATA
-from .frame import Frame
+import time
+
+from .sniffer_client import (
+    SnifferClient,
+    SnifferError,
+    Hop,
+    RSSI_ANY,
+    MACFILT_OFF,
+    MACFILT_ALLOW,
+    MACFILT_DENY,
+    HOP_GUARD_OFF,
+    HOP_GUARD_DROP,
+    HOP_GUARD_RELABEL,
+    HOP_GUARD_MAX_US,
+    HOP_STATS_BUCKET0_US,
+    SYNTH_DIST_FIXED,
+    SYNTH_DIST_UNIFORM,
+    SYNTH_DIST_IMIX,
+    SYNTH_HDR_LEN,
+    SYNTH_MAX_RATE,
+    MSG_EVT_FRAME,
+    LOSS_REASON_NAMES,
+    FILTER_MGMT,
+    FILTER_CTRL,
+    FILTER_DATA,
+)
+from .frame import Frame, META_FMT
+from . import cobs
+from .ble import BleAdv, ADV_TYPE_NAMES
+from .anomaly import Anomaly, REASON_NAMES
+from .mac import mac_parse, mac_str
+from .completeness import CompletenessEstimator
+from .geo import Survey, Track, start_gps
+from .pcapng import PcapngWriter
+from .rawlog import RawRecorder
+from .rrd import RoundRobinStore
+from .trace import write_chrome
+
+LOSS_SETTLE_S = 0.3  # a little over the device's loss event interval
 
 FILTER_NAMES = {
     "mgmt": FILTER_MGMT,
@@ -42,8 +79,8 @@ def frame_type_str(frame: Frame) -> str:
 
 
 def print_frame(frame: Frame) -> None:
-    src = Frame.mac_str(frame.src)
-    dst = Frame.mac_str(frame.dst)
+    src = mac_str(frame.src)
+    dst = mac_str(frame.dst)
     ftype = frame_type_str(frame)
     parts = [
         f"ch={frame.channel:<3d}",
@@ -63,6 +100,39 @@ def print_frame(frame: Frame) -> None:
     print(line, flush=True)
 
 
+def print_ble_adv(adv: BleAdv) -> None:
+    addr = mac_str(adv.addr)
+    atype = ADV_TYPE_NAMES.get(adv.adv_type, f"T{adv.adv_type}")
+    parts = [
+        "ble   ",
+        f"rssi={adv.rssi:<4d}",
+        f"{atype:<16s}",
+        addr,
+    ]
+    name = adv.name
+    if name:
+        parts.append(f'name="{name}"')
+    print("  ".join(parts), flush=True)
+
+
+def print_anomaly(anomaly: Anomaly) -> None:
+    reasons = ", ".join(
+        f"{REASON_NAMES.get(code, code)} x{count}" for code, count in anomaly.reasons
+    )
+    what = "started" if anomaly.onset else "ongoing"
+    line = (
+        f"*** {anomaly.kind_name.upper()} {what} ***  ch={anomaly.channel:<3d} "
+        f"rssi={anomaly.rssi:<4d} {mac_str(anomaly.bssid)} -> {mac_str(anomaly.target)}  "
+        f"deauth={anomaly.deauth_count} disassoc={anomaly.disassoc_count} "
+        f"in {anomaly.duration_ms / 1000:.1f}s"
+    )
+    if anomaly.suppressed:
+        line += f" ({anomaly.suppressed} suppressed)"
+    if reasons:
+        line += f"  reasons: {reasons}"
+    print(f"\033[1;33m{line}\033[0m", flush=True)
+
+
 def parse_filter(value: str) -> int:
     """Parse a comma-separated filter string into a bitmask."""
     if value == "all":
@@ -78,6 +148,51 @@ def parse_filter(value: str) -> int:
     return mask
 
 
+def parse_hop(spec: str) -> Hop:
+    """Parse ``CH:DWELL[:TYPES[:SNAPLEN[:RSSI]]]``, e.g. ``6:500:beacon+data:64:-80``.
+
+    TYPES is ``+``-separated frame types (mgmt, ctrl, data) and management
+    subtype names (beacon, probereq, ...); naming a subtype admits only the
+    named management subtypes.
+    """
+    parts = spec.split(":")
+    if not 2 <= len(parts) <= 5:
+        raise argparse.ArgumentTypeError(f"bad hop {spec!r} (CH:DWELL[:TYPES[:SNAPLEN[:RSSI]]])")
+    try:
+        channel, dwell = int(parts[0]), int(parts[1])
+        snaplen = int(parts[3]) if len(parts) > 3 and parts[3] else 0
+        rssi_min = int(parts[4]) if len(parts) > 4 and parts[4] else RSSI_ANY
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"bad hop {spec!r}")
+    type_mask = subtypes = 0
+    subtype_ids = {v.lower(): k for k, v in MGMT_SUBTYPE_NAMES.items()}
+    if len(parts) > 2 and parts[2] not in ("", "all"):
+        for name in parts[2].lower().split("+"):
+            if name in FILTER_NAMES:
+                type_mask |= FILTER_NAMES[name]
+            elif name in subtype_ids:
+                type_mask |= FILTER_MGMT
+                subtypes |= 1 << subtype_ids[name]
+            else:
+                raise argparse.ArgumentTypeError(f"unknown frame type {name!r} in hop {spec!r}")
+    return Hop(channel, dwell, type_mask, subtypes, snaplen, rssi_min)
+
+
+def parse_schedule(value: str) -> list:
+    return [parse_hop(s) for s in value.split(",") if s]
+
+
+def load_mac_list(path: str) -> list:
+    """One address per line; blank lines and ``#`` comments are ignored."""
+    macs = []
+    with open(path) as f:
+        for line in f:
+            text = line.split("#", 1)[0].strip()
+            if text:
+                macs.append(mac_parse(text))
+    return macs
+
+
 def cmd_scan(client: SnifferClient, args: argparse.Namespace) -> None:
     channel = args.channel
     filt = parse_filter(args.filter)
@@ -91,18 +206,71 @@ def cmd_scan(client: SnifferClient, args: argparse.Namespace) -> None:
         parts.append(f"filter={','.join(names)}")
     else:
         parts.append("filter=all")
+    if args.schedule:
+        parts.append(f"{len(args.schedule)}-hop schedule")
+    macs = load_mac_list(args.mac_filter) if args.mac_filter else []
+    if args.mac_filter:
+        parts.append(f"{args.mac_filter_mode} {len(macs)} MAC(s)")
+    if args.ble:
+        parts.append(f"ble={args.ble}ms every {args.ble_every} hop(s)")
+    if args.record:
+        parts.append(f"recording to {args.record}-*.raw" + (" (not decoding)" if args.record_only else ""))
+    if args.hop_guard:
+        parts.append(f"{args.hop_guard_mode} stale frames for {args.hop_guard}us after a switch")
     print(f"Scanning {', '.join(parts)}... (Ctrl+C to stop)")
 
     done = threading.Event()
     signal.signal(signal.SIGINT, lambda *_: done.set())
 
+    client.ble_config(args.ble, every=args.ble_every)
+    client.set_schedule(args.schedule)
+    client.deauth_config(args.deauth_threshold, suppress=args.suppress_deauth)
+    if args.hop_guard:
+        mode = HOP_GUARD_DROP if args.hop_guard_mode == "drop" else HOP_GUARD_RELABEL
+        client.hop_guard(args.hop_guard, mode)
+    else:
+        client.hop_guard(0, HOP_GUARD_OFF)
+    if args.mac_filter:
+        mode = MACFILT_ALLOW if args.mac_filter_mode == "allow" else MACFILT_DENY
+        client.set_mac_filter(macs, mode)
+    else:
+        client.set_mac_filter([], MACFILT_OFF)
     client.scan(channel=channel, frame_filter=filt)
     done.wait()
 
     client.stop()
-    print(
-        f"\nStopped. {client.frame_count} frames captured, ~{client.dropped} dropped."
-    )
+    if args.recorder is not None:
+        rec = args.recorder
+        print(f"\nRecorded {rec.bytes / 1e6:.1f} MB of raw stream to {len(rec.paths)} segment(s) "
+              f"({args.record}-*.raw)")
+        if args.record_only:
+            return
+    print(f"\nStopped. {client.frame_count} frames captured, {client.dropped} dropped.")
+    lost = {k: v for k, v in client.loss.items() if v}
+    if lost:
+        print("Device-side losses: " + ", ".join(f"{k}={v}" for k, v in lost.items()))
+    if args.ble:
+        print(f"{client.ble_adv_count} BLE advertisements received.")
+    if args.estimator is not None:
+        print_completeness(args.estimator)
+    if args.store is not None:
+        print(f"Activity counted into {args.rrd}.")
+    if args.survey is not None:
+        survey = args.survey
+        tiles = survey.heatmap.export(args.heatmap)
+        print(
+            f"\nGeotagged {survey.tagged} frames ({survey.untagged} without a fix) "
+            f"into {len(survey.heatmap)} cells, {tiles} tiles in {args.heatmap}/"
+        )
+
+
+def print_completeness(est: CompletenessEstimator) -> None:
+    print(f"\nCapture completeness: {est.overall_ratio() * 100:.1f}% overall")
+    for ch, (received, expected, ratio) in est.channels().items():
+        print(f"  ch={ch:<3d} {received:>8d} / {expected:<8d} {ratio * 100:5.1f}%")
+    top = sorted(est.devices().items(), key=lambda d: d[1][1], reverse=True)[:10]
+    for addr, (received, expected, ratio) in top:
+        print(f"  {mac_str(addr)} {received:>8d} / {expected:<8d} {ratio * 100:5.1f}%")
 
 
 def cmd_stop(client: SnifferClient, args: argparse.Namespace) -> None:
@@ -115,6 +283,204 @@ def cmd_status(client: SnifferClient, args: argparse.Namespace) -> None:
     print(f"Promiscuous mode: {'ON' if enabled else 'OFF'}")
 
 
+def cmd_stats(client: SnifferClient, args: argparse.Namespace) -> None:
+    st = client.stats()
+    print(f"Frames sent:      {st['frames_sent']}")
+    print(f"BLE adverts sent: {st['ble_adv_sent']} ({st['ble_adv_dedup']} deduplicated)")
+    print(
+        f"Radio time:       wifi {st['wifi_ms']} ms ({st['wifi_permille'] / 10:.1f}%), "
+        f"ble {st['ble_ms']} ms ({st['ble_permille'] / 10:.1f}%)"
+    )
+
+
+def cmd_hops(client: SnifferClient, args: argparse.Namespace) -> None:
+    st = client.hop_stats()
+    n = st["switches"]
+    mean = st["switch_us_total"] / n if n else 0
+    print(f"Channel switches: {n} (mean {mean:.0f} us, max {st['switch_us_max']} us)")
+    print(
+        f"Settle window:    {st['settle_frames']} frames, {st['stale_frames']} from the old "
+        f"channel, {st['guarded']} guarded (guard {st['guard_us']} us)"
+    )
+    print(f"  {'us':>11}  {'switches':>9}  {'stale':>9}")
+    for i, (sw, stale) in enumerate(zip(st["switch_hist"], st["stale_hist"])):
+        lo = 0 if i == 0 else HOP_STATS_BUCKET0_US << (i - 1)
+        hi = f"{HOP_STATS_BUCKET0_US << i}" if i < len(st["switch_hist"]) - 1 else ""
+        print(f"  {lo:>5}-{hi:<5}  {sw:>9}  {stale:>9}")
+
+
+def parse_sizes(value: str) -> tuple:
+    """N (fixed), A-B (uniform) or imix[:A-B] -> (dist, len_min, len_max)."""
+    dist = SYNTH_DIST_FIXED
+    if value.startswith("imix"):
+        dist = SYNTH_DIST_IMIX
+        value = value[5:] or "64-1500"
+    lo, _, hi = value.partition("-")
+    try:
+        lo, hi = int(lo), int(hi or lo)
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"bad size spec {value!r} (N, A-B or imix[:A-B])")
+    if hi != lo and dist == SYNTH_DIST_FIXED:
+        dist = SYNTH_DIST_UNIFORM
+    if not SYNTH_HDR_LEN <= lo <= hi <= 2300:
+        raise argparse.ArgumentTypeError(f"sizes must be within {SYNTH_HDR_LEN}-2300")
+    return dist, lo, hi
+
+
+class BenchCounter:
+    """on_frame callback counting synthetic frames and their bytes."""
+
+    def __init__(self):
+        self.frames = 0
+        self.bytes = 0
+
+    def __call__(self, frame: Frame) -> None:
+        if frame.channel == 0:
+            self.frames += 1
+            self.bytes += 20 + len(frame.raw)  # header + metadata + frame
+
+
+def percentiles(values: list, ps=(50, 90, 99)) -> str:
+    if not values:
+        return "no replies"
+    v = sorted(values)
+    parts = [f"p{p}={v[min(len(v) - 1, len(v) * p // 100)] * 1e3:.2f}" for p in ps]
+    return " ".join(parts) + f" max={v[-1] * 1e3:.2f} ms"
+
+
+def decode_capacity(sizes: tuple, n: int = 50_000) -> float:
+    """Frames/s this host decodes and dispatches, from a synthetic wire stream."""
+    dist, lo, hi = sizes
+    lens = {SYNTH_DIST_FIXED: (lo,), SYNTH_DIST_UNIFORM: range(lo, hi + 1, max(1, (hi - lo) // 63)),
+            SYNTH_DIST_IMIX: (lo,) * 7 + ((lo + hi) // 2,) * 4 + (hi,)}[dist]
+    parts = []
+    for i in range(n):
+        size = lens[i % len(lens)]
+        raw = (b"\x08\x02\x00\x00" + b"\xff" * 6 + b"\x02SYNT\x00" * 2
+               + struct.pack("<H", (i & 0xFFF) << 4) + bytes([i & 0xFF]) * (size - SYNTH_HDR_LEN))
+        meta = struct.pack(META_FMT, i, size, 0, 0, 0, 2, 0, 0, i & 0xFFFF, 0)
+        msg = struct.pack("<BBH", MSG_EVT_FRAME, 4, len(meta) + size) + meta + raw
+        parts.append(b"\x00" + cobs.encode(msg) + b"\x00")
+    stream = b"".join(parts)
+    counter = BenchCounter()
+    done = threading.Event()
+
+    def on_frame(frame: Frame) -> None:
+        counter(frame)
+        if counter.frames == n:
+            done.set()
+
+    client = SnifferClient(None, on_frame=on_frame)
+    t0 = time.perf_counter()
+    for off in range(0, len(stream), 16384):
+        client.feed(stream[off : off + 16384])
+    done.wait(60)
+    elapsed = time.perf_counter() - t0
+    client.close()
+    return n / elapsed
+
+
+def transit_gaps(client: SnifferClient) -> int:
+    """Frames the device sent that never decoded (seq gaps)."""
+    loss = client.loss
+    return client.dropped - sum(loss[k] for k in LOSS_REASON_NAMES[:3])
+
+
+def cmd_bench(client: SnifferClient, args: argparse.Namespace) -> None:
+    counter = args.counter
+    dist, lo, hi = args.sizes
+    print(f"Link benchmark: {['fixed', 'uniform', 'imix'][dist]} {lo}-{hi} byte frames, "
+          f"{args.seconds:g} s per step")
+
+    rtts = []
+    for i in range(args.pings):
+        rtts.append(client.ping(struct.pack("<I", i))[0])
+    print(f"Idle RTT ({len(rtts)} pings):   {percentiles(rtts)}")
+    capacity = decode_capacity(args.sizes)
+    print(f"Host decode capacity: {capacity:,.0f} frames/s (offline, this machine)\n")
+
+    print(f"{'offered/s':>10} {'frames/s':>10} {'MB/s':>7} {'device loss':>11} {'gaps':>6} "
+          f"{'backlog':>8} {'drain ms':>8}  loaded RTT")
+    best = None
+    behind_at = None
+    rates = args.rates or [1000 << i for i in range(20) if 1000 << i <= SYNTH_MAX_RATE]
+    for rate in rates:
+        loss0 = sum(client.loss[k] for k in ("queue_full", "usb_timeout"))
+        gaps0 = transit_gaps(client)
+        frames0, bytes0 = counter.frames, counter.bytes
+        peak = 0
+        loaded = []
+        client.synth(rate, lo, hi, dist)
+        t0 = time.perf_counter()
+        while time.perf_counter() - t0 < args.seconds:
+            try:
+                loaded.append(client.ping()[0])
+            except SnifferError:
+                pass  # reply lost in the stream or timed out
+            peak = max(peak, client.backlog + client.rx_pending // (20 + lo))
+            time.sleep(0.1)
+        elapsed = time.perf_counter() - t0
+        client.synth(0)
+        # drain: until the decoder has delivered everything that arrived
+        t1 = time.perf_counter()
+        while (client.backlog or client.rx_pending) and time.perf_counter() - t1 < 10:
+            time.sleep(0.005)
+        drain = time.perf_counter() - t1
+        time.sleep(LOSS_SETTLE_S)  # let the device's next loss event arrive
+
+        got = counter.frames - frames0
+        fps = got / elapsed
+        mbs = (counter.bytes - bytes0) / elapsed / 1e6
+        lost = sum(client.loss[k] for k in ("queue_full", "usb_timeout")) - loss0
+        gaps = transit_gaps(client) - gaps0
+        print(f"{rate:>10,} {fps:>10,.0f} {mbs:>7.2f} {lost:>11,} {gaps:>6,} {peak:>8,} "
+              f"{drain * 1e3:>8.0f}  {percentiles(loaded, (50, 99))}")
+
+        behind = drain > 0.25 * args.seconds
+        if behind and behind_at is None:
+            behind_at = rate
+        offered = got + lost + gaps
+        if offered and (lost + gaps) / offered <= 0.001 and not behind:
+            best = (rate, fps, mbs)
+        elif offered and (lost + gaps) / offered > 0.05:
+            break
+
+    print()
+    if best:
+        print(f"Max sustained: {best[1]:,.0f} frames/s, {best[2]:.2f} MB/s (offered {best[0]:,}/s, <0.1% loss)")
+    else:
+        print("No step ran without loss")
+    if behind_at:
+        print(f"Host decode fell behind at {behind_at:,} frames/s offered")
+    else:
+        print("Host decode kept up at every step; the limit is the device or the link")
+
+
+def cmd_trace(client: SnifferClient, args: argparse.Namespace) -> None:
+    if args.synth:
+        print(f"Tracing {args.seconds:g} s of {args.synth:,} synthetic frames/s...")
+    else:
+        print(f"Tracing {args.seconds:g} s of scanning {f'channel {args.channel}' if args.channel else 'all channels'}...")
+    client.trace_start()
+    if args.synth:
+        client.synth(args.synth, 64, 1500, SYNTH_DIST_IMIX)
+    else:
+        client.scan(channel=args.channel)
+    time.sleep(args.seconds)
+    try:
+        dump = client.trace_dump()
+    finally:
+        if args.synth:
+            client.synth(0)
+        else:
+            client.stop()
+    write_chrome(dump, args.output)
+    span = (dump.device_ns(dump.records[-1][0]) - dump.device_ns(dump.records[0][0])) / 1e6 if dump.records else 0
+    print(f"{len(dump.records)} device events over the last {span:.1f} ms ({dump.lost} overwritten), "
+          f"{len(dump.host_spans)} host spans, clock synced to {dump.sync_rtt_ns / 2e3:.0f} us")
+    print(f"Wrote {args.output}; open it in https://ui.perfetto.dev")
+
+
 def cmd_promisc(client: SnifferClient, args: argparse.Namespace) -> None:
     action = args.action
     if action is None:
@@ -156,9 +522,168 @@ def main() -> int:
         default="all",
         help="Frame type filter: all, mgmt, ctrl, data (comma-separated, e.g. mgmt,data)",
     )
+    p_scan.add_argument(
+        "--schedule",
+        type=parse_schedule,
+        default=[],
+        metavar="HOPS",
+        help="Comma-separated hop schedule with per-hop capture profiles, each "
+        "CH:DWELL[:TYPES[:SNAPLEN[:RSSI]]] (e.g. 6:1000:mgmt+data,1:300:beacon:64,11:300:beacon:64:-85)",
+    )
+    p_scan.add_argument(
+        "--completeness",
+        action="store_true",
+        help="Estimate capture completeness from 802.11 sequence gaps",
+    )
+    p_scan.add_argument(
+        "--deauth-threshold",
+        type=int,
+        default=0,
+        metavar="N",
+        help="Report a deauth/disassoc flood at N frames per second per BSSID/target "
+        "(e.g. 20; default: 0 = off)",
+    )
+    p_scan.add_argument(
+        "--suppress-deauth",
+        action="store_true",
+        help="Drop the individual frames of a detected deauth flood",
+    )
+    p_scan.add_argument(
+        "--mac-filter",
+        metavar="FILE",
+        help="Filter on the device by the MAC addresses in FILE (one per line)",
+    )
+    p_scan.add_argument(
+        "--mac-filter-mode",
+        choices=["allow", "deny"],
+        default="allow",
+        help="Keep only frames involving a listed address, or drop them "
+        "(default: allow)",
+    )
+    p_scan.add_argument(
+        "--pcapng",
+        metavar="FILE",
+        help="Also record frames to a pcapng file (radiotap; see lib.py.pcapng)",
+    )
+    p_scan.add_argument(
+        "--rrd",
+        metavar="FILE",
+        help="Also count per-channel frames and device presence into a round-robin "
+        "store made with 'python -m lib.py.rrd create'",
+    )
+    p_scan.add_argument(
+        "--record",
+        metavar="PREFIX",
+        help="Also record the raw device stream to PREFIX-NNNNN.raw (see lib.py.rawlog)",
+    )
+    p_scan.add_argument(
+        "--record-only",
+        action="store_true",
+        help="With --record, skip decoding: nothing is printed, and recording costs "
+        "about a buffer append per read",
+    )
+    p_scan.add_argument(
+        "--record-mb",
+        type=int,
+        default=256,
+        help="Rotate raw segments after this many MB (default: 256)",
+    )
+    p_scan.add_argument(
+        "--gps",
+        metavar="PORT",
+        help="NMEA GPS receiver serial port (or NMEA log file) for geotagging",
+    )
+    p_scan.add_argument(
+        "--gps-baud", type=int, default=9600, help="GPS baud rate (default: 9600)"
+    )
+    p_scan.add_argument(
+        "--heatmap",
+        metavar="DIR",
+        default="heatmap",
+        help="Directory for geohash heatmap tiles with --gps (default: heatmap)",
+    )
+    p_scan.add_argument(
+        "--ble",
+        type=int,
+        default=0,
+        metavar="MS",
+        help="Interleave BLE scan windows of MS milliseconds (default: off)",
+    )
+    p_scan.add_argument(
+        "--ble-every",
+        type=int,
+        default=1,
+        metavar="N",
+        help="Insert a BLE window after every N Wi-Fi hops (default: 1)",
+    )
+
+    p_scan.add_argument(
+        "--hop-guard",
+        type=int,
+        default=0,
+        metavar="US",
+        help="After each channel switch, guard this many microseconds against "
+        f"frames from the old channel (max {HOP_GUARD_MAX_US}; default: off)",
+    )
+    p_scan.add_argument(
+        "--hop-guard-mode",
+        choices=["drop", "relabel"],
+        default="drop",
+        help="Drop guarded frames, or judge them by the previous hop's profile "
+        "(default: drop)",
+    )
 
     sub.add_parser("stop", help="Stop scanning")
     sub.add_parser("status", help="Query promiscuous mode status")
+    sub.add_parser("stats", help="Show device counters and radio duty cycle")
+    sub.add_parser("hops", help="Show channel-switch timing since the scan started")
+
+    p_bench = sub.add_parser(
+        "bench", help="Measure link throughput and RTT with synthetic frames (no radio)"
+    )
+    p_bench.add_argument(
+        "--sizes",
+        type=parse_sizes,
+        default=parse_sizes("imix"),
+        metavar="SPEC",
+        help="Frame lengths: N, A-B (uniform) or imix[:A-B] (7:4:1; default: imix:64-1500)",
+    )
+    p_bench.add_argument(
+        "--rates",
+        type=lambda v: [int(r) for r in v.split(",")],
+        default=None,
+        help="Comma-separated frames/s to step through (default: doubling from 1000 "
+        "until loss passes 5%%)",
+    )
+    p_bench.add_argument(
+        "--seconds", type=float, default=3.0, help="Duration of each step (default: 3)"
+    )
+    p_bench.add_argument(
+        "--pings", type=int, default=200, help="Idle pings for the RTT baseline (default: 200)"
+    )
+
+    p_trace = sub.add_parser(
+        "trace", help="Record a device event trace with the client's spans as a Perfetto timeline"
+    )
+    p_trace.add_argument(
+        "-c", "--channel", type=int, default=None, help="Channel to scan (omit for all channels)"
+    )
+    p_trace.add_argument(
+        "--synth",
+        type=int,
+        default=0,
+        metavar="RATE",
+        help="Trace synthetic imix frames at RATE/s instead of scanning (no radio)",
+    )
+    p_trace.add_argument(
+        "--seconds",
+        type=float,
+        default=2.0,
+        help="Run this long before the dump; the ring keeps the last 2048 events (default: 2)",
+    )
+    p_trace.add_argument(
+        "-o", "--output", default="trace.json", help="Chrome trace JSON file (default: trace.json)"
+    )
 
     p_promisc = sub.add_parser("promisc", help="Control promiscuous mode")
     p_promisc.add_argument(
@@ -169,11 +694,64 @@ def main() -> int:
     )
 
     args = parser.parse_args()
+    record_only = args.command == "scan" and args.record_only
+    if record_only and (not args.record or args.completeness or args.gps or args.pcapng or args.rrd):
+        parser.error("--record-only needs --record, and excludes decoding options")
 
     on_frame = print_frame if args.command == "scan" else None
+    if args.command == "bench":
+        on_frame = args.counter = BenchCounter()
+    args.estimator = None
+    args.survey = None
+    args.writer = None
+    args.store = None
+    if args.command == "scan" and (args.completeness or args.gps or args.pcapng or args.rrd):
+        est = args.estimator = CompletenessEstimator() if args.completeness else None
+        writer = args.writer = PcapngWriter(args.pcapng) if args.pcapng else None
+        if args.rrd:
+            try:
+                args.store = RoundRobinStore(args.rrd, writable=True)
+            except (OSError, ValueError) as e:
+                print(f"Error opening {args.rrd}: {e}", file=sys.stderr)
+                return 1
+        store = args.store
+        if args.gps:
+            track = Track()
+            try:
+                start_gps(args.gps, track, args.gps_baud)
+            except Exception as e:
+                print(f"Error opening GPS {args.gps}: {e}", file=sys.stderr)
+                return 1
+            args.survey = Survey(track)
+        survey = args.survey
+
+        def on_frame(frame: Frame) -> None:
+            print_frame(frame)
+            if est is not None:
+                est.update(frame)
+            if survey is not None:
+                survey.observe(frame)
+            if writer is not None:
+                writer.write(frame)
+            if store is not None:
+                store.observe(frame)
+
+    on_ble_adv = print_ble_adv if args.command == "scan" else None
+    on_anomaly = print_anomaly if args.command == "scan" else None
+    args.recorder = None
+    if args.command == "scan" and args.record:
+        args.recorder = RawRecorder(args.record, segment_bytes=args.record_mb << 20)
 
     try:
-        client = SnifferClient(args.port, baudrate=args.baud, on_frame=on_frame)
+        client = SnifferClient(
+            args.port,
+            baudrate=args.baud,
+            on_frame=on_frame,
+            on_ble_adv=on_ble_adv,
+            on_anomaly=on_anomaly,
+            record=args.recorder,
+            decode=not record_only,
+        )
     except Exception as e:
         print(f"Error opening {args.port}: {e}", file=sys.stderr)
         return 1
@@ -185,6 +763,14 @@ def main() -> int:
             cmd_stop(client, args)
         elif args.command == "status":
             cmd_status(client, args)
+        elif args.command == "stats":
+            cmd_stats(client, args)
+        elif args.command == "hops":
+            cmd_hops(client, args)
+        elif args.command == "bench":
+            cmd_bench(client, args)
+        elif args.command == "trace":
+            cmd_trace(client, args)
         elif args.command == "promisc":
             cmd_promisc(client, args)
     except SnifferError as e:
@@ -192,6 +778,10 @@ def main() -> int:
         return 1
     finally:
         client.close()
+        if args.writer is not None:
+            args.writer.close()
+        if args.store is not None:
+            args.store.close()
 
     return 0
 
@@ -0,0 +1,98 @@
+"""Anomaly event raised by the firmware's on-device detectors."""
+
+import struct
+from typing import List, Tuple
+
+from .mac import mac_from_bytes, mac_str
+
+# event struct format (matches firmware anomaly_meta_t, 56 bytes)
+ANOMALY_FMT = "<IBB6s6sBbHBxIIII8H"
+ANOMALY_SIZE = struct.calcsize(ANOMALY_FMT)  # 56
+
+ANOMALY_DEAUTH_FLOOD = 0x01
+ANOMALY_FLAG_ONSET = 0x01
+
+ANOMALY_KIND_NAMES = {
+    ANOMALY_DEAUTH_FLOOD: "deauth-flood",
+}
+
+# common 802.11 reason codes seen in deauth/disassoc frames
+REASON_NAMES = {
+    1: "unspecified",
+    2: "prev-auth-invalid",
+    3: "leaving",
+    4: "inactivity",
+    5: "ap-full",
+    6: "class2-from-nonauth",
+    7: "class3-from-nonassoc",
+    8: "leaving-bss",
+    15: "4way-timeout",
+}
+
+
+class Anomaly:
+    """A detector report: who is being flooded, by whom, and how hard.
+
+    Counts cover the flood since its onset; ``onset`` is True on the first
+    report, later ones are periodic updates while it continues.
+    """
+
+    __slots__ = (
+        "timestamp_us",
+        "kind",
+        "flags",
+        "bssid",
+        "target",
+        "channel",
+        "rssi",
+        "window_count",
+        "duration_ms",
+        "deauth_count",
+        "disassoc_count",
+        "suppressed",
+        "reasons",
+    )
+
+    def __init__(self, payload: bytes):
+        f = struct.unpack_from(ANOMALY_FMT, payload)
+        (
+            self.timestamp_us,
+            self.kind,
+            self.flags,
+            bssid,
+            target,
+            self.channel,
+            self.rssi,
+            self.window_count,
+            num_reasons,
+            self.duration_ms,
+            self.deauth_count,
+            self.disassoc_count,
+            self.suppressed,
+        ) = f[:13]
+        self.bssid = mac_from_bytes(bssid)
+        self.target = mac_from_bytes(target)
+        pairs = f[13:]
+        self.reasons: List[Tuple[int, int]] = [
+            (pairs[2 * i], pairs[2 * i + 1]) for i in range(min(num_reasons, 4))
+        ]
+
+    @property
+    def onset(self) -> bool:
+        return bool(self.flags & ANOMALY_FLAG_ONSET)
+
+    @property
+    def kind_name(self) -> str:
+        return ANOMALY_KIND_NAMES.get(self.kind, f"0x{self.kind:02x}")
+
+    def __repr__(self) -> str:
+        reasons = ",".join(
+            f"{REASON_NAMES.get(code, code)}:{count}" for code, count in self.reasons
+        )
+        return (
+            f"Anomaly({self.kind_name}{' onset' if self.onset else ''}, "
+            f"bssid={mac_str(self.bssid)}, target={mac_str(self.target)}, "
+            f"ch={self.channel}, rssi={self.rssi}, deauth={self.deauth_count}, "
+            f"disassoc={self.disassoc_count}, suppressed={self.suppressed}, "
+            f"{self.duration_ms}ms, reasons={reasons})"
+        )
@@ -0,0 +1,79 @@
+"""Capture-completeness estimator on a replayed hopping capture.
+
+    python -m lib.py.bench.completeness [seconds]
+
+Synthesizes transmitters on channels 1/6/11 with known sequence counters,
+"captures" only what is sent while a 13-channel hop schedule sits on their
+channel (plus random radio loss), then compares the estimator's ratios
+with ground truth and reports update throughput.
+"""
+
+import random
+import struct
+import sys
+import time
+
+from ..completeness import CompletenessEstimator
+from ..frame import Frame
+
+SECONDS = float(sys.argv[1]) if len(sys.argv) > 1 else 120.0
+DWELL_MS = 200
+CHANNELS = list(range(1, 14))
+RADIO_LOSS = 0.05
+
+
+def replay():
+    rnd = random.Random(7)
+    txs = []
+    for i in range(60):
+        ch = (1, 6, 11)[i % 3]
+        rate = rnd.choice((10, 10, 30, 100))  # frames/s: beacons .. busy clients
+        qos = i % 2 == 1
+        txs.append((0x020000000000 | i, ch, rate, qos))
+
+    events = []
+    for addr, ch, rate, qos in txs:
+        t, seq = rnd.random() / rate, rnd.randrange(4096)
+        while t < SECONDS:
+            events.append((t, addr, ch, qos, seq))
+            seq = (seq + 1) & 0xFFF
+            t += rnd.expovariate(rate)
+    events.sort()
+
+    cycle = DWELL_MS * len(CHANNELS) / 1000
+    sent = {c: 0 for c in (1, 6, 11)}
+    captured = []
+    for t, addr, ch, qos, seq in events:
+        sent[ch] += 1
+        on = CHANNELS[int((t % cycle) * 1000 // DWELL_MS)]
+        if on != ch or rnd.random() < RADIO_LOSS:
+            continue
+        fc = 0x88 if qos else 0x08  # QoS data / data
+        raw = struct.pack("<HH", fc, 0) + b"\xff" * 6 + addr.to_bytes(6, "big")
+        raw += addr.to_bytes(6, "big") + struct.pack("<H", seq << 4)
+        if qos:
+            raw += b"\x00\x00"  # QoS control, TID 0
+        meta = struct.pack("<IHBbbBBBHH", int(t * 1e6) & 0xFFFFFFFF, len(raw), ch, -60, -95, 2, 0, 0, 0, 0)
+        captured.append(Frame(meta, raw))
+    return sent, captured
+
+
+def main() -> None:
+    sent, frames = replay()
+    est = CompletenessEstimator()
+    t0 = time.perf_counter()
+    for f in frames:
+        est.update(f)
+    dt = time.perf_counter() - t0
+
+    truth = 1 / len(CHANNELS) * (1 - RADIO_LOSS)
+    print(f"{len(frames)} captured frames, {SECONDS:.0f} s, {len(CHANNELS)} x {DWELL_MS} ms hops")
+    print(f"update: {len(frames) / dt / 1e3:.0f} kframes/s\n")
+    print(f"{'ch':>3} {'true':>7} {'estimated':>10}")
+    for ch, (received, expected, ratio) in est.channels().items():
+        print(f"{ch:>3} {received / sent[ch] * 100:6.1f}% {ratio * 100:9.1f}%")
+    print(f"\nexpected ratio for this schedule: {truth * 100:.1f}%")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,191 @@
+"""Frame layout: memory per retained frame and attribute-access cost.
+
+    python -m lib.py.bench.frame [frames]
+
+"before" reproduces the previous layout: ten metadata fields unpacked into
+slots, plus a ``__dict__`` for ``cached_property`` header fields. "after" is
+``Frame``. Memory is counted with tracemalloc while the frames are built
+and kept, with the metadata freshly allocated per frame as the client does.
+``raw`` is allocated beforehand, so the figures leave it out. Memory is
+measured twice: on fresh frames, and after a pass that touches the
+addresses and the SSID. Access cost is ns per read in a loop over the
+frames (best of 7), with the loop's own cost subtracted and the header
+fields already parsed. "build" is ns per frame to construct it.
+"""
+
+import random
+import struct
+import sys
+import time
+import tracemalloc
+from functools import cached_property
+
+from ..frame import Frame, FRAME_TYPE_MGMT, META_FMT
+from ..mac import BROADCAST
+
+N = int(sys.argv[1]) if len(sys.argv) > 1 else 200_000
+ATTRS = ("timestamp_us", "rssi", "channel", "seq_num", "frame_type", "addr2", "src", "ssid")
+
+_unpack_u64 = struct.Struct(">Q").unpack_from
+
+
+class DictFrame:
+    """The previous layout, reduced to the fields used here."""
+
+    __slots__ = ("_ts", "_frame_len", "_channel", "_rssi", "_noise_floor", "_pkt_type",
+                 "_rx_state", "_rate", "_seq_num", "_orig_len", "_raw", "__dict__")
+
+    def __init__(self, meta: bytes, raw: bytes):
+        (self._ts, self._frame_len, self._channel, self._rssi, self._noise_floor, self._pkt_type,
+         self._rx_state, self._rate, self._seq_num, self._orig_len) = struct.unpack_from(META_FMT, meta)
+        self._raw = raw
+
+    @property
+    def timestamp_us(self):
+        return self._ts
+
+    @property
+    def rssi(self):
+        return self._rssi
+
+    @property
+    def channel(self):
+        return self._channel
+
+    @property
+    def seq_num(self):
+        return self._seq_num
+
+    @cached_property
+    def frame_control(self):
+        return 0 if len(self._raw) < 2 else struct.unpack_from("<H", self._raw, 0)[0]
+
+    @cached_property
+    def frame_type(self):
+        return (self.frame_control >> 2) & 0x03
+
+    @cached_property
+    def to_ds(self):
+        return bool(self.frame_control & (1 << 8))
+
+    @cached_property
+    def from_ds(self):
+        return bool(self.frame_control & (1 << 9))
+
+    @cached_property
+    def addr1(self):
+        return None if len(self._raw) < 10 else _unpack_u64(self._raw, 2)[0] & BROADCAST
+
+    @cached_property
+    def addr2(self):
+        return None if len(self._raw) < 16 else _unpack_u64(self._raw, 8)[0] & BROADCAST
+
+    @cached_property
+    def addr3(self):
+        return None if len(self._raw) < 22 else _unpack_u64(self._raw, 14)[0] & BROADCAST
+
+    @cached_property
+    def src(self):
+        if self.frame_type == FRAME_TYPE_MGMT or not self.from_ds:
+            return self.addr2
+        return self.addr3 if not self.to_ds else None
+
+    @cached_property
+    def ssid(self):
+        if self.frame_type != FRAME_TYPE_MGMT:
+            return None
+        data, pos = self._raw, 36
+        while pos + 2 <= len(data):
+            if data[pos] == 0:
+                return str(data[pos + 2 : pos + 2 + data[pos + 1]], "utf-8", errors="replace")
+            pos += 2 + data[pos + 1]
+        return None
+
+
+def make_records(n: int):
+    """(meta, raw) pairs: beacons, probe requests and data frames from 2000 devices."""
+    rnd = random.Random(1)
+    macs = [bytes([0x02]) + rnd.randbytes(5) for _ in range(2000)]
+    out = []
+    for i in range(n):
+        src = macs[rnd.randrange(len(macs))]
+        kind = i % 4
+        if kind == 0:
+            ssid = b"net-%d" % (i % 50)
+            raw = (b"\x80\x00\x00\x00" + b"\xff" * 6 + src + src + struct.pack("<H", (i & 0xFFF) << 4)
+                   + bytes(12) + bytes([0, len(ssid)]) + ssid + b"\x01\x04\x82\x84\x8b\x96")
+        elif kind == 1:
+            raw = (b"\x40\x00\x00\x00" + b"\xff" * 6 + src + b"\xff" * 6 + struct.pack("<H", (i & 0xFFF) << 4)
+                   + b"\x00\x00\x01\x04\x82\x84\x8b\x96")
+        else:
+            raw = (b"\x08\x02\x00\x00" + macs[i % 7] + macs[i % 11] + src + struct.pack("<H", (i & 0xFFF) << 4)
+                   + bytes(rnd.choice((40, 120, 600))))
+        meta = struct.pack(META_FMT, rnd.getrandbits(32), len(raw), 1 + i % 13, -30 - i % 60, -95,
+                           0, 0, 11, i & 0xFFFF, 0)
+        out.append((bytearray(meta), raw))
+    return out
+
+
+def retained(cls, records):
+    """Return (frames, bytes per fresh frame, bytes per frame after a touch pass)."""
+    tracemalloc.start()
+    base = tracemalloc.get_traced_memory()[0]
+    frames = [cls(bytes(meta), raw) for meta, raw in records]
+    fresh = tracemalloc.get_traced_memory()[0] - base
+    for f in frames:
+        f.addr1, f.addr2, f.addr3, f.src, f.ssid
+    touched = tracemalloc.get_traced_memory()[0] - base
+    tracemalloc.stop()
+    # the list itself holds 8 bytes per frame in both layouts
+    n = len(frames)
+    return frames, fresh / n - 8, touched / n - 8
+
+
+def build_ns(cls, records) -> float:
+    best = float("inf")
+    for _ in range(3):
+        t0 = time.perf_counter()
+        frames = [cls(bytes(meta), raw) for meta, raw in records]
+        best = min(best, time.perf_counter() - t0)
+        del frames
+    return best / len(records) * 1e9
+
+
+def _loop(body: str):
+    ns = {}
+    exec(f"def run(frames):\n    for f in frames:\n        {body}\n", ns)
+    return ns["run"]
+
+
+def access_ns(frames, attr: str) -> float:
+    run, empty = _loop(f"f.{attr}"), _loop("f")
+    best = [float("inf")] * 2
+    for _ in range(7):
+        for i, fn in enumerate((run, empty)):
+            t0 = time.perf_counter()
+            fn(frames)
+            best[i] = min(best[i], time.perf_counter() - t0)
+    return max(best[0] - best[1], 0.0) / len(frames) * 1e9
+
+
+def main() -> None:
+    records = make_records(N)
+    print(f"{N} frames (beacons, probe requests, data)\n")
+    results = {}
+    for name, cls in (("before", DictFrame), ("after", Frame)):
+        frames, fresh, touched = retained(cls, records)
+        ns = {"build": build_ns(cls, records)}
+        ns.update((a, access_ns(frames, a)) for a in ATTRS)
+        results[name] = (fresh, touched, ns)
+        del frames
+
+    print(f"{'bytes/frame':<14} {'before':>8} {'after':>8}")
+    for i, label in enumerate(("fresh", "touched")):
+        print(f"{label:<14} {results['before'][i]:>8.0f} {results['after'][i]:>8.0f}")
+    print(f"\n{'ns/read':<14} {'before':>8} {'after':>8}")
+    for a in ("build",) + ATTRS:
+        print(f"{a:<14} {results['before'][2][a]:>8.1f} {results['after'][2][a]:>8.1f}")
+
+
+if __name__ == "__main__":
+    main()
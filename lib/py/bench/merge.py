@@ -0,0 +1,125 @@
+"""External merge throughput in GB/min, plain and compressed output.
+
+    python -m lib.py.bench.merge [frames] [sensors] [segments]
+
+Writes a synthetic capture set to a temporary directory: each sensor
+records ``segments`` consecutive segments over the same time span. A quarter
+of every sensor's frames are also heard by the next sensor, up to 2 ms
+later. One segment is shuffled, so it goes through the spilled-run path.
+The set is merged at gzip levels 0, 1 and 6. Each output is read back and
+checked for time order, for the packet count and for every cross-sensor
+copy having been dropped. The compressed output is read back with the
+sidecar index on 1 and on all threads.
+"""
+
+import glob
+import os
+import random
+import struct
+import sys
+import tempfile
+import time
+
+from ..frame import Frame, META_FMT
+from ..merge import GzSegmentReader, merge_captures
+from ..pcapng import PcapngReader, PcapngWriter
+
+N = int(sys.argv[1]) if len(sys.argv) > 1 else 400_000
+SENSORS = int(sys.argv[2]) if len(sys.argv) > 2 else 4
+SEGMENTS = int(sys.argv[3]) if len(sys.argv) > 3 else 4
+SHARED = 4  # 1 in SHARED frames is also heard by the next sensor
+LEVELS = (0, 1, 6)
+
+
+def _frame(rnd: random.Random, seq: int, channel: int) -> Frame:
+    body = rnd.randbytes(rnd.choice((0, 40, 120, 400, 1200)))
+    raw = (b"\x08\x01\x00\x00" + b"\x02\x00\x00\x00\x00\x01" + rnd.randbytes(6) + b"\x02\x00\x00\x00\x00\x01"
+           + struct.pack("<H", (seq & 0xFFF) << 4) + body)
+    meta = struct.pack(META_FMT, 0, len(raw), channel, -40 - seq % 50, -95, 0, 0, 0, 0, 0)
+    return Frame(meta, raw)
+
+
+def write_set(root: str) -> tuple:
+    """Return (paths, distinct frames)."""
+    rnd = random.Random(1)
+    per = N // (SENSORS * SEGMENTS)
+    t_base = 1_700_000_000_000_000
+    # per sensor: list of (ts, frame) in time order
+    heard = [[] for _ in range(SENSORS)]
+    distinct = 0
+    for s in range(SENSORS):
+        t = t_base + s * 37
+        for i in range(per * SEGMENTS):
+            t += rnd.randrange(100, 400)
+            f = _frame(rnd, i, 1 + s % 11)
+            heard[s].append((t, f))
+            distinct += 1
+            if i % SHARED == 0:
+                heard[(s + 1) % SENSORS].append((t + rnd.randrange(0, 2000), f))
+    paths = []
+    for s in range(SENSORS):
+        frames = sorted(heard[s], key=lambda x: x[0])
+        seg = len(frames) // SEGMENTS + 1
+        for k in range(SEGMENTS):
+            chunk = frames[k * seg : (k + 1) * seg]
+            if s == 0 and k == 0:
+                rnd.shuffle(chunk)
+            path = os.path.join(root, f"sensor{s}-{k:03d}.pcapng")
+            with PcapngWriter(path) as w:
+                for ts, f in chunk:
+                    w.write(f, ts)
+            paths.append(path)
+    rnd.shuffle(paths)
+    return paths, distinct
+
+
+def read_back(level: int, prefix: str, workers: int = 0):
+    last = 0
+    n = 0
+    if level:
+        for path in sorted(glob.glob(prefix + "-*.pcapng.gz")):
+            for ts, _iface, _data, _orig in GzSegmentReader(path, workers or None).records():
+                assert ts >= last, "output out of order"
+                last = ts
+                n += 1
+    else:
+        for path in sorted(glob.glob(prefix + "-*.pcapng")):
+            with PcapngReader(path) as r:
+                ts = r.timestamps()
+                assert list(ts) == sorted(ts) and (not ts or ts[0] >= last), "output out of order"
+                last = ts[-1] if ts else last
+                n += len(ts)
+    return n
+
+
+def main() -> None:
+    with tempfile.TemporaryDirectory() as root:
+        t0 = time.perf_counter()
+        paths, distinct = write_set(root)
+        size = sum(os.path.getsize(p) for p in paths)
+        print(f"{len(paths)} segments from {SENSORS} sensors, {size / 1e6:.0f} MB, {distinct} distinct frames "
+              f"(written in {time.perf_counter() - t0:.1f} s), {os.cpu_count()} cores\n")
+
+        for level in LEVELS:
+            prefix = os.path.join(root, f"out{level}")
+            t0 = time.perf_counter()
+            st = merge_captures(paths, prefix, segment_bytes=max(size // 3, 1 << 20), run_bytes=8 << 20,
+                                dedup_us=5000, level=level)
+            dt = time.perf_counter() - t0
+            assert st["packets_out"] == distinct, (st, distinct)
+            assert read_back(level, prefix) == distinct
+            print(f"level {level}: {size / 1e9 / dt * 60:6.2f} GB/min ({dt:.2f} s)  "
+                  f"{st['duplicates']} duplicates, {st['runs']} run(s), "
+                  f"{st['segments']} segment(s), {st['output_bytes'] / 1e6:.0f} MB")
+
+        prefix = os.path.join(root, "out1")
+        out = sum(os.path.getsize(p) for p in glob.glob(prefix + "-*.pcapng.gz"))
+        for workers in sorted({1, os.cpu_count() or 1}):
+            t0 = time.perf_counter()
+            read_back(1, prefix, workers)
+            dt = time.perf_counter() - t0
+            print(f"read back level 1, {workers} thread(s): {out / 1e9 / dt * 60:6.2f} GB/min compressed ({dt:.2f} s)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+"""Map-reduce scaling over a pcapng archive, 1 to 16 worker processes.
+
+    python -m lib.py.bench.pcapng_scaling [frames] [segments]
+
+Writes a synthetic archive to a temporary directory, times the first open
+(block walk + ``.idx`` write) against a cached open, then runs the CLI's
+``summarize`` mapper with 1, 2, 4, 8 and 16 workers. Every run must agree
+on the result. Speedup is bounded by the machine's core count.
+"""
+
+import os
+import random
+import struct
+import sys
+import tempfile
+import time
+
+from ..frame import Frame, META_FMT
+from ..pcapng import PcapngReader, PcapngWriter, map_reduce, summarize
+
+N = int(sys.argv[1]) if len(sys.argv) > 1 else 1_000_000
+SEGMENTS = int(sys.argv[2]) if len(sys.argv) > 2 else 32
+DEVICES = 5000
+WORKERS = (1, 2, 4, 8, 16)
+
+
+def write_archive(root: str) -> list:
+    rnd = random.Random(1)
+    macs = [bytes([0x02]) + rnd.randbytes(5) for _ in range(DEVICES)]
+    per = N // SEGMENTS
+    paths = []
+    t = 1_700_000_000_000_000
+    for s in range(SEGMENTS):
+        path = os.path.join(root, f"seg{s:03d}.pcapng")
+        with PcapngWriter(path) as w:
+            for i in range(per):
+                src = macs[rnd.randrange(DEVICES)]
+                raw = (b"\x80\x00\x00\x00" + b"\xff" * 6 + src + src
+                       + struct.pack("<H", (i & 0xFFF) << 4) + b"\0" * 12 + b"\x00\x04test")
+                meta = struct.pack(META_FMT, 0, len(raw), 1 + i % 13, -40 - i % 50, -95, 0, 0, 0, 0, 0)
+                t += 150
+                w.write(Frame(meta, raw), t)
+        paths.append(path)
+    return paths
+
+
+def main() -> None:
+    with tempfile.TemporaryDirectory() as root:
+        t0 = time.perf_counter()
+        paths = write_archive(root)
+        size = sum(os.path.getsize(p) for p in paths)
+        print(f"{N // SEGMENTS * SEGMENTS} frames in {SEGMENTS} segments, {size / 1e6:.0f} MB "
+              f"(written in {time.perf_counter() - t0:.1f} s), {os.cpu_count()} cores\n")
+
+        t0 = time.perf_counter()
+        for p in paths:
+            PcapngReader(p).close()
+        cold = time.perf_counter() - t0
+        t0 = time.perf_counter()
+        for p in paths:
+            PcapngReader(p).close()
+        warm = time.perf_counter() - t0
+        print(f"open all: index build {cold * 1e3:.0f} ms, cached .idx {warm * 1e3:.0f} ms\n")
+
+        base = None
+        ref = None
+        for w in WORKERS:
+            best = float("inf")
+            for _ in range(3):
+                t0 = time.perf_counter()
+                out = map_reduce(paths, summarize, workers=w)
+                best = min(best, time.perf_counter() - t0)
+            key = (out["frames"], len(out["devices"]), sorted(out["types"].items()))
+            assert ref is None or key == ref, "result depends on worker count"
+            ref = key
+            base = base or best
+            print(f"workers={w:<3} {out['frames'] / best / 1e3:8.0f} kframes/s  "
+                  f"({best * 1e3:.0f} ms, x{base / best:.2f})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,70 @@
+"""Reader-thread cost per read: raw recording alone vs. recording plus decoding.
+
+    python -m lib.py.bench.rawlog [frames]
+
+Builds a device stream of IMIX-sized frame events in memory, then pushes it
+through the reader's per-chunk path in 4 KB and 64 KB reads (the size of a
+busy ``read()``). Three paths are timed. "record" is ``RawRecorder.write``
+plus the record-only sync scan, as with ``SnifferClient(record=...,
+decode=False)``. "decode" is ``feed()``. "record+decode" is both. Recorder
+writes go to a temporary directory, and callbacks do nothing.
+"""
+
+import os
+import struct
+import sys
+import tempfile
+import time
+
+from .. import cobs
+from ..frame import META_FMT
+from ..rawlog import RawRecorder
+from ..sniffer_client import SnifferClient
+
+N = int(sys.argv[1]) if len(sys.argv) > 1 else 200_000
+SIZES = (64,) * 7 + (576,) * 4 + (1500,)
+
+
+def build_stream(n: int) -> bytes:
+    parts = []
+    for i in range(n):
+        size = SIZES[i % len(SIZES)]
+        raw = b"\x08\x02\x00\x00" + b"\xff" * 6 + b"\x02SYNT\x00" * 2 + struct.pack("<H", (i & 0xFFF) << 4)
+        raw += bytes([i & 0xFF or 1]) * (size - len(raw))
+        meta = struct.pack(META_FMT, i, size, 6, -50, -95, 2, 0, 0, i & 0xFFFF, 0)
+        msg = struct.pack("<BBH", 0xC0, 0, len(meta) + size) + meta + raw
+        parts.append(b"\x00" + cobs.encode(msg) + b"\x00")
+    return b"".join(parts)
+
+
+def run(stream: bytes, chunk: int, record: bool, decode: bool, root: str) -> float:
+    rec = RawRecorder(os.path.join(root, f"r{chunk}{int(decode)}")) if record else None
+    client = SnifferClient(None, record=rec, decode=decode)
+    pieces = [stream[i : i + chunk] for i in range(0, len(stream), chunk)]
+    t0 = time.perf_counter()
+    for piece in pieces:
+        if rec is not None:
+            rec.write(piece)
+            if not decode:
+                client._skim(piece)
+                continue
+        client.feed(piece)
+    elapsed = time.perf_counter() - t0
+    client.close()
+    return elapsed / len(pieces)
+
+
+def main() -> None:
+    stream = build_stream(N)
+    print(f"{N} frame events, {len(stream) / 1e6:.0f} MB of stream\n")
+    print(f"{'read size':>10} {'path':>14} {'us/read':>9} {'MB/s':>9}")
+    with tempfile.TemporaryDirectory() as root:
+        for chunk in (4096, 65536):
+            for name, record, decode in (("record", True, False), ("decode", False, True),
+                                         ("record+decode", True, True)):
+                per = run(stream, chunk, record, decode, root)
+                print(f"{chunk:>10} {name:>14} {per * 1e6:>9.1f} {chunk / per / 1e6:>9.0f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,131 @@
+"""Round-robin store: update cost per frame and query latency over months.
+
+    python -m lib.py.bench.rrd [frames]
+
+A store with the default levels, channels 1-14 and 256 devices is fed a
+2000 frames/s stream of frames from 1000 transmitters, a quarter of them
+tracked. The bench reports the cost per frame of ``observe()``, next to the
+bare loop over the frames. A second store then gets 400 days of history
+(hourly, then per-minute for the last 30 days, then per-second for the last
+hour). Typical queries are timed on it, read back through a fresh
+read-only open as the CLI would.
+"""
+
+import os
+import random
+import struct
+import sys
+import tempfile
+import time
+
+from ..frame import Frame, META_FMT
+from ..rrd import RoundRobinStore, SERIES_CHANNEL, SERIES_DEVICE
+
+N = int(sys.argv[1]) if len(sys.argv) > 1 else 500_000
+RATE = 2000
+T0 = 1_700_000_000
+TRACKED = 256
+
+
+def make_frames(n: int, rnd: random.Random):
+    out = []
+    for i in range(n):
+        mac = 0x020000000000 | rnd.randrange(1000)
+        raw = b"\x80\x00\x00\x00" + b"\xff" * 6 + mac.to_bytes(6, "big") * 2 + b"\x00\x00"
+        ch = rnd.randint(1, 13)
+        out.append(Frame(struct.pack(META_FMT, i, len(raw), ch, -60, -95, 0, 0, 0, i & 0xFFFF, 0), raw))
+    return out
+
+
+def ingest(root: str) -> None:
+    rnd = random.Random(1)
+    frames = make_frames(N, rnd)
+    times = [T0 + i / RATE for i in range(N)]
+    for f in frames:  # addresses are parsed lazily: parse them outside the timed loops
+        f.addr2
+
+    t0 = time.perf_counter()
+    for f, t in zip(frames, times):
+        pass
+    bare = time.perf_counter() - t0
+
+    devices = [0x020000000000 | k for k in range(0, 1000, 1000 // TRACKED)][:TRACKED]
+    store = RoundRobinStore.create(os.path.join(root, "ingest.rrd"), devices=devices)
+    t0 = time.perf_counter()
+    for f, t in zip(frames, times):
+        store.observe(f, t)
+    store.flush()
+    elapsed = time.perf_counter() - t0
+    ch6 = store.find("ch6")[0]
+    check = store.total(ch6, T0, T0 + N / RATE + 1) == sum(f.channel == 6 for f in frames)
+    store.close()
+
+    print(f"{N} frames over {N / RATE:.0f} s, {len(store.series)} series, {store.size / 1e6:.0f} MB file")
+    print(f"  observe(): {(elapsed - bare) / N * 1e9:.0f} ns/frame ({N / elapsed / 1e3:.0f} kframes/s, "
+          f"loop alone {bare / N * 1e9:.0f} ns), totals {'ok' if check else 'WRONG'}\n")
+
+
+def backfill(root: str) -> str:
+    path = os.path.join(root, "history.rrd")
+    rnd = random.Random(2)
+    devices = [0x020000000000 | k for k in range(64)]
+    store = RoundRobinStore.create(path, devices=devices)
+    chans = [i for i, s in enumerate(store.series) if s.group == SERIES_CHANNEL]
+    devs = [i for i, s in enumerate(store.series) if s.group == SERIES_DEVICE]
+    end = T0 + 400 * 86400
+    t0 = time.perf_counter()
+    # coarse history: whole hours of counts and presence
+    for t in range(T0, end - 30 * 86400, 3600):
+        for i in chans:
+            store.add(i, t, rnd.randrange(100_000))
+        for i in devs:
+            if rnd.random() < 0.3:
+                store.add(i, t)
+    for t in range(end - 30 * 86400, end - 3600, 60):
+        for i in chans:
+            store.add(i, t, rnd.randrange(2000))
+        if t % 600 == 0:
+            for i in devs:
+                store.add(i, t)
+    for t in range(end - 3600, end):
+        for i in chans:
+            store.add(i, t, rnd.randrange(40))
+    store.close()
+    print(f"history: 400 days, {len(store.series)} series, {store.size / 1e6:.0f} MB file, "
+          f"written in {time.perf_counter() - t0:.1f} s\n")
+    return path
+
+
+def queries(path: str) -> None:
+    store = RoundRobinStore(path)
+    now = store.last_second + 1
+    chans = store.find("ch")
+    devs = store.find("devices")
+    cases = [
+        ("ch6, last hour per second", [store.find("ch6")[0]], 3600, None),
+        ("14 channels, 7 days per minute", chans, 7 * 86400, None),
+        ("14 channels, 30 days per hour", chans, 30 * 86400, 3600),
+        ("64 devices, 30 days per day", devs, 30 * 86400, 86400),
+        ("64 devices, 365 days per day", devs, 365 * 86400, 86400),
+        ("14 channels, 365 days total", chans, 365 * 86400, 365 * 86400),
+    ]
+    print(f"{'query':<34} {'level':>6} {'values':>8} {'ms':>8}")
+    for name, series, span, step in cases:
+        best = float("inf")
+        for _ in range(5):
+            t0 = time.perf_counter()
+            level = store.pick_level(now - span, step)
+            n = sum(len(store.fetch(i, now - span, now, step, level)[2]) for i in series)
+            best = min(best, time.perf_counter() - t0)
+        print(f"{name:<34} {store.levels[level].step:>5}s {n:>8} {best * 1e3:>8.2f}")
+    store.close()
+
+
+def main() -> None:
+    with tempfile.TemporaryDirectory() as root:
+        ingest(root)
+        queries(backfill(root))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,75 @@
+"""Decode a recorded device byte stream and time it (harness for bench/wire).
+
+    python -m lib.py.bench.wire STREAM [--chunk 4096] [--repeat 3]
+
+The timed pass is the real client path: ``SnifferClient(None).feed()`` in
+chunks, then ``close()`` so the dispatcher has delivered every event. A
+separate untimed pass splits and decodes with ``lib.py.cobs`` for the
+message count and digest. Prints one JSON line (see bench/wire/corpus.py).
+"""
+
+import argparse
+import json
+import struct
+import time
+import zlib
+
+from .. import cobs
+from ..sniffer_client import SnifferClient
+
+HDR_SIZE = 4
+
+
+def digest(stream: bytes):
+    n = 0
+    crc = 0
+    for encoded in stream.split(b"\x00"):
+        if not encoded:
+            continue
+        try:
+            msg = cobs.decode(encoded)
+        except ValueError:
+            continue
+        if len(msg) < HDR_SIZE:
+            continue
+        n += 1
+        crc = zlib.crc32(msg, zlib.crc32(struct.pack("<I", len(msg)), crc))
+    return n, f"{crc:08x}"
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(prog="python -m lib.py.bench.wire")
+    ap.add_argument("stream")
+    ap.add_argument("--chunk", type=int, default=4096)
+    ap.add_argument("--repeat", type=int, default=3)
+    args = ap.parse_args()
+
+    with open(args.stream, "rb") as f:
+        stream = f.read()
+    chunks = [stream[o : o + args.chunk] for o in range(0, len(stream), args.chunk)]
+
+    best = float("inf")
+    for _ in range(args.repeat):
+        anomalies = []
+        client = SnifferClient(None, on_anomaly=anomalies.append)
+        t0 = time.perf_counter()
+        for c in chunks:
+            client.feed(c)
+        client.close()
+        best = min(best, time.perf_counter() - t0)
+
+    messages, crc = digest(stream)
+    print(json.dumps({
+        "impl": "py",
+        "messages": messages,
+        "digest": crc,
+        "frames": client.frame_count,
+        "ble_adv": client.ble_adv_count,
+        "anomalies": len(anomalies),
+        "dropped": client.dropped,
+        "seconds": round(best, 6),
+    }))
+
+
+if __name__ == "__main__":
+    main()
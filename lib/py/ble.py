@@ -0,0 +1,82 @@
+"""BLE advertisement event forwarded by the sniffer's interleaved BLE scan."""
+
+import struct
+from typing import Iterator, Optional, Tuple
+
+from .mac import mac_str
+
+# metadata struct format (matches firmware ble_adv_meta_t, 14 bytes)
+BLE_META_FMT = "<I6sBbBB"
+BLE_META_SIZE = struct.calcsize(BLE_META_FMT)  # 14
+
+# advertising PDU types as reported by the BLE host
+ADV_TYPE_NAMES = {
+    0: "ADV_IND",
+    1: "ADV_DIRECT_IND",
+    2: "ADV_SCAN_IND",
+    3: "ADV_NONCONN_IND",
+    4: "SCAN_RSP",
+}
+
+# AD structure types
+AD_TYPE_NAME_SHORT = 0x08
+AD_TYPE_NAME_COMPLETE = 0x09
+AD_TYPE_MANUFACTURER = 0xFF
+
+
+class BleAdv:
+    """BLE advertisement with metadata and raw advertising data."""
+
+    __slots__ = ("timestamp_us", "addr", "addr_type", "rssi", "adv_type", "data")
+
+    def __init__(self, meta: bytes, data: bytes):
+        (
+            self.timestamp_us,
+            addr,
+            self.addr_type,
+            self.rssi,
+            self.adv_type,
+            _,
+        ) = struct.unpack_from(BLE_META_FMT, meta)
+        # NimBLE reports addresses little-endian
+        self.addr = int.from_bytes(addr, "little")
+        self.data = data
+
+    def iter_ad(self) -> Iterator[Tuple[int, bytes]]:
+        """Yield (ad_type, ad_data) tuples from the advertising data."""
+        data = self.data
+        pos = 0
+        while pos < len(data):
+            ad_len = data[pos]
+            if ad_len == 0 or pos + 1 + ad_len > len(data):
+                break
+            yield data[pos + 1], data[pos + 2 : pos + 1 + ad_len]
+            pos += 1 + ad_len
+
+    @property
+    def name(self) -> Optional[str]:
+        """Local name (complete or shortened), if advertised."""
+        for ad_type, ad_data in self.iter_ad():
+            if ad_type in (AD_TYPE_NAME_COMPLETE, AD_TYPE_NAME_SHORT):
+                return ad_data.decode("utf-8", errors="replace")
+        return None
+
+    @property
+    def manufacturer_id(self) -> Optional[int]:
+        """Company identifier from manufacturer-specific data, if present."""
+        for ad_type, ad_data in self.iter_ad():
+            if ad_type == AD_TYPE_MANUFACTURER and len(ad_data) >= 2:
+                return struct.unpack_from("<H", ad_data)[0]
+        return None
+
+    def __repr__(self) -> str:
+        parts = [
+            f"addr={mac_str(self.addr)}",
+            f"rssi={self.rssi}",
+            f"type={ADV_TYPE_NAMES.get(self.adv_type, self.adv_type)}",
+            f"len={len(self.data)}",
+        ]
+        name = self.name
+        if name is not None:
+            parts.append(f"name={name!r}")
+        return f"BleAdv({', '.join(parts)})"
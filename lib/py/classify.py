@@ -0,0 +1,618 @@
+"""Beacon classifier: training on labeled captures, export, and inference.
+
+Mirrors the firmware's ``main/classify.c``. A beacon or probe response is
+reduced to a fixed feature vector (beacon interval, capability bits, an
+IE-order signature, rates, element presence, HT capabilities, vendor
+OUIs); a model is a table of binary tests on the features plus either a
+decision tree over them or logistic-regression weights. Both score a frame
+0..255 with integer arithmetic, so ``Model.score`` here and the firmware
+agree exactly.
+
+Models are trained from pcapng captures labeled by transmitter and
+uploaded with ``SnifferClient.set_classifier``. The device then sends a
+``Detection`` for every beacon that scores at or above the threshold, at
+most once per transmitter per hold-off:
+
+    python -m lib.py.classify train cap1.pcapng cap2.pcapng --targets targets.txt -o model.bin
+    python -m lib.py.classify eval model.bin cap3.pcapng --targets targets.txt
+    python -m lib.py.classify dump model.bin
+"""
+
+import argparse
+import math
+import struct
+import sys
+from typing import Dict, Iterable, List, NamedTuple, Optional, Sequence, Set, Tuple
+
+from .mac import mac_from_bytes, mac_parse, mac_str
+
+CLF_VERSION = 1
+CLF_MAX_TESTS = 64
+CLF_MAX_NODES = 255
+CLF_MAX_TERMS = 64
+CLF_MAX_OUIS = 8
+CLF_MAX_DEPTH = 7  # a full tree of this depth has 255 nodes
+
+CLF_KIND_OFF = 0
+CLF_KIND_TREE = 1
+CLF_KIND_LOGISTIC = 2
+
+# features
+(
+    F_SUBTYPE,
+    F_INTERVAL,
+    F_CAPS,
+    F_IE_SIG,
+    F_NUM_IES,
+    F_SSID_LEN,
+    F_RATES,
+    F_BASIC_RATES,
+    F_ELEMS,
+    F_HT_CAPS,
+    F_NUM_VENDOR,
+) = range(11)
+NUM_FEATURES = 11
+
+FEATURE_NAMES = (
+    "subtype", "interval", "caps", "ie_sig", "num_ies", "ssid_len",
+    "rates", "basic_rates", "elems", "ht_caps", "num_vendor",
+)
+
+OP_LE = 0  # x <= value
+OP_EQ = 1  # x == value
+OP_ANY = 2  # x & value != 0
+OP_OUI = 3  # a vendor element has OUI value
+
+LEAF = 0xFF
+
+# F_RATES bits for 500 kb/s rate values, then membership selectors
+_RATE_BITS = {2: 0, 4: 1, 11: 2, 22: 3, 12: 4, 18: 5, 24: 6, 36: 7, 48: 8, 72: 9, 96: 10, 108: 11,
+              127: 12, 126: 13, 122: 14}
+RATE_OTHER = 1 << 15
+_RATE_OF = [1 << _RATE_BITS[r] if r in _RATE_BITS else RATE_OTHER for r in range(128)]
+
+# F_ELEMS bits
+E_HT_CAP, E_HT_OP, E_VHT_CAP, E_HE_CAP = 1 << 0, 1 << 1, 1 << 2, 1 << 3
+E_RSN, E_WPA, E_WMM, E_WPS = 1 << 4, 1 << 5, 1 << 6, 1 << 7
+E_COUNTRY, E_EXT_CAP, E_RM_CAP, E_MOBILITY = 1 << 8, 1 << 9, 1 << 10, 1 << 11
+E_ERP, E_POWER, E_TIM, E_DS = 1 << 12, 1 << 13, 1 << 14, 1 << 15
+_ELEM_BIT = {3: E_DS, 5: E_TIM, 7: E_COUNTRY, 32: E_POWER, 42: E_ERP, 45: E_HT_CAP, 48: E_RSN,
+             54: E_MOBILITY, 61: E_HT_OP, 70: E_RM_CAP, 127: E_EXT_CAP, 191: E_VHT_CAP}
+_MS_VENDOR = {1: E_WPA, 2: E_WMM, 4: E_WPS}
+
+# 255 / (1 + e^-x) at x = -8, -7.5, ..., 8 (as in the firmware)
+_SIGMOID = (
+    0, 0, 0, 0, 1, 1, 2, 3, 5, 7, 12, 19, 30, 47, 69, 96,
+    128, 159, 186, 208, 225, 236, 243, 248, 250, 252, 253, 254, 254, 255, 255, 255, 255,
+)
+
+_HDR = struct.Struct("<BBBBHhBBH")
+_TEST = struct.Struct("<BBHI")
+_NODE = struct.Struct("<BBBx")
+_TERM = struct.Struct("<Bxh")
+
+# detection event struct format (matches firmware detection_meta_t, 24 bytes)
+DETECTION_FMT = "<I6sBbBBBxHHI"
+DETECTION_SIZE = struct.calcsize(DETECTION_FMT)  # 24
+
+
+class Features(NamedTuple):
+    f: Tuple[int, ...]  # indexed by F_*
+    ouis: Tuple[int, ...]  # distinct vendor OUIs in order, at most CLF_MAX_OUIS
+
+
+def extract(raw: bytes) -> Optional[Features]:
+    """Features of a beacon or probe response, or None for other frames."""
+    n = len(raw)
+    if n < 36:
+        return None
+    fc0 = raw[0]
+    subtype = fc0 >> 4
+    if fc0 & 0x0C or subtype not in (8, 5):
+        return None
+    f = [0] * NUM_FEATURES
+    f[F_SUBTYPE] = subtype
+    f[F_INTERVAL] = raw[32] | raw[33] << 8
+    f[F_CAPS] = raw[34] | raw[35] << 8
+    ouis: List[int] = []
+    sig = 2166136261
+    elems = rates = basic = num = vendor = 0
+    pos = 36
+    while pos + 2 <= n:
+        eid, ln = raw[pos], raw[pos + 1]
+        d = pos + 2
+        if d + ln > n:
+            break
+        pos = d + ln
+        num += 1
+        sig = ((sig ^ eid) * 16777619) & 0xFFFFFFFF
+        elems |= _ELEM_BIT.get(eid, 0)
+        if eid == 0:
+            f[F_SSID_LEN] = ln
+        elif eid == 1 or eid == 50:
+            for b in raw[d:pos]:
+                bit = _RATE_OF[b & 0x7F]
+                rates |= bit
+                if b & 0x80:
+                    basic |= bit
+        elif eid == 45:
+            if ln >= 2:
+                f[F_HT_CAPS] = raw[d] | raw[d + 1] << 8
+        elif eid == 221:
+            if ln >= 3:
+                vendor += 1
+                o = raw[d] << 16 | raw[d + 1] << 8 | raw[d + 2]
+                if o == 0x0050F2 and ln >= 4:
+                    elems |= _MS_VENDOR.get(raw[d + 3], 0)
+                if o not in ouis and len(ouis) < CLF_MAX_OUIS:
+                    ouis.append(o)
+        elif eid == 255:
+            if ln >= 1:
+                sig = ((sig ^ raw[d]) * 16777619) & 0xFFFFFFFF
+                if raw[d] == 35:
+                    elems |= E_HE_CAP
+    f[F_IE_SIG] = sig
+    f[F_NUM_IES] = num
+    f[F_RATES] = rates
+    f[F_BASIC_RATES] = basic
+    f[F_ELEMS] = elems
+    f[F_NUM_VENDOR] = vendor
+    return Features(tuple(f), tuple(ouis))
+
+
+class Test(NamedTuple):
+    feature: int
+    op: int
+    value: int
+
+    def holds(self, x: Features) -> bool:
+        if self.op == OP_LE:
+            return x.f[self.feature] <= self.value
+        if self.op == OP_EQ:
+            return x.f[self.feature] == self.value
+        if self.op == OP_ANY:
+            return x.f[self.feature] & self.value != 0
+        return self.value in x.ouis
+
+    def __str__(self) -> str:
+        if self.op == OP_OUI:
+            v = self.value
+            return f"oui {v >> 16:02x}:{v >> 8 & 0xFF:02x}:{v & 0xFF:02x}"
+        name = FEATURE_NAMES[self.feature]
+        if self.op == OP_LE:
+            return f"{name} <= {self.value}"
+        if self.op == OP_EQ:
+            return f"{name} == 0x{self.value:x}" if self.feature in _HEX_FEATURES else f"{name} == {self.value}"
+        return f"{name} & 0x{self.value:x}"
+
+
+_HEX_FEATURES = (F_CAPS, F_IE_SIG, F_RATES, F_BASIC_RATES, F_ELEMS, F_HT_CAPS)
+
+
+class Model:
+    """A classifier as the firmware holds it.
+
+    ``items`` are ``(test, yes, no)`` tree nodes (``test == LEAF``: ``yes`` is
+    the confidence) or ``(test, weight)`` logistic terms with the weight and
+    ``bias`` in logit units x 256.
+    """
+
+    def __init__(self, kind: int, tests: Sequence[Test], items: Sequence[Tuple[int, ...]],
+                 label: int = 1, threshold: int = 128, holdoff_ms: int = 1000, bias: int = 0):
+        self.kind = kind
+        self.tests = list(tests)
+        self.items = [tuple(i) for i in items]
+        self.label = label
+        self.threshold = threshold
+        self.holdoff_ms = holdoff_ms
+        self.bias = bias
+
+    @classmethod
+    def off(cls) -> "Model":
+        """The empty model, which turns the device classifier off."""
+        return cls(CLF_KIND_OFF, [], [])
+
+    def score(self, x: Features) -> int:
+        """Confidence 0..255, exactly as the firmware computes it."""
+        tests = self.tests
+        if self.kind == CLF_KIND_TREE:
+            nodes = self.items
+            i = 0
+            while nodes[i][0] != LEAF:
+                t, yes, no = nodes[i]
+                i = yes if tests[t].holds(x) else no
+            return nodes[i][1]
+        if self.kind != CLF_KIND_LOGISTIC:
+            return 0
+        s = self.bias
+        for t, w in self.items:
+            if tests[t].holds(x):
+                s += w
+        s = min(2048, max(-2048, s)) + 2048
+        k, frac = s >> 7, s & 127
+        if k == 32:
+            return _SIGMOID[32]
+        return _SIGMOID[k] + ((_SIGMOID[k + 1] - _SIGMOID[k]) * frac >> 7)
+
+    def steps(self) -> int:
+        """Tests evaluated in the worst case (tree depth, or number of terms)."""
+        if self.kind == CLF_KIND_LOGISTIC:
+            return len(self.items)
+        if self.kind != CLF_KIND_TREE:
+            return 0
+        depth = [0] * len(self.items)
+        for i, (t, yes, no) in enumerate(self.items):
+            if t != LEAF:
+                depth[yes] = max(depth[yes], depth[i] + 1)
+                depth[no] = max(depth[no], depth[i] + 1)
+        return max(depth)
+
+    def to_blob(self) -> bytes:
+        """The upload format (``BULK_KIND_CLASSIFIER``)."""
+        out = bytearray(_HDR.pack(CLF_VERSION, self.kind, self.label, self.threshold, self.holdoff_ms,
+                                  self.bias, len(self.tests), len(self.items), 0))
+        for t in self.tests:
+            out += _TEST.pack(t.feature, t.op, 0, t.value)
+        for item in self.items:
+            out += _NODE.pack(*item) if self.kind == CLF_KIND_TREE else _TERM.pack(*item)
+        return bytes(out)
+
+    @classmethod
+    def from_blob(cls, blob: bytes) -> "Model":
+        """Parse and validate an upload blob as the firmware does (ValueError if malformed)."""
+        if len(blob) < _HDR.size:
+            raise ValueError("model blob too short")
+        version, kind, label, threshold, holdoff, bias, nt, ni, _ = _HDR.unpack_from(blob)
+        if version != CLF_VERSION or kind > CLF_KIND_LOGISTIC or nt > CLF_MAX_TESTS:
+            raise ValueError(f"unsupported model (version {version}, kind {kind}, {nt} tests)")
+        if (kind == CLF_KIND_TREE and ni == 0) or (kind == CLF_KIND_LOGISTIC and ni > CLF_MAX_TERMS) \
+                or (kind == CLF_KIND_OFF and (nt or ni)):
+            raise ValueError(f"bad item count {ni}")
+        if len(blob) != _HDR.size + nt * _TEST.size + ni * 4:
+            raise ValueError("model blob length does not match its counts")
+        pos = _HDR.size
+        tests = []
+        for _ in range(nt):
+            feature, op, _, value = _TEST.unpack_from(blob, pos)
+            pos += _TEST.size
+            if op > OP_OUI or (op != OP_OUI and feature >= NUM_FEATURES):
+                raise ValueError(f"bad test {feature}/{op}")
+            tests.append(Test(feature, op, value))
+        items = []
+        for i in range(ni):
+            if kind == CLF_KIND_TREE:
+                t, yes, no = _NODE.unpack_from(blob, pos)
+                if t != LEAF and (t >= nt or not i < yes < ni or not i < no < ni):
+                    raise ValueError(f"bad node {i}")
+                items.append((t, yes, no))
+            else:
+                t, w = _TERM.unpack_from(blob, pos)
+                if t >= nt:
+                    raise ValueError(f"bad term {i}")
+                items.append((t, w))
+            pos += 4
+        return cls(kind, tests, items, label, threshold, holdoff, bias)
+
+    def describe(self) -> str:
+        kind = {CLF_KIND_OFF: "off", CLF_KIND_TREE: "tree", CLF_KIND_LOGISTIC: "logistic"}[self.kind]
+        lines = [f"{kind} model, label {self.label}, threshold {self.threshold}, "
+                 f"hold-off {self.holdoff_ms} ms, {len(self.tests)} tests, {len(self.items)} "
+                 f"{'nodes' if self.kind == CLF_KIND_TREE else 'terms'}, {self.steps()} steps, "
+                 f"{len(self.to_blob())} bytes"]
+        if self.kind == CLF_KIND_LOGISTIC:
+            lines.append(f"  bias {self.bias / 256:+.2f}")
+            for t, w in sorted(self.items, key=lambda i: -abs(i[1])):
+                lines.append(f"  {w / 256:+6.2f}  {self.tests[t]}")
+        elif self.kind == CLF_KIND_TREE:
+            def walk(i: int, indent: str) -> None:
+                t, yes, no = self.items[i]
+                if t == LEAF:
+                    lines.append(f"{indent}-> {yes}")
+                    return
+                lines.append(f"{indent}if {self.tests[t]}:")
+                walk(yes, indent + "  ")
+                lines.append(f"{indent}else:")
+                walk(no, indent + "  ")
+            walk(0, "  ")
+        return "\n".join(lines)
+
+
+# ---- training ----
+
+
+def candidate_tests(xs: Sequence[Features], min_count: int = 2) -> List[Test]:
+    """Tests worth splitting on: thresholds, values, bits and OUIs seen in the data."""
+    values: Dict[int, Dict[int, int]] = {f: {} for f in range(NUM_FEATURES)}
+    ouis: Dict[int, int] = {}
+    for x in xs:
+        for f, v in enumerate(x.f):
+            values[f][v] = values[f].get(v, 0) + 1
+        for o in x.ouis:
+            ouis[o] = ouis.get(o, 0) + 1
+    out: Set[Test] = set()
+    for f, seen in values.items():
+        common = sorted(v for v, n in seen.items() if n >= min_count)
+        if f in (F_INTERVAL, F_NUM_IES, F_SSID_LEN, F_NUM_VENDOR):
+            out.update(Test(f, OP_LE, v) for v in common[:-1])
+        if f in (F_SUBTYPE, F_CAPS, F_IE_SIG, F_HT_CAPS, F_RATES, F_BASIC_RATES, F_INTERVAL):
+            out.update(Test(f, OP_EQ, v) for v in common)
+        if f in (F_CAPS, F_RATES, F_BASIC_RATES, F_ELEMS, F_HT_CAPS):
+            bits = 0
+            for v in common:
+                bits |= v
+            out.update(Test(f, OP_ANY, 1 << b) for b in range(32) if bits >> b & 1)
+    out.update(Test(0, OP_OUI, o) for o, n in ouis.items() if n >= min_count)
+    return sorted(out)
+
+
+def _masks(tests: Sequence[Test], xs: Sequence[Features]) -> List[int]:
+    """Per test, a bitmask of the samples it holds for."""
+    out = []
+    for t in tests:
+        m = 0
+        for i, x in enumerate(xs):
+            if t.holds(x):
+                m |= 1 << i
+        out.append(m)
+    return out
+
+
+def _popcount(m: int) -> int:
+    return bin(m).count("1")
+
+
+def _confidence(pos: int, n: int) -> int:
+    return round(255 * (pos + 1) / (n + 2))
+
+
+def train_tree(xs: Sequence[Features], ys: Sequence[bool], max_depth: int = 6, min_leaf: int = 2,
+               **model_args) -> Model:
+    """CART (Gini impurity) over the candidate tests, with smoothed leaf confidences."""
+    max_depth = min(max_depth, CLF_MAX_DEPTH)
+    cands = candidate_tests(xs)
+    masks = _masks(cands, xs)
+    ymask = sum(1 << i for i, y in enumerate(ys) if y)
+    used: Dict[int, int] = {}  # candidate -> test index
+    nodes: List[List[int]] = []
+
+    def build(idx: int, depth: int) -> int:
+        me = len(nodes)
+        nodes.append([LEAF, 0, 0])
+        n = _popcount(idx)
+        pos = _popcount(idx & ymask)
+        best = None
+        if depth < max_depth and 0 < pos < n and n >= 2 * min_leaf:
+            # once the test table is full, only tests already in it
+            pool = range(len(cands)) if len(used) < CLF_MAX_TESTS else list(used)
+            score0 = pos * (n - pos) / n
+            for c in pool:
+                yes = idx & masks[c]
+                ny = _popcount(yes)
+                if ny < min_leaf or n - ny < min_leaf:
+                    continue
+                py = _popcount(yes & ymask)
+                nn, pn = n - ny, pos - py
+                # n x weighted Gini / 2
+                s = py * (ny - py) / ny + pn * (nn - pn) / nn
+                if s < score0 and (best is None or s < best[0]):
+                    best = (s, c)
+        if best is None:
+            nodes[me][1] = _confidence(pos, n)
+            return me
+        c = best[1]
+        t = used.setdefault(c, len(used))
+        yes = build(idx & masks[c], depth + 1)
+        no = build(idx & ~masks[c], depth + 1)
+        nodes[me] = [t, yes, no]
+        return me
+
+    build((1 << len(xs)) - 1, 0)
+    tests = [None] * len(used)
+    for c, t in used.items():
+        tests[t] = cands[c]
+    return Model(CLF_KIND_TREE, tests, nodes, **model_args)
+
+
+def train_logistic(xs: Sequence[Features], ys: Sequence[bool], max_terms: int = 32, epochs: int = 300,
+                   rate: float = 0.5, l2: float = 1e-3, **model_args) -> Model:
+    """L2-regularized logistic regression over the most informative candidate tests."""
+    max_terms = min(max_terms, CLF_MAX_TERMS, CLF_MAX_TESTS)
+    n = len(xs)
+    cands = candidate_tests(xs)
+    masks = _masks(cands, xs)
+    ymask = sum(1 << i for i, y in enumerate(ys) if y)
+    full = (1 << n) - 1
+    pos = _popcount(ymask)
+
+    # rank by Gini gain on their own, skipping tests that split the data identically
+    def impurity(m: int) -> float:
+        ny, py = _popcount(m), _popcount(m & ymask)
+        nn, pn = n - ny, pos - py
+        return (py * (ny - py) / ny if ny else 0) + (pn * (nn - pn) / nn if nn else 0)
+
+    order = sorted(range(len(cands)), key=lambda c: impurity(masks[c]))
+    chosen: List[int] = []
+    seen: Set[int] = set()
+    for c in order:
+        m = masks[c]
+        if m in seen or (full & ~m) in seen or m in (0, full):
+            continue
+        seen.add(m)
+        chosen.append(c)
+        if len(chosen) == max_terms:
+            break
+
+    active = [[j for j, c in enumerate(chosen) if masks[c] >> i & 1] for i in range(n)]
+    w = [0.0] * len(chosen)
+    b = 0.0
+    target = [1.0 if y else 0.0 for y in ys]
+    for _ in range(epochs):
+        gw = [0.0] * len(w)
+        gb = 0.0
+        for act, t in zip(active, target):
+            z = b + sum(w[j] for j in act)
+            p = 1 / (1 + math.exp(-max(-30.0, min(30.0, z))))
+            e = p - t
+            gb += e
+            for j in act:
+                gw[j] += e
+        b -= rate * gb / n
+        for j in range(len(w)):
+            w[j] -= rate * (gw[j] / n + l2 * w[j])
+
+    def q(v: float) -> int:
+        return max(-32768, min(32767, round(v * 256)))
+
+    terms = [(j, q(v)) for j, v in enumerate(w) if q(v)]
+    tests = [cands[chosen[j]] for j, _ in terms]
+    return Model(CLF_KIND_LOGISTIC, tests, [(i, wq) for i, (_, wq) in enumerate(terms)], bias=q(b),
+                 **model_args)
+
+
+# ---- labeled captures ----
+
+
+def load_samples(paths: Iterable[str], targets: Set[int]) -> Tuple[List[Features], List[bool], List[int]]:
+    """Distinct (transmitter, features) pairs of the beacons and probe responses in pcapng captures.
+
+    Returns features, labels (transmitter in ``targets``) and transmitters.
+    Repeated beacons of one AP count once, so busy APs do not dominate.
+    """
+    from .pcapng import PcapngReader
+
+    seen: Set[Tuple[int, Features]] = set()
+    xs: List[Features] = []
+    ys: List[bool] = []
+    macs: List[int] = []
+    for path in paths:
+        with PcapngReader(path) as r:
+            for frame in r.frames():
+                raw = bytes(frame.raw)
+                x = extract(raw)
+                if x is None:
+                    continue
+                mac = mac_from_bytes(raw[10:16])
+                if (mac, x) in seen:
+                    continue
+                seen.add((mac, x))
+                xs.append(x)
+                ys.append(mac in targets)
+                macs.append(mac)
+    return xs, ys, macs
+
+
+def evaluate(model: Model, xs: Sequence[Features], ys: Sequence[bool]) -> Dict[str, float]:
+    """Precision and recall at the model's threshold."""
+    tp = fp = fn = 0
+    for x, y in zip(xs, ys):
+        hit = model.score(x) >= model.threshold
+        tp += hit and y
+        fp += hit and not y
+        fn += y and not hit
+    return {
+        "samples": len(xs),
+        "positives": tp + fn,
+        "precision": tp / (tp + fp) if tp + fp else 1.0,
+        "recall": tp / (tp + fn) if tp + fn else 1.0,
+    }
+
+
+class Detection:
+    """A device-side classifier hit: a beacon that scored at or above the threshold.
+
+    ``suppressed`` counts hits on the same transmitter held back by the
+    hold-off since the previous detection.
+    """
+
+    __slots__ = ("timestamp_us", "mac", "channel", "rssi", "label", "confidence", "subtype",
+                 "interval", "suppressed", "ie_sig")
+
+    def __init__(self, payload: bytes):
+        (
+            self.timestamp_us,
+            mac,
+            self.channel,
+            self.rssi,
+            self.label,
+            self.confidence,
+            self.subtype,
+            self.interval,
+            self.suppressed,
+            self.ie_sig,
+        ) = struct.unpack_from(DETECTION_FMT, payload)
+        self.mac = mac_from_bytes(mac)
+
+    def __repr__(self) -> str:
+        return (
+            f"Detection({mac_str(self.mac)}, label={self.label}, confidence={self.confidence}, "
+            f"ch={self.channel}, rssi={self.rssi}, suppressed={self.suppressed})"
+        )
+
+
+# ---- command line ----
+
+
+def _targets(text: str) -> Set[int]:
+    if text.startswith("@"):
+        with open(text[1:]) as f:
+            items = [line.split("#")[0].strip() for line in f]
+    else:
+        items = text.split(",")
+    return {mac_parse(m) for m in items if m}
+
+
+def main(argv: Optional[Sequence[str]] = None) -> None:
+    parser = argparse.ArgumentParser(prog="python -m lib.py.classify", description=__doc__.split("\n")[0])
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    tr = sub.add_parser("train", help="Train a model on labeled captures")
+    tr.add_argument("captures", nargs="+", help="pcapng files")
+    tr.add_argument("--targets", required=True, help="Target transmitters: comma-separated, or @FILE (one per line)")
+    tr.add_argument("-o", "--output", required=True, help="Model blob to write")
+    tr.add_argument("--logistic", action="store_true", help="Logistic regression instead of a decision tree")
+    tr.add_argument("--depth", type=int, default=6, help=f"Tree depth, up to {CLF_MAX_DEPTH} (default: 6)")
+    tr.add_argument("--terms", type=int, default=32, help=f"Logistic terms, up to {CLF_MAX_TERMS} (default: 32)")
+    tr.add_argument("--label", type=int, default=1, help="Label reported with detections (default: 1)")
+    tr.add_argument("--threshold", type=int, default=128, help="Detection confidence 0-255 (default: 128)")
+    tr.add_argument("--holdoff-ms", type=int, default=1000, help="Per-transmitter hold-off (default: 1000)")
+
+    ev = sub.add_parser("eval", help="Score labeled captures with a model")
+    ev.add_argument("model")
+    ev.add_argument("captures", nargs="+")
+    ev.add_argument("--targets", required=True)
+
+    dm = sub.add_parser("dump", help="Print a model")
+    dm.add_argument("model")
+
+    args = parser.parse_args(argv)
+    if args.cmd == "dump":
+        with open(args.model, "rb") as f:
+            print(Model.from_blob(f.read()).describe())
+        return
+
+    targets = _targets(args.targets)
+    xs, ys, macs = load_samples(args.captures, targets)
+    print(f"{len(xs)} distinct beacons from {len(set(macs))} transmitters, {sum(ys)} from targets",
+          file=sys.stderr)
+
+    if args.cmd == "train":
+        if not any(ys) or all(ys):
+            parser.error("the captures need beacons from both targets and others")
+        opts = dict(label=args.label, threshold=args.threshold, holdoff_ms=args.holdoff_ms)
+        if args.logistic:
+            model = train_logistic(xs, ys, max_terms=args.terms, **opts)
+        else:
+            model = train_tree(xs, ys, max_depth=args.depth, **opts)
+        with open(args.output, "wb") as f:
+            f.write(model.to_blob())
+        print(model.describe())
+    else:
+        with open(args.model, "rb") as f:
+            model = Model.from_blob(f.read())
+    r = evaluate(model, xs, ys)
+    print(f"precision {r['precision']:.3f}, recall {r['recall']:.3f} "
+          f"({r['positives']} target beacons of {r['samples']})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,189 @@
+"""Capture-completeness estimation from 802.11 sequence-number gaps.
+
+Every transmitter numbers its frames with a 12-bit sequence counter (one per
+TID for QoS data, one shared by management and non-QoS data). The frames we
+capture from it, against the span of sequence numbers they cover, tell us
+what fraction of its transmissions we actually saw while hopping.
+
+Caveats: a transmitter that sends more than ~4096 frames while we are away
+wraps the counter unseen, so its ratio is overestimated; frames sent to other
+BSSs are counted too (that is what the counter tracks).
+"""
+
+from typing import Dict, Iterable, List, Optional, Sequence, Tuple
+
+from .frame import Frame
+from .mac import mac_at
+
+SEQ_MOD = 4096
+
+# a backwards step this small is a late (reordered) frame filling a hole
+REORDER_WINDOW = 64
+
+# forward jumps this large are treated as a counter reset, not as loss
+MAX_GAP = SEQ_MOD - REORDER_WINDOW
+
+# stream slot for management / non-QoS data (QoS data uses its TID 0-15)
+_SLOT_NON_QOS = 16
+
+FC_RETRY = 0x0800
+
+
+class CompletenessEstimator:
+    """Streaming per-transmitter / per-channel capture ratio estimator.
+
+    Feed every captured frame to ``update()`` (O(1), a few dict operations).
+    Ratios are ``received / expected`` where ``expected`` is the number of
+    sequence numbers spanned since a transmitter was first seen.
+    """
+
+    __slots__ = ("_streams", "_devices", "_channels", "frames", "duplicates")
+
+    def __init__(self):
+        # (addr2 << 5 | slot) -> [last_seq]
+        self._streams: Dict[int, List[int]] = {}
+        # addr2 -> [received, expected]
+        self._devices: Dict[int, List[int]] = {}
+        # channel -> [received, expected]
+        self._channels: Dict[int, List[int]] = {}
+        self.frames = 0
+        self.duplicates = 0
+
+    def update(self, frame: Frame) -> None:
+        raw = frame.raw
+        if len(raw) < 24:
+            return
+        fc = raw[0] | (raw[1] << 8)
+        ftype = (fc >> 2) & 0x03
+        if ftype == 1 or ftype == 3:
+            return  # control frames carry no sequence number
+
+        if ftype == 2 and fc & 0x80:  # QoS data: per-TID counter
+            qos_off = 30 if (fc & 0x0300) == 0x0300 else 24
+            if len(raw) < qos_off + 2:
+                return
+            slot = raw[qos_off] & 0x0F
+        else:
+            slot = _SLOT_NON_QOS
+
+        seq = (raw[22] | (raw[23] << 8)) >> 4
+        addr2 = mac_at(raw, 10)
+        self.frames += 1
+
+        key = (addr2 << 5) | slot
+        stream = self._streams.get(key)
+        if stream is None:
+            self._streams[key] = [seq]
+            gap = 1
+        else:
+            gap = (seq - stream[0]) & (SEQ_MOD - 1)
+            if gap == 0:
+                # retransmission (or the same frame seen twice)
+                self.duplicates += 1
+                return
+            if gap > MAX_GAP:
+                # late frame: fills a hole already counted as expected
+                gap = 0
+            elif fc & FC_RETRY and gap > SEQ_MOD // 2:
+                gap = 0
+            else:
+                stream[0] = seq
+
+        dev = self._devices.get(addr2)
+        if dev is None:
+            dev = self._devices[addr2] = [0, 0]
+        dev[0] += 1
+        dev[1] += gap
+
+        ch = self._channels.get(frame.channel)
+        if ch is None:
+            ch = self._channels[frame.channel] = [0, 0]
+        ch[0] += 1
+        ch[1] += gap
+
+    # ---- queries ----
+
+    @staticmethod
+    def _ratio(counts: List[int]) -> float:
+        received, expected = counts
+        if expected <= 0:
+            return 1.0
+        return min(1.0, received / expected)
+
+    def device_ratio(self, addr: int) -> Optional[float]:
+        counts = self._devices.get(addr)
+        return None if counts is None else self._ratio(counts)
+
+    def channel_ratio(self, channel: int) -> Optional[float]:
+        counts = self._channels.get(channel)
+        return None if counts is None else self._ratio(counts)
+
+    def devices(self, min_expected: int = 1) -> Dict[int, Tuple[int, int, float]]:
+        """addr -> (received, expected, ratio)."""
+        return {
+            addr: (c[0], c[1], self._ratio(c))
+            for addr, c in self._devices.items()
+            if c[1] >= min_expected
+        }
+
+    def channels(self) -> Dict[int, Tuple[int, int, float]]:
+        """channel -> (received, expected, ratio)."""
+        return {ch: (c[0], c[1], self._ratio(c)) for ch, c in sorted(self._channels.items())}
+
+    def overall_ratio(self) -> float:
+        received = sum(c[0] for c in self._channels.values())
+        expected = sum(c[1] for c in self._channels.values())
+        return self._ratio([received, expected])
+
+    def metrics(self) -> Dict[str, float]:
+        """Flat metric names suitable for a metrics exporter or log line."""
+        out: Dict[str, float] = {
+            "capture.frames": self.frames,
+            "capture.duplicates": self.duplicates,
+            "capture.devices": len(self._devices),
+            "capture.ratio": self.overall_ratio(),
+        }
+        for ch, (received, expected, ratio) in self.channels().items():
+            out[f"capture.ch{ch}.received"] = received
+            out[f"capture.ch{ch}.expected"] = expected
+            out[f"capture.ch{ch}.ratio"] = ratio
+        return out
+
+    def reset(self) -> None:
+        self._streams.clear()
+        self._devices.clear()
+        self._channels.clear()
+        self.frames = 0
+        self.duplicates = 0
+
+
+def rank_schedules(
+    estimator: CompletenessEstimator,
+    candidates: Iterable[Sequence[Tuple[int, int]]],
+    switch_ms: float = 0.0,
+) -> List[Tuple[float, Sequence[Tuple[int, int]]]]:
+    """Rank hop-schedule candidates by predicted capture.
+
+    Each candidate is a sequence of ``(channel, dwell_ms)``. A channel's
+    transmission rate is taken as proportional to its ``expected`` count (the
+    transmitters keep sending while we are away), and a schedule captures
+    the share of that traffic matching its dwell share of the cycle, after
+    ``switch_ms`` dead time per hop.
+
+    Returns ``(predicted_fraction, candidate)`` pairs, best first.
+    """
+    expected = {ch: c[1] for ch, c in estimator.channels().items()}
+    total = sum(expected.values())
+    ranked = []
+    for cand in candidates:
+        cycle = sum(dwell for _, dwell in cand) + switch_ms * len(cand)
+        if cycle <= 0 or total == 0:
+            ranked.append((0.0, cand))
+            continue
+        dwell_by_ch: Dict[int, float] = {}
+        for ch, dwell in cand:
+            dwell_by_ch[ch] = dwell_by_ch.get(ch, 0.0) + dwell
+        score = sum(expected.get(ch, 0) * d / cycle for ch, d in dwell_by_ch.items())
+        ranked.append((score / total, cand))
+    ranked.sort(key=lambda r: r[0], reverse=True)
+    return ranked
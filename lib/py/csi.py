@@ -0,0 +1,129 @@
+"""Channel state information (CSI) reports forwarded by the sniffer's CSI mode."""
+
+import math
+import struct
+from array import array
+from typing import Optional
+
+from .mac import mac_from_bytes, mac_str
+
+# metadata struct format (matches firmware csi_meta_t, 24 bytes)
+CSI_FMT = "<I6sBbbBBBBxHHH"
+CSI_SIZE = struct.calcsize(CSI_FMT)  # 24
+
+CSI_BITS_8 = 8  # values as the driver reported them
+CSI_BITS_4 = 4  # two values per byte, scaled by 2**shift
+CSI_MAX_MATCH = 16  # addresses / OUIs in the device-side filter
+
+CSI_FLAG_FIRST_WORD_INVALID = 0x01  # the first four values are not valid
+
+
+def _nibble_table(high: bool, shift: int) -> bytes:
+    """bytes.translate table: packed byte -> one int8 value (as a byte) scaled back."""
+    out = bytearray(256)
+    for b in range(256):
+        v = (b >> 4) if high else (b & 0x0F)
+        v = v - 16 if v & 0x08 else v
+        out[b] = (v << shift) & 0xFF
+    return bytes(out)
+
+
+# per shift: (low nibble table, high nibble table)
+_UNPACK4 = [(_nibble_table(False, s), _nibble_table(True, s)) for s in range(5)]
+
+
+def unpack_values(data: bytes, bits: int, shift: int, count: int) -> bytes:
+    """Packed report data back to ``count`` int8 values (as raw bytes)."""
+    if bits != CSI_BITS_4:
+        return bytes(data[:count])
+    lo, hi = _UNPACK4[min(shift, 4)]
+    out = bytearray(2 * len(data))
+    out[0::2] = data.translate(lo)
+    out[1::2] = data.translate(hi)
+    return bytes(out[:count])
+
+
+class CsiReport:
+    """CSI of one received PPDU: metadata plus the (packed) I/Q values.
+
+    Values are int8 pairs per subcarrier, imaginary part first, in the order
+    the driver reports them (which depends on the PPDU format; see the
+    ESP-IDF Wi-Fi CSI documentation). ``suppressed`` counts reports from the
+    same transmitter held back by the device-side rate limit since the
+    previous one.
+    """
+
+    __slots__ = (
+        "timestamp_us",
+        "mac",
+        "channel",
+        "rssi",
+        "noise_floor",
+        "rate",
+        "flags",
+        "bits",
+        "shift",
+        "sig_len",
+        "csi_len",
+        "suppressed",
+        "data",
+    )
+
+    def __init__(self, meta: bytes, data: bytes):
+        (
+            self.timestamp_us,
+            mac,
+            self.channel,
+            self.rssi,
+            self.noise_floor,
+            self.rate,
+            self.flags,
+            self.bits,
+            self.shift,
+            self.sig_len,
+            self.csi_len,
+            self.suppressed,
+        ) = struct.unpack_from(CSI_FMT, meta)
+        self.mac = mac_from_bytes(mac)
+        self.data = data
+
+    @property
+    def first_word_invalid(self) -> bool:
+        return bool(self.flags & CSI_FLAG_FIRST_WORD_INVALID)
+
+    def values(self) -> array:
+        """The ``csi_len`` int8 values, unpacked and scaled back (``array('b')``)."""
+        return array("b", unpack_values(self.data, self.bits, self.shift, self.csi_len))
+
+    def amplitudes(self) -> array:
+        """Magnitude per subcarrier (``array('f')``)."""
+        v = self.values()
+        return array("f", [math.hypot(v[i], v[i + 1]) for i in range(0, len(v) - 1, 2)])
+
+    def to_numpy(self):
+        """Complex samples per subcarrier as a NumPy ``complex64`` array.
+
+        NumPy is imported on first use and is not otherwise required.
+        """
+        import numpy as np
+
+        v = np.frombuffer(unpack_values(self.data, self.bits, self.shift, self.csi_len & ~1),
+                          dtype=np.int8).astype(np.float32)
+        out = np.empty(len(v) // 2, dtype=np.complex64)
+        out.real = v[1::2]
+        out.imag = v[0::2]
+        return out
+
+    def __repr__(self) -> str:
+        q = f", 4-bit<<{self.shift}" if self.bits == CSI_BITS_4 else ""
+        return (
+            f"CsiReport({mac_str(self.mac)}, ch={self.channel}, rssi={self.rssi}, "
+            f"{self.csi_len // 2} subcarriers{q}, suppressed={self.suppressed})"
+        )
+
+
+def encode_match(mac: Optional[int] = None, oui: Optional[int] = None) -> bytes:
+    """One CSI_CONFIG filter entry: a full address or a 24-bit OUI."""
+    if mac is not None:
+        return bytes([6]) + mac.to_bytes(6, "big")
+    return bytes([3]) + (oui << 24).to_bytes(6, "big")
@@ -1,8 +1,15 @@
 """802.11 frame class with lazy parsing of header fields and IEs."""
 
 import struct
-from functools import cached_property
-from typing import Optional, Iterator, Tuple
+from typing import Optional, Iterator, Tuple, Union
+
+from . import mac as _mac
+from .mac import mac_at, BROADCAST as _MAC_MASK
+
+# addresses are read as the low 48 bits of a big-endian u64 (see mac.mac_at)
+_unpack_u64 = struct.Struct(">Q").unpack_from
+_unpack_u32 = struct.Struct("<I").unpack_from
+_unpack_u16 = struct.Struct("<H").unpack_from
 
 # metadata struct format (matches firmware frame_meta_t, 16 bytes)
 META_FMT = "<IHBbbBBBHH"
@@ -21,76 +28,79 @@ SUBTYPE_PROBE_RESP = 5
 SUBTYPE_BEACON = 8
 SUBTYPE_DEAUTH = 12
 
+# not yet parsed (None is a parsed value)
+_UNSET = object()
+
 
 class Frame:
     """Captured 802.11 frame with metadata.
 
-    Metadata fields (timestamp, rssi, channel, etc.) are unpacked eagerly.
-    802.11 header fields (addresses, SSID, etc.) are parsed lazily on access.
+    The metadata (timestamp, rssi, channel, etc.) stays in the packed
+    16-byte record it arrived in, and each accessor reads its field from
+    there. 802.11 header fields (addresses, SSID) are parsed on first access
+    and kept in slots that hold ``_UNSET`` until then. Fields cheaper to
+    recompute than to keep (frame control, sequence control) are not kept.
+    With no per-frame ``__dict__``, a retained frame costs its slots, the
+    metadata record and ``raw``. Addresses are 48-bit integers (see
+    ``lib.py.mac``).
     """
 
-    __slots__ = (
-        "_ts",
-        "_frame_len",
-        "_channel",
-        "_rssi",
-        "_noise_floor",
-        "_pkt_type",
-        "_rx_state",
-        "_rate",
-        "_seq_num",
-        "_raw",
-        "__dict__",  # needed for cached_property
-    )
+    __slots__ = ("_meta", "_raw", "_addr1", "_addr2", "_addr3", "_bssid", "_src", "_dst", "_ssid")
 
     def __init__(self, meta: bytes, raw: bytes):
-        (
-            self._ts,
-            self._frame_len,
-            self._channel,
-            self._rssi,
-            self._noise_floor,
-            self._pkt_type,
-            self._rx_state,
-            self._rate,
-            self._seq_num,
-            _,
-        ) = struct.unpack_from(META_FMT, meta)
+        if type(meta) is not bytes or len(meta) != META_SIZE:
+            if len(meta) < META_SIZE:
+                raise ValueError(f"frame metadata is {len(meta)} bytes, need {META_SIZE}")
+            meta = bytes(meta[:META_SIZE])
+        self._meta = meta
         self._raw = raw
+        self._addr1 = self._addr2 = self._addr3 = _UNSET
+        self._bssid = self._src = self._dst = self._ssid = _UNSET
 
-    # ---- metadata (eager) ----
+    # ---- metadata (packed) ----
 
     @property
     def timestamp_us(self) -> int:
-        return self._ts
+        return _unpack_u32(self._meta, 0)[0]
 
     @property
     def channel(self) -> int:
-        return self._channel
+        return self._meta[6]
 
     @property
     def rssi(self) -> int:
-        return self._rssi
+        v = self._meta[7]
+        return v - 256 if v > 127 else v
 
     @property
     def noise_floor(self) -> int:
-        return self._noise_floor
+        v = self._meta[8]
+        return v - 256 if v > 127 else v
 
     @property
     def pkt_type(self) -> int:
-        return self._pkt_type
+        return self._meta[9]
 
     @property
     def rx_state(self) -> int:
-        return self._rx_state
+        return self._meta[10]
 
     @property
     def rate(self) -> int:
-        return self._rate
+        return self._meta[11]
 
     @property
     def seq_num(self) -> int:
-        return self._seq_num
+        return _unpack_u16(self._meta, 12)[0]
+
+    @property
+    def orig_len(self) -> int:
+        """Length on air if the hop's snaplen cut the frame, else 0."""
+        return _unpack_u16(self._meta, 14)[0]
+
+    @property
+    def truncated(self) -> bool:
+        return self._meta[14] != 0 or self._meta[15] != 0
 
     @property
     def raw(self) -> bytes:
@@ -98,115 +108,127 @@ class Frame:
 
     # ---- 802.11 MAC header (lazy) ----
 
-    @cached_property
+    @property
     def frame_control(self) -> int:
-        if len(self._raw) < 2:
-            return 0
-        return struct.unpack_from("<H", self._raw, 0)[0]
+        r = self._raw
+        return r[0] | r[1] << 8 if len(r) >= 2 else 0
 
-    @cached_property
+    @property
     def frame_type(self) -> int:
-        return (self.frame_control >> 2) & 0x03
+        r = self._raw
+        return (r[0] >> 2) & 0x03 if len(r) >= 2 else 0
 
-    @cached_property
+    @property
     def frame_subtype(self) -> int:
-        return (self.frame_control >> 4) & 0x0F
+        r = self._raw
+        return r[0] >> 4 if len(r) >= 2 else 0
 
-    @cached_property
+    @property
     def to_ds(self) -> bool:
-        return bool(self.frame_control & (1 << 8))
+        r = self._raw
+        return len(r) >= 2 and bool(r[1] & 0x01)
 
-    @cached_property
+    @property
     def from_ds(self) -> bool:
-        return bool(self.frame_control & (1 << 9))
+        r = self._raw
+        return len(r) >= 2 and bool(r[1] & 0x02)
 
-    @cached_property
+    @property
     def duration(self) -> int:
         if len(self._raw) < 4:
             return 0
-        return struct.unpack_from("<H", self._raw, 2)[0]
+        return _unpack_u16(self._raw, 2)[0]
 
-    @cached_property
-    def addr1(self) -> Optional[bytes]:
+    @property
+    def addr1(self) -> Optional[int]:
         """Receiver / destination address."""
-        if len(self._raw) < 10:
-            return None
-        return self._raw[4:10]
+        a = self._addr1
+        if a is _UNSET:
+            a = self._addr1 = _unpack_u64(self._raw, 2)[0] & _MAC_MASK if len(self._raw) >= 10 else None
+        return a
 
-    @cached_property
-    def addr2(self) -> Optional[bytes]:
+    @property
+    def addr2(self) -> Optional[int]:
         """Transmitter / source address."""
-        if len(self._raw) < 16:
-            return None
-        return self._raw[10:16]
+        a = self._addr2
+        if a is _UNSET:
+            a = self._addr2 = _unpack_u64(self._raw, 8)[0] & _MAC_MASK if len(self._raw) >= 16 else None
+        return a
 
-    @cached_property
-    def addr3(self) -> Optional[bytes]:
+    @property
+    def addr3(self) -> Optional[int]:
         """BSSID (in most management/data frames)."""
-        if len(self._raw) < 22:
-            return None
-        return self._raw[16:22]
+        a = self._addr3
+        if a is _UNSET:
+            a = self._addr3 = _unpack_u64(self._raw, 14)[0] & _MAC_MASK if len(self._raw) >= 22 else None
+        return a
 
-    @cached_property
+    @property
     def sequence_control(self) -> Optional[int]:
         if len(self._raw) < 24:
             return None
-        return struct.unpack_from("<H", self._raw, 22)[0]
+        return _unpack_u16(self._raw, 22)[0]
 
-    @cached_property
+    @property
     def sequence_number(self) -> Optional[int]:
         sc = self.sequence_control
         return None if sc is None else (sc >> 4)
 
-    @cached_property
+    @property
     def fragment_number(self) -> Optional[int]:
         sc = self.sequence_control
         return None if sc is None else (sc & 0x0F)
 
     # ---- derived addresses ----
 
-    @cached_property
-    def bssid(self) -> Optional[bytes]:
-        if self.frame_type == FRAME_TYPE_MGMT:
-            return self.addr3
-        if not self.to_ds and not self.from_ds:
-            return self.addr3
-        if not self.to_ds and self.from_ds:
-            return self.addr2
-        if self.to_ds and not self.from_ds:
-            return self.addr1
-        return None
-
-    @cached_property
-    def src(self) -> Optional[bytes]:
-        if self.frame_type == FRAME_TYPE_MGMT:
-            return self.addr2
-        if not self.to_ds and not self.from_ds:
-            return self.addr2
-        if not self.to_ds and self.from_ds:
-            return self.addr3
-        if self.to_ds and not self.from_ds:
-            return self.addr2
-        # WDS: addr4 at offset 24
-        if len(self._raw) >= 30:
-            return self._raw[24:30]
-        return None
-
-    @cached_property
-    def dst(self) -> Optional[bytes]:
-        if self.frame_type == FRAME_TYPE_MGMT:
-            return self.addr1
-        if not self.to_ds and not self.from_ds:
-            return self.addr1
-        if not self.to_ds and self.from_ds:
-            return self.addr1
-        if self.to_ds and not self.from_ds:
-            return self.addr3
-        return self.addr3
+    def _ds(self) -> int:
+        """To-DS/From-DS bits (bit 0 / bit 1); 0 for management frames."""
+        r = self._raw
+        if len(r) < 2 or (r[0] >> 2) & 0x03 == FRAME_TYPE_MGMT:
+            return 0
+        return r[1] & 0x03
+
+    @property
+    def bssid(self) -> Optional[int]:
+        a = self._bssid
+        if a is _UNSET:
+            ds = self._ds()
+            if ds == 0:
+                a = self.addr3
+            elif ds == 2:
+                a = self.addr2
+            elif ds == 1:
+                a = self.addr1
+            else:
+                a = None
+            self._bssid = a
+        return a
+
+    @property
+    def src(self) -> Optional[int]:
+        a = self._src
+        if a is _UNSET:
+            ds = self._ds()
+            if ds == 0 or ds == 1:
+                a = self.addr2
+            elif ds == 2:
+                a = self.addr3
+            elif len(self._raw) >= 30:
+                a = mac_at(self._raw, 24)  # WDS: addr4 at offset 24
+            else:
+                a = None
+            self._src = a
+        return a
+
+    @property
+    def dst(self) -> Optional[int]:
+        a = self._dst
+        if a is _UNSET:
+            a = self._dst = self.addr3 if self._ds() & 0x01 else self.addr1
+        return a
 
     # ---- information elements ----
 
-    @cached_property
     def _ie_offset(self) -> int:
         if self.frame_type != FRAME_TYPE_MGMT:
             return -1
@@ -221,7 +243,7 @@ class Frame:
 
     def iter_ies(self) -> Iterator[Tuple[int, bytes]]:
         """Yield (ie_id, ie_data) tuples from management frame IEs."""
-        offset = self._ie_offset
+        offset = self._ie_offset()
         if offset < 0:
             return
         pos = offset
@@ -234,48 +256,46 @@ class Frame:
             yield ie_id, data[pos + 2 : pos + 2 + ie_len]
             pos += 2 + ie_len
 
-    @cached_property
+    @property
     def ssid(self) -> Optional[str]:
         """Extract SSID from IE 0 (beacons, probe req/resp)."""
-        for ie_id, ie_data in self.iter_ies():
-            if ie_id == 0:
-                if len(ie_data) == 0:
-                    return ""
-                return ie_data.decode("utf-8", errors="replace")
-        return None
+        s = self._ssid
+        if s is _UNSET:
+            s = None
+            for ie_id, ie_data in self.iter_ies():
+                if ie_id == 0:
+                    s = str(ie_data, "utf-8", errors="replace") if len(ie_data) else ""
+                    break
+            self._ssid = s
+        return s
 
     # ---- convenience ----
 
-    @cached_property
+    @property
     def is_beacon(self) -> bool:
-        return (
-            self.frame_type == FRAME_TYPE_MGMT and self.frame_subtype == SUBTYPE_BEACON
-        )
+        r = self._raw
+        return len(r) >= 2 and r[0] & 0xFC == SUBTYPE_BEACON << 4
 
-    @cached_property
+    @property
     def is_probe_req(self) -> bool:
-        return (
-            self.frame_type == FRAME_TYPE_MGMT
-            and self.frame_subtype == SUBTYPE_PROBE_REQ
-        )
+        r = self._raw
+        return len(r) >= 2 and r[0] & 0xFC == SUBTYPE_PROBE_REQ << 4
 
-    @cached_property
+    @property
     def is_probe_resp(self) -> bool:
-        return (
-            self.frame_type == FRAME_TYPE_MGMT
-            and self.frame_subtype == SUBTYPE_PROBE_RESP
-        )
+        r = self._raw
+        return len(r) >= 2 and r[0] & 0xFC == SUBTYPE_PROBE_RESP << 4
 
     @staticmethod
-    def mac_str(addr: Optional[bytes]) -> str:
-        if addr is None:
-            return "??:??:??:??:??:??"
-        return ":".join(f"{b:02x}" for b in addr)
+    def mac_str(addr: Union[int, bytes, None]) -> str:
+        if isinstance(addr, (bytes, bytearray)):
+            addr = _mac.mac_from_bytes(addr)
+        return _mac.mac_str(addr)
 
     def __repr__(self) -> str:
         parts = [
-            f"ch={self._channel}",
-            f"rssi={self._rssi}",
+            f"ch={self.channel}",
+            f"rssi={self.rssi}",
             f"type={self.frame_type}/{self.frame_subtype}",
             f"src={self.mac_str(self.addr2)}",
             f"dst={self.mac_str(self.addr1)}",
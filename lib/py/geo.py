@@ -0,0 +1,394 @@
+"""GPS geotagging and geohash heatmap aggregation for drive surveys.
+
+An NMEA stream from a separate GPS receiver (serial port or a log file) is
+parsed into a time-indexed ``Track``. Frames are placed on it by
+interpolation and aggregated per target into geohash cells (count, mean and
+max RSSI), which export as a directory of per-tile JSON files.
+
+    track = Track()
+    follow_nmea(open("drive.nmea"), track)          # or a serial port
+    survey = Survey(track, precision=7)
+    ... survey.observe(frame) for each frame ...
+    survey.heatmap.export("tiles/")
+"""
+
+import calendar
+import json
+import os
+import threading
+import time
+from array import array
+from bisect import bisect_right
+from typing import Callable, Dict, IO, Iterable, List, Optional, Tuple
+
+from .frame import Frame
+from .mac import mac_str
+
+_BASE32 = "0123456789bcdefghjkmnpqrstuvwxyz"
+
+
+# ---- NMEA ----
+
+
+def _nmea_checksum_ok(line: str) -> bool:
+    star = line.rfind("*")
+    if star < 0:
+        return True  # checksum is optional
+    try:
+        want = int(line[star + 1 : star + 3], 16)
+    except ValueError:
+        return False
+    got = 0
+    for c in line[1:star]:
+        got ^= ord(c)
+    return got == want
+
+
+def _nmea_coord(value: str, hemi: str) -> Optional[float]:
+    if not value:
+        return None
+    dot = value.find(".")
+    deg_len = (dot if dot >= 0 else len(value)) - 2
+    deg = float(value[:deg_len]) + float(value[deg_len:]) / 60.0
+    return -deg if hemi in ("S", "W") else deg
+
+
+def _nmea_time(hhmmss: str, day_epoch: float) -> float:
+    h, m, s = int(hhmmss[0:2]), int(hhmmss[2:4]), float(hhmmss[4:])
+    return day_epoch + h * 3600 + m * 60 + s
+
+
+class NmeaParser:
+    """Turns RMC / GGA sentences into ``(utc_epoch, lat, lon)`` fixes.
+
+    GGA carries no date, so it uses the date of the last RMC (or the host's
+    current UTC date until one arrives).
+    """
+
+    def __init__(self):
+        now = time.gmtime()
+        self._day = calendar.timegm((now.tm_year, now.tm_mon, now.tm_mday, 0, 0, 0))
+
+    def parse(self, line: str) -> Optional[Tuple[float, float, float]]:
+        line = line.strip()
+        if len(line) < 7 or line[0] != "$" or not _nmea_checksum_ok(line):
+            return None
+        body = line[1:].split("*", 1)[0]
+        f = body.split(",")
+        kind = f[0][2:]
+        try:
+            if kind == "RMC" and len(f) >= 10:
+                if f[2] != "A" or not f[1]:
+                    return None  # no fix
+                if f[9]:
+                    d, mo, y = int(f[9][0:2]), int(f[9][2:4]), 2000 + int(f[9][4:6])
+                    self._day = calendar.timegm((y, mo, d, 0, 0, 0))
+                lat, lon = _nmea_coord(f[3], f[4]), _nmea_coord(f[5], f[6])
+            elif kind == "GGA" and len(f) >= 7:
+                if f[6] in ("", "0") or not f[1]:
+                    return None  # no fix
+                lat, lon = _nmea_coord(f[2], f[3]), _nmea_coord(f[4], f[5])
+            else:
+                return None
+        except ValueError:
+            return None
+        if lat is None or lon is None:
+            return None
+        return _nmea_time(f[1], self._day), lat, lon
+
+
+# ---- track ----
+
+
+class Track:
+    """Time-indexed GPS fixes with bounded memory.
+
+    Fixes must arrive in time order (they do from a receiver); older ones
+    are discarded past ``max_points``. ``locate()`` interpolates linearly,
+    in amortized O(1) for monotonic queries and O(log n) otherwise.
+    Thread-safe for one writer and one reader.
+    """
+
+    def __init__(self, max_points: int = 86400, max_gap_s: float = 10.0):
+        self.max_points = max_points
+        self.max_gap_s = max_gap_s  # don't interpolate across longer outages
+        self._t = array("d")
+        self._lat = array("d")
+        self._lon = array("d")
+        self._cursor = 0
+        self._lock = threading.Lock()
+
+    def __len__(self) -> int:
+        return len(self._t)
+
+    def add(self, t: float, lat: float, lon: float) -> None:
+        with self._lock:
+            if self._t and t <= self._t[-1]:
+                return  # duplicate sentence (RMC + GGA) or out of order
+            self._t.append(t)
+            self._lat.append(lat)
+            self._lon.append(lon)
+            if len(self._t) > 2 * self.max_points:
+                # trim in bulk so appends stay amortized O(1)
+                drop = len(self._t) - self.max_points
+                del self._t[:drop], self._lat[:drop], self._lon[:drop]
+                self._cursor = max(0, self._cursor - drop)
+
+    def span(self) -> Optional[Tuple[float, float]]:
+        if not self._t:
+            return None
+        return self._t[0], self._t[-1]
+
+    def locate(self, t: float) -> Optional[Tuple[float, float]]:
+        """Interpolated (lat, lon) at time t, or None outside the track."""
+        with self._lock:
+            ts = self._t
+            n = len(ts)
+            if n == 0 or t < ts[0] or t > ts[-1]:
+                return None
+            # advance the cursor for monotonic queries, else binary search
+            i = self._cursor
+            if i >= n - 1 or ts[i] > t:
+                i = max(0, bisect_right(ts, t) - 1)
+            else:
+                while i < n - 1 and ts[i + 1] <= t:
+                    i += 1
+            self._cursor = i
+            if i == n - 1:
+                return self._lat[i], self._lon[i]
+            t0, t1 = ts[i], ts[i + 1]
+            if t1 - t0 > self.max_gap_s:
+                return None
+            a = (t - t0) / (t1 - t0)
+            return (
+                self._lat[i] + (self._lat[i + 1] - self._lat[i]) * a,
+                self._lon[i] + (self._lon[i + 1] - self._lon[i]) * a,
+            )
+
+
+def follow_nmea(
+    source: IO, track: Track, stop: Optional[threading.Event] = None
+) -> None:
+    """Feed NMEA lines from a file or serial port into `track` until EOF/stop.
+
+    Accepts text or binary streams (pyserial ports are binary).
+    """
+    parser = NmeaParser()
+    while stop is None or not stop.is_set():
+        line = source.readline()
+        if not line:
+            if hasattr(source, "in_waiting"):
+                continue  # serial read timeout
+            break
+        if isinstance(line, bytes):
+            line = line.decode("ascii", errors="replace")
+        fix = parser.parse(line)
+        if fix is not None:
+            track.add(*fix)
+
+
+def start_gps(
+    source: str, track: Track, baudrate: int = 9600
+) -> Tuple[threading.Thread, threading.Event]:
+    """Follow a GPS receiver on a serial port (or an NMEA log file) in a thread.
+
+    Returns the thread and an event that stops it.
+    """
+    if os.path.isfile(source):
+        stream = open(source, "rb")
+    else:
+        import serial
+
+        stream = serial.Serial(source, baudrate, timeout=0.5)
+    stop = threading.Event()
+
+    def run() -> None:
+        try:
+            follow_nmea(stream, track, stop)
+        finally:
+            stream.close()
+
+    thread = threading.Thread(target=run, daemon=True, name="gps")
+    thread.start()
+    return thread, stop
+
+
+# ---- geohash ----
+
+
+def _spread(v: int) -> int:
+    """Spread the low 32 bits of v to the even bit positions of a 64-bit int."""
+    v &= 0xFFFFFFFF
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFF
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FF
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F
+    v = (v | (v << 2)) & 0x3333333333333333
+    v = (v | (v << 1)) & 0x5555555555555555
+    return v
+
+
+def geohash_int(lat: float, lon: float, precision: int) -> int:
+    """Geohash of `precision` characters as a 5*precision-bit integer."""
+    bits = 5 * precision
+    lon_bits = (bits + 1) // 2
+    lat_bits = bits // 2
+    lat_i = min(int((lat + 90.0) / 180.0 * (1 << lat_bits)), (1 << lat_bits) - 1)
+    lon_i = min(int((lon + 180.0) / 360.0 * (1 << lon_bits)), (1 << lon_bits) - 1)
+    # geohash interleaves starting with longitude at the top bit
+    if bits % 2 == 0:
+        return (_spread(lon_i) << 1) | _spread(lat_i)
+    return _spread(lon_i) | (_spread(lat_i) << 1)
+
+
+def geohash_str(code: int, precision: int) -> str:
+    out = []
+    for i in range(precision - 1, -1, -1):
+        out.append(_BASE32[(code >> (5 * i)) & 0x1F])
+    return "".join(out)
+
+
+def geohash(lat: float, lon: float, precision: int = 7) -> str:
+    return geohash_str(geohash_int(lat, lon, precision), precision)
+
+
+# ---- aggregation ----
+
+
+class HeatMap:
+    """Per-target observations aggregated into geohash cells.
+
+    Each (target, cell) keeps count, RSSI sum (for the mean), max RSSI and
+    first/last seen, updated in O(1). Memory is bounded by the number of
+    distinct cells actually visited.
+    """
+
+    def __init__(self, precision: int = 7):
+        self.precision = precision
+        # (target, cell) -> [count, rssi_sum, rssi_max, first_t, last_t]
+        self.cells: Dict[Tuple[int, int], List[float]] = {}
+
+    def add(self, target: int, lat: float, lon: float, rssi: int, t: float = 0.0) -> None:
+        self.add_cell(target, geohash_int(lat, lon, self.precision), rssi, t)
+
+    def add_cell(self, target: int, cell: int, rssi: int, t: float = 0.0) -> None:
+        c = self.cells.get((target, cell))
+        if c is None:
+            self.cells[(target, cell)] = [1, rssi, rssi, t, t]
+            return
+        c[0] += 1
+        c[1] += rssi
+        if rssi > c[2]:
+            c[2] = rssi
+        c[4] = t
+
+    def __len__(self) -> int:
+        return len(self.cells)
+
+    def export(self, out_dir: str, tile_precision: int = 5) -> int:
+        """Write one JSON file per `tile_precision` geohash tile, plus index.json.
+
+        Each tile file is ``{"precision": p, "cells": [[suffix, mac,
+        count, mean_rssi, max_rssi, first_t, last_t], ...]}`` where suffix
+        is the cell's geohash with the tile prefix stripped. Returns the
+        number of tiles written.
+        """
+        os.makedirs(out_dir, exist_ok=True)
+        shift = 5 * (self.precision - tile_precision)
+        tiles: Dict[str, list] = {}
+        for (target, cell), (count, rssi_sum, rssi_max, first_t, last_t) in self.cells.items():
+            full = geohash_str(cell, self.precision)
+            tile = geohash_str(cell >> shift, tile_precision)
+            tiles.setdefault(tile, []).append([
+                full[tile_precision:],
+                mac_str(target),
+                count,
+                round(rssi_sum / count, 1),
+                rssi_max,
+                round(first_t, 3),
+                round(last_t, 3),
+            ])
+        for tile, cells in tiles.items():
+            with open(os.path.join(out_dir, f"{tile}.json"), "w") as f:
+                json.dump({"precision": self.precision, "cells": cells}, f, separators=(",", ":"))
+        with open(os.path.join(out_dir, "index.json"), "w") as f:
+            json.dump(
+                {"precision": self.precision, "tile_precision": tile_precision,
+                 "tiles": sorted(tiles)},
+                f, separators=(",", ":"),
+            )
+        return len(tiles)
+
+
+# ---- device clock ----
+
+
+class DeviceClock:
+    """Maps the firmware's 32-bit microsecond timestamps to UTC epoch seconds.
+
+    Anchored to host time at the first frame, then unwrapped across the
+    ~71 minute rollover, so frames are placed by when they were captured
+    rather than when the host got around to them.
+    """
+
+    def __init__(self, now: Callable[[], float] = time.time):
+        self._now = now
+        self._offset: Optional[float] = None
+        self._last = 0
+        self._wraps = 0
+
+    def to_utc(self, timestamp_us: int) -> float:
+        if self._offset is None:
+            self._offset = self._now() - timestamp_us / 1e6
+        elif timestamp_us < self._last and self._last - timestamp_us > 0x80000000:
+            self._wraps += 1
+        self._last = timestamp_us
+        return self._offset + (self._wraps * 0x100000000 + timestamp_us) / 1e6
+
+
+# ---- survey ----
+
+
+class Survey:
+    """Geotags frames against a track and aggregates them into a HeatMap.
+
+    Frames are keyed by transmitter (``addr2``). `targets` restricts the
+    aggregation to a set of MACs; `predicate` to frames it returns True for.
+    """
+
+    def __init__(
+        self,
+        track: Track,
+        precision: int = 7,
+        clock: Optional[DeviceClock] = None,
+        targets: Optional[Iterable[int]] = None,
+        predicate: Optional[Callable[[Frame], bool]] = None,
+    ):
+        self.track = track
+        self.heatmap = HeatMap(precision)
+        self.clock = clock or DeviceClock()
+        self.targets = None if targets is None else set(targets)
+        self.predicate = predicate
+        self.tagged = 0
+        self.untagged = 0
+        self._last_pos: Optional[Tuple[float, float]] = None
+        self._last_cell = 0
+
+    def observe(self, frame: Frame) -> None:
+        tx = frame.addr2
+        if tx is None:
+            return
+        if self.targets is not None and tx not in self.targets:
+            return
+        if self.predicate is not None and not self.predicate(frame):
+            return
+        t = self.clock.to_utc(frame.timestamp_us)
+        pos = self.track.locate(t)
+        if pos is None:
+            self.untagged += 1
+            return
+        # consecutive frames mostly share a position (1 Hz fixes)
+        if pos != self._last_pos:
+            self._last_pos = pos
+            self._last_cell = geohash_int(pos[0], pos[1], self.heatmap.precision)
+        self.heatmap.add_cell(tx, self._last_cell, frame.rssi, t)
+        self.tagged += 1
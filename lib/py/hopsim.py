@@ -0,0 +1,498 @@
+"""Offline hop-schedule simulator and optimizer.
+
+Replays recorded (or generated) per-device transmission times against hop
+schedules and reports, for a set of targets, the probability of detection
+within a horizon and the mean time to first detection.
+
+Traffic is a CSV of ``timestamp_us,channel,mac`` rows, one per transmission,
+recorded with a radio parked on each device's channel (so the recording
+itself misses nothing). A schedule is a cycle of ``(channel, dwell_ms)``
+hops; the first ``switch_ms`` of every dwell is dead time.
+
+With active probing (``--probe RATE``) the device sends probe requests at
+the start of each dwell, rate-limited as the firmware does it
+(``main/probe.c``). A responder (an AP) present on the channel is then
+detected ``response_ms`` after the dwell's dead time, without waiting for
+its next beacon.
+
+    python -m lib.py.hopsim traffic.csv --targets aa:bb:cc:dd:ee:ff,...
+    python -m lib.py.hopsim --generate 3600 --optimize 2000
+    python -m lib.py.hopsim --generate 3600 --schedule 1:100,6:100,11:100 --probe 20
+"""
+
+import argparse
+import csv
+import os
+import random
+import sys
+import time
+from array import array
+from bisect import bisect_left
+from concurrent.futures import ProcessPoolExecutor
+from typing import Dict, FrozenSet, Iterable, List, NamedTuple, Optional, Sequence, Tuple
+
+from .mac import mac_parse
+
+Schedule = Tuple[Tuple[int, int], ...]  # ((channel, dwell_ms), ...)
+
+# dwell choices explored by the optimizer (0 = channel skipped)
+DWELL_CHOICES_MS = (0, 50, 100, 200, 300, 500, 1000, 2500)
+
+# the firmware's default all-channel schedule
+DEFAULT_SCHEDULE: Schedule = tuple((ch, 2500) for ch in range(1, 14))
+
+# a responder counts as present on its channel if it transmitted there within this of a probe
+PRESENT_S = 1.0
+
+
+class Probing(NamedTuple):
+    """Active probing as configured with ``SnifferClient.probe_config``.
+
+    Responders answer any probe; ``per_dwell`` (one per SSID, plus the
+    wildcard one) only sets how fast the rate limit is used up.
+    """
+
+    rate: int  # probes per second
+    responders: FrozenSet[int]  # targets that answer probes (APs)
+    per_dwell: int = 1
+    response_ms: float = 5.0  # from the end of the dead time to the response
+
+
+# ---- traffic ----
+
+
+class TrafficIndex:
+    """Per-target, per-channel sorted transmission times (seconds).
+
+    Only target transmissions are indexed; everything a schedule evaluation
+    needs is a ``bisect`` into one of these arrays.
+    """
+
+    def __init__(self, events: Iterable[Tuple[float, int, int]], targets: Optional[Iterable[int]] = None):
+        wanted = None if targets is None else set(targets)
+        per: Dict[int, Dict[int, List[float]]] = {}
+        t_min, t_max = float("inf"), float("-inf")
+        for t, ch, mac in events:
+            if t < t_min:
+                t_min = t
+            if t > t_max:
+                t_max = t
+            if wanted is not None and mac not in wanted:
+                continue
+            per.setdefault(mac, {}).setdefault(ch, []).append(t)
+
+        self.start = t_min if per else 0.0
+        self.end = t_max if per else 0.0
+        self.targets: Dict[int, Dict[int, array]] = {
+            mac: {ch: array("d", sorted(ts)) for ch, ts in chans.items()}
+            for mac, chans in per.items()
+        }
+
+    @property
+    def channels(self) -> List[int]:
+        return sorted({ch for chans in self.targets.values() for ch in chans})
+
+    def __len__(self) -> int:
+        return sum(len(ts) for chans in self.targets.values() for ts in chans.values())
+
+
+def load_csv(path: str) -> Iterable[Tuple[float, int, int]]:
+    """Yield ``(t_seconds, channel, mac)`` from a ``timestamp_us,channel,mac`` CSV."""
+    with open(path, newline="") as f:
+        for row in csv.reader(f):
+            if not row or not row[0].strip().isdigit():
+                continue  # header / blank
+            yield int(row[0]) / 1e6, int(row[1]), mac_parse(row[2].strip())
+
+
+def generate(
+    seconds: float,
+    devices: int = 30,
+    channels: Sequence[int] = (1, 6, 11),
+    seed: int = 1,
+) -> List[Tuple[float, int, int]]:
+    """Synthetic traffic: beaconing APs (102.4 ms TU) and bursty clients."""
+    rnd = random.Random(seed)
+    events = []
+    for i in range(devices):
+        mac = 0x020000000000 | i
+        ch = rnd.choice(channels)
+        if i % 2 == 0:
+            # AP: beacons at a fixed interval with a random phase
+            interval = 0.1024 * rnd.choice((1, 1, 2, 3))
+            t = rnd.random() * interval
+            while t < seconds:
+                events.append((t, ch, mac))
+                t += interval
+        else:
+            # client: bursts of probes every ~10-60 s
+            t = rnd.random() * 30
+            while t < seconds:
+                for k in range(rnd.randint(1, 6)):
+                    events.append((t + k * 0.002, ch, mac))
+                t += rnd.uniform(10, 60)
+    events.sort()
+    return events
+
+
+def generated_aps(devices: int = 30) -> List[int]:
+    """Addresses of the beaconing APs in ``generate(..., devices)``."""
+    return [0x020000000000 | i for i in range(0, devices, 2)]
+
+
+# ---- simulation ----
+
+
+def _first_detection(
+    times: array, offsets: Sequence[Tuple[float, float]], cycle: float, t0: float, limit: float
+) -> Optional[float]:
+    """Earliest t in `times` inside a live window, with the cycle starting at t0.
+
+    `offsets` are the (live_start, live_end) of this channel's windows
+    relative to the start of a cycle.
+    """
+    n = len(times)
+    k = bisect_left(times, t0)
+    while k < n:
+        t = times[k]
+        if t >= limit:
+            return None
+        # position of t within its cycle
+        cyc_start = t0 + ((t - t0) // cycle) * cycle
+        rel = t - cyc_start
+        nxt = None
+        for lo, hi in offsets:
+            if rel < lo:
+                nxt = cyc_start + lo if nxt is None else min(nxt, cyc_start + lo)
+            elif rel < hi:
+                return t
+        # not live: jump to the next live window start
+        if nxt is None:
+            nxt = cyc_start + cycle + offsets[0][0]
+        k = bisect_left(times, nxt, k + 1)
+    return None
+
+
+def probe_grants(schedule: Schedule, probing: Probing, horizon_s: float) -> List[Tuple[int, int, int]]:
+    """``(start_ms, channel, probes)`` for every dwell within the horizon.
+
+    Mirrors ``probe_dwell`` in the firmware: a token bucket in thousandths
+    of a probe, full at scan start, refilled at ``rate`` per second and
+    holding at most one dwell's worth.
+    """
+    out: List[Tuple[int, int, int]] = []
+    wanted = probing.per_dwell
+    if probing.rate <= 0 or wanted <= 0 or not schedule:
+        return out
+    cap = wanted * 1000
+    tokens, last, now = cap, 0, 0
+    limit = horizon_s * 1000
+    while now < limit:
+        for ch, dwell in schedule:
+            elapsed = min(now - last, cap)
+            last = now
+            tokens = min(cap, tokens + elapsed * probing.rate)
+            n = min(wanted, tokens // 1000)
+            tokens -= n * 1000
+            out.append((now, ch, n))
+            now += dwell
+    return out
+
+
+def _probe_times(schedule: Schedule, probing: Probing, switch_ms: float,
+                 horizon_s: float) -> Dict[int, List[float]]:
+    """Per channel, seconds from scan start at which probe responses arrive."""
+    out: Dict[int, List[float]] = {}
+    settle = switch_ms + probing.response_ms
+    # grants come one per hop, in schedule order; a channel may recur with another dwell
+    for i, (start, ch, n) in enumerate(probe_grants(schedule, probing, horizon_s)):
+        if n and settle < schedule[i % len(schedule)][1]:
+            out.setdefault(ch, []).append((start + settle) / 1000.0)
+    return out
+
+
+def _present(times: array, t: float) -> bool:
+    k = bisect_left(times, t - PRESENT_S)
+    return k < len(times) and times[k] <= t + PRESENT_S
+
+
+def evaluate(
+    index: TrafficIndex,
+    schedule: Schedule,
+    switch_ms: float = 0.0,
+    horizon_s: float = 60.0,
+    starts: int = 64,
+    seed: int = 0,
+    probing: Optional[Probing] = None,
+) -> Tuple[float, float]:
+    """Return (detection probability within horizon, mean time to detection).
+
+    Averaged over all targets and `starts` evenly spaced start times (with a
+    seeded jitter). Undetected runs count as `horizon_s` in the mean.
+    """
+    cycle = sum(d for _, d in schedule) / 1000.0
+    if cycle <= 0 or not index.targets:
+        return 0.0, horizon_s
+
+    # live windows per channel, relative to cycle start
+    windows: Dict[int, List[Tuple[float, float]]] = {}
+    pos = 0.0
+    for ch, dwell in schedule:
+        lo = pos + switch_ms / 1000.0
+        hi = pos + dwell / 1000.0
+        if hi > lo:
+            windows.setdefault(ch, []).append((lo, hi))
+        pos = hi
+
+    probes = _probe_times(schedule, probing, switch_ms, horizon_s) if probing else {}
+
+    span = max(0.0, index.end - index.start - horizon_s)
+    rnd = random.Random(seed)
+    detected = 0
+    total_ttd = 0.0
+    runs = 0
+    for s in range(starts):
+        t0 = index.start + span * (s + rnd.random()) / starts
+        limit = t0 + horizon_s
+        for mac, chans in index.targets.items():
+            best = None
+            for ch, times in chans.items():
+                offs = windows.get(ch)
+                if offs is None:
+                    continue
+                t = _first_detection(times, offs, cycle, t0, limit if best is None else best)
+                if t is not None and (best is None or t < best):
+                    best = t
+                if probes and mac in probing.responders:
+                    for rel in probes.get(ch, ()):
+                        t = t0 + rel
+                        if t >= (limit if best is None else best):
+                            break
+                        if _present(times, t):
+                            best = t
+                            break
+            runs += 1
+            if best is None:
+                total_ttd += horizon_s
+            else:
+                detected += 1
+                total_ttd += best - t0
+    return detected / runs, total_ttd / runs
+
+
+# ---- parallel evaluation ----
+
+_worker_index: Optional[TrafficIndex] = None
+
+
+def _init_worker(index: TrafficIndex) -> None:
+    global _worker_index
+    _worker_index = index
+
+
+def _eval_one(args) -> Tuple[float, float]:
+    schedule, switch_ms, horizon_s, starts, probing = args
+    return evaluate(_worker_index, schedule, switch_ms, horizon_s, starts, probing=probing)
+
+
+class Simulator:
+    """Evaluates many schedules against one index across worker processes."""
+
+    def __init__(self, index: TrafficIndex, switch_ms: float = 5.0, horizon_s: float = 60.0,
+                 starts: int = 64, jobs: Optional[int] = None, probing: Optional[Probing] = None):
+        self.index = index
+        self.probing = probing
+        self.switch_ms = switch_ms
+        self.horizon_s = horizon_s
+        self.starts = starts
+        self.jobs = jobs or os.cpu_count() or 1
+        self._pool: Optional[ProcessPoolExecutor] = None
+
+    def __enter__(self):
+        if self.jobs > 1:
+            self._pool = ProcessPoolExecutor(
+                self.jobs, initializer=_init_worker, initargs=(self.index,)
+            )
+        return self
+
+    def __exit__(self, *args):
+        if self._pool is not None:
+            self._pool.shutdown()
+
+    def evaluate_many(self, schedules: Sequence[Schedule]) -> List[Tuple[float, float]]:
+        work = [(s, self.switch_ms, self.horizon_s, self.starts, self.probing) for s in schedules]
+        if self._pool is None:
+            _init_worker(self.index)
+            return [_eval_one(w) for w in work]
+        chunk = max(1, len(work) // (self.jobs * 4))
+        return list(self._pool.map(_eval_one, work, chunksize=chunk))
+
+
+# ---- optimizer ----
+
+
+def _score(result: Tuple[float, float]) -> Tuple[float, float]:
+    p_detect, mean_ttd = result
+    return (p_detect, -mean_ttd)
+
+
+def _from_dwells(channels: Sequence[int], dwells: Sequence[int]) -> Schedule:
+    return tuple((ch, d) for ch, d in zip(channels, dwells) if d > 0)
+
+
+def optimize(
+    sim: Simulator,
+    channels: Sequence[int],
+    iterations: int = 1000,
+    batch: int = 64,
+    seed: int = 0,
+    log=None,
+) -> Tuple[int, List[Tuple[Tuple[float, float], Schedule]]]:
+    """Random restarts plus hill climbing over per-channel dwell times.
+
+    Each round evaluates `batch` candidates in parallel: mutations of the
+    current best schedules plus fresh random ones. Returns the number of
+    schedules evaluated (fewer than `iterations` if new candidates run out)
+    and the best (result, schedule) pairs found, best first.
+    """
+    rnd = random.Random(seed)
+    seen: Dict[Schedule, Tuple[float, float]] = {}
+    elite: List[Tuple[Tuple[float, float], Tuple[int, ...]]] = []
+
+    def random_dwells() -> Tuple[int, ...]:
+        return tuple(rnd.choice(DWELL_CHOICES_MS[1:]) for _ in channels)
+
+    def mutate(dwells: Tuple[int, ...]) -> Tuple[int, ...]:
+        d = list(dwells)
+        for _ in range(rnd.randint(1, 2)):
+            d[rnd.randrange(len(d))] = rnd.choice(DWELL_CHOICES_MS)
+        if not any(d):
+            d[rnd.randrange(len(d))] = rnd.choice(DWELL_CHOICES_MS[1:])
+        return tuple(d)
+
+    evaluated = 0
+    while evaluated < iterations:
+        cands: List[Tuple[int, ...]] = []
+        tries = 0
+        while len(cands) < min(batch, iterations - evaluated) and tries < batch * 20:
+            tries += 1
+            if elite and rnd.random() < 0.75:
+                d = mutate(elite[rnd.randrange(min(len(elite), 8))][1])
+            else:
+                d = random_dwells()
+            s = _from_dwells(channels, d)
+            if s not in seen and d not in cands:
+                cands.append(d)
+        if not cands:
+            break
+
+        scheds = [_from_dwells(channels, d) for d in cands]
+        for d, s, r in zip(cands, scheds, sim.evaluate_many(scheds)):
+            seen[s] = r
+            elite.append((r, d))
+        elite.sort(key=lambda e: _score(e[0]), reverse=True)
+        del elite[32:]
+        evaluated += len(cands)
+        if log is not None:
+            r, d = elite[0]
+            log(f"{evaluated:>6d} evaluated  best p={r[0]:.3f} ttd={r[1]:.2f}s  "
+                f"{format_schedule(_from_dwells(channels, d))}")
+
+    return evaluated, [(r, _from_dwells(channels, d)) for r, d in elite]
+
+
+# ---- CLI ----
+
+
+def parse_schedule(text: str) -> Schedule:
+    """Parse ``"1:500,6:500,11:500"``."""
+    hops = []
+    for part in text.split(","):
+        ch, dwell = part.split(":")
+        hops.append((int(ch), int(dwell)))
+    return tuple(hops)
+
+
+def format_schedule(schedule: Schedule) -> str:
+    return ",".join(f"{ch}:{dwell}" for ch, dwell in schedule)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(
+        prog="python -m lib.py.hopsim",
+        description="Simulate and optimize hop schedules against recorded traffic",
+    )
+    parser.add_argument("traffic", nargs="?", help="CSV of timestamp_us,channel,mac")
+    parser.add_argument("--generate", type=float, metavar="SECONDS",
+                        help="Use generated traffic of this length instead of a CSV")
+    parser.add_argument("--targets", help="Comma-separated target MACs (default: all devices)")
+    parser.add_argument("--schedule", action="append", default=[],
+                        help='Schedule to evaluate, e.g. "1:500,6:500,11:500" (repeatable)')
+    parser.add_argument("--optimize", type=int, default=0, metavar="N",
+                        help="Search N schedules for the best detection metrics")
+    parser.add_argument("--switch-ms", type=float, default=5.0,
+                        help="Dead time at the start of every dwell (default: 5)")
+    parser.add_argument("--horizon", type=float, default=60.0,
+                        help="Detection horizon in seconds (default: 60)")
+    parser.add_argument("--starts", type=int, default=64,
+                        help="Start times sampled per schedule (default: 64)")
+    parser.add_argument("--jobs", type=int, default=None, help="Worker processes (default: all cores)")
+    parser.add_argument("--probe", type=int, default=0, metavar="RATE",
+                        help="Model active probing at RATE probes per second")
+    parser.add_argument("--probe-per-dwell", type=int, default=1, metavar="N",
+                        help="Probes wanted per dwell: SSIDs plus the wildcard one (default: 1)")
+    parser.add_argument("--probe-response-ms", type=float, default=5.0,
+                        help="Probe to response after the dead time (default: 5)")
+    parser.add_argument("--responders",
+                        help="Comma-separated targets that answer probes (default: the generated APs)")
+    args = parser.parse_args()
+
+    if args.generate:
+        events: Iterable = generate(args.generate)
+    elif args.traffic:
+        events = load_csv(args.traffic)
+    else:
+        parser.error("give a traffic CSV or --generate SECONDS")
+
+    targets = [mac_parse(m) for m in args.targets.split(",")] if args.targets else None
+    t0 = time.perf_counter()
+    index = TrafficIndex(events, targets)
+    print(f"indexed {len(index)} transmissions from {len(index.targets)} targets "
+          f"over {index.end - index.start:.0f} s in {time.perf_counter() - t0:.1f} s")
+    if not index.targets:
+        print("no target traffic", file=sys.stderr)
+        return 1
+
+    schedules = [parse_schedule(s) for s in args.schedule] or [DEFAULT_SCHEDULE]
+
+    probing = None
+    if args.probe:
+        if args.responders:
+            responders = [mac_parse(m) for m in args.responders.split(",")]
+        elif args.generate:
+            responders = generated_aps()
+        else:
+            parser.error("--probe needs --responders for recorded traffic")
+        probing = Probing(args.probe, frozenset(responders), args.probe_per_dwell, args.probe_response_ms)
+        with Simulator(index, args.switch_ms, args.horizon, args.starts, args.jobs) as sim:
+            for s, (p, ttd) in zip(schedules, sim.evaluate_many(schedules)):
+                print(f"passive  p={p:.3f} ttd={ttd:6.2f}s  {format_schedule(s)}")
+
+    with Simulator(index, args.switch_ms, args.horizon, args.starts, args.jobs, probing) as sim:
+        label = "probe    " if probing else ""
+        for s, (p, ttd) in zip(schedules, sim.evaluate_many(schedules)):
+            print(f"{label}p={p:.3f} ttd={ttd:6.2f}s  {format_schedule(s)}")
+
+        if args.optimize:
+            t0 = time.perf_counter()
+            evaluated, best = optimize(sim, index.channels, args.optimize, log=print)
+            dt = time.perf_counter() - t0
+            print(f"\n{evaluated} schedules in {dt:.1f} s "
+                  f"({evaluated / dt:.0f}/s on {sim.jobs} workers); best:")
+            for (p, ttd), s in best[:5]:
+                print(f"p={p:.3f} ttd={ttd:6.2f}s  {format_schedule(s)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+"""MAC addresses as 48-bit integers.
+
+Integers hash and compare faster than 6-byte ``bytes`` slices and need no
+allocation to extract, which matters for per-device dicts at full frame rate.
+The most significant byte is the first byte on the wire, so ``oui()`` is
+simply the top 24 bits.
+"""
+
+import struct
+from typing import Optional
+
+BROADCAST = 0xFFFFFFFFFFFF
+
+# an address is the low 48 bits of the big-endian u64 ending at its last byte
+_unpack_u64 = struct.Struct(">Q").unpack_from
+
+# formatted strings, shared between all callers; reset when it gets large
+_STR_CACHE: dict = {}
+_STR_CACHE_MAX = 1 << 16
+
+UNKNOWN_STR = "??:??:??:??:??:??"
+
+
+def mac_at(buf: bytes, offset: int) -> int:
+    """Read the 6-byte address at ``buf[offset:offset + 6]`` without slicing."""
+    if offset >= 2:
+        return _unpack_u64(buf, offset - 2)[0] & BROADCAST
+    return int.from_bytes(buf[offset : offset + 6], "big")
+
+
+def mac_from_bytes(addr: bytes) -> int:
+    return int.from_bytes(addr, "big")
+
+
+def mac_to_bytes(mac: int) -> bytes:
+    return mac.to_bytes(6, "big")
+
+
+def mac_parse(text: str) -> int:
+    """Parse ``"aa:bb:cc:dd:ee:ff"`` (or ``-`` / no separators)."""
+    return int(text.replace(":", "").replace("-", ""), 16)
+
+
+def mac_str(mac: Optional[int]) -> str:
+    """Format as ``"aa:bb:cc:dd:ee:ff"``; repeated addresses hit a cache."""
+    if mac is None:
+        return UNKNOWN_STR
+    s = _STR_CACHE.get(mac)
+    if s is None:
+        h = f"{mac:012x}"
+        s = f"{h[0:2]}:{h[2:4]}:{h[4:6]}:{h[6:8]}:{h[8:10]}:{h[10:12]}"
+        if len(_STR_CACHE) >= _STR_CACHE_MAX:
+            _STR_CACHE.clear()
+        _STR_CACHE[mac] = s
+    return s
+
+
+def oui(mac: int) -> int:
+    """Organizationally unique identifier (top 24 bits)."""
+    return mac >> 24
+
+
+def oui_str(mac: int) -> str:
+    return mac_str(mac)[:8]
+
+
+def is_multicast(mac: int) -> bool:
+    """Group bit (I/G) of the first octet; includes broadcast."""
+    return bool((mac >> 40) & 0x01)
+
+
+def is_local(mac: int) -> bool:
+    """Locally administered bit (U/L), e.g. randomized client addresses."""
+    return bool((mac >> 40) & 0x02)
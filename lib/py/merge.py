@@ -0,0 +1,586 @@
+"""External k-way merge of pcapng segments into one time-ordered archive.
+
+    python -m lib.py.merge OUT sensor-a/*.pcapng sensor-b/*.pcapng
+
+Inputs come from any number of sensors and days, overlapping in time and
+given in any order. The merge never holds more than one sorting run in
+memory, plus about a megabyte per input being read and per output member
+being compressed:
+
+* An input already in time order is read in place. A plain segment is
+  checked on its index. A merged segment is always in order, and its
+  ``.gzidx`` says so.
+* Any other input is cut into runs of at most ``--run-mb``. Each run is
+  sorted in memory and spilled to a temporary file.
+* All sources are then merged by timestamp with a heap. Every source is
+  read sequentially in 1 MiB reads.
+
+A frame is a duplicate when an identical 802.11 frame (radiotap and FCS
+excluded) came from a different input within ``--dedup-ms``. Only the
+first copy is kept. Timestamps are the recording hosts' wall clocks, so
+the window has to cover their offsets. Only management and data frames of
+at least 24 bytes are compared. Control frames have no sequence number,
+so identical ACKs and CTSs are common and are not duplicates.
+
+Output goes to ``OUT-00000.pcapng.gz``, ``OUT-00001.pcapng.gz``, ... and
+each segment is rotated after ``--segment-mb`` of pcapng. Each one is a
+series of independent gzip members of about 1 MiB of pcapng blocks, so any
+gzip reader or Wireshark opens it. Members are compressed on a thread pool.
+A ``.gzidx`` sidecar lists every member's offset, size, packet count and
+time range. ``GzSegmentReader`` uses it to seek by time and to decompress
+members in parallel. Every segment starts with one interface per input
+(named after the file), so the sensor a frame came from is kept.
+``--level 0`` writes plain pcapng segments with the usual ``.idx``.
+"""
+
+import argparse
+import heapq
+import mmap
+import os
+import shutil
+import struct
+import sys
+import tempfile
+import time
+import zlib
+from collections import deque
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Deque, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple
+
+from .pcapng import (
+    BT_EPB,
+    BT_IDB,
+    BT_SHB,
+    BYTE_ORDER_MAGIC,
+    LINKTYPE_IEEE802_11,
+    LINKTYPE_IEEE802_11_RADIOTAP,
+    OPT_IF_TSRESOL,
+    PcapngReader,
+    _parse_radiotap,
+)
+
+IO_CHUNK = 1 << 20  # sequential read / write size
+MEMBER_SIZE = 1 << 20  # pcapng bytes per gzip member
+
+OPT_IF_NAME = 2
+
+# .gzidx sidecar: magic, version, flags, segment size, segment mtime_ns, members,
+# then per member: offset, compressed size, pcapng size, packets, first / last timestamp
+_GZIDX_MAGIC = b"SNPZ"
+_GZIDX_VERSION = 1
+_GZIDX_SORTED = 1
+_GZIDX_HDR = struct.Struct("<4sHHQqI")
+_GZIDX_MEMBER = struct.Struct("<QIIIQQ")
+
+# spilled run record: timestamp, interface, captured length, original length
+_RUN_REC = struct.Struct("<QHII")
+
+_EPB_HDR = struct.Struct("<IIIIIII")  # type, length, interface, ts hi, ts lo, captured, original
+
+# source item: (timestamp, source, n, interface, data, original length, sensor);
+# (source, n) is unique, so the heap never compares data
+Item = Tuple[int, int, int, int, bytes, int, int]
+Interface = Tuple[int, str]  # (linktype, name)
+
+
+def _pad4(n: int) -> int:
+    return -n & 3
+
+
+def _block(btype: int, body: bytes) -> bytes:
+    total = 12 + len(body) + _pad4(len(body))
+    return struct.pack("<II", btype, total) + body + b"\0" * _pad4(len(body)) + struct.pack("<I", total)
+
+
+def _option(code: int, value: bytes) -> bytes:
+    return struct.pack("<HH", code, len(value)) + value + b"\0" * _pad4(len(value))
+
+
+def _section(interfaces: Sequence[Interface]) -> bytes:
+    """Section header plus one microsecond-resolution IDB per interface."""
+    out = _block(BT_SHB, struct.pack("<IHHq", BYTE_ORDER_MAGIC, 1, 0, -1))
+    for linktype, name in interfaces:
+        opts = _option(OPT_IF_NAME, name.encode()) + _option(0, b"")
+        out += _block(BT_IDB, struct.pack("<HHI", linktype, 0, 0) + opts)
+    return out
+
+
+# ---- reading merged segments ----
+
+
+class _StreamParser:
+    """Incremental pcapng parser for bytes that are not mapped (decompressed streams)."""
+
+    def __init__(self):
+        # stream-wide interfaces: (big_endian, linktype, units per second, name)
+        self.interfaces: List[Tuple[bool, int, int, str]] = []
+        self._section: List[int] = []
+        self._big = False
+        self._buf = b""
+
+    def feed(self, chunk: bytes) -> Iterator[Tuple[int, int, memoryview, int]]:
+        """Yield ``(timestamp_us, interface, data, orig_len)`` for the complete packets."""
+        buf = self._buf + chunk if self._buf else chunk
+        view = memoryview(buf)
+        size = len(buf)
+        off = 0
+        while off + 12 <= size:
+            e = ">" if self._big else "<"
+            btype, blen = struct.unpack_from(e + "II", buf, off)
+            if btype == BT_SHB:
+                (bom,) = struct.unpack_from("<I", buf, off + 8)
+                self._big = bom != BYTE_ORDER_MAGIC
+                e = ">" if self._big else "<"
+                btype, blen = struct.unpack_from(e + "II", buf, off)
+                self._section = []
+            if blen < 12 or blen & 3:
+                raise ValueError("corrupt pcapng block")
+            if off + blen > size:
+                break
+            if btype == BT_EPB:
+                local, hi, lo, cap, orig = struct.unpack_from(e + "IIIII", buf, off + 8)
+                if local < len(self._section):
+                    iface = self._section[local]
+                    units = self.interfaces[iface][2]
+                    ts = (hi << 32) | lo
+                    if units != 1_000_000:
+                        ts = ts * 1_000_000 // units
+                    yield ts, iface, view[off + 28 : off + 28 + cap], orig
+            elif btype == BT_IDB:
+                self._section.append(len(self.interfaces))
+                self.interfaces.append(self._parse_idb(buf, off, blen, e))
+            off += blen
+        self._buf = bytes(view[off:])
+
+    def _parse_idb(self, buf: bytes, off: int, blen: int, e: str) -> Tuple[bool, int, int, str]:
+        (linktype,) = struct.unpack_from(e + "H", buf, off + 8)
+        units, name = 1_000_000, ""
+        pos, end = off + 16, off + blen - 4
+        while pos + 4 <= end:
+            code, olen = struct.unpack_from(e + "HH", buf, pos)
+            if code == 0:
+                break
+            if code == OPT_IF_TSRESOL and olen >= 1:
+                v = buf[pos + 4]
+                units = 2 ** (v & 0x7F) if v & 0x80 else 10 ** v
+            elif code == OPT_IF_NAME:
+                name = bytes(buf[pos + 4 : pos + 4 + olen]).decode("utf-8", "replace")
+            pos += 4 + olen + _pad4(olen)
+        return self._big, linktype, units, name
+
+
+class GzSegmentReader:
+    """A gzip-compressed pcapng segment, with its ``.gzidx`` if there is one.
+
+    With the index, ``records()`` decompresses only the members overlapping
+    the requested time range, several at a time on ``workers`` threads
+    (zlib releases the GIL). Without it, the file is decompressed as one
+    stream.
+    """
+
+    def __init__(self, path: str, workers: Optional[int] = None):
+        self.path = path
+        self.workers = workers or os.cpu_count() or 1
+        self.members: List[Tuple[int, int, int, int, int, int]] = []
+        self.sorted = False
+        self.indexed = self._load_index(path + ".gzidx")
+        self.interfaces: List[Tuple[bool, int, int, str]] = []
+
+    def _load_index(self, idx_path: str) -> bool:
+        try:
+            st = os.stat(self.path)
+            with open(idx_path, "rb") as f:
+                magic, version, flags, size, mtime_ns, n = _GZIDX_HDR.unpack(f.read(_GZIDX_HDR.size))
+                if (magic, version, size, mtime_ns) != (_GZIDX_MAGIC, _GZIDX_VERSION, st.st_size, st.st_mtime_ns):
+                    return False
+                raw = f.read(n * _GZIDX_MEMBER.size)
+        except (OSError, struct.error):
+            return False
+        if len(raw) != n * _GZIDX_MEMBER.size:
+            return False
+        self.members = list(_GZIDX_MEMBER.iter_unpack(raw))
+        self.sorted = bool(flags & _GZIDX_SORTED)
+        return True
+
+    def __len__(self) -> int:
+        return sum(m[3] for m in self.members)
+
+    def records(
+        self, since_us: Optional[int] = None, until_us: Optional[int] = None
+    ) -> Iterator[Tuple[int, int, memoryview, int]]:
+        """Yield ``(timestamp_us, interface, data, orig_len)``; the range needs the index."""
+        parser = _StreamParser()
+        self.interfaces = parser.interfaces
+        if not self.indexed:
+            for ts, iface, data, orig in self._stream(parser):
+                if (since_us is None or ts >= since_us) and (until_us is None or ts < until_us):
+                    yield ts, iface, data, orig
+            return
+
+        members = self.members
+        if members:
+            # the first member carries the section header and every interface
+            wanted = [0] + [
+                i for i, m in enumerate(members)
+                if i and (since_us is None or m[5] >= since_us) and (until_us is None or m[4] < until_us)
+            ]
+        else:
+            wanted = []
+        with open(self.path, "rb") as f, ThreadPoolExecutor(self.workers) as pool:
+            pending: Deque[Future] = deque()
+            it = iter(wanted)
+
+            def submit() -> bool:
+                i = next(it, None)
+                if i is None:
+                    return False
+                offset, clen = members[i][0], members[i][1]
+                f.seek(offset)
+                pending.append(pool.submit(zlib.decompress, f.read(clen), 31))
+                return True
+
+            for _ in range(2 * self.workers):
+                if not submit():
+                    break
+            while pending:
+                data = pending.popleft().result()
+                submit()
+                for rec in parser.feed(data):
+                    ts = rec[0]
+                    if (since_us is None or ts >= since_us) and (until_us is None or ts < until_us):
+                        yield rec
+
+    def _stream(self, parser: _StreamParser) -> Iterator[Tuple[int, int, memoryview, int]]:
+        with open(self.path, "rb", buffering=0) as f:
+            d = zlib.decompressobj(31)
+            while True:
+                chunk = f.read(IO_CHUNK)
+                if not chunk:
+                    break
+                while chunk:
+                    yield from parser.feed(d.decompress(chunk))
+                    if not d.eof:
+                        break
+                    chunk = d.unused_data  # next gzip member
+                    d = zlib.decompressobj(31)
+            yield from parser.feed(d.flush())
+
+
+# ---- sources ----
+
+
+def _run_writer(path: str, items: List[Item]) -> None:
+    items.sort()
+    with open(path, "wb", buffering=IO_CHUNK) as f:
+        pack = _RUN_REC.pack
+        for ts, _src, _n, iface, data, orig, _sensor in items:
+            f.write(pack(ts, iface, len(data), orig))
+            f.write(data)
+
+
+def _run_source(path: str, source: int, sensor: int) -> Iterator[Item]:
+    size = _RUN_REC.size
+    unpack = _RUN_REC.unpack_from
+    n = 0
+    with open(path, "rb", buffering=0) as f:
+        buf = b""
+        while True:
+            chunk = f.read(IO_CHUNK)
+            if not chunk:
+                return
+            buf = buf + chunk if buf else chunk
+            off, end = 0, len(buf)
+            while off + size <= end:
+                ts, iface, cap, orig = unpack(buf, off)
+                if off + size + cap > end:
+                    break
+                yield ts, source, n, iface, buf[off + size : off + size + cap], orig, sensor
+                n += 1
+                off += size + cap
+            buf = buf[off:]
+
+
+def _reader_source(records: Iterable, gmap: Dict[int, int], source: int, sensor: int) -> Iterator[Item]:
+    n = 0
+    for ts, iface, data, orig in records:
+        g = gmap.get(iface)
+        if g is not None:
+            yield ts, source, n, g, data, orig, sensor
+            n += 1
+
+
+def _in_order(ts) -> bool:
+    return all(a <= b for a, b in zip(ts, ts[1:]))
+
+
+# ---- output ----
+
+
+class SegmentWriter:
+    """Time-ordered packets into rotated, gzip-member-compressed pcapng segments."""
+
+    def __init__(
+        self,
+        prefix: str,
+        interfaces: Sequence[Interface],
+        segment_bytes: int = 512 << 20,
+        level: int = 1,
+        workers: Optional[int] = None,
+    ):
+        self.prefix = prefix
+        self.segment_bytes = segment_bytes
+        self.level = level
+        self.workers = workers or os.cpu_count() or 1
+        self.paths: List[str] = []
+        self.bytes_out = 0
+        self._section = _section(interfaces)
+        self._pool = ThreadPoolExecutor(self.workers) if level else None
+        self._pending: Deque[Tuple[Future, int, int, int, int]] = deque()
+        self._f = None
+        self._member = bytearray()
+        self._m_packets = 0
+        self._m_first = self._m_last = 0
+        self._seg_bytes = 0
+        self._index: List[Tuple[int, int, int, int, int, int]] = []
+
+    def write(self, ts: int, iface: int, data: bytes, orig: int) -> None:
+        if self._f is None:
+            self._open()
+        cap = len(data)
+        pad = _pad4(cap)
+        total = 32 + cap + pad
+        m = self._member
+        m += _EPB_HDR.pack(BT_EPB, total, iface, ts >> 32, ts & 0xFFFFFFFF, cap, orig)
+        m += data
+        m += b"\0" * pad
+        m += total.to_bytes(4, "little")
+        if not self._m_packets:
+            self._m_first = ts
+        self._m_last = ts
+        self._m_packets += 1
+        if len(m) >= MEMBER_SIZE:
+            self._flush_member()
+            if self._seg_bytes >= self.segment_bytes:
+                self._close_segment()
+
+    def _open(self) -> None:
+        ext = ".pcapng.gz" if self.level else ".pcapng"
+        path = f"{self.prefix}-{len(self.paths):05d}{ext}"
+        self.paths.append(path)
+        self._f = open(path, "wb")
+        self._index = []
+        self._seg_bytes = 0
+        self._member += self._section
+
+    def _flush_member(self) -> None:
+        data = bytes(self._member)
+        self._member = bytearray()
+        self._seg_bytes += len(data)
+        meta = (len(data), self._m_packets, self._m_first, self._m_last)
+        self._m_packets = 0
+        if not self.level:
+            self._f.write(data)
+            return
+        fut = self._pool.submit(_gzip_member, data, self.level)
+        self._pending.append((fut,) + meta)
+        while len(self._pending) > 2 * self.workers:
+            self._write_member()
+
+    def _write_member(self) -> None:
+        fut, raw_len, packets, first, last = self._pending.popleft()
+        blob = fut.result()
+        self._index.append((self._f.tell(), len(blob), raw_len, packets, first, last))
+        self._f.write(blob)
+
+    def _close_segment(self) -> None:
+        if self._member:
+            self._flush_member()
+        while self._pending:
+            self._write_member()
+        path = self.paths[-1]
+        self._f.close()
+        self._f = None
+        self.bytes_out += os.path.getsize(path)
+        if self.level:
+            st = os.stat(path)
+            with open(path + ".gzidx", "wb") as f:
+                f.write(_GZIDX_HDR.pack(_GZIDX_MAGIC, _GZIDX_VERSION, _GZIDX_SORTED, st.st_size,
+                                        st.st_mtime_ns, len(self._index)))
+                for m in self._index:
+                    f.write(_GZIDX_MEMBER.pack(*m))
+        else:
+            PcapngReader(path).close()  # writes the .idx
+
+    def close(self) -> None:
+        if self._f is not None:
+            self._close_segment()
+        if self._pool is not None:
+            self._pool.shutdown()
+
+
+def _gzip_member(data: bytes, level: int) -> bytes:
+    c = zlib.compressobj(level, zlib.DEFLATED, 31)
+    return c.compress(data) + c.flush()
+
+
+# ---- merge ----
+
+
+def _dedup_key(linktype: int, data) -> Optional[bytes]:
+    """802.11 bytes to compare, or None for frames that are never duplicates."""
+    if linktype == LINKTYPE_IEEE802_11_RADIOTAP:
+        try:
+            _ch, _rssi, _noise, hlen, fcs = _parse_radiotap(data)
+        except (struct.error, IndexError):
+            return None
+        data = data[hlen : len(data) - 4] if fcs else data[hlen:]
+    elif linktype != LINKTYPE_IEEE802_11:
+        return None
+    if len(data) < 24 or (data[0] >> 2) & 3 == 1:
+        return None
+    return bytes(data)
+
+
+def merge_captures(
+    inputs: Sequence[str],
+    prefix: str,
+    segment_bytes: int = 512 << 20,
+    run_bytes: int = 64 << 20,
+    dedup_us: int = 20_000,
+    level: int = 1,
+    workers: Optional[int] = None,
+    tmp_dir: Optional[str] = None,
+) -> Dict[str, int]:
+    """Merge ``inputs`` into time-ordered segments named ``prefix-NNNNN``.
+
+    Returns counts: inputs, input_bytes, runs (spilled), packets_in,
+    duplicates, packets_out, segments, output_bytes.
+    """
+    stats = dict(inputs=len(inputs), input_bytes=0, runs=0, packets_in=0,
+                 duplicates=0, packets_out=0, segments=0, output_bytes=0)
+    interfaces: List[Interface] = []
+    sources: List[Iterator[Item]] = []
+    opened: list = []
+    spill = tempfile.mkdtemp(prefix="merge-", dir=tmp_dir)
+    try:
+        for sensor, path in enumerate(inputs):
+            stats["input_bytes"] += os.path.getsize(path)
+            name = os.path.basename(path)
+            if path.endswith(".gz"):
+                r = GzSegmentReader(path, workers)
+                records = r.records()
+                in_order = r.sorted
+                first = next(records, None)  # parses the interfaces
+                ifs = [(lt, n or name) for _big, lt, _u, n in r.interfaces]
+
+                def chain(first=first, records=records):
+                    if first is not None:
+                        yield first
+                        yield from records
+
+                records = chain()
+            else:
+                r = PcapngReader(path)
+                opened.append(r)
+                if hasattr(r._map, "madvise") and hasattr(mmap, "MADV_SEQUENTIAL"):
+                    r._map.madvise(mmap.MADV_SEQUENTIAL)
+                ifs = [(lt, name if len(r.interfaces) == 1 else f"{name}#{i}")
+                       for i, (_big, lt, _u) in enumerate(r.interfaces)]
+                in_order = _in_order(r.timestamps())
+                records = r.records()
+            gmap = {}
+            for i, itf in enumerate(ifs):
+                if itf[0] in (LINKTYPE_IEEE802_11, LINKTYPE_IEEE802_11_RADIOTAP):
+                    gmap[i] = len(interfaces)
+                    interfaces.append(itf)
+
+            if in_order:
+                sources.append(_reader_source(records, gmap, len(sources), sensor))
+                continue
+            # out of order: sorted runs, spilled
+            run: List[Item] = []
+            held = 0
+            for item in _reader_source(records, gmap, 0, sensor):
+                ts, _s, n, g, data, orig, _ = item
+                run.append((ts, 0, n, g, bytes(data), orig, sensor))
+                held += len(data) + 128
+                if held >= run_bytes:
+                    rp = os.path.join(spill, f"run{stats['runs']:05d}")
+                    _run_writer(rp, run)
+                    sources.append(_run_source(rp, len(sources), sensor))
+                    stats["runs"] += 1
+                    run, held = [], 0
+            if run:
+                rp = os.path.join(spill, f"run{stats['runs']:05d}")
+                _run_writer(rp, run)
+                sources.append(_run_source(rp, len(sources), sensor))
+                stats["runs"] += 1
+
+        linktypes = [lt for lt, _ in interfaces]
+        writer = SegmentWriter(prefix, interfaces, segment_bytes, level, workers)
+        seen: Dict[bytes, Tuple[int, int]] = {}
+        recent: Deque[Tuple[int, bytes]] = deque()
+        n_in = dups = 0
+        try:
+            for ts, _src, _n, iface, data, orig, sensor in heapq.merge(*sources):
+                n_in += 1
+                if dedup_us:
+                    key = _dedup_key(linktypes[iface], data)
+                    if key is not None:
+                        horizon = ts - dedup_us
+                        while recent and recent[0][0] < horizon:
+                            old_ts, old = recent.popleft()
+                            if seen.get(old, (None,))[0] == old_ts:
+                                del seen[old]
+                        prev = seen.get(key)
+                        if prev is not None and prev[1] != sensor:
+                            dups += 1
+                            continue
+                        seen[key] = (ts, sensor)
+                        recent.append((ts, key))
+                writer.write(ts, iface, data, orig)
+        finally:
+            writer.close()
+        stats.update(packets_in=n_in, duplicates=dups, packets_out=n_in - dups,
+                     segments=len(writer.paths), output_bytes=writer.bytes_out)
+        return stats
+    finally:
+        sources.clear()
+        for r in opened:
+            r.close()
+        shutil.rmtree(spill, ignore_errors=True)
+
+
+def main(argv: Optional[Sequence[str]] = None) -> None:
+    ap = argparse.ArgumentParser(
+        prog="python -m lib.py.merge",
+        description="Merge pcapng captures into one time-ordered, de-duplicated archive",
+    )
+    ap.add_argument("output", help="Output prefix (writes OUTPUT-00000.pcapng.gz, ...)")
+    ap.add_argument("inputs", nargs="+", help="pcapng segments (.pcapng or merged .pcapng.gz)")
+    ap.add_argument("--segment-mb", type=int, default=512, help="pcapng MB per output segment (default: 512)")
+    ap.add_argument("--run-mb", type=int, default=64, help="Memory for sorting out-of-order inputs (default: 64)")
+    ap.add_argument("--dedup-ms", type=float, default=20, help="Cross-sensor duplicate window, 0 = off (default: 20)")
+    ap.add_argument("--level", type=int, default=1, choices=range(10), metavar="0-9",
+                    help="gzip level, 0 = plain pcapng (default: 1)")
+    ap.add_argument("--workers", type=int, default=0, help="Compression threads (default: all cores)")
+    ap.add_argument("--tmp", help="Directory for spilled runs (default: system temp)")
+    args = ap.parse_args(argv)
+
+    t0 = time.perf_counter()
+    st = merge_captures(
+        args.inputs, args.output,
+        segment_bytes=args.segment_mb << 20, run_bytes=args.run_mb << 20,
+        dedup_us=int(args.dedup_ms * 1000), level=args.level,
+        workers=args.workers or None, tmp_dir=args.tmp,
+    )
+    elapsed = time.perf_counter() - t0
+    print(f"{st['packets_in']} packets from {st['inputs']} input(s) "
+          f"({st['input_bytes'] / 1e6:.0f} MB, {st['runs']} spilled run(s))")
+    print(f"{st['duplicates']} cross-sensor duplicates dropped, {st['packets_out']} packets written "
+          f"to {st['segments']} segment(s), {st['output_bytes'] / 1e6:.0f} MB")
+    print(f"{elapsed:.1f} s, {st['input_bytes'] / 1e9 / max(elapsed, 1e-9) * 60:.2f} GB/min")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,592 @@
+"""Memory-mapped pcapng reading, writing, and parallel map-reduce analysis.
+
+Capture archives are pcapng segments with 802.11 frames, either raw
+(linktype 105) or behind a radiotap header (linktype 127, which is what
+``PcapngWriter`` and ``scan --pcapng`` produce). A reader memory-maps its
+segment and walks the blocks once to build an index of packet-block offsets.
+The index is saved next to the segment as ``<segment>.idx``, so later opens
+skip the walk. Packets are yielded as ``memoryview`` slices of the map, with
+no copies.
+
+``map_reduce`` splits the indexed packets of many segments into shards,
+runs a mapper over each shard on every core, and merges the per-shard
+aggregates:
+
+    python -m lib.py.pcapng captures/*.pcapng --workers 8
+
+Simple Packet Blocks (no timestamp or interface) are skipped.
+"""
+
+import argparse
+import mmap
+import os
+import struct
+import sys
+import time
+from array import array
+from collections import Counter
+from concurrent.futures import ProcessPoolExecutor
+from typing import Any, Callable, Dict, Iterable, Iterator, List, Optional, Sequence, Tuple
+
+from .frame import Frame, META_FMT
+from .mac import mac_str
+
+# block types
+BT_SHB = 0x0A0D0D0A
+BT_IDB = 0x00000001
+BT_EPB = 0x00000006
+
+BYTE_ORDER_MAGIC = 0x1A2B3C4D
+
+LINKTYPE_IEEE802_11 = 105
+LINKTYPE_IEEE802_11_RADIOTAP = 127
+
+OPT_IF_TSRESOL = 9
+
+# radiotap fields we read, by present bit: (alignment, size)
+_RT_FIELDS = ((8, 8), (1, 1), (1, 1), (2, 4), (1, 2), (1, 1), (1, 1))
+_RT_TSFT, _RT_FLAGS, _RT_RATE, _RT_CHANNEL, _RT_FHSS, _RT_SIGNAL, _RT_NOISE = range(7)
+_RT_FLAG_FCS = 0x10
+_RT_PRESENT_EXT = 1 << 31
+
+# what PcapngWriter emits: channel, dBm signal, dBm noise
+_RT_WRITE_PRESENT = (1 << _RT_CHANNEL) | (1 << _RT_SIGNAL) | (1 << _RT_NOISE)
+_RT_WRITE = struct.Struct("<BBHIHHbb")  # version, pad, len, present, freq, flags, signal, noise
+_RT_CHAN_2GHZ = 0x0080
+_RT_CHAN_5GHZ = 0x0100
+
+_pack_meta = struct.Struct(META_FMT).pack
+
+
+class _FileFrame(Frame):
+    """Frame read from a file: the full timestamp does not fit the 32-bit metadata field."""
+
+    __slots__ = ("_ts",)
+
+    @property
+    def timestamp_us(self) -> int:
+        return self._ts
+
+
+# index sidecar: magic, version, segment size, segment mtime_ns, interfaces, packets
+_IDX_MAGIC = b"SNPX"
+_IDX_VERSION = 1
+_IDX_HDR = struct.Struct("<4sHxxQqII")
+_IDX_IFACE = struct.Struct("<BxHQ")  # big-endian flag, linktype, timestamp units per second
+
+
+def channel_to_freq(channel: int) -> int:
+    if channel == 14:
+        return 2484
+    if channel < 14:
+        return 2407 + 5 * channel
+    return 5000 + 5 * channel
+
+
+def freq_to_channel(freq: int) -> int:
+    if freq == 2484:
+        return 14
+    if 2412 <= freq < 2484:
+        return (freq - 2407) // 5
+    if 5000 <= freq < 6000:
+        return (freq - 5000) // 5
+    return 0
+
+
+# ---- writing ----
+
+
+class PcapngWriter:
+    """Write frames to a pcapng segment with a radiotap header.
+
+    Radiotap carries the channel, RSSI and noise floor. Timestamps are the
+    host's wall clock at ``write()`` unless given, because the device's 32-bit
+    microsecond counter starts at boot.
+    """
+
+    def __init__(self, path: str):
+        self._f = open(path, "wb")
+        shb_body = struct.pack("<IHHq", BYTE_ORDER_MAGIC, 1, 0, -1)
+        self._block(BT_SHB, shb_body)
+        self._block(BT_IDB, struct.pack("<HHI", LINKTYPE_IEEE802_11_RADIOTAP, 0, 0))
+
+    def _block(self, btype: int, body: bytes) -> None:
+        pad = -len(body) & 3
+        total = 12 + len(body) + pad
+        self._f.write(struct.pack("<II", btype, total) + body + b"\0" * pad + struct.pack("<I", total))
+
+    def write(self, frame: Frame, timestamp_us: Optional[int] = None) -> None:
+        if timestamp_us is None:
+            timestamp_us = time.time_ns() // 1000
+        channel = frame.channel
+        rt = _RT_WRITE.pack(
+            0, 0, _RT_WRITE.size, _RT_WRITE_PRESENT,
+            channel_to_freq(channel), _RT_CHAN_2GHZ if channel <= 14 else _RT_CHAN_5GHZ,
+            frame.rssi, frame.noise_floor,
+        )
+        raw = frame.raw
+        cap = len(rt) + len(raw)
+        orig = len(rt) + (frame.orig_len or len(raw))
+        hdr = struct.pack("<IIIII", 0, timestamp_us >> 32, timestamp_us & 0xFFFFFFFF, cap, orig)
+        self._block(BT_EPB, hdr + rt + bytes(raw))
+
+    def flush(self) -> None:
+        self._f.flush()
+
+    def close(self) -> None:
+        self._f.close()
+
+    def __enter__(self) -> "PcapngWriter":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+# ---- reading ----
+
+
+class PcapngReader:
+    """Indexed, memory-mapped pcapng segment.
+
+    ``len(reader)`` is the packet count. ``packets()`` and ``frames()``
+    take an index range, which is how map-reduce shards a segment. Views
+    handed out keep the map alive: ``close()`` only unmaps once they are
+    gone.
+    """
+
+    def __init__(self, path: str, use_index_file: bool = True):
+        self.path = path
+        self._file = open(path, "rb")
+        st = os.fstat(self._file.fileno())
+        self._size = st.st_size
+        self._mtime_ns = st.st_mtime_ns
+        self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ) if self._size else b""
+        self._view = memoryview(self._map)
+
+        # per interface: (big_endian, linktype, timestamp units per second)
+        self.interfaces: List[Tuple[bool, int, int]] = []
+        self._offsets = array("Q")
+        self._ifaces = array("H")
+
+        idx_path = path + ".idx"
+        if not (use_index_file and self._load_index(idx_path)):
+            self._build_index()
+            if use_index_file:
+                self._save_index(idx_path)
+
+    def __len__(self) -> int:
+        return len(self._offsets)
+
+    # -- index --
+
+    def _build_index(self) -> None:
+        buf = self._view
+        size = self._size
+        off = 0
+        section: List[int] = []  # section-local interface id -> global id
+        le_hdr, be_hdr = struct.Struct("<II"), struct.Struct(">II")
+        hdr = le_hdr
+        big = False
+        offsets, ifaces = self._offsets, self._ifaces
+        while off + 12 <= size:
+            btype, blen = hdr.unpack_from(buf, off)
+            if btype == BT_SHB:
+                (bom,) = struct.unpack_from("<I", buf, off + 8)
+                big = bom != BYTE_ORDER_MAGIC
+                hdr = be_hdr if big else le_hdr
+                btype, blen = hdr.unpack_from(buf, off)
+                section = []
+            if blen < 12 or blen & 3 or off + blen > size:
+                break  # truncated tail (segment still being written)
+            if btype == BT_EPB:
+                (local,) = struct.unpack_from(">I" if big else "<I", buf, off + 8)
+                if local < len(section):
+                    offsets.append(off)
+                    ifaces.append(section[local])
+            elif btype == BT_IDB:
+                section.append(len(self.interfaces))
+                self.interfaces.append(self._parse_idb(buf, off, blen, big))
+            off += blen
+
+    @staticmethod
+    def _parse_idb(buf, off: int, blen: int, big: bool) -> Tuple[bool, int, int]:
+        e = ">" if big else "<"
+        (linktype,) = struct.unpack_from(e + "H", buf, off + 8)
+        units = 1_000_000
+        pos, end = off + 16, off + blen - 4
+        while pos + 4 <= end:
+            code, olen = struct.unpack_from(e + "HH", buf, pos)
+            if code == 0:
+                break
+            if code == OPT_IF_TSRESOL and olen >= 1:
+                v = buf[pos + 4]
+                units = 2 ** (v & 0x7F) if v & 0x80 else 10 ** v
+            pos += 4 + olen + (-olen & 3)
+        return big, linktype, units
+
+    def _load_index(self, idx_path: str) -> bool:
+        try:
+            with open(idx_path, "rb") as f:
+                head = f.read(_IDX_HDR.size)
+                if len(head) != _IDX_HDR.size:
+                    return False
+                magic, version, size, mtime_ns, n_if, n_pkt = _IDX_HDR.unpack(head)
+                if (magic, version, size, mtime_ns) != (_IDX_MAGIC, _IDX_VERSION, self._size, self._mtime_ns):
+                    return False
+                for _ in range(n_if):
+                    big, linktype, units = _IDX_IFACE.unpack(f.read(_IDX_IFACE.size))
+                    self.interfaces.append((bool(big), linktype, units))
+                self._offsets.fromfile(f, n_pkt)
+                self._ifaces.fromfile(f, n_pkt)
+        except (OSError, EOFError, struct.error):
+            self.interfaces.clear()
+            self._offsets = array("Q")
+            self._ifaces = array("H")
+            return False
+        return True
+
+    def _save_index(self, idx_path: str) -> None:
+        tmp = idx_path + ".tmp"
+        try:
+            with open(tmp, "wb") as f:
+                f.write(_IDX_HDR.pack(_IDX_MAGIC, _IDX_VERSION, self._size, self._mtime_ns,
+                                      len(self.interfaces), len(self._offsets)))
+                for big, linktype, units in self.interfaces:
+                    f.write(_IDX_IFACE.pack(big, linktype, units))
+                self._offsets.tofile(f)
+                self._ifaces.tofile(f)
+            os.replace(tmp, idx_path)
+        except OSError:
+            pass  # read-only archive: the index just lives in memory
+
+    # -- iteration --
+
+    def packets(self, start: int = 0, stop: Optional[int] = None) -> Iterator[Tuple[int, int, memoryview]]:
+        """Yield ``(timestamp_us, interface, data)`` with ``data`` a view into the map."""
+        view = self._view
+        offsets, ifaces = self._offsets, self._ifaces
+        stop = len(offsets) if stop is None else min(stop, len(offsets))
+        epb_le, epb_be = struct.Struct("<IIII"), struct.Struct(">IIII")
+        info = self.interfaces
+        for i in range(start, stop):
+            off = offsets[i]
+            iface = ifaces[i]
+            big, _linktype, units = info[iface]
+            hi, lo, cap, _orig = (epb_be if big else epb_le).unpack_from(view, off + 12)
+            ts = (hi << 32) | lo
+            if units != 1_000_000:
+                ts = ts * 1_000_000 // units
+            data = off + 28
+            yield ts, iface, view[data : data + cap]
+
+    def records(self, start: int = 0, stop: Optional[int] = None) -> Iterator[Tuple[int, int, memoryview, int]]:
+        """Like ``packets()``, plus each packet's original length on the wire."""
+        view = self._view
+        offsets, ifaces = self._offsets, self._ifaces
+        stop = len(offsets) if stop is None else min(stop, len(offsets))
+        epb_le, epb_be = struct.Struct("<IIII"), struct.Struct(">IIII")
+        info = self.interfaces
+        for i in range(start, stop):
+            off = offsets[i]
+            iface = ifaces[i]
+            big, _linktype, units = info[iface]
+            hi, lo, cap, orig = (epb_be if big else epb_le).unpack_from(view, off + 12)
+            ts = (hi << 32) | lo
+            if units != 1_000_000:
+                ts = ts * 1_000_000 // units
+            data = off + 28
+            yield ts, iface, view[data : data + cap], orig
+
+    def timestamps(self) -> array:
+        """Every packet's timestamp in microseconds, in file order."""
+        out = array("Q")
+        view, info = self._view, self.interfaces
+        ts_le, ts_be = struct.Struct("<II"), struct.Struct(">II")
+        for off, iface in zip(self._offsets, self._ifaces):
+            big, _linktype, units = info[iface]
+            hi, lo = (ts_be if big else ts_le).unpack_from(view, off + 12)
+            ts = (hi << 32) | lo
+            out.append(ts if units == 1_000_000 else ts * 1_000_000 // units)
+        return out
+
+    def frames(self, start: int = 0, stop: Optional[int] = None) -> Iterator[Frame]:
+        """Yield ``Frame`` objects whose ``raw`` is a view into the map.
+
+        Radiotap channel, signal and noise fill the metadata. The timestamp
+        is the packet's full microsecond time, not a 32-bit device counter.
+        """
+        info = self.interfaces
+        for ts, iface, data in self.packets(start, stop):
+            linktype = info[iface][1]
+            channel = rssi = noise = 0
+            if linktype == LINKTYPE_IEEE802_11_RADIOTAP:
+                channel, rssi, noise, hlen, fcs = _parse_radiotap(data)
+                data = data[hlen : len(data) - 4] if fcs else data[hlen:]
+            elif linktype != LINKTYPE_IEEE802_11:
+                continue
+            f = _FileFrame(_pack_meta(0, len(data), channel, rssi, noise, 0, 0, 0, 0, 0), data)
+            f._ts = ts
+            yield f
+
+    def close(self) -> None:
+        self._view.release()
+        if isinstance(self._map, mmap.mmap):
+            try:
+                self._map.close()
+            except BufferError:
+                pass  # frames still reference it; unmapped when they are collected
+        self._file.close()
+
+    def __enter__(self) -> "PcapngReader":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+def _radiotap_layout(data: memoryview) -> Tuple[int, int, int, int, int]:
+    """Walk a radiotap header: offsets of (flags, channel, signal, noise) or -1, and its length."""
+    hlen, present = struct.unpack_from("<HI", data, 2)
+    hlen = min(hlen, len(data))
+    pos = 8
+    word = present
+    while word & _RT_PRESENT_EXT and pos + 4 <= hlen:  # skip extended bitmaps
+        (word,) = struct.unpack_from("<I", data, pos)
+        pos += 4
+    found = {}
+    for bit, (align, size) in enumerate(_RT_FIELDS):
+        if not present & (1 << bit):
+            continue
+        pos += -pos & (align - 1)
+        if pos + size > hlen:
+            break
+        found[bit] = pos
+        pos += size
+    get = found.get
+    return get(_RT_FLAGS, -1), get(_RT_CHANNEL, -1), get(_RT_SIGNAL, -1), get(_RT_NOISE, -1), hlen
+
+
+# layouts by (length, present word): a capture uses one or two, so the
+# per-packet cost is a dict lookup and a few byte reads
+_rt_layouts: Dict[Tuple[int, int], Tuple[int, int, int, int, int]] = {}
+_unpack_rt_key = struct.Struct("<HI").unpack_from
+
+
+def _parse_radiotap(data: memoryview) -> Tuple[int, int, int, int, bool]:
+    """Return (channel, rssi, noise, header length, has_fcs) from a radiotap header."""
+    if len(data) < 8:
+        return 0, 0, 0, len(data), False
+    key = _unpack_rt_key(data, 2)
+    layout = _rt_layouts.get(key)
+    if layout is None:
+        layout = _radiotap_layout(data)
+        if not key[1] & _RT_PRESENT_EXT and key[0] <= len(data):
+            _rt_layouts[key] = layout
+    flags, chan, sig, noise, hlen = layout
+    channel = freq_to_channel(data[chan] | data[chan + 1] << 8) if chan >= 0 else 0
+    rssi = (data[sig] ^ 0x80) - 0x80 if sig >= 0 else 0
+    nf = (data[noise] ^ 0x80) - 0x80 if noise >= 0 else 0
+    fcs = flags >= 0 and bool(data[flags] & _RT_FLAG_FCS)
+    return channel, rssi, nf, hlen, fcs
+
+
+# ---- aggregates ----
+
+
+class DeviceTable:
+    """Per-transmitter frame count, first/last seen and strongest RSSI.
+
+    Mergeable, so it can be built per shard and combined.
+    """
+
+    __slots__ = ("devices",)
+
+    def __init__(self):
+        # mac -> [frames, first_us, last_us, max_rssi]
+        self.devices: Dict[int, List[int]] = {}
+
+    def update(self, frame: Frame) -> None:
+        mac = frame.addr2
+        if mac is None:
+            return
+        ts = frame.timestamp_us
+        d = self.devices.get(mac)
+        if d is None:
+            self.devices[mac] = [1, ts, ts, frame.rssi]
+            return
+        d[0] += 1
+        if ts < d[1]:
+            d[1] = ts
+        if ts > d[2]:
+            d[2] = ts
+        if frame.rssi > d[3]:
+            d[3] = frame.rssi
+
+    def merge(self, other: "DeviceTable") -> "DeviceTable":
+        mine = self.devices
+        for mac, o in other.devices.items():
+            d = mine.get(mac)
+            if d is None:
+                mine[mac] = o
+            else:
+                d[0] += o[0]
+                d[1] = min(d[1], o[1])
+                d[2] = max(d[2], o[2])
+                d[3] = max(d[3], o[3])
+        return self
+
+    def top(self, n: int) -> List[Tuple[int, List[int]]]:
+        return sorted(self.devices.items(), key=lambda kv: kv[1][0], reverse=True)[:n]
+
+    def __len__(self) -> int:
+        return len(self.devices)
+
+
+def merge(a: Any, b: Any) -> Any:
+    """Combine two shard aggregates of the same shape.
+
+    Objects with a ``merge`` method (device tables, sketches) merge
+    themselves. Counters add, dicts merge per key, sets union, lists
+    concatenate, numbers add.
+    """
+    if a is None:
+        return b
+    if b is None:
+        return a
+    if hasattr(a, "merge"):
+        return a.merge(b)
+    if isinstance(a, Counter):
+        a.update(b)
+        return a
+    if isinstance(a, dict):
+        for k, v in b.items():
+            a[k] = merge(a[k], v) if k in a else v
+        return a
+    if isinstance(a, set):
+        return a | b
+    if isinstance(a, tuple):
+        return tuple(merge(x, y) for x, y in zip(a, b))
+    return a + b
+
+
+# ---- map-reduce ----
+
+Shard = Tuple[str, int, int]  # (segment path, first packet, end packet)
+Mapper = Callable[[Iterator[Frame]], Any]
+
+_worker_readers: Dict[str, PcapngReader] = {}
+
+
+def _reader(path: str) -> PcapngReader:
+    r = _worker_readers.get(path)
+    if r is None:
+        r = _worker_readers[path] = PcapngReader(path)
+    return r
+
+
+def _count(path: str) -> int:
+    return len(_reader(path))
+
+
+def _run_shard(mapper: Mapper, shard: Shard) -> Any:
+    path, start, stop = shard
+    return mapper(_reader(path).frames(start, stop))
+
+
+def plan_shards(counts: Sequence[Tuple[str, int]], target: int) -> List[Shard]:
+    """Cut segments into shards of about ``target`` packets (never spanning files)."""
+    shards = []
+    for path, n in counts:
+        pieces = max(1, round(n / target)) if target else 1
+        step = -(-n // pieces) if n else 0
+        for start in range(0, n, step or 1):
+            shards.append((path, start, min(n, start + step)))
+    return shards
+
+
+def map_reduce(
+    paths: Iterable[str],
+    mapper: Mapper,
+    workers: Optional[int] = None,
+    shards_per_worker: int = 4,
+) -> Any:
+    """Run ``mapper`` over every frame of ``paths`` on ``workers`` processes.
+
+    ``mapper`` gets an iterator of frames for one shard and returns an
+    aggregate. It must be a module-level function so it can be pickled.
+    Aggregates are combined with ``merge`` in shard order, so the result
+    does not depend on the worker count. Segments are indexed in parallel
+    first (and reuse their ``.idx`` files after that).
+    """
+    paths = list(paths)
+    workers = workers or os.cpu_count() or 1
+    if workers == 1:
+        counts = [(p, _count(p)) for p in paths]
+        total = sum(n for _, n in counts)
+        result = None
+        for shard in plan_shards(counts, total):
+            result = merge(result, _run_shard(mapper, shard))
+        return result
+
+    with ProcessPoolExecutor(max_workers=workers) as pool:
+        counts = list(zip(paths, pool.map(_count, paths)))
+        total = sum(n for _, n in counts)
+        shards = plan_shards(counts, -(-total // (workers * shards_per_worker)))
+        result = None
+        for part in pool.map(_run_shard, [mapper] * len(shards), shards):
+            result = merge(result, part)
+        return result
+
+
+# ---- CLI ----
+
+
+def summarize(frames: Iterator[Frame]) -> Dict[str, Any]:
+    """Mapper behind the CLI: device table, frame-type counts and frame total."""
+    devices = DeviceTable()
+    types: Counter = Counter()
+    n = 0
+    for f in frames:
+        n += 1
+        devices.update(f)
+        fc0 = f.raw[0] if f.raw else 0
+        types[((fc0 >> 2) & 3, fc0 >> 4)] += 1
+    return {"frames": n, "devices": devices, "types": types}
+
+
+TYPE_NAMES = {0: "mgmt", 1: "ctrl", 2: "data", 3: "ext"}
+
+
+def main(argv: Optional[Sequence[str]] = None) -> None:
+    ap = argparse.ArgumentParser(
+        prog="python -m lib.py.pcapng",
+        description="Summarize pcapng capture archives in parallel",
+    )
+    ap.add_argument("files", nargs="+", help="pcapng segments")
+    ap.add_argument("--workers", type=int, default=0, help="Processes (default: all cores)")
+    ap.add_argument("--top", type=int, default=20, help="Transmitters to list (default: 20)")
+    args = ap.parse_args(argv)
+
+    t0 = time.perf_counter()
+    out = map_reduce(args.files, summarize, workers=args.workers or None)
+    elapsed = time.perf_counter() - t0
+    if out is None:
+        print("no packets")
+        return
+
+    n = out["frames"]
+    devices: DeviceTable = out["devices"]
+    print(f"{n} frames, {len(devices)} transmitters, {len(args.files)} segment(s) "
+          f"in {elapsed:.2f} s ({n / max(elapsed, 1e-9) / 1e3:.0f} kframes/s)\n")
+    print("frame types:")
+    for (ftype, sub), count in out["types"].most_common():
+        print(f"  {TYPE_NAMES[ftype]}/{sub:<3} {count:>10}")
+    print(f"\ntop {args.top} transmitters:")
+    for mac, (count, first, last, rssi) in devices.top(args.top):
+        print(f"  {mac_str(mac)}  {count:>9} frames  rssi {rssi:>4} dBm  "
+              f"{(last - first) / 1e6:>9.1f} s span")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
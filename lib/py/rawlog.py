@@ -0,0 +1,300 @@
+"""Raw wire-stream recording: the device's bytes exactly as read, for later.
+
+    python -m lib.py PORT scan --record day1 [--record-only]
+    python -m lib.py.rawlog day1-*.raw [--pcapng day1.pcapng] [--since T] [--until T]
+
+``RawRecorder`` is handed every chunk the client's reader thread reads,
+before any decoding. It appends the chunks to a buffer and writes the buffer
+to the current segment in one call once it holds ``buffer_bytes`` or once
+``flush_s`` has passed. Segments (``PREFIX-00000.raw``, ...) rotate at a
+flush after ``segment_bytes``. Concatenated, they are the original stream.
+
+Once every ``mark_s`` seconds, a marker pairs the host clock with the
+segment offset where that chunk starts. Markers go to a ``<segment>.ridx``
+sidecar at each flush, and every segment starts with one. They let a reader
+seek by time and stamp frames with host time when the stream is replayed.
+
+``RawReader`` reads a recording back. ``replay()`` feeds it to a client
+(``SnifferClient(None, ...)``), and the CLI prints a summary or writes
+pcapng. Stamps in the pcapng are the host time of the frame's marker
+interval, plus the device clock's advance since the first frame of that
+interval.
+"""
+
+import argparse
+import bisect
+import os
+import struct
+import sys
+import threading
+import time
+from typing import Iterator, List, Optional, Sequence, Tuple
+
+IO_SIZE = 1 << 20
+
+_RIDX_MAGIC = b"SNPR"
+_RIDX_VERSION = 1
+_RIDX_HDR = struct.Struct("<4sHxx")
+_RIDX_MARK = struct.Struct("<QQ")  # host time (us since the epoch), segment offset
+
+
+class RawRecorder:
+    """Append raw device bytes to rotating segments with time markers.
+
+    Not thread-safe: one thread (the client's reader) calls ``write()``.
+    """
+
+    def __init__(
+        self,
+        prefix: str,
+        segment_bytes: int = 256 << 20,
+        buffer_bytes: int = IO_SIZE,
+        flush_s: float = 1.0,
+        mark_s: float = 1.0,
+    ):
+        self.prefix = prefix
+        self.segment_bytes = segment_bytes
+        self.buffer_bytes = buffer_bytes
+        self.flush_s = flush_s
+        self.mark_s = mark_s
+        self.paths: List[str] = []
+        self.bytes = 0  # recorded, including what is still buffered
+        self._buf = bytearray()
+        self._marks = bytearray()
+        self._f = None
+        self._idx = None
+        self._offset = 0  # segment offset of the buffer's start
+        self._last_flush = self._last_mark = 0.0
+
+    def write(self, chunk: bytes) -> None:
+        now = time.monotonic()
+        if self._f is None:
+            self._open()
+            self._last_flush = now
+            self._last_mark = now - self.mark_s  # mark the segment's first byte
+        if now - self._last_mark >= self.mark_s:
+            self._marks += _RIDX_MARK.pack(time.time_ns() // 1000, self._offset + len(self._buf))
+            self._last_mark = now
+        self._buf += chunk
+        self.bytes += len(chunk)
+        if len(self._buf) >= self.buffer_bytes or now - self._last_flush >= self.flush_s:
+            self.flush()
+            self._last_flush = now
+            if self._offset >= self.segment_bytes:
+                self._close_segment()
+
+    def flush(self) -> None:
+        if self._f is None:
+            return
+        if self._buf:
+            self._f.write(self._buf)
+            self._offset += len(self._buf)
+            self._buf = bytearray()
+        if self._marks:
+            self._idx.write(self._marks)
+            self._marks = bytearray()
+        self._f.flush()
+        self._idx.flush()
+
+    def close(self) -> None:
+        if self._f is not None:
+            self.flush()
+            self._close_segment()
+
+    def _open(self) -> None:
+        path = f"{self.prefix}-{len(self.paths):05d}.raw"
+        self.paths.append(path)
+        self._f = open(path, "wb", buffering=0)
+        self._idx = open(path + ".ridx", "wb", buffering=0)
+        self._idx.write(_RIDX_HDR.pack(_RIDX_MAGIC, _RIDX_VERSION))
+        self._offset = 0
+
+    def _close_segment(self) -> None:
+        self._f.close()
+        self._idx.close()
+        self._f = self._idx = None
+
+    def __enter__(self) -> "RawRecorder":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+class RawReader:
+    """A recording's segments, in order, with their markers."""
+
+    def __init__(self, paths: Sequence[str]):
+        self.paths = sorted(paths)
+        # (host_us, segment, offset), in stream order
+        self.marks: List[Tuple[int, int, int]] = []
+        self.sizes = [os.path.getsize(p) for p in self.paths]
+        for seg, path in enumerate(self.paths):
+            for host_us, off in self._load_marks(path + ".ridx"):
+                self.marks.append((host_us, seg, off))
+
+    @staticmethod
+    def _load_marks(path: str) -> Iterator[Tuple[int, int]]:
+        try:
+            with open(path, "rb") as f:
+                raw = f.read()
+        except OSError:
+            return iter(())
+        if len(raw) < _RIDX_HDR.size or raw[:4] != _RIDX_MAGIC:
+            return iter(())
+        body = raw[_RIDX_HDR.size :]
+        return _RIDX_MARK.iter_unpack(body[: len(body) - len(body) % _RIDX_MARK.size])
+
+    @property
+    def size(self) -> int:
+        return sum(self.sizes)
+
+    @property
+    def span_us(self) -> Tuple[int, int]:
+        """Host time of the first and last marker (0, 0 without markers)."""
+        return (self.marks[0][0], self.marks[-1][0]) if self.marks else (0, 0)
+
+    def intervals(
+        self, since_us: Optional[int] = None, until_us: Optional[int] = None, size: int = IO_SIZE
+    ) -> Iterator[Tuple[int, bytes]]:
+        """Yield ``(host_us, data)`` per marker interval, in pieces of at most ``size``.
+
+        ``host_us`` is the time of the marker the piece follows (0 before the
+        first one). A range starts at the last marker at or before
+        ``since_us``, so the first message may be cut; decoders skip to the
+        next delimiter.
+        """
+        marks = self.marks
+        j = 0  # next marker to adopt
+        seg = off = host = 0
+        if since_us is not None and marks:
+            j = max(0, bisect.bisect_right([m[0] for m in marks], since_us) - 1)
+            _, seg, off = marks[j]
+        while seg < len(self.paths):
+            while j < len(marks) and (marks[j][1], marks[j][2]) <= (seg, off):
+                host = marks[j][0]
+                j += 1
+                if until_us is not None and host >= until_us:
+                    return
+            end = self.sizes[seg]
+            if j < len(marks) and marks[j][1] == seg:
+                end = min(end, marks[j][2])
+            if off < end:
+                with open(self.paths[seg], "rb", buffering=0) as f:
+                    f.seek(off)
+                    while off < end:
+                        data = f.read(min(size, end - off))
+                        if not data:
+                            break
+                        yield host, data
+                        off += len(data)
+                off = end
+            if off >= self.sizes[seg]:
+                seg, off = seg + 1, 0
+
+    def replay(self, client, since_us: Optional[int] = None, until_us: Optional[int] = None) -> None:
+        """Feed the recording (or a time range of it) to ``client.feed()``."""
+        skip = since_us is not None
+        for _host, data in self.intervals(since_us, until_us):
+            if skip:
+                i = data.find(0)
+                if i < 0:
+                    continue
+                data = data[i:]
+                skip = False
+            client.feed(data)
+
+
+class _Stamper:
+    """on_frame for conversion: host time per marker interval plus device clock advance."""
+
+    def __init__(self, writer):
+        self.writer = writer
+        self.host_us = 0
+        self.dev_base: Optional[int] = None
+        self.frames = 0
+        self.cond = threading.Condition()
+
+    def start(self, host_us: int) -> None:
+        self.host_us = host_us
+        self.dev_base = None
+
+    def __call__(self, frame) -> None:
+        dev = frame.timestamp_us
+        if self.dev_base is None:
+            self.dev_base = dev
+        delta = (dev - self.dev_base) & 0xFFFFFFFF
+        if self.writer is not None:
+            self.writer.write(frame, self.host_us + (delta if delta < 0x80000000 else 0))
+        with self.cond:
+            self.frames += 1
+            self.cond.notify()
+
+    def wait(self, frames: int) -> None:
+        with self.cond:
+            self.cond.wait_for(lambda: self.frames >= frames, timeout=10)
+
+
+def main(argv: Optional[Sequence[str]] = None) -> None:
+    from .pcapng import PcapngWriter
+    from .sniffer_client import SnifferClient
+
+    ap = argparse.ArgumentParser(
+        prog="python -m lib.py.rawlog",
+        description="Decode a raw recording: summary, or conversion to pcapng",
+    )
+    ap.add_argument("segments", nargs="+", help="Recorded .raw segments")
+    ap.add_argument("--pcapng", help="Write frames to this pcapng file")
+    ap.add_argument("--since", help="Start at this many seconds into the recording (or an epoch time)")
+    ap.add_argument("--until", help="Stop at this many seconds into the recording (or an epoch time)")
+    args = ap.parse_args(argv)
+
+    reader = RawReader(args.segments)
+    start_us, end_us = reader.span_us
+
+    def when(value: Optional[str]) -> Optional[int]:
+        if value is None:
+            return None
+        t = int(float(value) * 1e6)
+        return t if t >= 1e15 else start_us + t  # an epoch time, or seconds into the recording
+
+    since_us, until_us = when(args.since), when(args.until)
+    writer = PcapngWriter(args.pcapng) if args.pcapng else None
+    stamper = _Stamper(writer)
+    client = SnifferClient(None, on_frame=stamper)
+    t0 = time.perf_counter()
+    nbytes = 0
+    try:
+        skip = since_us is not None
+        host = None
+        for h, data in reader.intervals(since_us, until_us):
+            if h != host:
+                stamper.wait(client.frame_count)  # frames of the previous interval are stamped
+                stamper.start(h)
+                host = h
+            if skip:
+                i = data.find(0)
+                if i < 0:
+                    continue
+                data, skip = data[i:], False
+            client.feed(data)
+            nbytes += len(data)
+        stamper.wait(client.frame_count)
+    finally:
+        client.close()
+        if writer is not None:
+            writer.close()
+    elapsed = time.perf_counter() - t0
+
+    print(f"{len(reader.paths)} segment(s), {nbytes / 1e6:.1f} MB, "
+          f"{(end_us - start_us) / 1e6:.0f} s recorded, decoded in {elapsed:.1f} s")
+    print(f"{client.frame_count} frames, {client.ble_adv_count} BLE adverts, {client.dropped} dropped")
+    lost = {k: v for k, v in client.loss.items() if v}
+    if lost:
+        print("Device-side losses: " + ", ".join(f"{k}={v}" for k, v in lost.items()))
+    if writer is not None:
+        print(f"Wrote {stamper.frames} frames to {args.pcapng}")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
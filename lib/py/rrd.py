@@ -0,0 +1,591 @@
+"""Round-robin metrics store: long-term per-channel and per-device activity.
+
+    python -m lib.py.rrd create activity.rrd --devices @known.txt
+    python -m lib.py PORT scan --rrd activity.rrd
+    python -m lib.py.rrd query activity.rrd ch6 --since 7d --step 1m
+    python -m lib.py.rrd query activity.rrd devices --since 30d --step 1d
+
+A store is one fixed-size file holding a set of series at several
+consolidation levels (by default 1 s for an hour, 1 min for 30 days and
+1 h for 5 years). Each level is a ring of rows, one bucket of every series
+per row: once full, the newest row overwrites the oldest, so the file
+never grows. Channel
+series count frames; device series count the seconds in which the device
+(as transmitter) was heard, so a day's bucket over 3600 is hours present.
+
+``observe()`` costs one or two dict lookups and a list increment per frame:
+counts for the current second are kept in memory and added to every level
+when the second ends. Presence is deduplicated against the 1 s level, so
+frames may arrive a little out of order (up to the 1 s level's span).
+
+Readers memory-map the file and read a series' ring directly, so a range
+query over months touches a few thousand numbers. A reader sees the data as
+of the writer's last completed second. Buckets are aligned to the epoch
+(UTC days).
+"""
+
+import argparse
+import mmap
+import os
+import re
+import struct
+import sys
+import time
+from array import array
+from calendar import timegm
+from typing import Callable, Dict, Iterable, List, NamedTuple, Optional, Sequence, Tuple
+
+from .frame import Frame
+from .mac import mac_parse, mac_str
+
+# series groups and consolidations
+SERIES_FREE = 0  # spare device slot
+SERIES_CHANNEL = 1
+SERIES_DEVICE = 2
+AGG_COUNT = 0  # events per bucket
+AGG_SECONDS = 1  # seconds with at least one event per bucket
+
+DEFAULT_LEVELS = "1s:1h,1m:30d,1h:5y"
+DEFAULT_CHANNELS = tuple(range(1, 15))
+
+_MAGIC = b"SNRR"
+_VERSION = 1
+# magic, version, levels, series, data offset, created (s), last flushed second
+_HDR = struct.Struct("<4sHHIIqq")
+_LEVEL = struct.Struct("<IIq")  # step (s), rows, newest bucket (-1 = none)
+_SERIES = struct.Struct("<BBxxxxxxQ")  # group, agg, key (channel or address)
+_PAGE = 4096
+_CELL = 4  # u32 per bucket
+
+_UNITS = {"s": 1, "m": 60, "h": 3600, "d": 86400, "w": 7 * 86400, "y": 365 * 86400}
+
+
+def parse_duration(text: str) -> int:
+    """Seconds in ``90``, ``30s``, ``5m``, ``12h``, ``30d``, ``2w`` or ``5y``."""
+    m = re.fullmatch(r"(\d+)([smhdwy]?)", text.strip())
+    if not m:
+        raise ValueError(f"bad duration {text!r}")
+    return int(m.group(1)) * _UNITS[m.group(2) or "s"]
+
+
+def parse_levels(spec: str) -> List[Tuple[int, int]]:
+    """``STEP:SPAN,...`` (e.g. ``1s:1h,1m:30d``) as ``[(step_s, rows), ...]``.
+
+    The first step must be 1 s, and each step a multiple of the one before.
+    """
+    levels = []
+    for part in spec.split(","):
+        step_s, _, span = part.partition(":")
+        step, span_s = parse_duration(step_s), parse_duration(span or step_s)
+        if step <= 0 or span_s < step:
+            raise ValueError(f"bad level {part!r}")
+        if levels and step % levels[-1][0]:
+            raise ValueError(f"level {part!r}: step is not a multiple of the previous one")
+        levels.append((step, span_s // step))
+    if not levels or levels[0][0] != 1:
+        raise ValueError("the first level must have a 1 s step")
+    return levels
+
+
+def format_duration(s: int) -> str:
+    for unit in "ydhms":
+        n = _UNITS[unit]
+        if s % n == 0 and s >= n:
+            return f"{s // n}{unit}"
+    return f"{s}s"
+
+
+class Series(NamedTuple):
+    group: int
+    agg: int
+    key: int
+
+    def __str__(self) -> str:
+        if self.group == SERIES_CHANNEL:
+            return f"ch{self.key}"
+        if self.group == SERIES_DEVICE:
+            return mac_str(self.key)
+        return "-"
+
+
+class Level(NamedTuple):
+    step: int
+    rows: int
+    offset: int  # byte offset of the level's data
+
+
+class RoundRobinStore:
+    """A round-robin store file; see the module docstring.
+
+    ``RoundRobinStore.create()`` makes a file and opens it for writing;
+    ``RoundRobinStore(path)`` opens one read-only, and ``writable=True`` for
+    updates. One writer at a time; any number of readers.
+    """
+
+    def __init__(self, path: str, writable: bool = False, now: Callable[[], float] = time.time):
+        self.path = path
+        self._now = now
+        self._file = open(path, "r+b" if writable else "rb")
+        self.size = os.fstat(self._file.fileno()).st_size
+        self._map = mmap.mmap(
+            self._file.fileno(), self.size, access=mmap.ACCESS_WRITE if writable else mmap.ACCESS_READ
+        )
+        magic, version, nlevels, nseries, data_off, self.created, _ = _HDR.unpack_from(self._map, 0)
+        if magic != _MAGIC or version != _VERSION:
+            self._map.close()
+            self._file.close()
+            raise ValueError(f"{path}: not a round-robin store")
+        self._cells = memoryview(self._map).cast("I")
+
+        pos = _HDR.size
+        self.levels: List[Level] = []
+        off = data_off
+        for _ in range(nlevels):
+            step, rows, _newest = _LEVEL.unpack_from(self._map, pos)
+            self.levels.append(Level(step, rows, off))
+            off += rows * nseries * _CELL
+            pos += _LEVEL.size
+        self._series_pos = pos
+        self.series: List[Series] = [Series(*_SERIES.unpack_from(self._map, pos + i * _SERIES.size))
+                                     for i in range(nseries)]
+        self._index()
+
+        # writer state: counts of the current second, not yet in the levels
+        self._writable = writable
+        self._sec = self._last = self.last_second
+        self._heads = [self._newest(k) for k in range(nlevels)]
+        self._presence = [s.agg == AGG_SECONDS for s in self.series]
+        self._pend = [0] * nseries
+        self._zeros = array("I", bytes(_CELL * min(1 << 16, nseries * max(lv.rows for lv in self.levels))))
+        self.late_dropped = 0  # older than the 1 s level could deduplicate, or than any level holds
+
+    @classmethod
+    def create(
+        cls,
+        path: str,
+        levels: str = DEFAULT_LEVELS,
+        channels: Iterable[int] = DEFAULT_CHANNELS,
+        devices: Iterable[int] = (),
+        spare: int = 0,
+        now: Callable[[], float] = time.time,
+    ) -> "RoundRobinStore":
+        """Create a store (replacing ``path``) and open it for writing.
+
+        ``spare`` device slots can be filled later with ``add_device()``.
+        The file is sized for every level up front (sparse where the OS
+        allows).
+        """
+        lv = parse_levels(levels)
+        series = [Series(SERIES_CHANNEL, AGG_COUNT, c) for c in channels]
+        series += [Series(SERIES_DEVICE, AGG_SECONDS, m) for m in dict.fromkeys(devices)]
+        series += [Series(SERIES_FREE, AGG_SECONDS, 0)] * spare
+        if not series:
+            raise ValueError("a store needs at least one series")
+        head = _HDR.size + len(lv) * _LEVEL.size + len(series) * _SERIES.size
+        data_off = (head + _PAGE - 1) // _PAGE * _PAGE
+        size = data_off + sum(rows for _, rows in lv) * len(series) * _CELL
+
+        buf = bytearray(data_off)
+        _HDR.pack_into(buf, 0, _MAGIC, _VERSION, len(lv), len(series), data_off, int(now()), -1)
+        pos = _HDR.size
+        for step, rows in lv:
+            _LEVEL.pack_into(buf, pos, step, rows, -1)
+            pos += _LEVEL.size
+        for s in series:
+            _SERIES.pack_into(buf, pos, *s)
+            pos += _SERIES.size
+        with open(path, "wb") as f:
+            f.write(buf)
+            f.truncate(size)
+        return cls(path, writable=True, now=now)
+
+    def _index(self) -> None:
+        self._channels: Dict[int, int] = {}
+        self._devices: Dict[int, int] = {}
+        for i, s in enumerate(self.series):
+            if s.group == SERIES_CHANNEL:
+                self._channels[s.key] = i
+            elif s.group == SERIES_DEVICE:
+                self._devices[s.key] = i
+
+    # -- header --
+
+    @property
+    def last_second(self) -> int:
+        """Newest second added to the levels (-1 before the first)."""
+        return _HDR.unpack_from(self._map, 0)[6]
+
+    def _newest(self, level: int) -> int:
+        return _LEVEL.unpack_from(self._map, _HDR.size + level * _LEVEL.size)[2]
+
+    # -- writing --
+
+    def add_device(self, mac: int) -> bool:
+        """Track a device in a spare slot. False if it is tracked already or none is left."""
+        if mac in self._devices:
+            return False
+        for i, s in enumerate(self.series):
+            if s.group == SERIES_FREE:
+                s = self.series[i] = Series(SERIES_DEVICE, AGG_SECONDS, mac)
+                _SERIES.pack_into(self._map, self._series_pos + i * _SERIES.size, *s)
+                self._devices[mac] = i
+                return True
+        return False
+
+    def observe(self, frame: Frame, t: Optional[float] = None) -> None:
+        """Count a frame at time ``t`` (epoch seconds; default: now)."""
+        s = int(self._now() if t is None else t)
+        if s != self._sec and not self._roll(s):
+            late = (self._channels.get(frame.channel), self._devices.get(frame.addr2))
+            self._add(s, [(i, 1) for i in late if i is not None])
+            return
+        pend = self._pend
+        i = self._channels.get(frame.channel)
+        if i is not None:
+            pend[i] += 1
+        if self._devices:
+            i = self._devices.get(frame.addr2)
+            if i is not None:
+                pend[i] += 1
+
+    def add(self, series: int, t: float, n: int = 1) -> None:
+        """Add ``n`` events to series index ``series`` at time ``t``."""
+        s = int(t)
+        if s == self._sec or self._roll(s):
+            self._pend[series] += n
+        else:
+            self._add(s, [(series, n)])
+
+    def _roll(self, s: int) -> bool:
+        """Move the current second to ``s``; False if ``s`` is in the past."""
+        if s < self._sec:
+            return False
+        self.flush()
+        self._sec = s
+        return True
+
+    def flush(self) -> None:
+        """Add the current second's counts to the levels."""
+        pend = self._pend
+        items = [(i, n) for i, n in enumerate(pend) if n]
+        if items:
+            self._add(self._sec, items)
+            for i, _ in items:
+                pend[i] = 0
+
+    def _clear(self, start: int, n: int) -> None:
+        cells, zeros = self._cells, self._zeros
+        while n > 0:
+            k = min(n, len(zeros))
+            cells[start : start + k] = zeros[:k]
+            start += k
+            n -= k
+
+    def _advance(self, level: int, bucket: int) -> None:
+        """Make ``bucket`` the newest of a level, zeroing the rows it skips over."""
+        step, rows, off = self.levels[level]
+        first = max(self._heads[level] + 1, bucket - rows + 1)
+        n = bucket - first + 1
+        width = len(self.series)
+        r = first % rows
+        head = min(n, rows - r)
+        self._clear(off // _CELL + r * width, head * width)
+        self._clear(off // _CELL, (n - head) * width)
+        self._heads[level] = bucket
+        _LEVEL.pack_into(self._map, _HDR.size + level * _LEVEL.size, step, rows, bucket)
+
+    def _add(self, s: int, items: List[Tuple[int, int]]) -> None:
+        """Add ``(series, n)`` counts at second ``s`` to every level that still holds it."""
+        cells, heads, width = self._cells, self._heads, len(self.series)
+        presence = self._presence
+        if any(presence[i] for i, _ in items):
+            # at most once per second: the 1 s level says whether it was counted
+            _, rows, off = self.levels[0]
+            row = off // _CELL + s % rows * width
+            if s <= heads[0] - rows:
+                kept = [(i, n) for i, n in items if not presence[i]]
+                self.late_dropped += len(items) - len(kept)
+            else:
+                seen = s <= heads[0]
+                kept = [(i, 1 if presence[i] else n) for i, n in items
+                        if not (presence[i] and seen and cells[row + i])]
+            items = kept
+        held = False
+        for level, (step, rows, off) in enumerate(self.levels):
+            b = s // step
+            if b > heads[level]:
+                self._advance(level, b)
+            elif b <= heads[level] - rows:
+                continue
+            row = off // _CELL + b % rows * width
+            for i, n in items:
+                cells[row + i] += n
+            held = True
+        if not held:
+            self.late_dropped += len(items)
+        if s > self._last:
+            self._last = s
+            struct.pack_into("<q", self._map, _HDR.size - 8, s)
+
+    # -- reading --
+
+    def find(self, name: str) -> List[int]:
+        """Series indexes for ``ch6``, ``ch`` (all channels), ``devices``, or an address."""
+        name = name.strip().lower()
+        if name == "ch":
+            return sorted(self._channels.values())
+        if name == "devices":
+            return sorted(self._devices.values())
+        if name.startswith("ch") and name[2:].isdigit():
+            i = self._channels.get(int(name[2:]))
+            return [] if i is None else [i]
+        i = self._devices.get(mac_parse(name))
+        return [] if i is None else [i]
+
+    def pick_level(self, start: float, step: Optional[int] = None) -> int:
+        """The level to answer a query from ``start`` with buckets of ``step`` seconds.
+
+        Of the levels whose step divides ``step`` (all of them without one),
+        those that still hold ``start``: the finest without ``step``, else
+        the coarsest. If none holds it, the one that reaches back furthest.
+        """
+        last = self.last_second
+        fits = [k for k, lv in enumerate(self.levels) if step is None or step % lv.step == 0]
+        if not fits:
+            raise ValueError(f"a step of {step} s is not a multiple of any level's step")
+
+        def oldest(k: int) -> int:
+            lv = self.levels[k]
+            return (last // lv.step - lv.rows + 1) * lv.step
+
+        holding = [k for k in fits if start >= oldest(k)]
+        if holding:
+            return holding[0] if step is None else holding[-1]
+        return min(fits, key=oldest)
+
+    def fetch(
+        self, series: int, start: float, end: float, step: Optional[int] = None, level: Optional[int] = None
+    ) -> Tuple[int, int, List[int]]:
+        """Buckets of one series over ``[start, end)``: ``(t0, step, values)``.
+
+        ``t0`` is the start of the first bucket. The range is cut to what
+        the chosen level still holds; buckets after the last update are 0.
+        With ``step``, buckets of the level are summed into ``step``-second
+        ones.
+        """
+        if level is None:
+            level = self.pick_level(start, step)
+        lstep, rows, off = self.levels[level]
+        if step is not None and step % lstep:
+            raise ValueError(f"a step of {step} s is not a multiple of the level's {lstep} s")
+        newest = self._newest(level)
+        b0 = max(int(start) // lstep, newest - rows + 1)
+        b1 = -(-int(end) // lstep)  # exclusive
+        if b1 <= b0:
+            return b0 * lstep, step or lstep, []
+        have = min(b1, newest + 1)
+        width = len(self.series)
+        base = off // _CELL + series
+        cells = self._cells
+        values: List[int] = []
+        b = b0
+        while b < have:
+            r = b % rows
+            n = min(have - b, rows - r)
+            values += cells[base + r * width : base + (r + n) * width : width].tolist()
+            b += n
+        values += [0] * (b1 - max(have, b0))
+
+        if step is None or step == lstep:
+            return b0 * lstep, lstep, values
+        k = step // lstep
+        t0 = b0 * lstep // step * step
+        lead = (b0 * lstep - t0) // lstep
+        values = [0] * lead + values
+        return t0, step, [sum(values[j : j + k]) for j in range(0, len(values), k)]
+
+    def total(self, series: int, start: float, end: float) -> int:
+        """Sum of a series over ``[start, end)`` from the coarsest level that holds it."""
+        return sum(self.fetch(series, start, end)[2])
+
+    def close(self) -> None:
+        if self._writable:
+            self.flush()
+            self._map.flush()
+        self._cells.release()
+        self._map.close()
+        self._file.close()
+
+    def __enter__(self) -> "RoundRobinStore":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+# ---- command line ----
+
+
+def parse_time(text: str, now: float) -> float:
+    """Epoch seconds, ``YYYY-MM-DD[THH:MM[:SS]]`` (UTC), or a duration before ``now``."""
+    text = text.strip()
+    m = re.fullmatch(r"(\d{4})-(\d\d)-(\d\d)(?:[T ](\d\d):(\d\d)(?::(\d\d))?)?", text)
+    if m:
+        return timegm(tuple(int(g or 0) for g in m.groups()) + (0, 0, 0))
+    try:
+        return float(text) if float(text) >= 1e9 else now - parse_duration(text)
+    except ValueError:
+        return now - parse_duration(text)
+
+
+def _stamp(t: int, step: int) -> str:
+    fmt = "%Y-%m-%d" if step % 86400 == 0 else "%Y-%m-%d %H:%M" if step % 60 == 0 else "%Y-%m-%d %H:%M:%S"
+    return time.strftime(fmt, time.gmtime(t))
+
+
+def _macs(items: Sequence[str]) -> List[int]:
+    out = []
+    for item in items:
+        if item.startswith("@"):
+            with open(item[1:]) as f:
+                out += [mac_parse(line.split("#")[0].strip()) for line in f if line.split("#")[0].strip()]
+        else:
+            out += [mac_parse(m) for m in item.split(",") if m]
+    return out
+
+
+def cmd_create(args: argparse.Namespace) -> None:
+    channels = []
+    for part in args.channels.split(","):
+        lo, _, hi = part.partition("-")
+        channels += range(int(lo), int(hi or lo) + 1)
+    store = RoundRobinStore.create(args.file, args.levels, channels, _macs(args.devices), args.spare)
+    with store:
+        print_info(store)
+
+
+def cmd_add(args: argparse.Namespace) -> None:
+    with RoundRobinStore(args.file, writable=True) as store:
+        for mac in _macs(args.devices):
+            if not store.add_device(mac):
+                print(f"{mac_str(mac)}: already tracked, or no spare slot left", file=sys.stderr)
+
+
+def cmd_ingest(args: argparse.Namespace) -> None:
+    from .pcapng import PcapngReader
+
+    with RoundRobinStore(args.file, writable=True) as store:
+        t0 = time.perf_counter()
+        n = 0
+        for path in args.captures:
+            with PcapngReader(path) as reader:
+                for f in reader.frames():
+                    store.observe(f, f.timestamp_us / 1e6)
+                    n += 1
+        elapsed = time.perf_counter() - t0
+        print(f"{n} frames in {elapsed:.1f} s ({n / max(elapsed, 1e-9) / 1e3:.0f} kframes/s), "
+              f"{store.late_dropped} too late to count")
+
+
+def print_info(store: RoundRobinStore) -> None:
+    last = store.last_second
+    tracked = sum(s.group == SERIES_DEVICE for s in store.series)
+    spare = sum(s.group == SERIES_FREE for s in store.series)
+    print(f"{store.path}: {store.size / 1e6:.1f} MB, {len(store.series)} series "
+          f"({len(store._channels)} channels, {tracked} devices, {spare} spare)")
+    print("last update: " + (_stamp(last, 1) + " UTC" if last >= 0 else "never"))
+    for lv in store.levels:
+        print(f"  {format_duration(lv.step):>4} x {lv.rows:<8} ({format_duration(lv.step * lv.rows)})")
+
+
+def cmd_info(args: argparse.Namespace) -> None:
+    with RoundRobinStore(args.file) as store:
+        print_info(store)
+        if args.series:
+            print(" ".join(str(s) for s in store.series if s.group != SERIES_FREE))
+
+
+def cmd_query(args: argparse.Namespace) -> None:
+    t_start = time.perf_counter()
+    with RoundRobinStore(args.file) as store:
+        last = store.last_second
+        now = (last + 1) if last >= 0 else time.time()
+        start = parse_time(args.since, now)
+        end = parse_time(args.until, now) if args.until else now
+        step = parse_duration(args.step) if args.step else None
+        found = [i for name in args.series for i in store.find(name)]
+        if not found:
+            sys.exit(f"no series matches {' '.join(args.series)}")
+        level = store.pick_level(start, step)
+        rows = {}
+        t0 = step_out = 0
+        for i in found:
+            t0, step_out, rows[i] = store.fetch(i, start, end, step, level)
+        elapsed = time.perf_counter() - t_start
+
+        names = [str(store.series[i]) for i in found]
+        hours = step_out >= 3600
+        if args.total:
+            for i, name in zip(found, names):
+                v = sum(rows[i])
+                what = "frames" if store.series[i].agg == AGG_COUNT else f"s present ({v / 3600:.2f} h)"
+                print(f"{name:>17}  {v:>12} {what}")
+        else:
+            width = max(12, *(len(n) for n in names))
+            print(f"{'':>19}" + "".join(f"{n:>{width + 1}}" for n in names))
+            for k in range(len(rows[found[0]])):
+                cells = []
+                for i in found:
+                    v = rows[i][k]
+                    agg = store.series[i].agg
+                    cells.append(f"{v / 3600:.2f}h" if agg == AGG_SECONDS and hours else str(v))
+                print(f"{_stamp(t0 + k * step_out, step_out):>19}" + "".join(f"{c:>{width + 1}}" for c in cells))
+        lv = store.levels[level]
+        print(f"# {format_duration(step_out)} buckets from the {format_duration(lv.step)} level, "
+              f"{len(found)} series in {elapsed * 1e3:.1f} ms", file=sys.stderr)
+
+
+def main(argv: Optional[Sequence[str]] = None) -> None:
+    ap = argparse.ArgumentParser(prog="python -m lib.py.rrd", description=__doc__.split("\n")[0])
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    cr = sub.add_parser("create", help="Create a store (replaces the file)")
+    cr.add_argument("file")
+    cr.add_argument("--levels", default=DEFAULT_LEVELS,
+                    help=f"STEP:SPAN consolidation levels, finest first (default: {DEFAULT_LEVELS})")
+    cr.add_argument("--channels", default="1-14", help="Channels to count frames for (default: 1-14)")
+    cr.add_argument("--devices", nargs="*", default=[],
+                    help="Devices to track presence of: comma-separated, or @FILE (one per line)")
+    cr.add_argument("--spare", type=int, default=0, help="Spare device slots for 'add' (default: 0)")
+
+    ad = sub.add_parser("add", help="Track more devices in spare slots")
+    ad.add_argument("file")
+    ad.add_argument("devices", nargs="+")
+
+    ig = sub.add_parser("ingest", help="Add the frames of pcapng captures, at their timestamps")
+    ig.add_argument("file")
+    ig.add_argument("captures", nargs="+")
+
+    inf = sub.add_parser("info", help="Show levels, series and last update")
+    inf.add_argument("file")
+    inf.add_argument("--series", action="store_true", help="List the series")
+
+    q = sub.add_parser("query", help="Print buckets (or totals) of series over a time range")
+    q.add_argument("file")
+    q.add_argument("series", nargs="+", help="ch6, ch (all channels), devices, or an address")
+    q.add_argument("--since", default="1h",
+                   help="Start: a duration before the last update (30d), a UTC date/time, or epoch seconds "
+                   "(default: 1h)")
+    q.add_argument("--until", help="End, in the same forms (default: the last update)")
+    q.add_argument("--step", help="Bucket size, a multiple of a level's step (default: the finest level "
+                   "that reaches back to --since)")
+    q.add_argument("--total", action="store_true", help="Print each series' sum over the range")
+
+    args = ap.parse_args(argv)
+    {"create": cmd_create, "add": cmd_add, "ingest": cmd_ingest, "info": cmd_info, "query": cmd_query}[
+        args.cmd
+    ](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
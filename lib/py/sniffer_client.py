@@ -2,13 +2,22 @@
 
 import struct
 import threading
+import time
+import zlib
+from collections import deque
 from queue import SimpleQueue
-from typing import Optional, Callable
+from typing import Callable, Dict, NamedTuple, Optional, Sequence, Tuple, Union
 
 import serial
 
 from . import cobs
 from .frame import Frame, META_SIZE
+from .ble import BleAdv, BLE_META_SIZE
+from .anomaly import Anomaly, ANOMALY_SIZE
+from .csi import CsiReport, CSI_SIZE, CSI_BITS_8, CSI_BITS_4, CSI_MAX_MATCH, encode_match
+from .classify import Detection, DETECTION_SIZE, Model
+from .trace import TraceDump, TRACE_OFF, TRACE_ON, TRACE_DUMP
+from .mac import mac_to_bytes
 
 # protocol constants (must match firmware protocol.h)
 MSG_CMD_SCAN_START = 0x01
@@ -16,12 +25,91 @@ MSG_CMD_SCAN_STOP = 0x02
 MSG_CMD_PROMISC_ON = 0x03
 MSG_CMD_PROMISC_OFF = 0x04
 MSG_CMD_PROMISC_QUERY = 0x05
+MSG_CMD_BLE_CONFIG = 0x06
+MSG_CMD_STATS_QUERY = 0x07
+MSG_CMD_DEAUTH_CONFIG = 0x08
+MSG_CMD_SET_SCHEDULE = 0x09
+MSG_CMD_BULK_BEGIN = 0x0A
+MSG_CMD_BULK_CHUNK = 0x0B
+MSG_CMD_BULK_COMMIT = 0x0C
+MSG_CMD_HOP_GUARD = 0x0D
+MSG_CMD_HOP_STATS_QUERY = 0x0E
+MSG_CMD_SYNTH = 0x0F
+MSG_CMD_PING = 0x10
+MSG_CMD_CSI_CONFIG = 0x11
+MSG_CMD_PROBE_CONFIG = 0x12
+MSG_CMD_TRACE = 0x13
 
 MSG_RSP_ACK = 0x81
 MSG_RSP_ERROR = 0x82
 MSG_RSP_PROMISC_STATUS = 0x83
+MSG_RSP_STATS = 0x84
+MSG_RSP_BULK_ACK = 0x85
+MSG_RSP_HOP_STATS = 0x86
+MSG_RSP_PONG = 0x87
 
 MSG_EVT_FRAME = 0xC0
+MSG_EVT_BLE_ADV = 0xC1
+MSG_EVT_ANOMALY = 0xC2
+MSG_EVT_LOSS = 0xC3
+MSG_EVT_CSI = 0xC4
+MSG_EVT_DETECTION = 0xC5
+MSG_EVT_TRACE = 0xC6
+
+# device-side loss reasons, in MSG_EVT_LOSS count order (must match firmware protocol.h)
+LOSS_REASON_NAMES = ("pool_empty", "queue_full", "oversize", "usb_timeout", "ble", "event")
+_LOSS_FRAME_REASONS = 3  # the first three count frames; the rest are other messages
+_LOSS_HDR = 8  # timestamp, seq_first, seq_last
+
+_RESPONSES = (
+    MSG_RSP_ACK, MSG_RSP_ERROR, MSG_RSP_PROMISC_STATUS, MSG_RSP_STATS, MSG_RSP_HOP_STATS, MSG_RSP_PONG,
+)
+
+# stats response (matches firmware proto_stats_t, 24 bytes)
+STATS_FMT = "<IIHHIII"
+STATS_FIELDS = (
+    "wifi_ms",
+    "ble_ms",
+    "wifi_permille",
+    "ble_permille",
+    "frames_sent",
+    "ble_adv_sent",
+    "ble_adv_dedup",
+)
+
+# hop stats response (matches firmware hop_stats_msg_t, 92 bytes)
+HOP_STATS_FMT = "<HBxIIIIII8I8I"
+HOP_STATS_FIELDS = (
+    "guard_us",
+    "guard_mode",
+    "switches",
+    "switch_us_total",
+    "switch_us_max",
+    "settle_frames",
+    "stale_frames",
+    "guarded",
+)
+HOP_STATS_BUCKETS = 8
+HOP_STATS_BUCKET0_US = 128  # bucket i counts values below 128 << i us; the last is open
+
+# post-switch guard modes (must match firmware hopstat.h)
+HOP_GUARD_OFF = 0  # count stale frames only
+HOP_GUARD_DROP = 1  # discard them
+HOP_GUARD_RELABEL = 2  # judge them by the previous hop's capture profile
+HOP_GUARD_MAX_US = 16384
+
+# synthetic frame source (must match firmware synth.h)
+SYNTH_DIST_FIXED = 0  # always len_min
+SYNTH_DIST_UNIFORM = 1  # uniform over len_min..len_max
+SYNTH_DIST_IMIX = 2  # len_min, midpoint, len_max at 7:4:1
+SYNTH_HDR_LEN = 24  # shortest synthetic frame
+SYNTH_MAX_RATE = 1_000_000
+PING_MAX_ECHO = 32
+
+# active probing (must match firmware probe.h)
+PROBE_MAX_SSIDS = 4
+PROBE_MAX_RATE = 200  # probes per second
+PROBE_FLAG_BROADCAST = 0x01
 
 # frame type filter bitmask (must match firmware)
 FILTER_ALL  = 0x00  # all frame types
@@ -29,6 +117,42 @@ FILTER_MGMT = 0x01  # management frames
 FILTER_CTRL = 0x02  # control frames
 FILTER_DATA = 0x04  # data frames
 
+# bulk configuration upload (must match firmware protocol.h)
+BULK_KIND_SCHEDULE = 0x01
+BULK_KIND_MAC_FILTER = 0x02
+BULK_KIND_CLASSIFIER = 0x03
+BULK_CHUNK_MAX = 256
+BULK_ACK_NONE = 0xFFFFFFFF
+BULK_WINDOW = 8  # chunks in flight; 8 * ~270 bytes fits the device's 4 KB RX ring
+
+# MAC filter modes
+MACFILT_OFF = 0
+MACFILT_ALLOW = 1  # forward only frames involving a listed address
+MACFILT_DENY = 2  # drop frames involving a listed address
+
+# hop-schedule entry (matches firmware sched_entry_msg_t, 9 bytes)
+HOP_FMT = "<BHBHHb"
+MAX_HOPS = 32
+RSSI_ANY = -128
+
+
+class Hop(NamedTuple):
+    """One hop-schedule entry and the capture profile applied while on it.
+
+    ``type_mask`` is a FILTER_* bitmask (0 = all); ``mgmt_subtypes`` has bit n
+    set to admit management subtype n (0 = all); ``snaplen`` cuts forwarded
+    frames to that many bytes (0 = whole frame); frames weaker than
+    ``rssi_min`` dBm are dropped.
+    """
+
+    channel: int
+    dwell_ms: int
+    type_mask: int = FILTER_ALL
+    mgmt_subtypes: int = 0
+    snaplen: int = 0
+    rssi_min: int = RSSI_ANY
+
+
 HDR_FMT = "<BBH"
 HDR_SIZE = struct.calcsize(HDR_FMT)  # 4
 
@@ -42,6 +166,10 @@ class SnifferError(Exception):
         0x03: "wifi failure",
         0x04: "scan active (stop scan first)",
         0x05: "invalid filter",
+        0x06: "invalid parameter",
+        0x07: "unsupported by firmware build",
+        0x08: "CRC mismatch",
+        0x09: "out of memory on device",
     }
 
     def __init__(self, cmd: int, code: int):
@@ -55,10 +183,29 @@ class SnifferClient:
     """Client for the ESP32-C6 sniffer firmware over USB serial.
 
     Args:
-        port: Serial port path (e.g. "/dev/ttyACM0" or "COM3").
+        port: Serial port path (e.g. "/dev/ttyACM0" or "COM3"), or None to
+              decode a recorded byte stream passed to ``feed()``.
         baudrate: Baud rate (default 115200, ignored for USB CDC-ACM).
         on_frame: Callback invoked for each received frame.
                   Signature: ``on_frame(frame: Frame) -> None``
+        on_ble_adv: Callback invoked for each BLE advertisement (only sent
+                  while BLE interleaving is enabled with ``ble_config``).
+                  Signature: ``on_ble_adv(adv: BleAdv) -> None``
+        on_anomaly: Callback invoked for each on-device detector report
+                  (e.g. a deauth flood, see ``deauth_config``).
+                  Signature: ``on_anomaly(anomaly: Anomaly) -> None``
+        on_csi: Callback invoked for each CSI report (only sent while CSI
+                  mode is enabled with ``csi_config``).
+                  Signature: ``on_csi(report: CsiReport) -> None``
+        on_detection: Callback invoked for each device-side classifier hit
+                  (only sent while a model is installed with ``set_classifier``).
+                  Signature: ``on_detection(det: Detection) -> None``
+        record: A ``RawRecorder`` (see ``rawlog``) handed every chunk read
+                  from the port before it is decoded. The client closes it.
+        decode: With a recorder, False skips decoding except while a
+                  command waits for its response. No callbacks run and the
+                  counters stay at zero, so recording costs about a buffer
+                  append per read.
     """
 
     TIMEOUT = 3.0  # seconds to wait for a command response
@@ -66,28 +213,57 @@ class SnifferClient:
 
     def __init__(
         self,
-        port: str,
+        port: Optional[str],
         baudrate: int = 115200,
         on_frame: Optional[Callable[["Frame"], None]] = None,
+        on_ble_adv: Optional[Callable[["BleAdv"], None]] = None,
+        on_anomaly: Optional[Callable[["Anomaly"], None]] = None,
+        on_csi: Optional[Callable[["CsiReport"], None]] = None,
+        on_detection: Optional[Callable[["Detection"], None]] = None,
+        record=None,
+        decode: bool = True,
     ):
-        self._ser = serial.Serial(port, baudrate, timeout=0.05)
+        self._ser = serial.Serial(port, baudrate, timeout=0.05) if port is not None else None
         self._on_frame = on_frame or (lambda _: None)
+        self._on_ble_adv = on_ble_adv or (lambda _: None)
+        self._on_anomaly = on_anomaly or (lambda _: None)
+        self._on_csi = on_csi or (lambda _: None)
+        self._on_detection = on_detection or (lambda _: None)
+        self._recorder = record
+        self._decode = decode or record is None
+        self._awaiting = 0  # callers waiting for a response (decoded even when not decoding), under _lock
         self.frame_count = 0
-        self.dropped = 0
+        self.ble_adv_count = 0
+        self.csi_count = 0
+        self.detection_count = 0
+        self._seq_dropped = 0  # transit losses, from seq_num gaps
+        self._loss_base = [0] * len(LOSS_REASON_NAMES)  # folded in as each scan start is acked
+        self._loss_cur = list(self._loss_base)  # cumulative counts of the current scan
+        self._loss_lock = threading.Lock()
+        self._fold_on_ack: Optional[int] = None  # command whose ACK restarts the device's counts
 
         self._buf = bytearray()
         self._seq_expect = 0
         self._first_seq = True
 
-        self._frame_q: SimpleQueue[Optional[Frame]] = SimpleQueue()
+        self._frame_q: SimpleQueue[Optional[object]] = SimpleQueue()
+
+        self._bulk_cond = threading.Condition()
+        self._bulk_acked = 0
+        self._bulk_acks = 0  # acks received, to spot duplicates
+
+        self._trace_cond = threading.Condition()
+        self._trace_dump: Optional[TraceDump] = None
+        self._spans: Optional[deque] = None  # host spans while tracing, see trace.py
 
         self._resp_event = threading.Event()
         self._resp_data: Optional[bytes] = None
         self._lock = threading.Lock()
         self._running = True
-        self._reader_thread = threading.Thread(target=self._reader, daemon=True)
-        self._dispatch_thread = threading.Thread(target=self._dispatcher, daemon=True)
-        self._reader_thread.start()
+        self._reader_thread = threading.Thread(target=self._reader, name="reader", daemon=True)
+        self._dispatch_thread = threading.Thread(target=self._dispatcher, name="dispatcher", daemon=True)
+        if self._ser is not None:
+            self._reader_thread.start()
         self._dispatch_thread.start()
 
     # ---- public API ----
@@ -102,7 +278,20 @@ class SnifferClient:
                 0 (FILTER_ALL) captures all frame types.
         """
         ch = 0 if channel is None else channel
-        self._send_cmd(MSG_CMD_SCAN_START, struct.pack("<BB", ch, frame_filter))
+        self._send_cmd(MSG_CMD_SCAN_START, struct.pack("<BB", ch, frame_filter), fold_loss=True)
+
+    @property
+    def dropped(self) -> int:
+        """Frames lost: reported by the device per reason, plus transit gaps."""
+        n = _LOSS_FRAME_REASONS
+        with self._loss_lock:
+            return self._seq_dropped + sum(self._loss_base[:n]) + sum(self._loss_cur[:n])
+
+    @property
+    def loss(self) -> Dict[str, int]:
+        """Device-side loss counts by reason (see ``LOSS_REASON_NAMES``)."""
+        with self._loss_lock:
+            return {k: b + c for k, b, c in zip(LOSS_REASON_NAMES, self._loss_base, self._loss_cur)}
 
     def stop(self) -> None:
         """Stop scanning."""
@@ -121,13 +310,347 @@ class SnifferClient:
         resp = self._send_cmd(MSG_CMD_PROMISC_QUERY)
         return resp[0] != 0 if resp else False
 
+    def ble_config(self, window_ms: int, every: int = 1, dedup_ms: int = 1000) -> None:
+        """Interleave BLE passive scan windows into the Wi-Fi hop schedule.
+
+        Args:
+            window_ms: Length of each BLE window in ms (0 disables BLE).
+            every: Insert a BLE window after every N Wi-Fi hops.
+            dedup_ms: Suppress repeats of the same address + payload on the
+                device within this window (0 forwards every advert).
+        """
+        self._send_cmd(
+            MSG_CMD_BLE_CONFIG, struct.pack("<HBH", window_ms, every, dedup_ms)
+        )
+
+    def deauth_config(
+        self,
+        threshold: int = 20,
+        window_ms: int = 1000,
+        report_ms: int = 5000,
+        suppress: bool = False,
+    ) -> None:
+        """Configure the on-device deauth/disassoc flood detector.
+
+        Args:
+            threshold: Frames per (BSSID, target) within ``window_ms`` that
+                count as a flood (0 disables the detector).
+            window_ms: Counting window.
+            report_ms: Repeat the anomaly report this often while the flood
+                continues (0 reports the onset only).
+            suppress: Drop the individual frames of an ongoing flood instead
+                of forwarding them.
+        """
+        self._send_cmd(
+            MSG_CMD_DEAUTH_CONFIG,
+            struct.pack("<HHHB", threshold, window_ms, report_ms, 1 if suppress else 0),
+        )
+
+    def set_schedule(self, hops: Sequence[Hop]) -> None:
+        """Replace the all-channel hop schedule with per-hop capture profiles.
+
+        Applies to scans started with ``channel=None`` (a running one restarts
+        on the new schedule). An empty sequence restores the default
+        schedule. At most ``MAX_HOPS`` entries.
+        """
+        if len(hops) > MAX_HOPS:
+            raise ValueError(f"at most {MAX_HOPS} hops")
+        payload = bytes([len(hops)]) + b"".join(struct.pack(HOP_FMT, *h) for h in hops)
+        self._send_cmd(MSG_CMD_SET_SCHEDULE, payload)
+
+    def hop_guard(self, guard_us: int, mode: int = HOP_GUARD_DROP) -> None:
+        """Set the guard interval after each channel switch.
+
+        Frames received within ``guard_us`` of a switch whose rx channel is
+        not the new hop's were in flight on the old channel. ``HOP_GUARD_DROP``
+        discards them, ``HOP_GUARD_RELABEL`` forwards them under the previous
+        hop's capture profile, and ``HOP_GUARD_OFF`` only counts them.
+        ``guard_us`` is at most ``HOP_GUARD_MAX_US``.
+        """
+        self._send_cmd(MSG_CMD_HOP_GUARD, struct.pack("<HB", guard_us, mode))
+
+    def hop_stats(self) -> dict:
+        """Query channel-switch timing and settle-window counts since scan start.
+
+        ``switch_hist`` bins switches by how long the radio was held and
+        ``stale_hist`` bins frames from the old channel by how long after the
+        switch they arrived; bucket ``i`` counts values below ``128 << i``
+        microseconds and the last bucket is open-ended.
+        """
+        resp = self._send_cmd(MSG_CMD_HOP_STATS_QUERY)
+        if not resp or len(resp) < struct.calcsize(HOP_STATS_FMT):
+            return {}
+        values = struct.unpack_from(HOP_STATS_FMT, resp)
+        n = len(HOP_STATS_FIELDS)
+        out = dict(zip(HOP_STATS_FIELDS, values[:n]))
+        out["switch_hist"] = list(values[n : n + HOP_STATS_BUCKETS])
+        out["stale_hist"] = list(values[n + HOP_STATS_BUCKETS :])
+        return out
+
+    def synth(
+        self,
+        rate: int,
+        len_min: int = 256,
+        len_max: Optional[int] = None,
+        dist: int = SYNTH_DIST_FIXED,
+        count: int = 0,
+    ) -> None:
+        """Generate synthetic frame events on the device, bypassing the radio.
+
+        Frames are emitted at ``rate`` per second (0 stops) with lengths
+        drawn by ``dist`` from ``len_min..len_max``, until ``count`` have
+        been offered (0 = until stopped). They arrive through ``on_frame``
+        on channel 0, with seq numbers and loss accounting like captured
+        frames. Frames the link could not take in time count as
+        ``queue_full``. Not allowed while scanning; a scan start stops it.
+        """
+        if len_max is None:
+            len_max = len_min
+        self._send_cmd(MSG_CMD_SYNTH, struct.pack("<IIHHB", rate, count, len_min, len_max, dist),
+                       fold_loss=rate != 0)
+
+    def ping(self, echo: bytes = b"") -> Tuple[float, int, int]:
+        """Round trip to the device and back through the decoder.
+
+        Returns ``(rtt_s, rx_us, tx_us)``: the host round trip time and the
+        device's 32-bit microsecond clock when it handled the ping and when
+        it sent the reply. Up to ``PING_MAX_ECHO`` bytes of ``echo`` come back.
+        """
+        t0 = time.perf_counter()
+        resp = self._send_cmd(MSG_CMD_PING, echo[:PING_MAX_ECHO])
+        rtt = time.perf_counter() - t0
+        if not resp or len(resp) < 8:
+            raise SnifferError(MSG_CMD_PING, 0xFF)
+        rx_us, tx_us = struct.unpack_from("<II", resp)
+        return rtt, rx_us, tx_us
+
+    def csi_config(
+        self,
+        enable: bool = True,
+        macs: Sequence[int] = (),
+        ouis: Sequence[int] = (),
+        bits: int = CSI_BITS_8,
+        interval_ms: int = 0,
+    ) -> None:
+        """Turn CSI reports on or off.
+
+        Reports arrive through ``on_csi`` while scanning. With ``macs``
+        and/or ``ouis`` (24-bit, see ``mac.oui``) only transmitters matching
+        one of them are reported, up to ``CSI_MAX_MATCH`` in all.
+        ``interval_ms`` forwards at most one report per transmitter per
+        interval. ``CSI_BITS_4`` halves the size of each report at the cost
+        of quantization (see ``csi``). Raises ``SnifferError`` with
+        ERR_UNSUPPORTED if the firmware was built without CSI.
+        """
+        entries = [encode_match(mac=m) for m in macs] + [encode_match(oui=o) for o in ouis]
+        if len(entries) > CSI_MAX_MATCH:
+            raise ValueError(f"at most {CSI_MAX_MATCH} addresses and OUIs")
+        payload = struct.pack("<BBHB", int(enable), bits, interval_ms, len(entries))
+        self._send_cmd(MSG_CMD_CSI_CONFIG, payload + b"".join(entries))
+
+    def probe_config(
+        self,
+        rate: int = 20,
+        ssids: Sequence[str] = (),
+        broadcast: bool = False,
+        src: Optional[int] = None,
+    ) -> None:
+        """Send probe requests at the start of every Wi-Fi dwell (``rate`` 0 = off).
+
+        Each dwell sends a directed probe per SSID in ``ssids`` (up to
+        ``PROBE_MAX_SSIDS``), plus a wildcard one if ``broadcast`` or no SSID
+        is given, so APs on the channel answer at once rather than at their
+        next beacon. ``rate`` caps probes per second (up to
+        ``PROBE_MAX_RATE``); dwells beyond it send fewer, with the SSIDs
+        taking turns. ``src`` is the transmitter address (default: the
+        radio's own). A running scan restarts.
+        """
+        names = [s.encode() if isinstance(s, str) else bytes(s) for s in ssids]
+        if len(names) > PROBE_MAX_SSIDS or any(len(n) > 32 for n in names):
+            raise ValueError(f"at most {PROBE_MAX_SSIDS} SSIDs of up to 32 bytes")
+        payload = struct.pack(
+            "<BB6sHB", int(rate > 0), PROBE_FLAG_BROADCAST if broadcast else 0,
+            mac_to_bytes(src) if src is not None else bytes(6), rate, len(names),
+        )
+        self._send_cmd(MSG_CMD_PROBE_CONFIG, payload + b"".join(bytes([len(n)]) + n for n in names))
+
+    @property
+    def backlog(self) -> int:
+        """Events decoded but not yet delivered to the callbacks."""
+        return self._frame_q.qsize()
+
+    @property
+    def rx_pending(self) -> int:
+        """Bytes received by the OS but not yet read by the decoder."""
+        return self._ser.in_waiting if self._ser is not None else 0
+
+    def set_mac_filter(self, macs: Sequence[int], mode: int = MACFILT_ALLOW) -> None:
+        """Install a device-side MAC filter (uploaded in bulk, applied atomically).
+
+        Frames are matched on addr1..addr3. ``MACFILT_ALLOW`` forwards only
+        frames involving a listed address, ``MACFILT_DENY`` drops them, and
+        ``MACFILT_OFF`` (or an empty list with it) removes the filter.
+        """
+        blob = bytes([mode, 0]) + b"".join(mac_to_bytes(m) for m in macs)
+        self.bulk_upload(BULK_KIND_MAC_FILTER, blob)
+
+    def set_classifier(self, model: Union[Model, bytes]) -> None:
+        """Install a beacon classifier on the device (uploaded in bulk).
+
+        ``model`` is a ``classify.Model`` (see ``python -m lib.py.classify
+        train``) or its exported blob. While installed, beacons and probe
+        responses are scored whatever the capture filter, and hits are
+        reported through ``on_detection``. Raises ``SnifferError`` with
+        ERR_INVALID_PARAM if the device rejects the table.
+        """
+        blob = model.to_blob() if isinstance(model, Model) else bytes(model)
+        self.bulk_upload(BULK_KIND_CLASSIFIER, blob)
+
+    def clear_classifier(self) -> None:
+        """Remove the device-side classifier."""
+        self.bulk_upload(BULK_KIND_CLASSIFIER, Model.off().to_blob())
+
+    def bulk_upload(
+        self, kind: int, blob: bytes, window: int = BULK_WINDOW, retries: int = 5
+    ) -> None:
+        """Upload a configuration blob larger than one command.
+
+        Chunks are streamed with up to ``window`` unacknowledged at a time.
+        The device acknowledges every chunk with the contiguous byte count it
+        holds; a repeated count means a chunk was lost, and the upload goes
+        back to that offset (as does a timeout). The blob is CRC-checked and
+        applied on the device only once complete.
+        """
+        self._await(1)
+        try:
+            self._bulk_upload(kind, blob, window, retries)
+        finally:
+            self._await(-1)
+
+    def _bulk_upload(self, kind: int, blob: bytes, window: int, retries: int) -> None:
+        total = len(blob)
+        self._send_cmd(MSG_CMD_BULK_BEGIN, struct.pack("<BII", kind, total, zlib.crc32(blob)))
+        with self._bulk_cond:
+            self._bulk_acked = 0
+            self._bulk_acks = 0
+
+        sent = 0
+        stalls = 0
+        dups = 0
+        while True:
+            with self._bulk_cond:
+                acked, acks = self._bulk_acked, self._bulk_acks
+            if acked == BULK_ACK_NONE:
+                raise SnifferError(MSG_CMD_BULK_CHUNK, 0x06)
+            if acked >= total:
+                break
+            while sent < total and sent - acked < window * BULK_CHUNK_MAX:
+                n = min(BULK_CHUNK_MAX, total - sent)
+                self._write(MSG_CMD_BULK_CHUNK, struct.pack("<I", sent) + blob[sent : sent + n])
+                sent += n
+            with self._bulk_cond:
+                if not self._bulk_cond.wait_for(
+                    lambda: self._bulk_acks != acks, timeout=0.1
+                ):
+                    stalls += 1
+                    if stalls > retries:
+                        raise SnifferError(MSG_CMD_BULK_CHUNK, 0xFF)
+                    sent = self._bulk_acked
+                    continue
+                stalls = 0
+                if self._bulk_acked != acked:
+                    dups = 0
+                    continue
+                # duplicate ack: the chunk after it was lost. Resend from there
+                # once, and again only if a whole window's acks show no progress
+                dups += 1
+                if dups == 1 or dups > window:
+                    sent = acked
+                    dups = 1
+
+        self._send_cmd(MSG_CMD_BULK_COMMIT)
+
+    def trace_start(self, host_spans: int = 1 << 18) -> None:
+        """Clear the device's trace ring and start recording into it.
+
+        The client records its own read, decode and dispatch spans as well,
+        keeping the last ``host_spans`` of them. See ``trace.py``.
+        """
+        self._spans = deque(maxlen=host_spans)
+        self._send_cmd(MSG_CMD_TRACE, bytes([TRACE_ON]))
+
+    def trace_stop(self) -> None:
+        """Stop recording on both sides without a dump."""
+        self._spans = None
+        self._send_cmd(MSG_CMD_TRACE, bytes([TRACE_OFF]))
+
+    def trace_dump(self, pings: int = 5, timeout: float = 5.0) -> TraceDump:
+        """Stop recording and fetch the device trace, with the host spans.
+
+        The fastest of ``pings`` round trips, taken first, places the
+        device clock on the host's. Raises ``SnifferError`` if the dump does
+        not complete within ``timeout`` seconds.
+        """
+        sync = None
+        for _ in range(pings):
+            t0 = time.perf_counter_ns()
+            _, rx_us, _ = self.ping()
+            rtt = time.perf_counter_ns() - t0
+            if sync is None or rtt < sync[0]:
+                sync = (rtt, t0 + rtt // 2, rx_us)
+
+        dump = TraceDump()
+        spans, self._spans = self._spans, None
+        with self._trace_cond:
+            self._trace_dump = dump
+        self._await(1)  # chunks decode even when only recording
+        try:
+            self._send_cmd(MSG_CMD_TRACE, bytes([TRACE_DUMP]))
+            with self._trace_cond:
+                done = self._trace_cond.wait_for(lambda: dump.complete, timeout)
+                self._trace_dump = None
+        finally:
+            self._await(-1)
+        if not done:
+            raise SnifferError(MSG_CMD_TRACE, 0xFF)
+        if sync is not None:
+            dump.sync_rtt_ns, dump.sync = sync[0], sync[1:]
+        dump.host_spans = list(spans or ())
+        return dump
+
+    def stats(self) -> dict:
+        """Query device counters and per-radio duty cycle."""
+        resp = self._send_cmd(MSG_CMD_STATS_QUERY)
+        if not resp or len(resp) < struct.calcsize(STATS_FMT):
+            return {}
+        return dict(zip(STATS_FIELDS, struct.unpack_from(STATS_FMT, resp)))
+
+    def feed(self, chunk: bytes) -> None:
+        """Decode raw bytes as read from the device.
+
+        Called by the reader thread; with ``port=None`` it decodes a recorded
+        stream instead. Callbacks still run on the dispatcher thread.
+        """
+        self._buf.extend(chunk)
+        spans = self._spans
+        if spans is None:
+            self._process()
+            return
+        t0 = time.perf_counter_ns()
+        self._process()
+        spans.append(("decode", threading.current_thread().name, t0, time.perf_counter_ns(), len(chunk)))
+
     def close(self) -> None:
         """Close the serial connection and stop background threads."""
         self._running = False
         self._frame_q.put(self._SENTINEL)
-        self._reader_thread.join(timeout=2.0)
+        if self._ser is not None:
+            self._reader_thread.join(timeout=2.0)
         self._dispatch_thread.join(timeout=2.0)
-        self._ser.close()
+        if self._ser is not None:
+            self._ser.close()
+        if self._recorder is not None:
+            self._recorder.close()
 
     def __enter__(self):
         return self
@@ -137,18 +660,49 @@ class SnifferClient:
 
     # ---- internal ----
 
-    def _send_cmd(self, msg_type: int, payload: bytes = b"") -> Optional[bytes]:
-        """Send a command and wait for the response."""
+    def _fold_loss(self) -> None:
+        """The device restarts its loss counts at every scan (or synth) start.
+
+        Reader thread, at the start's ACK: loss events sent before it carry
+        the old counts, those after it the new ones.
+        """
+        with self._loss_lock:
+            self._loss_base = [b + c for b, c in zip(self._loss_base, self._loss_cur)]
+            self._loss_cur = [0] * len(self._loss_base)
+
+    def _await(self, n: int) -> None:
+        """Count a caller waiting for a response (+1) or done waiting (-1)."""
+        with self._lock:
+            self._awaiting += n
+
+    def _write(self, msg_type: int, payload: bytes = b"") -> None:
+        """Send a message without waiting for a response."""
         raw = struct.pack(HDR_FMT, msg_type, 0, len(payload)) + payload
-        encoded = cobs.encode(raw)
         with self._lock:
-            self._resp_event.clear()
-            self._resp_data = None
-            self._ser.write(b"\x00" + encoded + b"\x00")
-            self._ser.flush()
+            self._ser.write(b"\x00" + cobs.encode(raw) + b"\x00")
+
+    def _send_cmd(self, msg_type: int, payload: bytes = b"", fold_loss: bool = False) -> Optional[bytes]:
+        """Send a command and wait for the response.
 
-        if not self._resp_event.wait(timeout=self.TIMEOUT):
-            raise SnifferError(msg_type, 0xFF)
+        With ``fold_loss``, the command restarts the device's loss counts,
+        and they are folded in when its ACK arrives.
+        """
+        raw = struct.pack(HDR_FMT, msg_type, 0, len(payload)) + payload
+        encoded = cobs.encode(raw)
+        self._await(1)
+        try:
+            with self._lock:
+                self._resp_event.clear()
+                self._resp_data = None
+                self._fold_on_ack = msg_type if fold_loss else None
+                self._ser.write(b"\x00" + encoded + b"\x00")
+                self._ser.flush()
+            if not self._resp_event.wait(timeout=self.TIMEOUT):
+                raise SnifferError(msg_type, 0xFF)
+        finally:
+            with self._lock:
+                self._awaiting -= 1
+                self._fold_on_ack = None
 
         resp = self._resp_data
         if resp is None:
@@ -166,26 +720,61 @@ class SnifferClient:
         return rpayload
 
     def _dispatcher(self) -> None:
-        """Background thread: drain the frame queue and call on_frame."""
+        """Background thread: drain the event queue and call the callbacks."""
         while True:
-            frame = self._frame_q.get()
-            if frame is self._SENTINEL:
+            item = self._frame_q.get()
+            if item is self._SENTINEL:
                 break
-            self._on_frame(frame)
+            spans = self._spans
+            t0 = time.perf_counter_ns() if spans is not None else 0
+            if type(item) is Frame:
+                self._on_frame(item)
+            elif type(item) is BleAdv:
+                self._on_ble_adv(item)
+            elif type(item) is CsiReport:
+                self._on_csi(item)
+            elif type(item) is Detection:
+                self._on_detection(item)
+            else:
+                self._on_anomaly(item)
+            if spans is not None:
+                spans.append((type(item).__name__, "dispatcher", t0, time.perf_counter_ns(), None))
 
     def _reader(self) -> None:
         """Background thread: read serial, COBS-decode, enqueue frames."""
         while self._running:
+            spans = self._spans
+            t0 = time.perf_counter_ns() if spans is not None else 0
             try:
-                chunk = self._ser.read(4096)
+                # whatever has arrived, or block for the first byte; a fixed
+                # size would hold small responses back until the read timeout
+                chunk = self._ser.read(self._ser.in_waiting or 1)
             except serial.SerialException:
                 break
             if not chunk:
                 continue
+            if spans is not None:
+                spans.append(("read", "reader", t0, time.perf_counter_ns(), len(chunk)))
+            if self._recorder is not None:
+                self._recorder.write(chunk)
+                if not self._decode:
+                    self._skim(chunk)
+                    continue
+            self.feed(chunk)
+
+    def _skim(self, chunk: bytes) -> None:
+        """Record-only mode: decode responses while a command waits, else keep message sync."""
+        if self._awaiting:
             self._buf.extend(chunk)
-            self._process()
+            self._process(events=False)
+            return
+        i = chunk.rfind(0)
+        if i < 0:
+            self._buf.extend(chunk)
+        else:
+            self._buf[:] = chunk[i + 1 :]
 
-    def _process(self) -> None:
+    def _process(self, events: bool = True) -> None:
         """Extract COBS-framed messages from the accumulation buffer."""
         while True:
             try:
@@ -210,9 +799,41 @@ class SnifferClient:
 
             msg_type = decoded[0]
 
+            if not events and msg_type >= MSG_EVT_FRAME and msg_type != MSG_EVT_TRACE:
+                continue
             if msg_type == MSG_EVT_FRAME:
                 self._handle_frame(decoded)
-            elif msg_type in (MSG_RSP_ACK, MSG_RSP_ERROR, MSG_RSP_PROMISC_STATUS):
+            elif msg_type == MSG_EVT_BLE_ADV:
+                self._handle_ble_adv(decoded)
+            elif msg_type == MSG_EVT_ANOMALY:
+                if len(decoded) >= HDR_SIZE + ANOMALY_SIZE:
+                    self._frame_q.put(Anomaly(decoded[HDR_SIZE:]))
+            elif msg_type == MSG_EVT_CSI:
+                self._handle_csi(decoded)
+            elif msg_type == MSG_EVT_DETECTION:
+                if len(decoded) >= HDR_SIZE + DETECTION_SIZE:
+                    self.detection_count += 1
+                    self._frame_q.put(Detection(decoded[HDR_SIZE:]))
+            elif msg_type == MSG_EVT_TRACE:
+                with self._trace_cond:
+                    if self._trace_dump is not None and self._trace_dump.add_chunk(decoded[HDR_SIZE:]):
+                        self._trace_cond.notify_all()
+            elif msg_type == MSG_EVT_LOSS:
+                n = min((len(decoded) - HDR_SIZE - _LOSS_HDR) // 4, len(self._loss_cur))
+                if n > 0:
+                    counts = struct.unpack_from(f"<{n}I", decoded, HDR_SIZE + _LOSS_HDR)
+                    with self._loss_lock:
+                        self._loss_cur[:n] = counts
+            elif msg_type == MSG_RSP_BULK_ACK:
+                if len(decoded) >= HDR_SIZE + 4:
+                    with self._bulk_cond:
+                        self._bulk_acked = struct.unpack_from("<I", decoded, HDR_SIZE)[0]
+                        self._bulk_acks += 1
+                        self._bulk_cond.notify_all()
+            elif msg_type in _RESPONSES:
+                if (msg_type == MSG_RSP_ACK and len(decoded) > HDR_SIZE
+                        and decoded[HDR_SIZE] == self._fold_on_ack):
+                    self._fold_loss()
                 self._resp_data = decoded
                 self._resp_event.set()
 
@@ -234,14 +855,47 @@ class SnifferClient:
         frame = Frame(meta, frame_data)
 
         # drop detection
+        seq = frame.seq_num
         if self._first_seq:
-            self._seq_expect = frame.seq_num
+            self._seq_expect = seq
             self._first_seq = False
-        elif frame.seq_num != self._seq_expect:
-            gap = (frame.seq_num - self._seq_expect) & 0xFFFF
+        elif seq != self._seq_expect:
+            gap = (seq - self._seq_expect) & 0xFFFF
             if gap < 0x8000:
-                self.dropped += gap
-        self._seq_expect = (frame.seq_num + 1) & 0xFFFF
+                self._seq_dropped += gap
+        self._seq_expect = (seq + 1) & 0xFFFF
 
         self.frame_count += 1
         self._frame_q.put(frame)
+
+    def _handle_ble_adv(self, data: bytes) -> None:
+        """Parse a BLE advertisement event and queue it for on_ble_adv."""
+        _, _, payload_len = struct.unpack_from(HDR_FMT, data)
+        payload = data[HDR_SIZE : HDR_SIZE + payload_len]
+
+        if len(payload) < BLE_META_SIZE:
+            return
+
+        data_len = payload[BLE_META_SIZE - 1]
+        adv_data = payload[BLE_META_SIZE : BLE_META_SIZE + data_len]
+        if len(adv_data) < data_len:
+            return
+
+        self.ble_adv_count += 1
+        self._frame_q.put(BleAdv(payload[:BLE_META_SIZE], adv_data))
+
+    def _handle_csi(self, data: bytes) -> None:
+        """Parse a CSI event and queue it for on_csi."""
+        _, _, payload_len = struct.unpack_from(HDR_FMT, data)
+        payload = data[HDR_SIZE : HDR_SIZE + payload_len]
+
+        if len(payload) < CSI_SIZE:
+            return
+
+        csi_len = struct.unpack_from("<H", payload, 20)[0]
+        packed_len = (csi_len + 1) // 2 if payload[15] == CSI_BITS_4 else csi_len
+        if len(payload) < CSI_SIZE + packed_len:
+            return
+
+        self.csi_count += 1
+        self._frame_q.put(CsiReport(payload[:CSI_SIZE], payload[CSI_SIZE:]))
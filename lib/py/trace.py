@@ -0,0 +1,211 @@
+"""Firmware event traces, merged with the client's own spans into a Perfetto timeline.
+
+``SnifferClient.trace_start()`` clears the device's trace ring and has every
+firmware task record what it does (see ``main/trace.h``); the client records
+its reader, decode and dispatch work alongside. ``trace_dump()`` brings both
+back as a ``TraceDump``, and ``to_chrome()`` turns that into Chrome trace
+JSON, which https://ui.perfetto.dev and chrome://tracing open as a timeline:
+
+    with SnifferClient("/dev/ttyACM0") as client:
+        client.trace_start()
+        client.scan()
+        time.sleep(2)
+        dump = client.trace_dump()
+    write_chrome(dump, "trace.json")
+
+Device times are 32-bit microseconds. The dump carries a ping's round trip,
+and the device clock is placed at the midpoint of the fastest one, so the
+two sides line up to within half that round trip.
+"""
+
+import json
+import struct
+from typing import Dict, List, Optional, Tuple
+
+# trace command actions (must match firmware trace.h)
+TRACE_OFF = 0
+TRACE_ON = 1
+TRACE_DUMP = 2
+
+# events
+EV_CB_BEGIN = 1
+EV_CB_END = 2
+EV_POOL_GET = 3
+EV_POOL_PUT = 4
+EV_Q_SEND = 5
+EV_Q_RECV = 6
+EV_USB_BEGIN = 7
+EV_USB_END = 8
+EV_HOP_BEGIN = 9
+EV_HOP_END = 10
+EV_CMD_BEGIN = 11
+EV_CMD_END = 12
+ARG_NONE = 0xFFFF
+
+CB_NAMES = {0: "promisc rx", 1: "csi rx"}
+
+# chunk header (matches firmware trace_meta_t, 12 bytes) and records (trace_rec_t)
+META_FMT = "<IIHBB"
+META_SIZE = struct.calcsize(META_FMT)  # 12
+REC_FMT = "<IBBH"
+REC_SIZE = struct.calcsize(REC_FMT)  # 8
+NAME_LEN = 16
+CTX_OTHER = 15
+F_NAMES = 0x01
+F_LAST = 0x02
+
+CMD_NAMES = {
+    0x01: "SCAN_START", 0x02: "SCAN_STOP", 0x03: "PROMISC_ON", 0x04: "PROMISC_OFF",
+    0x05: "PROMISC_QUERY", 0x06: "BLE_CONFIG", 0x07: "STATS_QUERY", 0x08: "DEAUTH_CONFIG",
+    0x09: "SET_SCHEDULE", 0x0A: "BULK_BEGIN", 0x0B: "BULK_CHUNK", 0x0C: "BULK_COMMIT",
+    0x0D: "HOP_GUARD", 0x0E: "HOP_STATS_QUERY", 0x0F: "SYNTH", 0x10: "PING",
+    0x11: "CSI_CONFIG", 0x12: "PROBE_CONFIG", 0x13: "TRACE",
+}
+
+DEVICE_PID = 1
+HOST_PID = 2
+
+# (name, thread, begin ns, end ns, arg) in time.perf_counter_ns()
+HostSpan = Tuple[str, str, int, int, Optional[int]]
+
+
+class TraceDump:
+    """A device trace as sent by the firmware, plus what is needed to place it.
+
+    ``records`` are ``(ts_us, event, context, arg)`` in the order they were
+    recorded; ``names`` label the contexts (FreeRTOS task names). ``lost``
+    counts records the ring overwrote before the dump. ``sync`` is
+    ``(host_ns, device_us)`` for one instant on both clocks, and
+    ``host_spans`` the client's spans over the same period.
+    """
+
+    def __init__(self) -> None:
+        self.now = 0
+        self.lost = 0
+        self.names: List[str] = []
+        self.records: List[Tuple[int, int, int, int]] = []
+        self.sync: Optional[Tuple[int, int]] = None
+        self.sync_rtt_ns = 0
+        self.host_spans: List[HostSpan] = []
+        self.complete = False
+        self.missing = 0  # chunks that never arrived
+        self._seq = 0
+
+    def add_chunk(self, payload: bytes) -> bool:
+        """Take one MSG_EVT_TRACE payload; True once the last chunk is in."""
+        if len(payload) < META_SIZE:
+            return False
+        now, lost, seq, count, flags = struct.unpack_from(META_FMT, payload)
+        self.missing += (seq - self._seq) & 0xFFFF
+        self._seq = (seq + 1) & 0xFFFF
+        self.now, self.lost = now, lost
+        body = payload[META_SIZE:]
+        if flags & F_NAMES:
+            for i in range(min(count, len(body) // NAME_LEN)):
+                raw = body[i * NAME_LEN : (i + 1) * NAME_LEN]
+                self.names.append(raw.split(b"\0", 1)[0].decode("ascii", "replace"))
+        else:
+            n = min(count, len(body) // REC_SIZE)
+            self.records.extend(struct.iter_unpack(REC_FMT, body[: n * REC_SIZE]))
+        self.complete = bool(flags & F_LAST)
+        return self.complete
+
+    def ctx_name(self, ctx: int) -> str:
+        if ctx < len(self.names):
+            return self.names[ctx]
+        return "other" if ctx == CTX_OTHER else f"ctx{ctx}"
+
+    def device_ns(self, ts: int) -> int:
+        """A device timestamp on the host's perf_counter_ns() clock (or the device's, unsynced)."""
+        ref_host, ref_dev = self.sync if self.sync else (self.now * 1000, self.now)
+        d = ((ts - ref_dev + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        return ref_host + d * 1000
+
+
+def _span_name(ev: int, arg: int) -> Tuple[str, dict]:
+    if ev == EV_CB_BEGIN:
+        return CB_NAMES.get(arg, f"cb {arg}"), {}
+    if ev == EV_USB_BEGIN:
+        return "usb write", {"bytes": arg}
+    if ev == EV_HOP_BEGIN:
+        return f"hop ch{arg}", {"channel": arg}
+    return CMD_NAMES.get(arg, f"cmd 0x{arg:02x}"), {"type": arg}
+
+
+_BEGIN = {EV_CB_BEGIN: EV_CB_END, EV_USB_BEGIN: EV_USB_END, EV_HOP_BEGIN: EV_HOP_END,
+          EV_CMD_BEGIN: EV_CMD_END}
+_END = {v: k for k, v in _BEGIN.items()}
+
+
+def _device_events(dump: TraceDump, base_ns: int) -> List[dict]:
+    out: List[dict] = [
+        {"ph": "M", "pid": DEVICE_PID, "name": "process_name", "args": {"name": "sniffer (device)"}},
+        {"ph": "M", "pid": DEVICE_PID, "name": "process_sort_index", "args": {"sort_index": 0}},
+    ]
+    for ctx in sorted({r[2] for r in dump.records}):
+        out.append({"ph": "M", "pid": DEVICE_PID, "tid": ctx, "name": "thread_name",
+                    "args": {"name": dump.ctx_name(ctx)}})
+
+    open_spans: Dict[Tuple[int, int], int] = {}  # (ctx, begin event) -> depth
+    for ts, ev, ctx, arg in dump.records:
+        t = (dump.device_ns(ts) - base_ns) / 1000
+        if ev in _BEGIN:
+            name, args = _span_name(ev, arg)
+            open_spans[ctx, ev] = open_spans.get((ctx, ev), 0) + 1
+            out.append({"ph": "B", "pid": DEVICE_PID, "tid": ctx, "ts": t, "name": name, "args": args})
+        elif ev in _END:
+            # the ring may have overwritten the begin: an end without one is dropped
+            key = (ctx, _END[ev])
+            if not open_spans.get(key):
+                continue
+            open_spans[key] -= 1
+            args = {"timeout": True} if ev == EV_USB_END and arg else {}
+            out.append({"ph": "E", "pid": DEVICE_PID, "tid": ctx, "ts": t, "args": args})
+        elif ev in (EV_POOL_GET, EV_POOL_PUT):
+            if arg == ARG_NONE:
+                out.append({"ph": "i", "s": "t", "pid": DEVICE_PID, "tid": ctx, "ts": t, "name": "pool empty"})
+            else:
+                out.append({"ph": "C", "pid": DEVICE_PID, "ts": t, "name": "pool free", "args": {"buffers": arg}})
+        elif ev in (EV_Q_SEND, EV_Q_RECV):
+            if arg == ARG_NONE:
+                out.append({"ph": "i", "s": "t", "pid": DEVICE_PID, "tid": ctx, "ts": t, "name": "tx queue full"})
+            else:
+                out.append({"ph": "C", "pid": DEVICE_PID, "ts": t, "name": "tx queue", "args": {"depth": arg}})
+    return out
+
+
+def _host_events(spans: List[HostSpan], base_ns: int) -> List[dict]:
+    out: List[dict] = [
+        {"ph": "M", "pid": HOST_PID, "name": "process_name", "args": {"name": "sniffer_client (host)"}},
+        {"ph": "M", "pid": HOST_PID, "name": "process_sort_index", "args": {"sort_index": 1}},
+    ]
+    tids: Dict[str, int] = {}
+    for name, thread, b, e, arg in spans:
+        tid = tids.get(thread)
+        if tid is None:
+            tid = tids[thread] = len(tids) + 1
+            out.append({"ph": "M", "pid": HOST_PID, "tid": tid, "name": "thread_name", "args": {"name": thread}})
+        ev = {"ph": "X", "pid": HOST_PID, "tid": tid, "ts": (b - base_ns) / 1000, "dur": (e - b) / 1000,
+              "name": name}
+        if arg is not None:
+            ev["args"] = {"bytes": arg}
+        out.append(ev)
+    return out
+
+
+def to_chrome(dump: TraceDump) -> dict:
+    """Chrome trace JSON (as a dict) of the device records and host spans, from t = 0."""
+    starts = [dump.device_ns(r[0]) for r in dump.records] + [s[2] for s in dump.host_spans]
+    base_ns = min(starts, default=0)
+    events = _device_events(dump, base_ns)
+    if dump.host_spans:
+        events += _host_events(dump.host_spans, base_ns)
+    meta = {"lost": dump.lost, "missing_chunks": dump.missing, "synced": dump.sync is not None}
+    if dump.sync:
+        meta["sync_rtt_us"] = dump.sync_rtt_ns / 1000
+    return {"traceEvents": events, "displayTimeUnit": "ns", "metadata": meta}
+
+
+def write_chrome(dump: TraceDump, path: str) -> None:
+    with open(path, "w") as f:
+        json.dump(to_chrome(dump), f, separators=(",", ":"))
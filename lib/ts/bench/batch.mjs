@@ -0,0 +1,117 @@
+// Throughput and GC pauses: per-frame `onFrame` objects vs `onBatch` columns.
+//
+//   npm run build && node bench/batch.mjs [frames]
+
+import { PerformanceObserver, performance } from "node:perf_hooks";
+import { SnifferClient, cobsEncode } from "../dist/index.js";
+
+const N = Number(process.argv[2] ?? 500_000);
+const CHUNK = 4096;
+const ROUNDS = 3;
+
+// ---- synthetic device stream: beacons from 64 transmitters ----
+
+function frameEvent(i) {
+  const raw = new Uint8Array(24 + 12 + 2 + 8 + 120);
+  raw[0] = 0x80; // beacon
+  raw.set([0xff, 0xff, 0xff, 0xff, 0xff, 0xff], 4);
+  raw.set([0x02, 0x00, 0x00, 0x00, 0x00, i & 0x3f], 10);
+  raw.set([0x02, 0x00, 0x00, 0x00, 0x00, i & 0x3f], 16);
+  raw[22] = (i << 4) & 0xf0;
+  raw[23] = (i >> 4) & 0xff;
+  raw.set([0, 8, 0x66, 0x6c, 0x6f, 0x63, 0x6b, 0x2d, 0x30, 0x31], 36);
+
+  const msg = new Uint8Array(4 + 16 + raw.length);
+  const v = new DataView(msg.buffer);
+  v.setUint8(0, 0xc0);
+  v.setUint16(2, 16 + raw.length, true);
+  v.setUint32(4, i * 100, true);
+  v.setUint16(8, raw.length, true);
+  v.setUint8(10, 1 + (i % 13));
+  v.setInt8(11, -40 - (i % 50));
+  v.setUint16(16, i & 0xffff, true);
+  msg.set(raw, 20);
+
+  const enc = cobsEncode(msg);
+  const out = new Uint8Array(enc.length + 1);
+  out.set(enc);
+  return out; // trailing 0x00 delimiter
+}
+
+const parts = [];
+let total = 0;
+for (let i = 0; i < N; i++) {
+  const p = frameEvent(i);
+  parts.push(p);
+  total += p.length;
+}
+const stream = new Uint8Array(total);
+let off = 0;
+for (const p of parts) {
+  stream.set(p, off);
+  off += p.length;
+}
+
+// ---- harness ----
+
+let gcCount = 0;
+let gcTotal = 0;
+let gcMax = 0;
+new PerformanceObserver((list) => {
+  for (const e of list.getEntries()) {
+    gcCount++;
+    gcTotal += e.duration;
+    gcMax = Math.max(gcMax, e.duration);
+  }
+}).observe({ entryTypes: ["gc"] });
+
+async function run(name, options, check) {
+  for (let r = 0; r < ROUNDS; r++) {
+    const client = new SnifferClient(options);
+    await new Promise((res) => setTimeout(res, 10)); // flush gc observer
+    gcCount = gcTotal = gcMax = 0;
+
+    const t0 = performance.now();
+    for (let o = 0; o < stream.length; o += CHUNK) {
+      client.feed(stream.slice(o, o + CHUNK)); // serial reads are fresh chunks
+    }
+    const ms = performance.now() - t0;
+    await new Promise((res) => setTimeout(res, 10));
+
+    check(client);
+    console.log(
+      `${name.padEnd(8)} ${(N / ms / 1000).toFixed(2).padStart(6)} Mframes/s  ` +
+        `${(stream.length / ms / 1000).toFixed(1).padStart(6)} MB/s  ` +
+        `gc: ${String(gcCount).padStart(4)} pauses, ` +
+        `${gcTotal.toFixed(1)} ms total, ${gcMax.toFixed(2)} ms max`
+    );
+  }
+}
+
+// both consumers do the same work: count frames per transmitter and channel
+let perTx = new Map();
+const touch = (addr, ch) => perTx.set(addr * 16 + ch, (perTx.get(addr * 16 + ch) ?? 0) + 1);
+
+console.log(`${N} frames, ${(stream.length / 1e6).toFixed(1)} MB stream\n`);
+
+await run(
+  "onFrame",
+  {
+    onFrame(f) {
+      const a = f.addr2;
+      touch(a[4] * 256 + a[5], f.channel);
+    },
+  },
+  (c) => console.assert(c.frameCount === N && c.dropped === 0)
+);
+
+perTx = new Map();
+await run(
+  "onBatch",
+  {
+    onBatch(b) {
+      for (let i = 0; i < b.count; i++) touch(b.addr(i, 2), b.channel[i]);
+    },
+  },
+  (c) => console.assert(c.frameCount === N && c.dropped === 0)
+);
@@ -0,0 +1,103 @@
+// FlowTable throughput and query latency at millions of flows.
+//
+//   npm run build && node bench/flows.mjs [flows] [frames]
+//
+// `flows` is the size of the key space frames are drawn from (default 1M).
+// Data frames are pushed into 4096-frame batches (untimed) and accounted
+// with `addBatch` (timed). Half the frames come from a hot 1% of the flows,
+// the rest are spread over all of them, across stations on 256 BSSIDs.
+// Each batch stands for 10 ms of capture, so history spans several buckets.
+
+import { performance } from "node:perf_hooks";
+import { FlowTable, FrameBatch } from "../dist/index.js";
+
+const FLOWS = Number(process.argv[2] ?? 1_000_000);
+const FRAMES = Number(process.argv[3] ?? 4 * FLOWS);
+const BATCH = 4096;
+const BATCH_MS = 10;
+const HDR = 24 + 8; // data header + LLC/SNAP, cut as by a snaplen
+const ON_AIR = 1500;
+
+// one frame event (16-byte metadata + raw frame) rewritten per frame
+const src = new Uint8Array(16 + HDR);
+const meta = new DataView(src.buffer);
+meta.setUint16(4, HDR, true);
+meta.setUint16(14, ON_AIR, true);
+src[16] = 0x08; // data
+
+let rnd = 0x2545f491;
+function next() {
+  rnd ^= rnd << 13;
+  rnd ^= rnd >>> 17;
+  rnd ^= rnd << 5;
+  return rnd >>> 0;
+}
+
+function putMac(off, hi, lo) {
+  src[off] = 0x02;
+  src[off + 1] = hi;
+  src[off + 2] = lo >>> 24;
+  src[off + 3] = lo >>> 16;
+  src[off + 4] = lo >>> 8;
+  src[off + 5] = lo;
+}
+
+function fill(batch) {
+  batch.clear();
+  for (let i = 0; i < BATCH; i++) {
+    const r = next();
+    const flow = r & 1 ? r % Math.max(1, (FLOWS / 100) | 0) : next() % FLOWS;
+    const dir = 1 + (flow & 1); // to / from the AP
+    const bssid = flow & 0xff;
+    const sta = flow >>> 1;
+    src[17] = dir | (next() % 10 === 0 ? 0x08 : 0); // ToDS / FromDS, 10% retries
+    // ToDS: addr1 = BSSID, addr2 = SA, addr3 = DA; FromDS: addr1 = DA, addr2 = BSSID, addr3 = SA
+    putMac(16 + 4, dir === 1 ? 0 : 1, dir === 1 ? bssid : sta);
+    putMac(16 + 10, dir === 1 ? 1 : 0, dir === 1 ? sta : bssid);
+    putMac(16 + 16, 2, sta ^ 0x5a5a);
+    batch.push(src, 0, HDR);
+  }
+}
+
+const table = new FlowTable({ bucketMs: 1000, historyBuckets: 300 });
+const batch = new FrameBatch(BATCH);
+let addMs = 0;
+let now = 0;
+for (let done = 0; done < FRAMES; done += BATCH) {
+  fill(batch);
+  const t0 = performance.now();
+  table.addBatch(batch, now);
+  addMs += performance.now() - t0;
+  now += BATCH_MS;
+}
+
+const frames = Math.ceil(FRAMES / BATCH) * BATCH;
+console.log(
+  `${frames} frames into ${table.size} flows: ` +
+    `${(frames / addMs / 1000).toFixed(2)} Mframes/s (${addMs.toFixed(0)} ms)`
+);
+
+function time(name, fn, rounds = 5) {
+  let best = Infinity;
+  let out;
+  for (let r = 0; r < rounds; r++) {
+    const t0 = performance.now();
+    out = fn();
+    best = Math.min(best, performance.now() - t0);
+  }
+  console.log(`${name.padEnd(28)} ${best.toFixed(2).padStart(8)} ms`);
+  return out;
+}
+
+const top = time("topK(100) by bytes", () => table.topK(100));
+time("topK(100) by frames", () => table.topK(100, { by: "frames" }));
+time("topK(100) last 5 s", () => table.topK(100, { sinceMs: now - 5000 }));
+time("totals() last 5 s", () => table.totals(now - 5000));
+
+const f = top[0];
+console.assert(table.lookup(f.bssid, f.src, f.dst, f.direction) === f.id);
+console.log(
+  `top flow: ${f.frames} frames, ${f.bytes} bytes, retry ${(f.retryRate * 100).toFixed(1)}%\n` +
+    `heap: ${(process.memoryUsage().heapUsed / 1e6).toFixed(0)} MB, ` +
+    `array buffers: ${(process.memoryUsage().arrayBuffers / 1e6).toFixed(0)} MB`
+);
@@ -0,0 +1,74 @@
+// Decode a recorded device byte stream and time it (harness for bench/wire).
+//
+//   npm run build && node bench/wire.mjs STREAM [chunk] [repeat]
+//
+// The timed pass is the real client path: `SnifferClient.feed()` in chunks
+// with per-frame callbacks. A separate untimed pass splits and decodes with
+// `cobsDecode` for the message count and digest. Prints one JSON line (see
+// bench/wire/corpus.py).
+
+import { readFileSync } from "node:fs";
+import { performance } from "node:perf_hooks";
+import { SnifferClient, cobsDecode, crc32 } from "../dist/index.js";
+
+const HDR_SIZE = 4;
+
+const [path, chunkArg, repeatArg] = process.argv.slice(2);
+const CHUNK = Number(chunkArg ?? 4096);
+const REPEAT = Number(repeatArg ?? 3);
+
+const buf = readFileSync(path);
+const stream = new Uint8Array(buf.buffer, buf.byteOffset, buf.length);
+
+function digest() {
+  let n = 0;
+  let crc = 0;
+  const len = new Uint8Array(4);
+  let start = 0;
+  while (start < stream.length) {
+    let idx = stream.indexOf(0, start);
+    if (idx === -1) idx = stream.length;
+    if (idx > start) {
+      let msg = null;
+      try {
+        msg = cobsDecode(stream.subarray(start, idx));
+      } catch {
+        // malformed: dropped, as by the client
+      }
+      if (msg !== null && msg.length >= HDR_SIZE) {
+        n++;
+        new DataView(len.buffer).setUint32(0, msg.length, true);
+        crc = crc32(msg, crc32(len, crc));
+      }
+    }
+    start = idx + 1;
+  }
+  return [n, crc.toString(16).padStart(8, "0")];
+}
+
+let best = Infinity;
+let client;
+let anomalies = 0;
+for (let r = 0; r < REPEAT; r++) {
+  anomalies = 0;
+  client = new SnifferClient({ onFrame() {}, onBleAdv() {}, onAnomaly: () => anomalies++ });
+  const t0 = performance.now();
+  for (let o = 0; o < stream.length; o += CHUNK) {
+    client.feed(stream.slice(o, o + CHUNK)); // serial reads are fresh chunks
+  }
+  best = Math.min(best, performance.now() - t0);
+}
+
+const [messages, crc] = digest();
+console.log(
+  JSON.stringify({
+    impl: "ts",
+    messages,
+    digest: crc,
+    frames: client.frameCount,
+    ble_adv: client.bleAdvCount,
+    anomalies,
+    dropped: client.dropped,
+    seconds: best / 1000,
+  })
+);
@@ -1,291 +0,0 @@
-/** Web Serial client for the ESP32-C6 WiFi sniffer firmware. */
-import { encode, decode } from "./cobs.js";
-import { Frame, META_SIZE } from "./frame.js";
-// protocol constants (must match firmware protocol.h)
-const MSG_CMD_SCAN_START = 0x01;
-const MSG_CMD_SCAN_STOP = 0x02;
-const MSG_CMD_PROMISC_ON = 0x03;
-const MSG_CMD_PROMISC_OFF = 0x04;
-const MSG_CMD_PROMISC_QUERY = 0x05;
-const MSG_RSP_ACK = 0x81;
-const MSG_RSP_ERROR = 0x82;
-const MSG_RSP_PROMISC_STATUS = 0x83;
-const MSG_EVT_FRAME = 0xc0;
-const HDR_SIZE = 4; // <BBH: msg_type(1) + flags(1) + payload_len(2)
-// frame type filter bitmask (must match firmware)
-export const FILTER_ALL = 0x00; // all frame types
-export const FILTER_MGMT = 0x01; // management frames
-export const FILTER_CTRL = 0x02; // control frames
-export const FILTER_DATA = 0x04; // data frames
-const ERROR_NAMES = {
-    0x01: "unknown command",
-    0x02: "invalid channel",
-    0x03: "wifi failure",
-    0x04: "scan active (stop scan first)",
-    0x05: "invalid filter",
-};
-export class SnifferError extends Error {
-    cmd;
-    code;
-    constructor(cmd, code) {
-        const name = ERROR_NAMES[code] ?? `0x${code.toString(16).padStart(2, "0")}`;
-        super(`command 0x${cmd.toString(16).padStart(2, "0")} failed: ${name}`);
-        this.cmd = cmd;
-        this.code = code;
-    }
-}
-export class SnifferClient {
-    static TIMEOUT = 3000; // ms
-    frameCount = 0;
-    dropped = 0;
-    _port = null;
-    _reader = null;
-    _writer = null;
-    _running = false;
-    _buf = new Uint8Array(0);
-    _seqExpect = 0;
-    _firstSeq = true;
-    _onFrame;
-    _onDisconnect;
-    _baudRate;
-    _filters;
-    // command response signaling
-    _respResolve = null;
-    constructor(options = {}) {
-        this._onFrame = options.onFrame ?? (() => { });
-        this._onDisconnect = options.onDisconnect ?? (() => { });
-        this._baudRate = options.baudRate ?? 115200;
-        this._filters = options.filters ?? [];
-    }
-    /** Whether the client is currently connected to a serial port. */
-    get connected() {
-        return this._running && this._port !== null;
-    }
-    /**
-     * Request a serial port from the user and open it.
-     * Must be called from a user gesture (click, keypress, etc.).
-     */
-    async connect(existingPort) {
-        if (this._running)
-            throw new Error("already connected");
-        const port = existingPort ??
-            (await navigator.serial.requestPort(this._filters.length > 0 ? { filters: this._filters } : undefined));
-        await port.open({ baudRate: this._baudRate });
-        this._port = port;
-        this._running = true;
-        this._buf = new Uint8Array(0);
-        this._firstSeq = true;
-        this._seqExpect = 0;
-        this.frameCount = 0;
-        this.dropped = 0;
-        this._readLoop();
-    }
-    async scan(channel = 0, frameFilter = 0) {
-        await this._sendCmd(MSG_CMD_SCAN_START, new Uint8Array([channel, frameFilter]));
-    }
-    async stop() {
-        await this._sendCmd(MSG_CMD_SCAN_STOP);
-    }
-    async promiscOn() {
-        await this._sendCmd(MSG_CMD_PROMISC_ON);
-    }
-    async promiscOff() {
-        await this._sendCmd(MSG_CMD_PROMISC_OFF);
-    }
-    async promiscStatus() {
-        const resp = await this._sendCmd(MSG_CMD_PROMISC_QUERY);
-        return resp !== null && resp.length > 0 && resp[0] !== 0;
-    }
-    async disconnect() {
-        this._running = false;
-        // reject any pending command
-        if (this._respResolve) {
-            this._respResolve(null);
-            this._respResolve = null;
-        }
-        try {
-            if (this._reader) {
-                await this._reader.cancel();
-                this._reader.releaseLock();
-                this._reader = null;
-            }
-        }
-        catch {
-            // ignore
-        }
-        try {
-            if (this._writer) {
-                this._writer.releaseLock();
-                this._writer = null;
-            }
-        }
-        catch {
-            // ignore
-        }
-        try {
-            if (this._port) {
-                await this._port.close();
-                this._port = null;
-            }
-        }
-        catch {
-            // ignore
-        }
-    }
-    async _sendCmd(msgType, payload = new Uint8Array(0)) {
-        if (!this._port?.writable)
-            throw new Error("not connected");
-        // build header: <BBH (little-endian)
-        const hdr = new Uint8Array(HDR_SIZE);
-        const hdrView = new DataView(hdr.buffer);
-        hdrView.setUint8(0, msgType);
-        hdrView.setUint8(1, 0); // flags
-        hdrView.setUint16(2, payload.length, true);
-        const raw = new Uint8Array(HDR_SIZE + payload.length);
-        raw.set(hdr);
-        raw.set(payload, HDR_SIZE);
-        const encoded = encode(raw);
-        const packet = new Uint8Array(encoded.length + 2);
-        packet[0] = 0x00;
-        packet.set(encoded, 1);
-        packet[packet.length - 1] = 0x00;
-        // set up response promise before writing
-        const respPromise = new Promise((resolve) => {
-            this._respResolve = resolve;
-        });
-        // write
-        if (!this._writer && this._port.writable) {
-            this._writer = this._port.writable.getWriter();
-        }
-        await this._writer.write(packet);
-        // wait for response or timeout
-        let timer;
-        const resp = await Promise.race([
-            respPromise,
-            new Promise((_, reject) => {
-                timer = setTimeout(() => reject(new SnifferError(msgType, 0xff)), SnifferClient.TIMEOUT);
-            }),
-        ]).finally(() => {
-            clearTimeout(timer);
-            this._respResolve = null;
-        });
-        if (resp === null)
-            return null;
-        // parse response header
-        if (resp.length < HDR_SIZE)
-            return null;
-        const rv = new DataView(resp.buffer, resp.byteOffset, resp.byteLength);
-        const rtype = rv.getUint8(0);
-        const rplen = rv.getUint16(2, true);
-        const rpayload = resp.slice(HDR_SIZE, HDR_SIZE + rplen);
-        if (rtype === MSG_RSP_ERROR && rpayload.length >= 2) {
-            throw new SnifferError(rpayload[0], rpayload[1]);
-        }
-        return rpayload;
-    }
-    async _readLoop() {
-        const port = this._port;
-        if (!port?.readable)
-            return;
-        while (this._running && port.readable) {
-            this._reader = port.readable.getReader();
-            try {
-                while (this._running) {
-                    const { value, done } = await this._reader.read();
-                    if (done)
-                        break;
-                    if (value) {
-                        this._appendBuf(value);
-                        this._process();
-                    }
-                }
-            }
-            catch {
-                // serial error — will retry if port still readable
-            }
-            finally {
-                try {
-                    this._reader.releaseLock();
-                }
-                catch {
-                    // ignore
-                }
-                this._reader = null;
-            }
-        }
-        if (this._running) {
-            // disconnected unexpectedly
-            this._running = false;
-            this._onDisconnect();
-        }
-    }
-    _appendBuf(chunk) {
-        const combined = new Uint8Array(this._buf.length + chunk.length);
-        combined.set(this._buf);
-        combined.set(chunk, this._buf.length);
-        this._buf = combined;
-    }
-    _process() {
-        while (true) {
-            const idx = this._buf.indexOf(0x00);
-            if (idx === -1)
-                break;
-            if (idx === 0) {
-                this._buf = this._buf.slice(1);
-                continue;
-            }
-            const encodedSlice = this._buf.slice(0, idx);
-            this._buf = this._buf.slice(idx + 1);
-            let decoded;
-            try {
-                decoded = decode(encodedSlice);
-            }
-            catch {
-                continue;
-            }
-            if (decoded.length < HDR_SIZE)
-                continue;
-            const msgType = decoded[0];
-            if (msgType === MSG_EVT_FRAME) {
-                this._handleFrame(decoded);
-            }
-            else if (msgType === MSG_RSP_ACK ||
-                msgType === MSG_RSP_ERROR ||
-                msgType === MSG_RSP_PROMISC_STATUS) {
-                if (this._respResolve) {
-                    this._respResolve(decoded);
-                    this._respResolve = null;
-                }
-            }
-        }
-    }
-    _handleFrame(data) {
-        if (data.length < HDR_SIZE)
-            return;
-        const v = new DataView(data.buffer, data.byteOffset, data.byteLength);
-        const payloadLen = v.getUint16(2, true);
-        const payload = data.slice(HDR_SIZE, HDR_SIZE + payloadLen);
-        if (payload.length < META_SIZE)
-            return;
-        const meta = payload.slice(0, META_SIZE);
-        const frameLen = new DataView(meta.buffer, meta.byteOffset, meta.byteLength).getUint16(4, true);
-        const frameData = payload.slice(META_SIZE, META_SIZE + frameLen);
-        if (frameData.length < frameLen)
-            return;
-        const frame = new Frame(meta, frameData);
-        // drop detection
-        if (this._firstSeq) {
-            this._seqExpect = frame.seqNum;
-            this._firstSeq = false;
-        }
-        else if (frame.seqNum !== this._seqExpect) {
-            const gap = (frame.seqNum - this._seqExpect) & 0xffff;
-            if (gap < 0x8000)
-                this.dropped += gap;
-        }
-        this._seqExpect = (frame.seqNum + 1) & 0xffff;
-        this.frameCount++;
-        this._onFrame(frame);
-    }
-}
-//# sourceMappingURL=client.js.map
\ No newline at end of file
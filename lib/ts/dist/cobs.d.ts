@@ -1,4 +0,0 @@
-/** COBS (Consistent Overhead Byte Stuffing) encoder/decoder. */
-export declare function encode(data: Uint8Array): Uint8Array;
-export declare function decode(data: Uint8Array): Uint8Array;
-//# sourceMappingURL=cobs.d.ts.map
\ No newline at end of file
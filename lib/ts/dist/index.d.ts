@@ -1,6 +0,0 @@
-export { SnifferClient, SnifferError, FILTER_ALL, FILTER_MGMT, FILTER_CTRL, FILTER_DATA, } from "./client.js";
-export type { SnifferClientOptions } from "./client.js";
-export { Frame, META_SIZE } from "./frame.js";
-export { FRAME_TYPE_MGMT, FRAME_TYPE_CTRL, FRAME_TYPE_DATA, SUBTYPE_ASSOC_REQ, SUBTYPE_ASSOC_RESP, SUBTYPE_PROBE_REQ, SUBTYPE_PROBE_RESP, SUBTYPE_BEACON, SUBTYPE_DEAUTH, } from "./frame.js";
-export { encode as cobsEncode, decode as cobsDecode } from "./cobs.js";
-//# sourceMappingURL=index.d.ts.map
\ No newline at end of file
@@ -0,0 +1,94 @@
+/** Anomaly event raised by the firmware's on-device detectors. */
+
+import { macStr } from "./mac.js";
+
+// event struct: <IBB6s6sBbHBxIIII8H  (56 bytes)
+export const ANOMALY_SIZE = 56;
+
+export const ANOMALY_DEAUTH_FLOOD = 0x01;
+const ANOMALY_FLAG_ONSET = 0x01;
+
+const KindName: Record<number, string> = {
+  [ANOMALY_DEAUTH_FLOOD]: "deauth-flood",
+};
+
+// common 802.11 reason codes seen in deauth/disassoc frames
+export const REASON_NAMES: Record<number, string> = {
+  1: "unspecified",
+  2: "prev-auth-invalid",
+  3: "leaving",
+  4: "inactivity",
+  5: "ap-full",
+  6: "class2-from-nonauth",
+  7: "class3-from-nonassoc",
+  8: "leaving-bss",
+  15: "4way-timeout",
+};
+
+function macBe(v: DataView, off: number): number {
+  return v.getUint16(off) * 0x100000000 + v.getUint32(off + 2);
+}
+
+/**
+ * A detector report. Counts cover the flood since its onset; `onset` is true
+ * on the first report, later ones are periodic updates while it continues.
+ */
+export class Anomaly {
+  readonly timestampUs: number;
+  readonly kind: number;
+  readonly flags: number;
+  /** 48-bit addresses (see mac.ts); target is broadcast for untargeted floods. */
+  readonly bssid: number;
+  readonly target: number;
+  readonly channel: number;
+  readonly rssi: number;
+  readonly windowCount: number;
+  readonly durationMs: number;
+  readonly deauthCount: number;
+  readonly disassocCount: number;
+  readonly suppressed: number;
+  /** [reason code, count] pairs. */
+  readonly reasons: [number, number][];
+
+  constructor(payload: Uint8Array) {
+    const v = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+    this.timestampUs = v.getUint32(0, true);
+    this.kind = v.getUint8(4);
+    this.flags = v.getUint8(5);
+    this.bssid = macBe(v, 6);
+    this.target = macBe(v, 12);
+    this.channel = v.getUint8(18);
+    this.rssi = v.getInt8(19);
+    this.windowCount = v.getUint16(20, true);
+    const numReasons = Math.min(v.getUint8(22), 4);
+    this.durationMs = v.getUint32(24, true);
+    this.deauthCount = v.getUint32(28, true);
+    this.disassocCount = v.getUint32(32, true);
+    this.suppressed = v.getUint32(36, true);
+    this.reasons = [];
+    for (let i = 0; i < numReasons; i++) {
+      this.reasons.push([v.getUint16(40 + i * 4, true), v.getUint16(42 + i * 4, true)]);
+    }
+  }
+
+  get onset(): boolean {
+    return (this.flags & ANOMALY_FLAG_ONSET) !== 0;
+  }
+
+  get kindName(): string {
+    return KindName[this.kind] ?? `0x${this.kind.toString(16).padStart(2, "0")}`;
+  }
+
+  toString(): string {
+    const reasons = this.reasons
+      .map(([code, count]) => `${REASON_NAMES[code] ?? code}:${count}`)
+      .join(",");
+    return (
+      `Anomaly(${this.kindName}${this.onset ? " onset" : ""}, ` +
+      `bssid=${macStr(this.bssid)}, target=${macStr(this.target)}, ` +
+      `ch=${this.channel}, rssi=${this.rssi}, deauth=${this.deauthCount}, ` +
+      `disassoc=${this.disassocCount}, suppressed=${this.suppressed}, ` +
+      `${this.durationMs}ms, reasons=${reasons})`
+    );
+  }
+}
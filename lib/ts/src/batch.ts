@@ -0,0 +1,182 @@
+/** Struct-of-arrays batch of frames decoded from one serial read. */
+
+import { Frame, META_SIZE } from "./frame.js";
+
+const INITIAL_CAPACITY = 256;
+const INITIAL_PAYLOAD = 64 * 1024;
+
+/** u32 words per frame in `macs`: [a1Hi, a1Lo, a2Hi, a2Lo, a3Hi, a3Lo]. */
+export const MAC_STRIDE = 6;
+
+/**
+ * Frames as typed-array columns over one shared payload buffer.
+ *
+ * A batch delivered to `onBatch` is reused for the next read: it is only
+ * valid for the duration of the callback. Use `clone()` to keep it.
+ *
+ * MACs are split into a 16-bit high part and a 32-bit low part so they fit
+ * in a Uint32Array; `addr()` recombines them and returns -1 when the frame
+ * is too short to carry that address.
+ */
+export class FrameBatch {
+  count = 0;
+
+  timestampUs: Uint32Array;
+  channel: Uint8Array;
+  rssi: Int8Array;
+  seqNum: Uint16Array;
+  /** 802.11 frame control field (0 if the frame is shorter than 2 bytes). */
+  frameControl: Uint16Array;
+  macs: Uint32Array;
+  /** Raw 16-byte metadata records, `count * META_SIZE` bytes. */
+  meta: Uint8Array;
+  /** Raw 802.11 bytes of all frames back to back. */
+  payload: Uint8Array;
+  /** Frame i occupies `payload[offsets[i] .. offsets[i + 1])`. */
+  offsets: Uint32Array;
+
+  constructor(capacity: number = INITIAL_CAPACITY) {
+    this.timestampUs = new Uint32Array(capacity);
+    this.channel = new Uint8Array(capacity);
+    this.rssi = new Int8Array(capacity);
+    this.seqNum = new Uint16Array(capacity);
+    this.frameControl = new Uint16Array(capacity);
+    this.macs = new Uint32Array(capacity * MAC_STRIDE);
+    this.meta = new Uint8Array(capacity * META_SIZE);
+    this.payload = new Uint8Array(INITIAL_PAYLOAD);
+    this.offsets = new Uint32Array(capacity + 1);
+  }
+
+  get capacity(): number {
+    return this.timestampUs.length;
+  }
+
+  /** Empty the batch, keeping its storage. */
+  clear(): void {
+    this.count = 0;
+  }
+
+  frameType(i: number): number {
+    return (this.frameControl[i] >> 2) & 0x03;
+  }
+
+  frameSubtype(i: number): number {
+    return (this.frameControl[i] >> 4) & 0x0f;
+  }
+
+  /** Raw 802.11 bytes of frame i (a view, not a copy). */
+  raw(i: number): Uint8Array {
+    return this.payload.subarray(this.offsets[i], this.offsets[i + 1]);
+  }
+
+  /** addr1..addr3 of frame i as a 48-bit number (see mac.ts), or -1 if absent. */
+  addr(i: number, which: 1 | 2 | 3): number {
+    const len = this.offsets[i + 1] - this.offsets[i];
+    if (len < 4 + which * 6) return -1;
+    const k = i * MAC_STRIDE + (which - 1) * 2;
+    return this.macs[k] * 0x100000000 + this.macs[k + 1];
+  }
+
+  /** Frame i as a full `Frame` object (views into this batch's buffers). */
+  frame(i: number): Frame {
+    return new Frame(
+      this.meta.subarray(i * META_SIZE, (i + 1) * META_SIZE),
+      this.raw(i)
+    );
+  }
+
+  *frames(): Generator<Frame> {
+    for (let i = 0; i < this.count; i++) yield this.frame(i);
+  }
+
+  /** Copy of the used part of this batch that outlives the callback. */
+  clone(): FrameBatch {
+    const b = new FrameBatch(Math.max(this.count, 1));
+    b.count = this.count;
+    b.timestampUs.set(this.timestampUs.subarray(0, this.count));
+    b.channel.set(this.channel.subarray(0, this.count));
+    b.rssi.set(this.rssi.subarray(0, this.count));
+    b.seqNum.set(this.seqNum.subarray(0, this.count));
+    b.frameControl.set(this.frameControl.subarray(0, this.count));
+    b.macs.set(this.macs.subarray(0, this.count * MAC_STRIDE));
+    b.meta.set(this.meta.subarray(0, this.count * META_SIZE));
+    b.offsets.set(this.offsets.subarray(0, this.count + 1));
+    b.payload = this.payload.slice(0, this.offsets[this.count]);
+    return b;
+  }
+
+  /**
+   * Append one frame event. `meta` is the 16-byte metadata at `metaOff`
+   * in `src`, and the raw frame follows it.
+   */
+  push(src: Uint8Array, metaOff: number, frameLen: number): void {
+    const i = this.count;
+    if (i === this.capacity) this._grow(i * 2);
+
+    const start = this.offsets[i];
+    const end = start + frameLen;
+    if (end > this.payload.length) {
+      let size = this.payload.length * 2;
+      while (size < end) size *= 2;
+      const p = new Uint8Array(size);
+      p.set(this.payload.subarray(0, start));
+      this.payload = p;
+    }
+
+    this.meta.set(src.subarray(metaOff, metaOff + META_SIZE), i * META_SIZE);
+    const rawOff = metaOff + META_SIZE;
+    this.payload.set(src.subarray(rawOff, rawOff + frameLen), start);
+    this.offsets[i + 1] = end;
+
+    this.timestampUs[i] =
+      (src[metaOff] |
+        (src[metaOff + 1] << 8) |
+        (src[metaOff + 2] << 16) |
+        (src[metaOff + 3] << 24)) >>>
+      0;
+    this.channel[i] = src[metaOff + 6];
+    this.rssi[i] = (src[metaOff + 7] << 24) >> 24;
+    this.seqNum[i] = src[metaOff + 12] | (src[metaOff + 13] << 8);
+    this.frameControl[i] =
+      frameLen >= 2 ? src[rawOff] | (src[rawOff + 1] << 8) : 0;
+
+    // addr1/2/3 at raw offsets 4, 10, 16 (big-endian within each MAC)
+    const k = i * MAC_STRIDE;
+    for (let a = 0; a < 3; a++) {
+      const o = rawOff + 4 + a * 6;
+      if (frameLen >= 10 + a * 6) {
+        this.macs[k + a * 2] = (src[o] << 8) | src[o + 1];
+        this.macs[k + a * 2 + 1] =
+          ((src[o + 2] << 24) |
+            (src[o + 3] << 16) |
+            (src[o + 4] << 8) |
+            src[o + 5]) >>>
+          0;
+      } else {
+        this.macs[k + a * 2] = 0;
+        this.macs[k + a * 2 + 1] = 0;
+      }
+    }
+
+    this.count = i + 1;
+  }
+
+  private _grow(capacity: number): void {
+    const grow = <T extends Uint8Array | Int8Array | Uint16Array | Uint32Array>(
+      a: T,
+      n: number
+    ): T => {
+      const b = new (a.constructor as { new (n: number): T })(n);
+      b.set(a);
+      return b;
+    };
+    this.timestampUs = grow(this.timestampUs, capacity);
+    this.channel = grow(this.channel, capacity);
+    this.rssi = grow(this.rssi, capacity);
+    this.seqNum = grow(this.seqNum, capacity);
+    this.frameControl = grow(this.frameControl, capacity);
+    this.macs = grow(this.macs, capacity * MAC_STRIDE);
+    this.meta = grow(this.meta, capacity * META_SIZE);
+    this.offsets = grow(this.offsets, capacity + 1);
+  }
+}
@@ -0,0 +1,90 @@
+/** BLE advertisement event forwarded by the sniffer's interleaved BLE scan. */
+
+import { macStr } from "./mac.js";
+
+// metadata struct: <I6sBbBB  (14 bytes)
+//   u32 timestamp_us, u8[6] addr (little-endian), u8 addr_type, i8 rssi,
+//   u8 adv_type, u8 data_len
+export const BLE_META_SIZE = 14;
+
+// advertising PDU types as reported by the BLE host
+const AdvTypeName: Record<number, string> = {
+  0: "ADV_IND",
+  1: "ADV_DIRECT_IND",
+  2: "ADV_SCAN_IND",
+  3: "ADV_NONCONN_IND",
+  4: "SCAN_RSP",
+};
+
+// AD structure types
+const AD_TYPE_NAME_SHORT = 0x08;
+const AD_TYPE_NAME_COMPLETE = 0x09;
+const AD_TYPE_MANUFACTURER = 0xff;
+
+export class BleAdv {
+  readonly timestampUs: number;
+  /** Advertiser address as a 48-bit number (see mac.ts). */
+  readonly addr: number;
+  readonly addrType: number;
+  readonly rssi: number;
+  readonly advType: number;
+  readonly data: Uint8Array;
+
+  constructor(meta: Uint8Array, data: Uint8Array) {
+    const v = new DataView(meta.buffer, meta.byteOffset, meta.byteLength);
+    this.timestampUs = v.getUint32(0, true);
+    // NimBLE reports addresses little-endian
+    this.addr = v.getUint16(8, true) * 0x100000000 + v.getUint32(4, true);
+    this.addrType = v.getUint8(10);
+    this.rssi = v.getInt8(11);
+    this.advType = v.getUint8(12);
+    this.data = data;
+  }
+
+  *iterAd(): Generator<[number, Uint8Array]> {
+    const data = this.data;
+    let pos = 0;
+    while (pos < data.length) {
+      const adLen = data[pos];
+      if (adLen === 0 || pos + 1 + adLen > data.length) break;
+      yield [data[pos + 1], data.subarray(pos + 2, pos + 1 + adLen)];
+      pos += 1 + adLen;
+    }
+  }
+
+  /** Local name (complete or shortened), if advertised. */
+  get name(): string | null {
+    for (const [adType, adData] of this.iterAd()) {
+      if (adType === AD_TYPE_NAME_COMPLETE || adType === AD_TYPE_NAME_SHORT) {
+        return new TextDecoder("utf-8", { fatal: false }).decode(adData);
+      }
+    }
+    return null;
+  }
+
+  /** Company identifier from manufacturer-specific data, if present. */
+  get manufacturerId(): number | null {
+    for (const [adType, adData] of this.iterAd()) {
+      if (adType === AD_TYPE_MANUFACTURER && adData.length >= 2) {
+        return adData[0] | (adData[1] << 8);
+      }
+    }
+    return null;
+  }
+
+  static advTypeName(advType: number): string {
+    return AdvTypeName[advType] ?? `${advType}`;
+  }
+
+  toString(): string {
+    const parts = [
+      `addr=${macStr(this.addr)}`,
+      `rssi=${this.rssi}`,
+      `type=${BleAdv.advTypeName(this.advType)}`,
+      `len=${this.data.length}`,
+    ];
+    const name = this.name;
+    if (name !== null) parts.push(`name='${name}'`);
+    return `BleAdv(${parts.join(", ")})`;
+  }
+}
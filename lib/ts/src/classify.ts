@@ -0,0 +1,49 @@
+/** Detections reported by the sniffer's on-device beacon classifier. */
+
+import { macStr } from "./mac.js";
+
+// event struct: <I6sBbBBBxHHI  (24 bytes)
+export const DETECTION_SIZE = 24;
+
+/**
+ * A beacon or probe response that scored at or above the installed model's
+ * threshold (see `setClassifier`). `suppressed` counts hits on the same
+ * transmitter held back by the hold-off since the previous detection;
+ * `ieSig` is the element-order signature the model saw.
+ */
+export class Detection {
+  readonly timestampUs: number;
+  /** 48-bit transmitter address (see mac.ts). */
+  readonly mac: number;
+  readonly channel: number;
+  readonly rssi: number;
+  readonly label: number;
+  /** 0..255 */
+  readonly confidence: number;
+  readonly subtype: number;
+  /** Beacon interval, TU. */
+  readonly interval: number;
+  readonly suppressed: number;
+  readonly ieSig: number;
+
+  constructor(payload: Uint8Array) {
+    const v = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+    this.timestampUs = v.getUint32(0, true);
+    this.mac = v.getUint16(4) * 0x100000000 + v.getUint32(6);
+    this.channel = v.getUint8(10);
+    this.rssi = v.getInt8(11);
+    this.label = v.getUint8(12);
+    this.confidence = v.getUint8(13);
+    this.subtype = v.getUint8(14);
+    this.interval = v.getUint16(16, true);
+    this.suppressed = v.getUint16(18, true);
+    this.ieSig = v.getUint32(20, true);
+  }
+
+  toString(): string {
+    return (
+      `Detection(${macStr(this.mac)}, label=${this.label}, confidence=${this.confidence}, ` +
+      `ch=${this.channel}, rssi=${this.rssi}, suppressed=${this.suppressed})`
+    );
+  }
+}
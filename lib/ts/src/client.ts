@@ -1,7 +1,14 @@
 /** Web Serial client for the ESP32-C6 WiFi sniffer firmware. */
 
-import { encode, decode } from "./cobs.js";
+import { encode, decodeInto } from "./cobs.js";
 import { Frame, META_SIZE } from "./frame.js";
+import { FrameBatch } from "./batch.js";
+import { BleAdv, BLE_META_SIZE } from "./ble.js";
+import { Anomaly, ANOMALY_SIZE } from "./anomaly.js";
+import { CsiReport, CSI_SIZE, CSI_BITS_8, CSI_MAX_MATCH, csiPackedLen } from "./csi.js";
+import { Detection, DETECTION_SIZE } from "./classify.js";
+import { crc32 } from "./crc32.js";
+import { macToBytes } from "./mac.js";
 
 // protocol constants (must match firmware protocol.h)
 const MSG_CMD_SCAN_START = 0x01;
@@ -9,12 +16,46 @@ const MSG_CMD_SCAN_STOP = 0x02;
 const MSG_CMD_PROMISC_ON = 0x03;
 const MSG_CMD_PROMISC_OFF = 0x04;
 const MSG_CMD_PROMISC_QUERY = 0x05;
+const MSG_CMD_BLE_CONFIG = 0x06;
+const MSG_CMD_STATS_QUERY = 0x07;
+const MSG_CMD_DEAUTH_CONFIG = 0x08;
+const MSG_CMD_SET_SCHEDULE = 0x09;
+const MSG_CMD_BULK_BEGIN = 0x0a;
+const MSG_CMD_BULK_CHUNK = 0x0b;
+const MSG_CMD_BULK_COMMIT = 0x0c;
+const MSG_CMD_HOP_GUARD = 0x0d;
+const MSG_CMD_HOP_STATS_QUERY = 0x0e;
+const MSG_CMD_SYNTH = 0x0f;
+const MSG_CMD_PING = 0x10;
+const MSG_CMD_CSI_CONFIG = 0x11;
+const MSG_CMD_PROBE_CONFIG = 0x12;
 
 const MSG_RSP_ACK = 0x81;
 const MSG_RSP_ERROR = 0x82;
 const MSG_RSP_PROMISC_STATUS = 0x83;
+const MSG_RSP_STATS = 0x84;
+const MSG_RSP_BULK_ACK = 0x85;
+const MSG_RSP_HOP_STATS = 0x86;
+const MSG_RSP_PONG = 0x87;
 
 const MSG_EVT_FRAME = 0xc0;
+const MSG_EVT_BLE_ADV = 0xc1;
+const MSG_EVT_ANOMALY = 0xc2;
+const MSG_EVT_LOSS = 0xc3;
+const MSG_EVT_CSI = 0xc4;
+const MSG_EVT_DETECTION = 0xc5;
+
+/** Device-side loss reasons, in MSG_EVT_LOSS count order (must match firmware protocol.h). */
+export const LOSS_REASON_NAMES = [
+  "pool_empty",
+  "queue_full",
+  "oversize",
+  "usb_timeout",
+  "ble",
+  "event",
+] as const;
+const LOSS_FRAME_REASONS = 3; // the first three count frames; the rest are other messages
+const LOSS_HDR = 8; // timestamp, seq_first, seq_last
 
 const HDR_SIZE = 4; // <BBH: msg_type(1) + flags(1) + payload_len(2)
 
@@ -24,14 +65,117 @@ export const FILTER_MGMT = 0x01; // management frames
 export const FILTER_CTRL = 0x02; // control frames
 export const FILTER_DATA = 0x04; // data frames
 
+// bulk configuration upload (must match firmware protocol.h)
+export const BULK_KIND_SCHEDULE = 0x01;
+export const BULK_KIND_MAC_FILTER = 0x02;
+export const BULK_KIND_CLASSIFIER = 0x03;
+const BULK_CHUNK_MAX = 256;
+const BULK_ACK_NONE = 0xffffffff;
+const BULK_WINDOW = 8; // chunks in flight; fits the device's 4 KB RX ring
+const BULK_ACK_TIMEOUT = 100; // ms
+
+// MAC filter modes
+export const MACFILT_OFF = 0;
+export const MACFILT_ALLOW = 1; // forward only frames involving a listed address
+export const MACFILT_DENY = 2; // drop frames involving a listed address
+
 const ERROR_NAMES: Record<number, string> = {
   0x01: "unknown command",
   0x02: "invalid channel",
   0x03: "wifi failure",
   0x04: "scan active (stop scan first)",
   0x05: "invalid filter",
+  0x06: "invalid parameter",
+  0x07: "unsupported by firmware build",
+  0x08: "CRC mismatch",
+  0x09: "out of memory on device",
 };
 
+/**
+ * One hop-schedule entry and the capture profile applied while on it.
+ * `typeMask` is a FILTER_* bitmask (0 = all); `mgmtSubtypes` has bit n set to
+ * admit management subtype n (0 = all); `snaplen` cuts forwarded frames to
+ * that many bytes (0 = whole frame); frames weaker than `rssiMin` are dropped.
+ */
+export interface Hop {
+  channel: number;
+  dwellMs: number;
+  typeMask?: number;
+  mgmtSubtypes?: number;
+  snaplen?: number;
+  rssiMin?: number;
+}
+
+export const MAX_HOPS = 32;
+const HOP_SIZE = 9; // <BHBHHb
+
+/** Device counters and per-radio duty cycle (firmware proto_stats_t). */
+export interface SnifferStats {
+  wifiMs: number;
+  bleMs: number;
+  wifiPermille: number;
+  blePermille: number;
+  framesSent: number;
+  bleAdvSent: number;
+  bleAdvDedup: number;
+}
+
+const STATS_SIZE = 24;
+
+/**
+ * Channel-switch timing and settle-window counts since scan start (firmware
+ * hop_stats_msg_t). Histogram bucket `i` counts values below `128 << i` µs;
+ * the last bucket is open-ended.
+ */
+export interface HopStats {
+  guardUs: number;
+  guardMode: number;
+  switches: number;
+  switchUsTotal: number;
+  switchUsMax: number;
+  /** Frames arriving within 16 ms of a switch. */
+  settleFrames: number;
+  /** Of those, frames whose rx channel is not the new hop's. */
+  staleFrames: number;
+  /** Stale frames dropped or relabelled by the guard. */
+  guarded: number;
+  /** Switches by how long the radio was held. */
+  switchHist: number[];
+  /** Stale frames by arrival time after the switch. */
+  staleHist: number[];
+}
+
+const HOP_STATS_SIZE = 92;
+const HOP_STATS_BUCKETS = 8;
+
+// post-switch guard modes (must match firmware hopstat.h)
+export const HOP_GUARD_OFF = 0; // count stale frames only
+export const HOP_GUARD_DROP = 1; // discard them
+export const HOP_GUARD_RELABEL = 2; // judge them by the previous hop's capture profile
+export const HOP_GUARD_MAX_US = 16384;
+
+// synthetic frame source (must match firmware synth.h)
+export const SYNTH_DIST_FIXED = 0; // always lenMin
+export const SYNTH_DIST_UNIFORM = 1; // uniform over lenMin..lenMax
+export const SYNTH_DIST_IMIX = 2; // lenMin, midpoint, lenMax at 7:4:1
+export const SYNTH_MAX_RATE = 1_000_000;
+export const PING_MAX_ECHO = 32;
+
+// active probing (must match firmware probe.h)
+export const PROBE_MAX_SSIDS = 4;
+export const PROBE_MAX_RATE = 200; // probes per second
+const PROBE_FLAG_BROADCAST = 0x01;
+
+/** Reply to `ping()`. */
+export interface Pong {
+  /** Host round trip in milliseconds. */
+  rttMs: number;
+  /** Device clock (32-bit microseconds) when the ping was handled. */
+  rxUs: number;
+  /** Device clock just before the reply was written. */
+  txUs: number;
+}
+
 export class SnifferError extends Error {
   readonly cmd: number;
   readonly code: number;
@@ -47,6 +191,20 @@ export class SnifferError extends Error {
 export interface SnifferClientOptions {
   baudRate?: number;
   onFrame?: (frame: Frame) => void;
+  /**
+   * Called once per serial read with all frames decoded from it, as typed-array
+   * columns. When set, frames are delivered only here and `onFrame` is not
+   * called. The batch is reused after the callback returns.
+   */
+  onBatch?: (batch: FrameBatch) => void;
+  /** Called for each BLE advertisement while BLE interleaving is enabled. */
+  onBleAdv?: (adv: BleAdv) => void;
+  /** Called for each on-device detector report (e.g. a deauth flood). */
+  onAnomaly?: (anomaly: Anomaly) => void;
+  /** Called for each CSI report while CSI mode is enabled with `csiConfig`. */
+  onCsi?: (report: CsiReport) => void;
+  /** Called for each classifier hit while a model is installed with `setClassifier`. */
+  onDetection?: (det: Detection) => void;
   onDisconnect?: () => void;
   /** USB vendor/product filter for requestPort(). */
   filters?: SerialPortFilter[];
@@ -56,26 +214,53 @@ export class SnifferClient {
   static readonly TIMEOUT = 3000; // ms
 
   frameCount = 0;
-  dropped = 0;
+  bleAdvCount = 0;
+  csiCount = 0;
+  detectionCount = 0;
+
+  // transit losses (seq_num gaps) plus device-reported losses per reason;
+  // the device restarts its counts at every scan start, folded into _lossBase
+  private _seqDropped = 0;
+  private _lossBase: number[] = LOSS_REASON_NAMES.map(() => 0);
+  private _lossCur: number[] = LOSS_REASON_NAMES.map(() => 0);
 
   private _port: SerialPort | null = null;
   private _reader: ReadableStreamDefaultReader<Uint8Array> | null = null;
   private _writer: WritableStreamDefaultWriter<Uint8Array> | null = null;
   private _running = false;
   private _buf = new Uint8Array(0);
+  private _scratch = new Uint8Array(4096); // reused COBS decode buffer
+  private _batch: FrameBatch | null;
   private _seqExpect = 0;
   private _firstSeq = true;
 
   private _onFrame: (frame: Frame) => void;
+  private _onBatch: (batch: FrameBatch) => void;
+  private _onBleAdv: (adv: BleAdv) => void;
+  private _onAnomaly: (anomaly: Anomaly) => void;
+  private _onCsi: (report: CsiReport) => void;
+  private _onDetection: (det: Detection) => void;
   private _onDisconnect: () => void;
   private _baudRate: number;
   private _filters: SerialPortFilter[];
 
   // command response signaling
   private _respResolve: ((data: Uint8Array | null) => void) | null = null;
+  private _foldOnAck: number | null = null; // command whose ACK restarts the device's counts
+
+  // bulk upload acknowledgements
+  private _bulkAcked = 0;
+  private _bulkAcks = 0;
+  private _bulkWake: (() => void) | null = null;
 
   constructor(options: SnifferClientOptions = {}) {
     this._onFrame = options.onFrame ?? (() => {});
+    this._onBatch = options.onBatch ?? (() => {});
+    this._batch = options.onBatch ? new FrameBatch() : null;
+    this._onBleAdv = options.onBleAdv ?? (() => {});
+    this._onAnomaly = options.onAnomaly ?? (() => {});
+    this._onCsi = options.onCsi ?? (() => {});
+    this._onDetection = options.onDetection ?? (() => {});
     this._onDisconnect = options.onDisconnect ?? (() => {});
     this._baudRate = options.baudRate ?? 115200;
     this._filters = options.filters ?? [];
@@ -103,18 +288,39 @@ export class SnifferClient {
     this._port = port;
     this._running = true;
     this._buf = new Uint8Array(0);
+    this._batch?.clear();
     this._firstSeq = true;
     this._seqExpect = 0;
     this.frameCount = 0;
-    this.dropped = 0;
+    this.bleAdvCount = 0;
+    this.csiCount = 0;
+    this.detectionCount = 0;
+    this._seqDropped = 0;
+    this._lossBase.fill(0);
+    this._lossCur.fill(0);
 
     this._readLoop();
   }
 
+  /** Frames lost: reported by the device per reason, plus transit gaps. */
+  get dropped(): number {
+    let n = this._seqDropped;
+    for (let i = 0; i < LOSS_FRAME_REASONS; i++) n += this._lossBase[i] + this._lossCur[i];
+    return n;
+  }
+
+  /** Device-side loss counts by reason (see `LOSS_REASON_NAMES`). */
+  get loss(): Record<string, number> {
+    const out: Record<string, number> = {};
+    LOSS_REASON_NAMES.forEach((name, i) => (out[name] = this._lossBase[i] + this._lossCur[i]));
+    return out;
+  }
+
   async scan(channel: number = 0, frameFilter: number = 0): Promise<void> {
     await this._sendCmd(
       MSG_CMD_SCAN_START,
-      new Uint8Array([channel, frameFilter])
+      new Uint8Array([channel, frameFilter]),
+      true
     );
   }
 
@@ -135,6 +341,319 @@ export class SnifferClient {
     return resp !== null && resp.length > 0 && resp[0] !== 0;
   }
 
+  /**
+   * Interleave BLE passive scan windows into the Wi-Fi hop schedule.
+   * `windowMs` = 0 disables BLE; `every` inserts a window after every N
+   * Wi-Fi hops; `dedupMs` suppresses repeated addr+payload on the device.
+   */
+  async bleConfig(
+    windowMs: number,
+    every: number = 1,
+    dedupMs: number = 1000
+  ): Promise<void> {
+    const payload = new Uint8Array(5);
+    const v = new DataView(payload.buffer);
+    v.setUint16(0, windowMs, true);
+    v.setUint8(2, every);
+    v.setUint16(3, dedupMs, true);
+    await this._sendCmd(MSG_CMD_BLE_CONFIG, payload);
+  }
+
+  /**
+   * Configure the on-device deauth/disassoc flood detector. A flood is
+   * `threshold` frames per (BSSID, target) within `windowMs` (0 disables it);
+   * it is re-reported every `reportMs` while it lasts (0 = onset only), and
+   * `suppress` drops its individual frames instead of forwarding them.
+   */
+  async deauthConfig(
+    threshold: number = 20,
+    windowMs: number = 1000,
+    reportMs: number = 5000,
+    suppress: boolean = false
+  ): Promise<void> {
+    const payload = new Uint8Array(7);
+    const v = new DataView(payload.buffer);
+    v.setUint16(0, threshold, true);
+    v.setUint16(2, windowMs, true);
+    v.setUint16(4, reportMs, true);
+    v.setUint8(6, suppress ? 1 : 0);
+    await this._sendCmd(MSG_CMD_DEAUTH_CONFIG, payload);
+  }
+
+  /**
+   * Replace the all-channel hop schedule with per-hop capture profiles.
+   * Applies to scans started with channel 0 (a running one restarts on the
+   * new schedule); an empty list restores the default schedule.
+   */
+  async setSchedule(hops: Hop[]): Promise<void> {
+    if (hops.length > MAX_HOPS) throw new RangeError(`at most ${MAX_HOPS} hops`);
+    const payload = new Uint8Array(1 + hops.length * HOP_SIZE);
+    const v = new DataView(payload.buffer);
+    payload[0] = hops.length;
+    hops.forEach((h, i) => {
+      const off = 1 + i * HOP_SIZE;
+      v.setUint8(off, h.channel);
+      v.setUint16(off + 1, h.dwellMs, true);
+      v.setUint8(off + 3, h.typeMask ?? FILTER_ALL);
+      v.setUint16(off + 4, h.mgmtSubtypes ?? 0, true);
+      v.setUint16(off + 6, h.snaplen ?? 0, true);
+      v.setInt8(off + 8, h.rssiMin ?? -128);
+    });
+    await this._sendCmd(MSG_CMD_SET_SCHEDULE, payload);
+  }
+
+  /**
+   * Install a device-side MAC filter on addr1..addr3 (uploaded in bulk and
+   * applied atomically). MACFILT_ALLOW forwards only frames involving a
+   * listed address, MACFILT_DENY drops them, MACFILT_OFF removes the filter.
+   */
+  async setMacFilter(macs: number[], mode: number = MACFILT_ALLOW): Promise<void> {
+    const blob = new Uint8Array(2 + macs.length * 6);
+    blob[0] = mode;
+    macs.forEach((m, i) => blob.set(macToBytes(m), 2 + i * 6));
+    await this.bulkUpload(BULK_KIND_MAC_FILTER, blob);
+  }
+
+  /**
+   * Install a beacon classifier exported by `python -m lib.py.classify train`
+   * (uploaded in bulk). While installed, beacons and probe responses are
+   * scored whatever the capture filter and hits arrive through
+   * `onDetection`; a blob with kind 0 removes it. Fails with
+   * ERR_INVALID_PARAM if the device rejects the table.
+   */
+  async setClassifier(blob: Uint8Array): Promise<void> {
+    await this.bulkUpload(BULK_KIND_CLASSIFIER, blob);
+  }
+
+  /**
+   * Upload a configuration blob larger than one command. Chunks stream with
+   * up to `window` unacknowledged; the device acks the contiguous byte count
+   * after every chunk, and a repeated count (lost chunk) or a timeout sends
+   * the upload back to that offset. Applied on the device only once complete
+   * and CRC-checked.
+   */
+  async bulkUpload(
+    kind: number,
+    blob: Uint8Array,
+    window: number = BULK_WINDOW,
+    retries: number = 5
+  ): Promise<void> {
+    const total = blob.length;
+    const begin = new Uint8Array(9);
+    const bv = new DataView(begin.buffer);
+    bv.setUint8(0, kind);
+    bv.setUint32(1, total, true);
+    bv.setUint32(5, crc32(blob), true);
+    await this._sendCmd(MSG_CMD_BULK_BEGIN, begin);
+    this._bulkAcked = 0;
+    this._bulkAcks = 0;
+
+    let sent = 0;
+    let stalls = 0;
+    let dups = 0;
+    while (true) {
+      const acked = this._bulkAcked;
+      const acks = this._bulkAcks;
+      if (acked === BULK_ACK_NONE) throw new SnifferError(MSG_CMD_BULK_CHUNK, 0x06);
+      if (acked >= total) break;
+
+      while (sent < total && sent - acked < window * BULK_CHUNK_MAX) {
+        const n = Math.min(BULK_CHUNK_MAX, total - sent);
+        const chunk = new Uint8Array(4 + n);
+        new DataView(chunk.buffer).setUint32(0, sent, true);
+        chunk.set(blob.subarray(sent, sent + n), 4);
+        await this._write(MSG_CMD_BULK_CHUNK, chunk);
+        sent += n;
+      }
+
+      if (!(await this._waitBulkAck(acks))) {
+        if (++stalls > retries) throw new SnifferError(MSG_CMD_BULK_CHUNK, 0xff);
+        sent = this._bulkAcked;
+        continue;
+      }
+      stalls = 0;
+      if (this._bulkAcked !== acked) {
+        dups = 0;
+        continue;
+      }
+      // duplicate ack: the chunk after it was lost. Resend from there once,
+      // and again only if a whole window's acks show no progress
+      dups++;
+      if (dups === 1 || dups > window) {
+        sent = acked;
+        dups = 1;
+      }
+    }
+
+    await this._sendCmd(MSG_CMD_BULK_COMMIT);
+  }
+
+  /** Resolves true once an ack beyond `acks` has arrived, false on timeout. */
+  private _waitBulkAck(acks: number): Promise<boolean> {
+    if (this._bulkAcks !== acks) return Promise.resolve(true);
+    return new Promise((resolve) => {
+      const timer = setTimeout(() => {
+        this._bulkWake = null;
+        resolve(false);
+      }, BULK_ACK_TIMEOUT);
+      this._bulkWake = () => {
+        clearTimeout(timer);
+        resolve(true);
+      };
+    });
+  }
+
+  /**
+   * Set the guard interval after each channel switch. Frames received within
+   * `guardUs` of a switch whose rx channel is not the new hop's were in flight
+   * on the old channel: HOP_GUARD_DROP discards them, HOP_GUARD_RELABEL
+   * forwards them under the previous hop's capture profile, HOP_GUARD_OFF only
+   * counts them. `guardUs` is at most HOP_GUARD_MAX_US.
+   */
+  async hopGuard(guardUs: number, mode: number = HOP_GUARD_DROP): Promise<void> {
+    await this._sendCmd(MSG_CMD_HOP_GUARD, new Uint8Array([guardUs & 0xff, guardUs >> 8, mode]));
+  }
+
+  /** Query channel-switch timing and settle-window counts. */
+  async hopStats(): Promise<HopStats | null> {
+    const resp = await this._sendCmd(MSG_CMD_HOP_STATS_QUERY);
+    if (resp === null || resp.length < HOP_STATS_SIZE) return null;
+    const v = new DataView(resp.buffer, resp.byteOffset, resp.byteLength);
+    const hist = (off: number) =>
+      Array.from({ length: HOP_STATS_BUCKETS }, (_, i) => v.getUint32(off + 4 * i, true));
+    return {
+      guardUs: v.getUint16(0, true),
+      guardMode: v.getUint8(2),
+      switches: v.getUint32(4, true),
+      switchUsTotal: v.getUint32(8, true),
+      switchUsMax: v.getUint32(12, true),
+      settleFrames: v.getUint32(16, true),
+      staleFrames: v.getUint32(20, true),
+      guarded: v.getUint32(24, true),
+      switchHist: hist(28),
+      staleHist: hist(28 + 4 * HOP_STATS_BUCKETS),
+    };
+  }
+
+  /**
+   * Generate synthetic frame events on the device, bypassing the radio, at
+   * `rate` per second (0 stops) with lengths drawn by `dist` from
+   * lenMin..lenMax, until `count` have been offered (0 = until stopped).
+   * They arrive on channel 0 with seq numbers and loss accounting like
+   * captured frames. Not allowed while scanning.
+   */
+  async synth(
+    rate: number,
+    lenMin: number = 256,
+    lenMax: number = lenMin,
+    dist: number = SYNTH_DIST_FIXED,
+    count: number = 0
+  ): Promise<void> {
+    const payload = new Uint8Array(13);
+    const v = new DataView(payload.buffer);
+    v.setUint32(0, rate, true);
+    v.setUint32(4, count, true);
+    v.setUint16(8, lenMin, true);
+    v.setUint16(10, lenMax, true);
+    v.setUint8(12, dist);
+    await this._sendCmd(MSG_CMD_SYNTH, payload, rate !== 0);
+  }
+
+  /**
+   * Turn CSI reports on or off. Reports arrive through `onCsi` while
+   * scanning. With `macs` and/or `ouis` (24-bit, see `oui`) only matching
+   * transmitters are reported, up to CSI_MAX_MATCH in all; `intervalMs`
+   * forwards at most one report per transmitter per interval, and
+   * CSI_BITS_4 halves each report at the cost of quantization. Fails with
+   * ERR_UNSUPPORTED if the firmware was built without CSI.
+   */
+  async csiConfig(
+    enable: boolean = true,
+    macs: number[] = [],
+    ouis: number[] = [],
+    bits: number = CSI_BITS_8,
+    intervalMs: number = 0
+  ): Promise<void> {
+    const n = macs.length + ouis.length;
+    if (n > CSI_MAX_MATCH) throw new RangeError(`at most ${CSI_MAX_MATCH} addresses and OUIs`);
+    const payload = new Uint8Array(5 + n * 7);
+    const v = new DataView(payload.buffer);
+    v.setUint8(0, enable ? 1 : 0);
+    v.setUint8(1, bits);
+    v.setUint16(2, intervalMs, true);
+    v.setUint8(4, n);
+    macs.forEach((m, i) => {
+      payload[5 + i * 7] = 6;
+      payload.set(macToBytes(m), 6 + i * 7);
+    });
+    ouis.forEach((o, i) => {
+      const at = 5 + (macs.length + i) * 7;
+      payload[at] = 3;
+      payload.set(macToBytes(o * 0x1000000), at + 1);
+    });
+    await this._sendCmd(MSG_CMD_CSI_CONFIG, payload);
+  }
+
+  /**
+   * Send probe requests at the start of every Wi-Fi dwell (`rate` 0 = off):
+   * a directed one per SSID (up to PROBE_MAX_SSIDS) plus a wildcard one if
+   * `broadcast` or no SSID is given, at most `rate` per second (up to
+   * PROBE_MAX_RATE), from `src` (default: the radio's own address). APs on
+   * the channel then answer at once rather than at their next beacon. A
+   * running scan restarts.
+   */
+  async probeConfig(
+    rate: number = 20,
+    ssids: string[] = [],
+    broadcast: boolean = false,
+    src: number | null = null
+  ): Promise<void> {
+    const names = ssids.map((s) => new TextEncoder().encode(s));
+    if (names.length > PROBE_MAX_SSIDS || names.some((n) => n.length > 32)) {
+      throw new RangeError(`at most ${PROBE_MAX_SSIDS} SSIDs of up to 32 bytes`);
+    }
+    const payload = new Uint8Array(11 + names.reduce((a, n) => a + 1 + n.length, 0));
+    const v = new DataView(payload.buffer);
+    v.setUint8(0, rate > 0 ? 1 : 0);
+    v.setUint8(1, broadcast ? PROBE_FLAG_BROADCAST : 0);
+    if (src !== null) payload.set(macToBytes(src), 2);
+    v.setUint16(8, rate, true);
+    v.setUint8(10, names.length);
+    let off = 11;
+    for (const n of names) {
+      payload[off] = n.length;
+      payload.set(n, off + 1);
+      off += 1 + n.length;
+    }
+    await this._sendCmd(MSG_CMD_PROBE_CONFIG, payload);
+  }
+
+  /** Round trip to the device; up to PING_MAX_ECHO bytes of `echo` come back. */
+  async ping(echo: Uint8Array = new Uint8Array(0)): Promise<Pong> {
+    const t0 = performance.now();
+    const resp = await this._sendCmd(MSG_CMD_PING, echo.subarray(0, PING_MAX_ECHO));
+    const rttMs = performance.now() - t0;
+    if (resp === null || resp.length < 8) throw new SnifferError(MSG_CMD_PING, 0xff);
+    const v = new DataView(resp.buffer, resp.byteOffset, resp.byteLength);
+    return { rttMs, rxUs: v.getUint32(0, true), txUs: v.getUint32(4, true) };
+  }
+
+  /** Query device counters and per-radio duty cycle. */
+  async stats(): Promise<SnifferStats | null> {
+    const resp = await this._sendCmd(MSG_CMD_STATS_QUERY);
+    if (resp === null || resp.length < STATS_SIZE) return null;
+    const v = new DataView(resp.buffer, resp.byteOffset, resp.byteLength);
+    return {
+      wifiMs: v.getUint32(0, true),
+      bleMs: v.getUint32(4, true),
+      wifiPermille: v.getUint16(8, true),
+      blePermille: v.getUint16(10, true),
+      framesSent: v.getUint32(12, true),
+      bleAdvSent: v.getUint32(16, true),
+      bleAdvDedup: v.getUint32(20, true),
+    };
+  }
+
   async disconnect(): Promise<void> {
     this._running = false;
 
@@ -173,12 +692,7 @@ export class SnifferClient {
     }
   }
 
-  private async _sendCmd(
-    msgType: number,
-    payload: Uint8Array = new Uint8Array(0)
-  ): Promise<Uint8Array | null> {
-    if (!this._port?.writable) throw new Error("not connected");
-
+  private _packet(msgType: number, payload: Uint8Array): Uint8Array {
     // build header: <BBH (little-endian)
     const hdr = new Uint8Array(HDR_SIZE);
     const hdrView = new DataView(hdr.buffer);
@@ -195,6 +709,37 @@ export class SnifferClient {
     packet[0] = 0x00;
     packet.set(encoded, 1);
     packet[packet.length - 1] = 0x00;
+    return packet;
+  }
+
+  /** Send a message without waiting for a response. */
+  private async _write(msgType: number, payload: Uint8Array): Promise<void> {
+    if (!this._port?.writable) throw new Error("not connected");
+    if (!this._writer) this._writer = this._port.writable.getWriter();
+    await this._writer.write(this._packet(msgType, payload));
+  }
+
+  /** Add the current run's loss counts to the base, at the start of a new run. */
+  private _foldLoss(): void {
+    for (let i = 0; i < this._lossCur.length; i++) {
+      this._lossBase[i] += this._lossCur[i];
+      this._lossCur[i] = 0;
+    }
+  }
+
+  /**
+   * With `foldLoss`, the command restarts the device's loss counts: the
+   * current ones are folded into the base when its ACK arrives, since Loss
+   * events before the ACK still carry the previous run's counts.
+   */
+  private async _sendCmd(
+    msgType: number,
+    payload: Uint8Array = new Uint8Array(0),
+    foldLoss: boolean = false
+  ): Promise<Uint8Array | null> {
+    if (!this._port?.writable) throw new Error("not connected");
+
+    const packet = this._packet(msgType, payload);
 
     // set up response promise before writing
     const respPromise = new Promise<Uint8Array | null>((resolve) => {
@@ -205,6 +750,7 @@ export class SnifferClient {
     if (!this._writer && this._port.writable) {
       this._writer = this._port.writable.getWriter();
     }
+    this._foldOnAck = foldLoss ? msgType : null;
     await this._writer!.write(packet);
 
     // wait for response or timeout
@@ -220,6 +766,7 @@ export class SnifferClient {
     ]).finally(() => {
       clearTimeout(timer);
       this._respResolve = null;
+      this._foldOnAck = null;
     });
 
     if (resp === null) return null;
@@ -248,10 +795,7 @@ export class SnifferClient {
         while (this._running) {
           const { value, done } = await this._reader.read();
           if (done) break;
-          if (value) {
-            this._appendBuf(value);
-            this._process();
-          }
+          if (value) this.feed(value);
         }
       } catch {
         // serial error — will retry if port still readable
@@ -272,7 +816,20 @@ export class SnifferClient {
     }
   }
 
+  /**
+   * Feed raw bytes as read from the device. Called by the read loop; can also
+   * be used to decode a recorded byte stream without a serial port.
+   */
+  feed(chunk: Uint8Array): void {
+    this._appendBuf(chunk);
+    this._process();
+  }
+
   private _appendBuf(chunk: Uint8Array): void {
+    if (this._buf.length === 0) {
+      this._buf = chunk;
+      return;
+    }
     const combined = new Uint8Array(this._buf.length + chunk.length);
     combined.set(this._buf);
     combined.set(chunk, this._buf.length);
@@ -280,75 +837,148 @@ export class SnifferClient {
   }
 
   private _process(): void {
+    const buf = this._buf;
+    let start = 0;
+
     while (true) {
-      const idx = this._buf.indexOf(0x00);
+      const idx = buf.indexOf(0x00, start);
       if (idx === -1) break;
+      if (idx > start) this._handleMessage(buf.subarray(start, idx));
+      start = idx + 1;
+    }
 
-      if (idx === 0) {
-        this._buf = this._buf.slice(1);
-        continue;
-      }
+    // keep only the incomplete tail
+    if (start > 0) this._buf = buf.slice(start);
 
-      const encodedSlice = this._buf.slice(0, idx);
-      this._buf = this._buf.slice(idx + 1);
+    const batch = this._batch;
+    if (batch !== null && batch.count > 0) {
+      this._onBatch(batch);
+      batch.clear();
+    }
+  }
 
-      let decoded: Uint8Array;
-      try {
-        decoded = decode(encodedSlice);
-      } catch {
-        continue;
-      }
+  private _handleMessage(encoded: Uint8Array): void {
+    if (this._scratch.length < encoded.length) {
+      this._scratch = new Uint8Array(encoded.length * 2);
+    }
+
+    let len: number;
+    try {
+      len = decodeInto(encoded, this._scratch);
+    } catch {
+      return;
+    }
 
-      if (decoded.length < HDR_SIZE) continue;
+    if (len < HDR_SIZE) return;
 
-      const msgType = decoded[0];
+    // the scratch buffer is reused: anything kept past this call is copied
+    const decoded = this._scratch.subarray(0, len);
+    const msgType = decoded[0];
 
-      if (msgType === MSG_EVT_FRAME) {
-        this._handleFrame(decoded);
-      } else if (
-        msgType === MSG_RSP_ACK ||
-        msgType === MSG_RSP_ERROR ||
-        msgType === MSG_RSP_PROMISC_STATUS
-      ) {
-        if (this._respResolve) {
-          this._respResolve(decoded);
-          this._respResolve = null;
+    if (msgType === MSG_EVT_FRAME) {
+      this._handleFrame(decoded);
+    } else if (msgType === MSG_EVT_BLE_ADV) {
+      this._handleBleAdv(decoded);
+    } else if (msgType === MSG_EVT_ANOMALY) {
+      if (len >= HDR_SIZE + ANOMALY_SIZE) {
+        this._onAnomaly(new Anomaly(decoded.slice(HDR_SIZE, HDR_SIZE + ANOMALY_SIZE)));
+      }
+    } else if (msgType === MSG_EVT_CSI) {
+      if (len >= HDR_SIZE + CSI_SIZE) {
+        const bits = decoded[HDR_SIZE + 15];
+        const csiLen = decoded[HDR_SIZE + 20] | (decoded[HDR_SIZE + 21] << 8);
+        const end = HDR_SIZE + CSI_SIZE + csiPackedLen(csiLen, bits);
+        if (len >= end) {
+          this.csiCount++;
+          this._onCsi(new CsiReport(decoded.slice(HDR_SIZE, end)));
         }
       }
+    } else if (msgType === MSG_EVT_DETECTION) {
+      if (len >= HDR_SIZE + DETECTION_SIZE) {
+        this.detectionCount++;
+        this._onDetection(new Detection(decoded.slice(HDR_SIZE, HDR_SIZE + DETECTION_SIZE)));
+      }
+    } else if (msgType === MSG_EVT_LOSS) {
+      const n = Math.min((len - HDR_SIZE - LOSS_HDR) >> 2, this._lossCur.length);
+      const view = new DataView(decoded.buffer, decoded.byteOffset, len);
+      for (let i = 0; i < n; i++) {
+        this._lossCur[i] = view.getUint32(HDR_SIZE + LOSS_HDR + 4 * i, true);
+      }
+    } else if (msgType === MSG_RSP_BULK_ACK) {
+      if (len >= HDR_SIZE + 4) {
+        this._bulkAcked =
+          (decoded[4] | (decoded[5] << 8) | (decoded[6] << 16) | (decoded[7] << 24)) >>> 0;
+        this._bulkAcks++;
+        const wake = this._bulkWake;
+        this._bulkWake = null;
+        wake?.();
+      }
+    } else if (
+      msgType === MSG_RSP_ACK ||
+      msgType === MSG_RSP_ERROR ||
+      msgType === MSG_RSP_PROMISC_STATUS ||
+      msgType === MSG_RSP_STATS ||
+      msgType === MSG_RSP_HOP_STATS ||
+      msgType === MSG_RSP_PONG
+    ) {
+      if (msgType === MSG_RSP_ACK && len > HDR_SIZE && decoded[HDR_SIZE] === this._foldOnAck) {
+        this._foldLoss();
+      }
+      if (this._respResolve) {
+        this._respResolve(decoded.slice());
+        this._respResolve = null;
+      }
     }
   }
 
   private _handleFrame(data: Uint8Array): void {
-    if (data.length < HDR_SIZE) return;
-    const v = new DataView(data.buffer, data.byteOffset, data.byteLength);
-    const payloadLen = v.getUint16(2, true);
-    const payload = data.slice(HDR_SIZE, HDR_SIZE + payloadLen);
+    const payloadLen = data[2] | (data[3] << 8);
+    const end = Math.min(data.length, HDR_SIZE + payloadLen);
 
-    if (payload.length < META_SIZE) return;
+    if (end - HDR_SIZE < META_SIZE) return;
 
-    const meta = payload.slice(0, META_SIZE);
-    const frameLen = new DataView(
-      meta.buffer,
-      meta.byteOffset,
-      meta.byteLength
-    ).getUint16(4, true);
-    const frameData = payload.slice(META_SIZE, META_SIZE + frameLen);
+    const frameLen = data[HDR_SIZE + 4] | (data[HDR_SIZE + 5] << 8);
+    if (end - HDR_SIZE - META_SIZE < frameLen) return;
 
-    if (frameData.length < frameLen) return;
+    const seqNum = data[HDR_SIZE + 12] | (data[HDR_SIZE + 13] << 8);
+    this._trackSeq(seqNum);
+    this.frameCount++;
 
-    const frame = new Frame(meta, frameData);
+    if (this._batch !== null) {
+      this._batch.push(data, HDR_SIZE, frameLen);
+      return;
+    }
 
-    // drop detection
+    // one copy per frame; meta and raw are views into it
+    const payload = data.slice(HDR_SIZE, HDR_SIZE + META_SIZE + frameLen);
+    this._onFrame(
+      new Frame(payload.subarray(0, META_SIZE), payload.subarray(META_SIZE))
+    );
+  }
+
+  // drop detection
+  private _trackSeq(seqNum: number): void {
     if (this._firstSeq) {
-      this._seqExpect = frame.seqNum;
+      this._seqExpect = seqNum;
       this._firstSeq = false;
-    } else if (frame.seqNum !== this._seqExpect) {
-      const gap = (frame.seqNum - this._seqExpect) & 0xffff;
-      if (gap < 0x8000) this.dropped += gap;
+    } else if (seqNum !== this._seqExpect) {
+      const gap = (seqNum - this._seqExpect) & 0xffff;
+      if (gap < 0x8000) this._seqDropped += gap;
     }
-    this._seqExpect = (frame.seqNum + 1) & 0xffff;
+    this._seqExpect = (seqNum + 1) & 0xffff;
+  }
 
-    this.frameCount++;
-    this._onFrame(frame);
+  private _handleBleAdv(data: Uint8Array): void {
+    const payloadLen = data[2] | (data[3] << 8);
+    const payload = data.subarray(HDR_SIZE, HDR_SIZE + payloadLen);
+
+    if (payload.length < BLE_META_SIZE) return;
+
+    const dataLen = payload[BLE_META_SIZE - 1];
+    const advData = payload.slice(BLE_META_SIZE, BLE_META_SIZE + dataLen);
+    if (advData.length < dataLen) return;
+
+    this.bleAdvCount++;
+    this._onBleAdv(new BleAdv(payload.subarray(0, BLE_META_SIZE), advData));
   }
 }
@@ -55,3 +55,33 @@ export function decode(data: Uint8Array): Uint8Array {
 
   return new Uint8Array(out);
 }
+
+/**
+ * Decode into a caller-provided buffer of at least `data.length` bytes and
+ * return the decoded length. Allocation-free, for the client's hot path.
+ */
+export function decodeInto(data: Uint8Array, out: Uint8Array): number {
+  let o = 0;
+  let i = 0;
+  const length = data.length;
+
+  while (i < length) {
+    const code = data[i];
+    i++;
+    if (code === 0) {
+      throw new Error("zero byte in COBS-encoded data");
+    }
+
+    const end = i + code - 1;
+    if (end > length) {
+      throw new Error("truncated COBS data");
+    }
+    while (i < end) out[o++] = data[i++];
+
+    if (code < 0xff && i < length) {
+      out[o++] = 0x00;
+    }
+  }
+
+  return o;
+}
@@ -0,0 +1,98 @@
+/** Channel state information (CSI) reports forwarded by the sniffer's CSI mode. */
+
+import { macStr } from "./mac.js";
+
+// metadata struct: <I6sBbbBBBBxHHH  (24 bytes)
+export const CSI_SIZE = 24;
+
+export const CSI_BITS_8 = 8; // values as the driver reported them
+export const CSI_BITS_4 = 4; // two values per byte, scaled by 2**shift
+export const CSI_MAX_MATCH = 16; // addresses / OUIs in the device-side filter
+
+const CSI_FLAG_FIRST_WORD_INVALID = 0x01;
+
+/** Packed length of `count` values at `bits` per value. */
+export function csiPackedLen(count: number, bits: number): number {
+  return bits === CSI_BITS_4 ? (count + 1) >> 1 : count;
+}
+
+/**
+ * CSI of one received PPDU: metadata plus the (packed) I/Q values.
+ *
+ * Values are int8 pairs per subcarrier, imaginary part first, in the order
+ * the driver reports them (which depends on the PPDU format). `suppressed`
+ * counts reports from the same transmitter held back by the device-side
+ * rate limit since the previous one.
+ */
+export class CsiReport {
+  readonly timestampUs: number;
+  /** 48-bit transmitter address (see mac.ts). */
+  readonly mac: number;
+  readonly channel: number;
+  readonly rssi: number;
+  readonly noiseFloor: number;
+  readonly rate: number;
+  readonly flags: number;
+  readonly bits: number;
+  readonly shift: number;
+  readonly sigLen: number;
+  readonly csiLen: number;
+  readonly suppressed: number;
+  /** Packed values as received. */
+  readonly data: Uint8Array;
+
+  constructor(payload: Uint8Array) {
+    const v = new DataView(payload.buffer, payload.byteOffset, payload.byteLength);
+    this.timestampUs = v.getUint32(0, true);
+    this.mac = v.getUint16(4) * 0x100000000 + v.getUint32(6);
+    this.channel = v.getUint8(10);
+    this.rssi = v.getInt8(11);
+    this.noiseFloor = v.getInt8(12);
+    this.rate = v.getUint8(13);
+    this.flags = v.getUint8(14);
+    this.bits = v.getUint8(15);
+    this.shift = v.getUint8(16);
+    this.sigLen = v.getUint16(18, true);
+    this.csiLen = v.getUint16(20, true);
+    this.suppressed = v.getUint16(22, true);
+    this.data = payload.subarray(CSI_SIZE, CSI_SIZE + csiPackedLen(this.csiLen, this.bits));
+  }
+
+  get firstWordInvalid(): boolean {
+    return (this.flags & CSI_FLAG_FIRST_WORD_INVALID) !== 0;
+  }
+
+  /** The `csiLen` int8 values, unpacked and scaled back. */
+  values(): Int8Array {
+    const n = Math.min(this.csiLen, this.bits === CSI_BITS_4 ? this.data.length * 2 : this.data.length);
+    const out = new Int8Array(n);
+    if (this.bits !== CSI_BITS_4) {
+      out.set(new Int8Array(this.data.buffer, this.data.byteOffset, n));
+      return out;
+    }
+    // sign-extend each nibble from bit 3, then scale
+    const up = 28 - Math.min(this.shift, 4);
+    const data = this.data;
+    for (let i = 0; i < n; i++) {
+      const b = data[i >> 1];
+      out[i] = ((i & 1 ? b >> 4 : b & 0x0f) << 28) >> up;
+    }
+    return out;
+  }
+
+  /** Magnitude per subcarrier. */
+  amplitudes(): Float32Array {
+    const v = this.values();
+    const out = new Float32Array(v.length >> 1);
+    for (let k = 0; k < out.length; k++) out[k] = Math.hypot(v[2 * k], v[2 * k + 1]);
+    return out;
+  }
+
+  toString(): string {
+    const q = this.bits === CSI_BITS_4 ? `, 4-bit<<${this.shift}` : "";
+    return (
+      `CsiReport(${macStr(this.mac)}, ch=${this.channel}, rssi=${this.rssi}, ` +
+      `${this.csiLen >> 1} subcarriers${q}, suppressed=${this.suppressed})`
+    );
+  }
+}
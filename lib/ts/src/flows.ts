@@ -0,0 +1,488 @@
+/** Per-flow traffic accounting for data frames: who talks to whom, and how much. */
+
+import { FrameBatch, MAC_STRIDE } from "./batch.js";
+import { FRAME_TYPE_DATA, META_SIZE } from "./frame.js";
+
+// flow direction: the frame control ToDS / FromDS bits
+export const DIR_DIRECT = 0; // neither: ad hoc or direct link
+export const DIR_TO_AP = 1; // ToDS: station -> AP
+export const DIR_FROM_AP = 2; // FromDS: AP -> station
+export const DIR_WDS = 3; // both: AP -> AP (bssid = receiver, src = transmitter)
+
+const FC_RETRY = 1 << 11;
+
+// addr1..addr3 index of bssid / src / dst per direction
+const BSSID_ADDR = [2, 0, 1, 0];
+const SRC_ADDR = [1, 1, 2, 1];
+const DST_ADDR = [0, 2, 0, 2];
+
+const KEY_WORDS = 6; // [bssidHi, bssidLo, srcHi, srcLo, dstHi, dstLo]
+const MIN_LEN = 24; // data header through addr3 and sequence control
+const MAX_LOAD = 0.7;
+
+export interface Flow {
+  id: number;
+  bssid: number;
+  src: number;
+  dst: number;
+  direction: number;
+  /** Frames and bytes (on-air length) in the queried range, or in total. */
+  frames: number;
+  bytes: number;
+  retries: number;
+  retryRate: number;
+  firstSeenMs: number;
+  lastSeenMs: number;
+}
+
+export interface FlowTableOptions {
+  /** Width of one history bucket (default 1000 ms). */
+  bucketMs?: number;
+  /** History buckets kept; older ones are recycled (default 300). */
+  historyBuckets?: number;
+  /** Initial flow capacity; grows by doubling (default 4096). */
+  capacity?: number;
+}
+
+/** Flows touched in one history bucket, with their counts in it. */
+interface Bucket {
+  id: number;
+  count: number;
+  flow: Uint32Array;
+  frames: Uint32Array;
+  bytes: Float64Array;
+}
+
+/**
+ * Accumulates data frames into flows keyed by (BSSID, source, destination,
+ * direction).
+ *
+ * Flows are stored as typed-array columns in insertion order (a flow's id is
+ * its index) behind an open-addressing hash index with linear probing.
+ * `addBatch` hashes the keys of a whole `FrameBatch` in one pass before
+ * probing, so the hashing loop runs over plain columns.
+ *
+ * Totals cover the table's lifetime. Per-bucket counts are kept in a ring of
+ * `historyBuckets` buckets of `bucketMs` for time-range queries; times are
+ * host milliseconds supplied by the caller.
+ */
+export class FlowTable {
+  size = 0;
+  readonly bucketMs: number;
+
+  // flow columns
+  frames: Uint32Array;
+  bytes: Float64Array;
+  retries: Uint32Array;
+  firstSeenMs: Float64Array;
+  lastSeenMs: Float64Array;
+  private _keys: Uint32Array;
+  private _dir: Uint8Array;
+  private _hash: Uint32Array;
+  private _bucket: Float64Array; // history bucket id of the flow's latest entry
+  private _entry: Uint32Array; // its index in that bucket
+
+  // hash index: flow id + 1, 0 = empty
+  private _slots: Uint32Array;
+
+  private _ring: Bucket[];
+
+  // per-batch scratch
+  private _sIdx = new Uint32Array(256);
+  private _sHash = new Uint32Array(256);
+  private _sKey = new Uint32Array(256 * KEY_WORDS);
+
+  constructor(options: FlowTableOptions = {}) {
+    this.bucketMs = options.bucketMs ?? 1000;
+    const capacity = Math.max(16, options.capacity ?? 4096);
+    this.frames = new Uint32Array(capacity);
+    this.bytes = new Float64Array(capacity);
+    this.retries = new Uint32Array(capacity);
+    this.firstSeenMs = new Float64Array(capacity);
+    this.lastSeenMs = new Float64Array(capacity);
+    this._keys = new Uint32Array(capacity * KEY_WORDS);
+    this._dir = new Uint8Array(capacity);
+    this._hash = new Uint32Array(capacity);
+    this._bucket = new Float64Array(capacity).fill(-1);
+    this._entry = new Uint32Array(capacity);
+    this._slots = new Uint32Array(slotsFor(capacity));
+    this._ring = Array.from({ length: options.historyBuckets ?? 300 }, () => ({
+      id: -1,
+      count: 0,
+      flow: new Uint32Array(64),
+      frames: new Uint32Array(64),
+      bytes: new Float64Array(64),
+    }));
+  }
+
+  /** Account the data frames of a batch, all seen at `nowMs`. */
+  addBatch(batch: FrameBatch, nowMs: number = Date.now()): void {
+    const n = batch.count;
+    if (n > this._sIdx.length) {
+      const cap = 1 << Math.ceil(Math.log2(n));
+      this._sIdx = new Uint32Array(cap);
+      this._sHash = new Uint32Array(cap);
+      this._sKey = new Uint32Array(cap * KEY_WORDS);
+    }
+    const sIdx = this._sIdx;
+    const sHash = this._sHash;
+    const sKey = this._sKey;
+    const fc = batch.frameControl;
+    const macs = batch.macs;
+    const offsets = batch.offsets;
+
+    // pass 1: pick data frames, gather their keys and hash them
+    let m = 0;
+    for (let i = 0; i < n; i++) {
+      const c = fc[i];
+      if (((c >> 2) & 0x03) !== FRAME_TYPE_DATA || offsets[i + 1] - offsets[i] < MIN_LEN) continue;
+      const dir = (c >> 8) & 0x03;
+      const base = i * MAC_STRIDE;
+      const b = base + BSSID_ADDR[dir] * 2;
+      const s = base + SRC_ADDR[dir] * 2;
+      const d = base + DST_ADDR[dir] * 2;
+      const k = m * KEY_WORDS;
+      sKey[k] = macs[b];
+      sKey[k + 1] = macs[b + 1];
+      sKey[k + 2] = macs[s];
+      sKey[k + 3] = macs[s + 1];
+      sKey[k + 4] = macs[d];
+      sKey[k + 5] = macs[d + 1];
+      let h = mix(0x9747b28c ^ dir, macs[b]);
+      h = mix(h, macs[b + 1]);
+      h = mix(h, macs[s]);
+      h = mix(h, macs[s + 1]);
+      h = mix(h, macs[d]);
+      h = mix(h, macs[d + 1]);
+      sHash[m] = fmix(h);
+      sIdx[m] = i;
+      m++;
+    }
+    if (m === 0) return;
+
+    // pass 2: probe, insert and accumulate
+    const bucket = this._bucketFor(nowMs);
+    const meta = batch.meta;
+    for (let j = 0; j < m; j++) {
+      const i = sIdx[j];
+      const c = fc[i];
+      const mo = i * META_SIZE;
+      const origLen = meta[mo + 14] | (meta[mo + 15] << 8);
+      const len = origLen || offsets[i + 1] - offsets[i];
+      const f = this._find(sKey, j * KEY_WORDS, (c >> 8) & 0x03, sHash[j], nowMs);
+      this.frames[f]++;
+      this.bytes[f] += len;
+      if (c & FC_RETRY) this.retries[f]++;
+      this.lastSeenMs[f] = nowMs;
+      if (bucket) this._record(bucket, f, len);
+    }
+  }
+
+  /** Account one data frame (`bytes` on air). */
+  add(
+    bssid: number,
+    src: number,
+    dst: number,
+    direction: number,
+    bytes: number,
+    retry: boolean = false,
+    nowMs: number = Date.now()
+  ): number {
+    const k = this._sKey;
+    setKey(k, 0, bssid, src, dst);
+    let h = mix(0x9747b28c ^ direction, k[0]);
+    for (let w = 1; w < KEY_WORDS; w++) h = mix(h, k[w]);
+    const f = this._find(k, 0, direction, fmix(h), nowMs);
+    this.frames[f]++;
+    this.bytes[f] += bytes;
+    if (retry) this.retries[f]++;
+    this.lastSeenMs[f] = nowMs;
+    const bucket = this._bucketFor(nowMs);
+    if (bucket) this._record(bucket, f, bytes);
+    return f;
+  }
+
+  /** Id of a flow, or -1 if it has not been seen. */
+  lookup(bssid: number, src: number, dst: number, direction: number): number {
+    const k = new Uint32Array(KEY_WORDS);
+    setKey(k, 0, bssid, src, dst);
+    let h = mix(0x9747b28c ^ direction, k[0]);
+    for (let w = 1; w < KEY_WORDS; w++) h = mix(h, k[w]);
+    h = fmix(h);
+    const slots = this._slots;
+    const mask = slots.length - 1;
+    for (let p = h & mask; ; p = (p + 1) & mask) {
+      const s = slots[p];
+      if (s === 0) return -1;
+      if (this._matches(s - 1, k, 0, direction, h)) return s - 1;
+    }
+  }
+
+  /** Flow `id` with its lifetime totals. */
+  flow(id: number): Flow {
+    return this._flow(id, this.frames[id], this.bytes[id]);
+  }
+
+  /**
+   * The `k` flows with the most bytes (or frames), largest first. With
+   * `sinceMs` / `untilMs`, counts are those of the history buckets that
+   * overlap the range, so it is rounded out to whole buckets.
+   */
+  topK(
+    k: number,
+    options: { by?: "bytes" | "frames"; sinceMs?: number; untilMs?: number } = {}
+  ): Flow[] {
+    const byBytes = (options.by ?? "bytes") === "bytes";
+    let frames: ArrayLike<number> = this.frames;
+    let bytes: ArrayLike<number> = this.bytes;
+    let ids: ArrayLike<number> | null = null;
+    let n = this.size;
+    if (options.sinceMs !== undefined || options.untilMs !== undefined) {
+      const r = this._range(options.sinceMs ?? -Infinity, options.untilMs ?? Infinity);
+      frames = r.frames;
+      bytes = r.bytes;
+      ids = r.ids;
+      n = r.ids.length;
+    }
+    const value = byBytes ? bytes : frames;
+
+    // min-heap of the best k ids seen so far
+    const heap = new Uint32Array(Math.min(k, n));
+    let h = 0;
+    for (let j = 0; j < n; j++) {
+      const id = ids ? ids[j] : j;
+      const v = value[id];
+      if (h < heap.length) {
+        let c = h++;
+        while (c > 0) {
+          const p = (c - 1) >> 1;
+          if (value[heap[p]] <= v) break;
+          heap[c] = heap[p];
+          c = p;
+        }
+        heap[c] = id;
+      } else if (h > 0 && v > value[heap[0]]) {
+        let c = 0;
+        for (;;) {
+          let l = 2 * c + 1;
+          if (l >= h) break;
+          if (l + 1 < h && value[heap[l + 1]] < value[heap[l]]) l++;
+          if (value[heap[l]] >= v) break;
+          heap[c] = heap[l];
+          c = l;
+        }
+        heap[c] = id;
+      }
+    }
+
+    const out = Array.from(heap.subarray(0, h), (id) => this._flow(id, frames[id], bytes[id]));
+    return out.sort((a, b) => (byBytes ? b.bytes - a.bytes : b.frames - a.frames));
+  }
+
+  /** Frames and bytes of all flows in a time range (rounded out to buckets). */
+  totals(sinceMs: number = -Infinity, untilMs: number = Infinity): { frames: number; bytes: number } {
+    let frames = 0;
+    let bytes = 0;
+    this._eachBucket(sinceMs, untilMs, (b) => {
+      for (let e = 0; e < b.count; e++) {
+        frames += b.frames[e];
+        bytes += b.bytes[e];
+      }
+    });
+    return { frames, bytes };
+  }
+
+  /** Start of the oldest history bucket still held, or null if none. */
+  get historyStartMs(): number | null {
+    let oldest = Infinity;
+    for (const b of this._ring) if (b.id >= 0 && b.id < oldest) oldest = b.id;
+    return oldest === Infinity ? null : oldest * this.bucketMs;
+  }
+
+  clear(): void {
+    this.size = 0;
+    this._slots.fill(0);
+    this._bucket.fill(-1);
+    for (const b of this._ring) {
+      b.id = -1;
+      b.count = 0;
+    }
+  }
+
+  // ---- internal ----
+
+  private _find(key: Uint32Array, off: number, dir: number, h: number, nowMs: number): number {
+    const slots = this._slots;
+    const mask = slots.length - 1;
+    let p = h & mask;
+    for (;;) {
+      const s = slots[p];
+      if (s === 0) break;
+      if (this._matches(s - 1, key, off, dir, h)) return s - 1;
+      p = (p + 1) & mask;
+    }
+
+    const f = this.size;
+    if (f === this.frames.length) this._grow(f * 2);
+    this._keys.set(key.subarray(off, off + KEY_WORDS), f * KEY_WORDS);
+    this._dir[f] = dir;
+    this._hash[f] = h;
+    this.frames[f] = 0;
+    this.bytes[f] = 0;
+    this.retries[f] = 0;
+    this.firstSeenMs[f] = nowMs;
+    this._bucket[f] = -1;
+    this.size = f + 1;
+
+    if (this.size > this._slots.length * MAX_LOAD) {
+      this._rehash(this._slots.length * 2);
+    } else {
+      slots[p] = f + 1;
+    }
+    return f;
+  }
+
+  private _matches(f: number, key: Uint32Array, off: number, dir: number, h: number): boolean {
+    if (this._hash[f] !== h || this._dir[f] !== dir) return false;
+    const keys = this._keys;
+    const k = f * KEY_WORDS;
+    return (
+      keys[k] === key[off] &&
+      keys[k + 1] === key[off + 1] &&
+      keys[k + 2] === key[off + 2] &&
+      keys[k + 3] === key[off + 3] &&
+      keys[k + 4] === key[off + 4] &&
+      keys[k + 5] === key[off + 5]
+    );
+  }
+
+  private _rehash(nslots: number): void {
+    const slots = new Uint32Array(nslots);
+    const mask = nslots - 1;
+    for (let f = 0; f < this.size; f++) {
+      let p = this._hash[f] & mask;
+      while (slots[p] !== 0) p = (p + 1) & mask;
+      slots[p] = f + 1;
+    }
+    this._slots = slots;
+  }
+
+  private _grow(capacity: number): void {
+    this.frames = grow(this.frames, capacity);
+    this.bytes = grow(this.bytes, capacity);
+    this.retries = grow(this.retries, capacity);
+    this.firstSeenMs = grow(this.firstSeenMs, capacity);
+    this.lastSeenMs = grow(this.lastSeenMs, capacity);
+    this._keys = grow(this._keys, capacity * KEY_WORDS);
+    this._dir = grow(this._dir, capacity);
+    this._hash = grow(this._hash, capacity);
+    this._bucket = grow(this._bucket, capacity);
+    this._entry = grow(this._entry, capacity);
+  }
+
+  /** History bucket for a time, recycling the ring slot; null if too old. */
+  private _bucketFor(nowMs: number): Bucket | null {
+    const id = Math.floor(nowMs / this.bucketMs);
+    const b = this._ring[id % this._ring.length];
+    if (b.id === id) return b;
+    if (b.id > id) return null;
+    b.id = id;
+    b.count = 0;
+    return b;
+  }
+
+  private _record(b: Bucket, f: number, bytes: number): void {
+    let e = this._entry[f];
+    if (this._bucket[f] !== b.id) {
+      e = b.count++;
+      if (e === b.flow.length) {
+        b.flow = grow(b.flow, e * 2);
+        b.frames = grow(b.frames, e * 2);
+        b.bytes = grow(b.bytes, e * 2);
+      }
+      b.flow[e] = f;
+      b.frames[e] = 0;
+      b.bytes[e] = 0;
+      this._bucket[f] = b.id;
+      this._entry[f] = e;
+    }
+    b.frames[e]++;
+    b.bytes[e] += bytes;
+  }
+
+  private _eachBucket(sinceMs: number, untilMs: number, fn: (b: Bucket) => void): void {
+    const lo = Math.floor(sinceMs / this.bucketMs);
+    const hi = Math.ceil(untilMs / this.bucketMs);
+    for (const b of this._ring) if (b.id >= 0 && b.id >= lo && b.id < hi) fn(b);
+  }
+
+  private _range(sinceMs: number, untilMs: number) {
+    const frames = new Float64Array(this.size);
+    const bytes = new Float64Array(this.size);
+    const ids: number[] = [];
+    this._eachBucket(sinceMs, untilMs, (b) => {
+      for (let e = 0; e < b.count; e++) {
+        const f = b.flow[e];
+        if (frames[f] === 0) ids.push(f);
+        frames[f] += b.frames[e];
+        bytes[f] += b.bytes[e];
+      }
+    });
+    return { frames, bytes, ids };
+  }
+
+  private _flow(id: number, frames: number, bytes: number): Flow {
+    const k = id * KEY_WORDS;
+    const keys = this._keys;
+    return {
+      id,
+      bssid: keys[k] * 0x100000000 + keys[k + 1],
+      src: keys[k + 2] * 0x100000000 + keys[k + 3],
+      dst: keys[k + 4] * 0x100000000 + keys[k + 5],
+      direction: this._dir[id],
+      frames,
+      bytes,
+      retries: this.retries[id],
+      retryRate: this.frames[id] ? this.retries[id] / this.frames[id] : 0,
+      firstSeenMs: this.firstSeenMs[id],
+      lastSeenMs: this.lastSeenMs[id],
+    };
+  }
+}
+
+function slotsFor(capacity: number): number {
+  return 1 << Math.ceil(Math.log2(capacity / MAX_LOAD));
+}
+
+function setKey(k: Uint32Array, off: number, bssid: number, src: number, dst: number): void {
+  const macs = [bssid, src, dst];
+  for (let a = 0; a < 3; a++) {
+    k[off + a * 2] = Math.floor(macs[a] / 0x100000000);
+    k[off + a * 2 + 1] = macs[a] >>> 0;
+  }
+}
+
+// MurmurHash3 (x86, 32-bit) block mix and finalizer
+function mix(h: number, k: number): number {
+  k = Math.imul(k, 0xcc9e2d51);
+  k = (k << 15) | (k >>> 17);
+  k = Math.imul(k, 0x1b873593);
+  h ^= k;
+  h = (h << 13) | (h >>> 19);
+  return (Math.imul(h, 5) + 0xe6546b64) | 0;
+}
+
+function fmix(h: number): number {
+  h ^= h >>> 16;
+  h = Math.imul(h, 0x85ebca6b);
+  h ^= h >>> 13;
+  h = Math.imul(h, 0xc2b2ae35);
+  h ^= h >>> 16;
+  return h >>> 0;
+}
+
+function grow<T extends Uint8Array | Uint32Array | Float64Array>(a: T, n: number): T {
+  const b = new (a.constructor as { new (n: number): T })(n);
+  b.set(a.subarray(0, Math.min(a.length, n)));
+  return b;
+}
@@ -1,8 +1,10 @@
 /** 802.11 frame class with lazy parsing of header fields and IEs. */
 
+import { macAt, macStr } from "./mac.js";
+
 // metadata struct: <IHBbbBBBHH  (16 bytes)
 //   u32 timestamp_us, u16 frame_len, u8 channel, i8 rssi, i8 noise_floor,
-//   u8 pkt_type, u8 rx_state, u8 rate, u16 seq_num, u16 reserved
+//   u8 pkt_type, u8 rx_state, u8 rate, u16 seq_num, u16 orig_len
 export const META_SIZE = 16;
 
 // 802.11 frame types
@@ -44,10 +46,12 @@ export class Frame {
   readonly rxState: number;
   readonly rate: number;
   readonly seqNum: number;
+  /** Length on air if the hop's snaplen cut the frame, else 0. */
+  readonly origLen: number;
   readonly raw: Uint8Array;
 
-  // lazy cache
-  private _cache = new Map<string, unknown>();
+  // lazy cache (allocated on first lazy access)
+  private _cache: Map<string, unknown> | null = null;
 
   constructor(meta: Uint8Array, raw: Uint8Array) {
     const v = new DataView(meta.buffer, meta.byteOffset, meta.byteLength);
@@ -60,14 +64,15 @@ export class Frame {
     this.rxState = v.getUint8(10);
     this.rate = v.getUint8(11);
     this.seqNum = v.getUint16(12, true);
-    // bytes 14-15: reserved
+    this.origLen = v.getUint16(14, true);
     this.raw = raw;
   }
 
   // helpers for lazy properties
 
   private _lazy<T>(key: string, fn: () => T): T {
-    if (this._cache.has(key)) return this._cache.get(key) as T;
+    if (this._cache === null) this._cache = new Map();
+    else if (this._cache.has(key)) return this._cache.get(key) as T;
     const val = fn();
     this._cache.set(key, val);
     return val;
@@ -111,21 +116,21 @@ export class Frame {
     });
   }
 
-  get addr1(): Uint8Array | null {
+  get addr1(): number | null {
     return this._lazy("a1", () =>
-      this.raw.length < 10 ? null : this.raw.slice(4, 10)
+      this.raw.length < 10 ? null : macAt(this.raw, 4)
     );
   }
 
-  get addr2(): Uint8Array | null {
+  get addr2(): number | null {
     return this._lazy("a2", () =>
-      this.raw.length < 16 ? null : this.raw.slice(10, 16)
+      this.raw.length < 16 ? null : macAt(this.raw, 10)
     );
   }
 
-  get addr3(): Uint8Array | null {
+  get addr3(): number | null {
     return this._lazy("a3", () =>
-      this.raw.length < 22 ? null : this.raw.slice(16, 22)
+      this.raw.length < 22 ? null : macAt(this.raw, 16)
     );
   }
 
@@ -155,7 +160,7 @@ export class Frame {
 
   //  derived addresses
 
-  get bssid(): Uint8Array | null {
+  get bssid(): number | null {
     return this._lazy("bssid", () => {
       if (this.frameType === FRAME_TYPE_MGMT) return this.addr3;
       if (!this.toDs && !this.fromDs) return this.addr3;
@@ -165,19 +170,19 @@ export class Frame {
     });
   }
 
-  get src(): Uint8Array | null {
+  get src(): number | null {
     return this._lazy("src", () => {
       if (this.frameType === FRAME_TYPE_MGMT) return this.addr2;
       if (!this.toDs && !this.fromDs) return this.addr2;
       if (!this.toDs && this.fromDs) return this.addr3;
       if (this.toDs && !this.fromDs) return this.addr2;
       // WDS: addr4 at offset 24
-      if (this.raw.length >= 30) return this.raw.slice(24, 30);
+      if (this.raw.length >= 30) return macAt(this.raw, 24);
       return null;
     });
   }
 
-  get dst(): Uint8Array | null {
+  get dst(): number | null {
     return this._lazy("dst", () => {
       if (this.frameType === FRAME_TYPE_MGMT) return this.addr1;
       if (!this.toDs && !this.fromDs) return this.addr1;
@@ -254,11 +259,8 @@ export class Frame {
     return SubTypeName[subType as keyof typeof SubTypeName] ?? subType;
   }
 
-  static macStr(addr: Uint8Array | null): string {
-    if (addr === null) return "??:??:??:??:??:??";
-    return Array.from(addr)
-      .map((b) => b.toString(16).padStart(2, "0"))
-      .join(":");
+  static macStr(addr: number | null): string {
+    return macStr(addr);
   }
 
   toString(): string {
@@ -5,9 +5,65 @@ export {
   FILTER_MGMT,
   FILTER_CTRL,
   FILTER_DATA,
+  MAX_HOPS,
+  BULK_KIND_SCHEDULE,
+  BULK_KIND_MAC_FILTER,
+  BULK_KIND_CLASSIFIER,
+  MACFILT_OFF,
+  MACFILT_ALLOW,
+  MACFILT_DENY,
+  LOSS_REASON_NAMES,
+  HOP_GUARD_OFF,
+  HOP_GUARD_DROP,
+  HOP_GUARD_RELABEL,
+  HOP_GUARD_MAX_US,
+  SYNTH_DIST_FIXED,
+  SYNTH_DIST_UNIFORM,
+  SYNTH_DIST_IMIX,
+  SYNTH_MAX_RATE,
+  PING_MAX_ECHO,
+  PROBE_MAX_SSIDS,
+  PROBE_MAX_RATE,
 } from "./client.js";
-export type { SnifferClientOptions } from "./client.js";
+export type { SnifferClientOptions, SnifferStats, HopStats, Hop, Pong } from "./client.js";
 export { Frame, META_SIZE } from "./frame.js";
+export { BleAdv, BLE_META_SIZE } from "./ble.js";
+export {
+  Anomaly,
+  ANOMALY_SIZE,
+  ANOMALY_DEAUTH_FLOOD,
+  REASON_NAMES,
+} from "./anomaly.js";
+export {
+  CsiReport,
+  CSI_SIZE,
+  CSI_BITS_8,
+  CSI_BITS_4,
+  CSI_MAX_MATCH,
+  csiPackedLen,
+} from "./csi.js";
+export { Detection, DETECTION_SIZE } from "./classify.js";
+export { FrameBatch, MAC_STRIDE } from "./batch.js";
+export {
+  FlowTable,
+  DIR_DIRECT,
+  DIR_TO_AP,
+  DIR_FROM_AP,
+  DIR_WDS,
+} from "./flows.js";
+export type { Flow, FlowTableOptions } from "./flows.js";
+export { ChannelOccupancy, OCC_CHANNELS, OCC_NO_RSSI } from "./occupancy.js";
+export type { ChannelOccupancyOptions } from "./occupancy.js";
+export {
+  BROADCAST,
+  macAt,
+  macToBytes,
+  macParse,
+  macStr,
+  oui,
+  isMulticast,
+  isLocal,
+} from "./mac.js";
 export {
   FRAME_TYPE_MGMT,
   FRAME_TYPE_CTRL,
@@ -19,4 +75,9 @@ export {
   SUBTYPE_BEACON,
   SUBTYPE_DEAUTH,
 } from "./frame.js";
-export { encode as cobsEncode, decode as cobsDecode } from "./cobs.js";
+export { crc32 } from "./crc32.js";
+export {
+  encode as cobsEncode,
+  decode as cobsDecode,
+  decodeInto as cobsDecodeInto,
+} from "./cobs.js";
@@ -0,0 +1,73 @@
+/**
+ * MAC addresses as 48-bit numbers.
+ *
+ * Numbers are exact up to 2^53, compare with `===`, and make cheap Map keys
+ * (no per-address Uint8Array or string). The most significant byte is the
+ * first byte on the wire, so `oui()` is the top 24 bits.
+ */
+
+export const BROADCAST = 0xffffffffffff;
+
+const TWO_32 = 0x100000000;
+const TWO_40 = 0x10000000000;
+
+// formatted strings, shared between all callers; reset when it gets large
+const STR_CACHE = new Map<number, string>();
+const STR_CACHE_MAX = 1 << 16;
+
+const UNKNOWN_STR = "??:??:??:??:??:??";
+
+/** Read the 6-byte address at `buf[offset..offset + 6]` without copying. */
+export function macAt(buf: Uint8Array, offset: number): number {
+  const hi = (buf[offset] << 8) | buf[offset + 1];
+  const lo =
+    ((buf[offset + 2] << 24) |
+      (buf[offset + 3] << 16) |
+      (buf[offset + 4] << 8) |
+      buf[offset + 5]) >>>
+    0;
+  return hi * TWO_32 + lo;
+}
+
+export function macToBytes(mac: number): Uint8Array {
+  const out = new Uint8Array(6);
+  let v = mac;
+  for (let i = 5; i >= 0; i--) {
+    out[i] = v % 256;
+    v = Math.floor(v / 256);
+  }
+  return out;
+}
+
+/** Parse `"aa:bb:cc:dd:ee:ff"` (or `-` / no separators). */
+export function macParse(text: string): number {
+  return parseInt(text.replace(/[:-]/g, ""), 16);
+}
+
+/** Format as `"aa:bb:cc:dd:ee:ff"`; repeated addresses hit a cache. */
+export function macStr(mac: number | null): string {
+  if (mac === null || mac < 0) return UNKNOWN_STR;
+  let s = STR_CACHE.get(mac);
+  if (s === undefined) {
+    const h = mac.toString(16).padStart(12, "0");
+    s = `${h.slice(0, 2)}:${h.slice(2, 4)}:${h.slice(4, 6)}:${h.slice(6, 8)}:${h.slice(8, 10)}:${h.slice(10, 12)}`;
+    if (STR_CACHE.size >= STR_CACHE_MAX) STR_CACHE.clear();
+    STR_CACHE.set(mac, s);
+  }
+  return s;
+}
+
+/** Organizationally unique identifier (top 24 bits). */
+export function oui(mac: number): number {
+  return Math.floor(mac / 0x1000000);
+}
+
+/** Group bit (I/G) of the first octet; includes broadcast. */
+export function isMulticast(mac: number): boolean {
+  return (Math.floor(mac / TWO_40) & 0x01) !== 0;
+}
+
+/** Locally administered bit (U/L), e.g. randomized client addresses. */
+export function isLocal(mac: number): boolean {
+  return (Math.floor(mac / TWO_40) & 0x02) !== 0;
+}
@@ -0,0 +1,179 @@
+/** Per-channel activity in fixed time buckets, for waterfall and bar views. */
+
+import { FrameBatch } from "./batch.js";
+import { META_SIZE } from "./frame.js";
+
+/** Channels tracked: 0 (synthetic frames) through 14. */
+export const OCC_CHANNELS = 15;
+
+/** `maxRssi` of a bucket without frames. */
+export const OCC_NO_RSSI = -128;
+
+export interface ChannelOccupancyOptions {
+  /** Width of one bucket (default 100 ms). */
+  bucketMs?: number;
+  /** Buckets kept; older ones are recycled (default 600, one minute). */
+  historyBuckets?: number;
+  /** Detection markers kept; older ones are overwritten (default 256). */
+  maxMarkers?: number;
+}
+
+/**
+ * Frames, bytes (on-air length) and max RSSI per channel per time bucket.
+ *
+ * Storage is fixed at construction: a ring of `historyBuckets` rows of
+ * `OCC_CHANNELS` cells, as typed-array columns indexed by
+ * `row * OCC_CHANNELS + channel`. `addBatch` touches only the current row,
+ * and a view reads at most the whole ring, so drawing costs the same at any
+ * ingest rate. Times are host milliseconds supplied by the caller.
+ *
+ * Detection markers (a time, a channel and a caller-defined kind) are kept
+ * in a ring of their own for overlays.
+ */
+export class ChannelOccupancy {
+  readonly bucketMs: number;
+  readonly historyBuckets: number;
+
+  frames: Uint32Array;
+  bytes: Float64Array;
+  maxRssi: Int8Array;
+
+  /** Newest bucket id written (`floor(ms / bucketMs)`), -1 before any. */
+  latest = -1;
+  /** Incremented on every change, so a view can skip redrawing. */
+  version = 0;
+
+  markerMs: Float64Array;
+  markerChannel: Uint8Array;
+  markerKind: Uint8Array;
+  /** Markers held, up to `markerMs.length`. */
+  markerCount = 0;
+  private _markerNext = 0;
+
+  private _ids: Float64Array; // bucket id held by each row, -1 = empty
+
+  constructor(options: ChannelOccupancyOptions = {}) {
+    this.bucketMs = options.bucketMs ?? 100;
+    this.historyBuckets = Math.max(1, options.historyBuckets ?? 600);
+    const cells = this.historyBuckets * OCC_CHANNELS;
+    this.frames = new Uint32Array(cells);
+    this.bytes = new Float64Array(cells);
+    this.maxRssi = new Int8Array(cells).fill(OCC_NO_RSSI);
+    this._ids = new Float64Array(this.historyBuckets).fill(-1);
+    const markers = Math.max(1, options.maxMarkers ?? 256);
+    this.markerMs = new Float64Array(markers);
+    this.markerChannel = new Uint8Array(markers);
+    this.markerKind = new Uint8Array(markers);
+  }
+
+  /** Account every frame of a batch, all seen at `nowMs`. */
+  addBatch(batch: FrameBatch, nowMs: number = Date.now()): void {
+    const n = batch.count;
+    if (n === 0) return;
+    const row = this._rowFor(nowMs);
+    if (row < 0) return;
+    const base = row * OCC_CHANNELS;
+    const channel = batch.channel;
+    const rssi = batch.rssi;
+    const meta = batch.meta;
+    const offsets = batch.offsets;
+    const frames = this.frames;
+    const bytes = this.bytes;
+    const maxRssi = this.maxRssi;
+    for (let i = 0; i < n; i++) {
+      const ch = channel[i];
+      if (ch >= OCC_CHANNELS) continue;
+      const c = base + ch;
+      const mo = i * META_SIZE;
+      const origLen = meta[mo + 14] | (meta[mo + 15] << 8);
+      frames[c]++;
+      bytes[c] += origLen || offsets[i + 1] - offsets[i];
+      if (rssi[i] > maxRssi[c]) maxRssi[c] = rssi[i];
+    }
+    this.version++;
+  }
+
+  /** Account one frame of `bytes` on air. */
+  add(channel: number, bytes: number, rssi: number, nowMs: number = Date.now()): void {
+    if (channel < 0 || channel >= OCC_CHANNELS) return;
+    const row = this._rowFor(nowMs);
+    if (row < 0) return;
+    const c = row * OCC_CHANNELS + channel;
+    this.frames[c]++;
+    this.bytes[c] += bytes;
+    if (rssi > this.maxRssi[c]) this.maxRssi[c] = rssi;
+    this.version++;
+  }
+
+  /** Record a detection marker (e.g. an anomaly's kind) on a channel. */
+  mark(channel: number, kind: number, nowMs: number = Date.now()): void {
+    const m = this._markerNext;
+    this.markerMs[m] = nowMs;
+    this.markerChannel[m] = channel;
+    this.markerKind[m] = kind;
+    this._markerNext = (m + 1) % this.markerMs.length;
+    if (this.markerCount < this.markerMs.length) this.markerCount++;
+    this.version++;
+  }
+
+  /** Ring row holding bucket `id`, or -1 if it was never written or has been recycled. */
+  row(id: number): number {
+    if (id < 0) return -1;
+    const r = id % this.historyBuckets;
+    return this._ids[r] === id ? r : -1;
+  }
+
+  /** Bucket id for a time. */
+  bucketAt(ms: number): number {
+    return Math.floor(ms / this.bucketMs);
+  }
+
+  /**
+   * Frames, bytes and max RSSI of `channel` summed over buckets
+   * `fromId..toId` inclusive; buckets no longer held count as empty.
+   */
+  sum(channel: number, fromId: number, toId: number): { frames: number; bytes: number; maxRssi: number } {
+    let frames = 0;
+    let bytes = 0;
+    let maxRssi = OCC_NO_RSSI;
+    for (let id = Math.max(fromId, toId - this.historyBuckets + 1); id <= toId; id++) {
+      const r = this.row(id);
+      if (r < 0) continue;
+      const c = r * OCC_CHANNELS + channel;
+      frames += this.frames[c];
+      bytes += this.bytes[c];
+      if (this.maxRssi[c] > maxRssi) maxRssi = this.maxRssi[c];
+    }
+    return { frames, bytes, maxRssi };
+  }
+
+  clear(): void {
+    this.frames.fill(0);
+    this.bytes.fill(0);
+    this.maxRssi.fill(OCC_NO_RSSI);
+    this._ids.fill(-1);
+    this.latest = -1;
+    this.markerCount = 0;
+    this._markerNext = 0;
+    this.version++;
+  }
+
+  /** Row for a time, clearing rows recycled on the way; -1 if older than the ring. */
+  private _rowFor(nowMs: number): number {
+    const id = Math.floor(nowMs / this.bucketMs);
+    if (id > this.latest) {
+      // empty every bucket from the one after the newest through this one
+      const from = Math.max(this.latest + 1, id - this.historyBuckets + 1);
+      for (let b = from; b <= id; b++) {
+        const r = b % this.historyBuckets;
+        const c = r * OCC_CHANNELS;
+        this.frames.fill(0, c, c + OCC_CHANNELS);
+        this.bytes.fill(0, c, c + OCC_CHANNELS);
+        this.maxRssi.fill(OCC_NO_RSSI, c, c + OCC_CHANNELS);
+        this._ids[r] = b;
+      }
+      this.latest = id;
+    }
+    return this.row(id);
+  }
+}
@@ -0,0 +1,166 @@
+#include "protocol.h"
+#include "sdkconfig.h"
+
+#if CONFIG_BT_NIMBLE_ENABLED
+
+#include "esp_timer.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "host/ble_hs.h"
+#include "host/ble_gap.h"
+#include <string.h>
+
+/* -------- state -------- */
+
+static volatile bool  ble_synced = false;
+static uint8_t        own_addr_type;
+
+/* scan at 100% of the window: interval == window, in 0.625 ms units */
+#define BLE_SCAN_ITVL   0x0010
+
+/* -------- dedup (addr + payload hash) -------- */
+
+#define DEDUP_SLOTS     64   /* power of two */
+
+typedef struct {
+    uint32_t hash;
+    uint32_t last_ms;
+} dedup_slot_t;
+
+static dedup_slot_t       dedup[DEDUP_SLOTS];
+static volatile uint16_t  dedup_ms = 1000;
+
+/* FNV-1a over address, address type and advertising data */
+static uint32_t adv_hash(const uint8_t *addr, uint8_t addr_type,
+                         const uint8_t *data, uint8_t len)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ addr[i]) * 16777619u;
+    h = (h ^ addr_type) * 16777619u;
+    for (int i = 0; i < len; i++) h = (h ^ data[i]) * 16777619u;
+    return h ? h : 1; /* 0 marks an empty slot */
+}
+
+/*
+ * Direct-mapped table: a hit within dedup_ms is a duplicate; a miss (or a
+ * colliding hash) simply overwrites the slot, so memory stays fixed.
+ */
+static bool is_duplicate(uint32_t hash, uint32_t now_ms)
+{
+    if (dedup_ms == 0) return false;
+    dedup_slot_t *slot = &dedup[hash & (DEDUP_SLOTS - 1)];
+    if (slot->hash == hash && now_ms - slot->last_ms < dedup_ms) {
+        return true;
+    }
+    slot->hash    = hash;
+    slot->last_ms = now_ms;
+    return false;
+}
+
+void ble_set_dedup_ms(uint16_t ms)
+{
+    dedup_ms = ms;
+    memset(dedup, 0, sizeof(dedup));
+}
+
+/* -------- GAP events -------- */
+
+static int ble_gap_event_cb(struct ble_gap_event *event, void *arg)
+{
+    (void)arg;
+    if (event->type != BLE_GAP_EVENT_DISC) return 0;
+
+    const struct ble_gap_disc_desc *d = &event->disc;
+    uint8_t len = d->length_data > BLE_ADV_MAX_DATA ? BLE_ADV_MAX_DATA
+                                                    : d->length_data;
+    int64_t now_us = esp_timer_get_time();
+
+    uint32_t h = adv_hash(d->addr.val, d->addr.type, d->data, len);
+    if (is_duplicate(h, (uint32_t)(now_us / 1000))) {
+        proto_count_ble_dedup();
+        return 0;
+    }
+
+    ble_adv_meta_t meta = {
+        .timestamp = (uint32_t)now_us,
+        .addr_type = d->addr.type,
+        .rssi      = d->rssi,
+        .adv_type  = d->event_type,
+        .data_len  = len,
+    };
+    memcpy(meta.addr, d->addr.val, sizeof(meta.addr));
+    proto_send_ble_adv(&meta, d->data);
+    return 0;
+}
+
+/* -------- scan windows (called from scan_task) -------- */
+
+void ble_scan_window_start(uint32_t duration_ms)
+{
+    if (!ble_synced) return;
+    struct ble_gap_disc_params params = {
+        .itvl              = BLE_SCAN_ITVL,
+        .window            = BLE_SCAN_ITVL,
+        .filter_policy     = 0,
+        .limited           = 0,
+        .passive           = 1,
+        .filter_duplicates = 0,   /* dedup is ours, with a time window */
+    };
+    ble_gap_disc(own_addr_type, (int32_t)duration_ms, &params,
+                 ble_gap_event_cb, NULL);
+}
+
+void ble_scan_window_stop(void)
+{
+    if (ble_synced && ble_gap_disc_active()) {
+        ble_gap_disc_cancel();
+    }
+}
+
+/* -------- host stack -------- */
+
+static void ble_on_sync(void)
+{
+    if (ble_hs_id_infer_auto(0, &own_addr_type) == 0) {
+        ble_synced = true;
+    }
+}
+
+static void ble_on_reset(int reason)
+{
+    (void)reason;
+    ble_synced = false;
+}
+
+static void ble_host_task(void *arg)
+{
+    (void)arg;
+    nimble_port_run();
+    nimble_port_freertos_deinit();
+}
+
+bool ble_init(void)
+{
+    if (nimble_port_init() != ESP_OK) return false;
+    ble_hs_cfg.sync_cb  = ble_on_sync;
+    ble_hs_cfg.reset_cb = ble_on_reset;
+    nimble_port_freertos_init(ble_host_task);
+    return true;
+}
+
+bool ble_available(void)
+{
+    return ble_synced;
+}
+
+#else /* !CONFIG_BT_NIMBLE_ENABLED */
+
+/* BLE not built in: the scheduler never gets a BLE window */
+
+bool ble_init(void) { return false; }
+bool ble_available(void) { return false; }
+void ble_set_dedup_ms(uint16_t ms) { (void)ms; }
+void ble_scan_window_start(uint32_t duration_ms) { (void)duration_ms; }
+void ble_scan_window_stop(void) { }
+
+#endif
@@ -0,0 +1,76 @@
+#include "bulk.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* nibble-at-a-time table: 64 bytes instead of 1 KB, fast enough for 48 KB */
+static const uint32_t crc_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0x0F];
+    }
+    return crc;
+}
+
+uint32_t bulk_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    return ~crc_update(~crc, data, len);
+}
+
+bulk_status_t bulk_begin(bulk_t *b, uint8_t kind, uint32_t total, uint32_t crc)
+{
+    bulk_abort(b);
+    if (kind < BULK_KIND_SCHEDULE || kind > BULK_KIND_CLASSIFIER) return BULK_ERR_KIND;
+    if (total == 0 || total > BULK_MAX_LEN) return BULK_ERR_TOO_LARGE;
+    b->buf = malloc(total);
+    if (!b->buf) return BULK_ERR_NO_MEMORY;
+    b->kind       = kind;
+    b->total      = total;
+    b->received   = 0;
+    b->crc_expect = crc;
+    b->crc        = 0xFFFFFFFFu;
+    return BULK_OK;
+}
+
+uint32_t bulk_chunk(bulk_t *b, uint32_t offset, const uint8_t *data, size_t len)
+{
+    if (!b->buf) return 0;
+    if (offset != b->received || len > b->total - b->received) return b->received;
+    memcpy(b->buf + offset, data, len);
+    b->crc = crc_update(b->crc, data, len);
+    b->received += (uint32_t)len;
+    return b->received;
+}
+
+bulk_status_t bulk_commit(bulk_t *b, uint8_t **out, uint32_t *out_len)
+{
+    if (!b->buf) return BULK_ERR_NOT_ACTIVE;
+    bulk_status_t st = BULK_OK;
+    if (b->received != b->total) {
+        st = BULK_ERR_INCOMPLETE;
+    } else if (~b->crc != b->crc_expect) {
+        st = BULK_ERR_CRC;
+    }
+    if (st != BULK_OK) {
+        bulk_abort(b);
+        return st;
+    }
+    *out     = b->buf;
+    *out_len = b->total;
+    b->buf   = NULL;
+    return BULK_OK;
+}
+
+void bulk_abort(bulk_t *b)
+{
+    free(b->buf);
+    memset(b, 0, sizeof(*b));
+}
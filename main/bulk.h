@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ * Chunked transfer of configuration blobs larger than one command.
+ *
+ * A transfer is begun with its total length and CRC-32, fed in-order
+ * chunks (out-of-order or repeated chunks are ignored, so the sender can
+ * simply go back to the acknowledged offset), and committed once complete
+ * and the CRC matches. The CRC is accumulated as chunks arrive, so commit
+ * is O(1).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BULK_MAX_LEN        (48 * 1024)
+
+/* what a blob configures; bulk_begin refuses any other kind */
+#define BULK_KIND_SCHEDULE      0x01    /* same layout as the SET_SCHEDULE payload */
+#define BULK_KIND_MAC_FILTER    0x02    /* see macfilt.h */
+#define BULK_KIND_CLASSIFIER    0x03    /* see classify.h */
+
+typedef enum {
+    BULK_OK = 0,
+    BULK_ERR_TOO_LARGE,
+    BULK_ERR_NO_MEMORY,
+    BULK_ERR_NOT_ACTIVE,
+    BULK_ERR_INCOMPLETE,
+    BULK_ERR_CRC,
+    BULK_ERR_KIND,
+} bulk_status_t;
+
+typedef struct {
+    uint8_t  kind;
+    uint8_t *buf;           /* heap, total bytes */
+    uint32_t total;
+    uint32_t received;      /* contiguous bytes from offset 0 */
+    uint32_t crc_expect;
+    uint32_t crc;           /* running CRC of buf[0:received], pre-inverted */
+} bulk_t;
+
+/* CRC-32 (IEEE 802.3, as zlib.crc32) of len bytes, continuing from crc. */
+uint32_t bulk_crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+/* Start a transfer of a BULK_KIND_* blob, discarding any unfinished one. */
+bulk_status_t bulk_begin(bulk_t *b, uint8_t kind, uint32_t total, uint32_t crc);
+
+/*
+ * Accept a chunk at offset. Only the chunk that continues the contiguous
+ * prefix is stored. Returns the contiguous byte count to acknowledge.
+ */
+uint32_t bulk_chunk(bulk_t *b, uint32_t offset, const uint8_t *data, size_t len);
+
+/*
+ * Finish the transfer. On BULK_OK the blob is handed to the caller
+ * (*out / *out_len, free() it when done); in every case the transfer ends.
+ */
+bulk_status_t bulk_commit(bulk_t *b, uint8_t **out, uint32_t *out_len);
+
+/* Abandon the transfer and free its buffer. */
+void bulk_abort(bulk_t *b);
+
+static inline bool bulk_active(const bulk_t *b)
+{
+    return b->buf != NULL;
+}
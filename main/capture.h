@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+ * Capture path template: the per-frame work of the promiscuous callback,
+ * specialized per feature combination.
+ *
+ * No ESP-IDF dependencies of its own. The including file supplies the state
+ * and hooks below, so the same path is built into the firmware (sniffer.c)
+ * and the host benchmark (bench/capture/path.c).
+ *
+ * cap_run() is always inlined with a constant feature mask, so a variant
+ * only contains the stages its features need. With none, a frame is
+ * checked against the current hop and copied into the TX queue. A stage
+ * that is compiled in still checks its own switch (e.g. the MAC filter's
+ * mode), so a variant with extra features gives the same result, only
+ * slower. CAP_ALL is the generic path the firmware had before variants.
+ *
+ * The includer declares the state before including this file: scanning,
+ * deauth_det, hop_stats, hop_guard, hop_switched_us, cur_hop, prev_hop, clf
+ * (a pointer, used only while clf_on), clf_on and mac_filter. It defines
+ * these macros, used inside cap_run():
+ *   CAP_LOCK(name), CAP_UNLOCK(name)   for deauth, hop, clf and mac
+ *   CAP_NOW_US(), CAP_NOW_MS()         uint32_t clocks
+ *   CAP_SEND_FRAME(f, snaplen)
+ *   CAP_SEND_ANOMALY(report, timestamp)
+ *   CAP_SEND_DETECTION(f, label, x, confidence, suppressed)
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sched.h"
+#include "deauth.h"
+#include "hopstat.h"
+#include "classify.h"
+#include "macfilt.h"
+
+/* features a variant is built with */
+#define CAP_DEAUTH      (1 << 0)    /* deauth flood detector on */
+#define CAP_HOP         (1 << 1)    /* schedule visits more than one channel: settle accounting, guard */
+#define CAP_CLF         (1 << 2)    /* beacon classifier installed */
+#define CAP_PROFILE     (1 << 3)    /* a hop gates by type, mgmt subtype or RSSI */
+#define CAP_MACFILT     (1 << 4)    /* MAC filter installed */
+#define CAP_ALL         0x1F
+
+/*
+ * Variants built, fewest features first; a configuration runs the first one
+ * that covers it. X(name, features) for each.
+ */
+#define CAP_VARIANTS(X)                                         \
+    X(plain,              0)                                    \
+    X(hop,                CAP_HOP)                              \
+    X(deauth,             CAP_DEAUTH)                           \
+    X(deauth_hop,         CAP_DEAUTH | CAP_HOP)                 \
+    X(hop_profile,        CAP_HOP | CAP_PROFILE)                \
+    X(deauth_hop_profile, CAP_DEAUTH | CAP_HOP | CAP_PROFILE)   \
+    X(generic,            CAP_ALL)
+
+/* one received frame, as the path sees it */
+typedef struct {
+    const uint8_t *payload;
+    uint16_t       len;
+    uint8_t        channel;
+    int8_t         rssi;
+    bool           mgmt;        /* delivered as a management frame */
+    uint32_t       timestamp;   /* rx time */
+    const void    *pkt;         /* the driver's packet and type, for the output macros */
+    int            type;
+} cap_frame_t;
+
+/* CAP_HOP and CAP_PROFILE as needed by a hop table. */
+static inline unsigned cap_sched_features(const sched_hop_t *hops, int n)
+{
+    unsigned feats = 0;
+    for (int i = 0; i < n; i++) {
+        if (hops[i].channel != hops[0].channel) feats |= CAP_HOP;
+        if (hops[i].type_mask || hops[i].mgmt_subtypes || hops[i].rssi_min != SCHED_RSSI_ANY)
+            feats |= CAP_PROFILE;
+    }
+    return feats;
+}
+
+/* Index of the first variant in feats[] that covers needed (the last is CAP_ALL). */
+static inline int cap_pick(const unsigned *feats, int n, unsigned needed)
+{
+    int i = 0;
+    while (i < n - 1 && (needed & ~feats[i])) i++;
+    return i;
+}
+
+static inline __attribute__((always_inline)) void cap_run(const cap_frame_t *f, const unsigned feats)
+{
+    if ((feats & CAP_DEAUTH) && f->mgmt && scanning && deauth_is_candidate(f->payload, f->len)) {
+        deauth_report_t report;
+        CAP_LOCK(deauth);
+        int act = deauth_observe(&deauth_det, f->payload, f->len, f->channel, f->rssi,
+                                 CAP_NOW_MS(), &report);
+        CAP_UNLOCK(deauth);
+        if (act & DEAUTH_ACT_REPORT) CAP_SEND_ANOMALY(&report, f->timestamp);
+        if (act & DEAUTH_ACT_SUPPRESS) return;
+    }
+
+    const sched_hop_t *hop = cur_hop;
+    if (!hop || f->len < 1) return;
+
+    /* frames just after a switch may still be in flight from the old channel */
+    if (feats & CAP_HOP) {
+        uint32_t since = CAP_NOW_US() - hop_switched_us;
+        if (since < HOPSTAT_WINDOW_US) {
+            CAP_LOCK(hop);
+            int act = hopstat_observe(&hop_stats, &hop_guard, since, f->channel != hop->channel);
+            CAP_UNLOCK(hop);
+            if (act == HOPSTAT_DROP) return;
+            if (act == HOPSTAT_RELABEL && prev_hop) hop = prev_hop;
+        }
+    }
+
+    /* scored before the capture profile, so beacons need not be forwarded */
+    if (feats & CAP_CLF) {
+        clf_features_t x;
+        if (f->mgmt && clf_on && clf_extract(f->payload, f->len, &x)) {
+            uint16_t suppressed = 0;
+            CAP_LOCK(clf);
+            uint8_t label = clf->model.label;
+            uint8_t conf = clf_score(&clf->model, &x);
+            bool report = conf >= clf->model.threshold &&
+                          clf_admit(clf, f->payload + 10, CAP_NOW_MS(), &suppressed);
+            CAP_UNLOCK(clf);
+            if (report) CAP_SEND_DETECTION(f, label, &x, conf, suppressed);
+        }
+    }
+
+    if ((feats & CAP_PROFILE) && !sched_hop_admits(hop, f->payload[0], f->rssi)) return;
+
+    if ((feats & CAP_MACFILT) && mac_filter.mode != MACFILT_OFF) {
+        CAP_LOCK(mac);
+        bool pass = macfilt_admits(&mac_filter, f->payload, f->len);
+        CAP_UNLOCK(mac);
+        if (!pass) return;
+    }
+
+    CAP_SEND_FRAME(f, hop->snaplen);
+}
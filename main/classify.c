@@ -0,0 +1,264 @@
+#include "classify.h"
+#include <string.h>
+
+#define CLF_HDR_LEN     12
+#define CLF_TEST_LEN    8
+#define CLF_ITEM_LEN    4
+
+/* 255 / (1 + e^-x) at x = -8, -7.5, ..., 8; interpolated between */
+static const uint8_t sigmoid[33] = {
+    0, 0, 0, 0, 1, 1, 2, 3, 5, 7, 12, 19, 30, 47, 69, 96,
+    128, 159, 186, 208, 225, 236, 243, 248, 250, 252, 253, 254, 254, 255, 255, 255, 255,
+};
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool clf_parse(const uint8_t *blob, size_t len, clf_model_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    if (len < CLF_HDR_LEN || blob[0] != CLF_VERSION) return false;
+
+    uint8_t kind = blob[1];
+    uint8_t num_tests = blob[8], num_items = blob[9];
+    if (kind > CLF_KIND_LOGISTIC || num_tests > CLF_MAX_TESTS) return false;
+    if (kind == CLF_KIND_TREE && num_items == 0) return false;
+    if (kind == CLF_KIND_LOGISTIC && num_items > CLF_MAX_TERMS) return false;
+    if (kind == CLF_KIND_OFF && (num_tests || num_items)) return false;
+    if (len != CLF_HDR_LEN + (size_t)num_tests * CLF_TEST_LEN + (size_t)num_items * CLF_ITEM_LEN)
+        return false;
+
+    const uint8_t *p = blob + CLF_HDR_LEN;
+    for (int i = 0; i < num_tests; i++, p += CLF_TEST_LEN) {
+        clf_test_t *t = &m->tests[i];
+        t->feature = p[0];
+        t->op      = p[1];
+        t->value   = rd32(p + 4);
+        if (t->op > CLF_OP_OUI || (t->op != CLF_OP_OUI && t->feature >= CLF_NUM_FEATURES)) return false;
+    }
+    for (int i = 0; i < num_items; i++, p += CLF_ITEM_LEN) {
+        if (kind == CLF_KIND_TREE) {
+            clf_node_t *n = &m->nodes[i];
+            n->test = p[0];
+            n->yes  = p[1];
+            n->no   = p[2];
+            if (n->test == CLF_LEAF) continue;
+            /* children after the parent: every walk ends at a leaf */
+            if (n->test >= num_tests || n->yes <= i || n->no <= i ||
+                n->yes >= num_items || n->no >= num_items)
+                return false;
+        } else {
+            clf_term_t *t = &m->terms[i];
+            t->test   = p[0];
+            t->weight = (int16_t)rd16(p + 2);
+            if (t->test >= num_tests) return false;
+        }
+    }
+
+    m->kind       = kind;
+    m->label      = blob[2];
+    m->threshold  = blob[3];
+    m->holdoff_ms = rd16(blob + 4);
+    m->bias       = (int16_t)rd16(blob + 6);
+    m->num_tests  = num_tests;
+    m->num_items  = num_items;
+    return true;
+}
+
+void clf_configure(clf_t *c, const clf_model_t *m)
+{
+    memset(c->slots, 0, sizeof(c->slots));
+    c->model = *m;
+}
+
+/* CLF_F_RATES bit of a rate byte, basic-rate bit removed */
+static uint32_t rate_bit(uint8_t r)
+{
+    switch (r) {
+    case 2:   return 1 << 0;
+    case 4:   return 1 << 1;
+    case 11:  return 1 << 2;
+    case 22:  return 1 << 3;
+    case 12:  return 1 << 4;
+    case 18:  return 1 << 5;
+    case 24:  return 1 << 6;
+    case 36:  return 1 << 7;
+    case 48:  return 1 << 8;
+    case 72:  return 1 << 9;
+    case 96:  return 1 << 10;
+    case 108: return 1 << 11;
+    case 127: return CLF_RATE_HT;
+    case 126: return CLF_RATE_VHT;
+    case 122: return CLF_RATE_HE;
+    default:  return CLF_RATE_OTHER;
+    }
+}
+
+static uint32_t elem_bit(uint8_t id)
+{
+    switch (id) {
+    case 3:   return CLF_E_DS;
+    case 5:   return CLF_E_TIM;
+    case 7:   return CLF_E_COUNTRY;
+    case 32:  return CLF_E_POWER;
+    case 42:  return CLF_E_ERP;
+    case 45:  return CLF_E_HT_CAP;
+    case 48:  return CLF_E_RSN;
+    case 54:  return CLF_E_MOBILITY;
+    case 61:  return CLF_E_HT_OP;
+    case 70:  return CLF_E_RM_CAP;
+    case 127: return CLF_E_EXT_CAP;
+    case 191: return CLF_E_VHT_CAP;
+    default:  return 0;
+    }
+}
+
+bool clf_extract(const uint8_t *frame, size_t len, clf_features_t *x)
+{
+    /* management, beacon or probe response, with the fixed fields */
+    if (len < 36) return false;
+    uint8_t fc0 = frame[0];
+    uint8_t subtype = fc0 >> 4;
+    if ((fc0 & 0x0c) != 0 || (subtype != 8 && subtype != 5)) return false;
+
+    memset(x, 0, sizeof(*x));
+    x->f[CLF_F_SUBTYPE]  = subtype;
+    x->f[CLF_F_INTERVAL] = rd16(frame + 32);
+    x->f[CLF_F_CAPS]     = rd16(frame + 34);
+
+    uint32_t sig = 2166136261u;
+    for (size_t pos = 36; pos + 2 <= len;) {
+        uint8_t id = frame[pos], n = frame[pos + 1];
+        const uint8_t *d = frame + pos + 2;
+        if (pos + 2 + n > len) break;
+        pos += 2 + (size_t)n;
+
+        x->f[CLF_F_NUM_IES]++;
+        sig = (sig ^ id) * 16777619u;
+        x->f[CLF_F_ELEMS] |= elem_bit(id);
+
+        switch (id) {
+        case 0:
+            x->f[CLF_F_SSID_LEN] = n;
+            break;
+        case 1:
+        case 50:
+            for (int i = 0; i < n; i++) {
+                uint32_t bit = rate_bit(d[i] & 0x7f);
+                x->f[CLF_F_RATES] |= bit;
+                if (d[i] & 0x80) x->f[CLF_F_BASIC_RATES] |= bit;
+            }
+            break;
+        case 45:
+            if (n >= 2) x->f[CLF_F_HT_CAPS] = rd16(d);
+            break;
+        case 221: {
+            if (n < 3) break;
+            x->f[CLF_F_NUM_VENDOR]++;
+            uint32_t oui = ((uint32_t)d[0] << 16) | ((uint32_t)d[1] << 8) | d[2];
+            if (oui == 0x0050f2 && n >= 4) {
+                if (d[3] == 1) x->f[CLF_F_ELEMS] |= CLF_E_WPA;
+                else if (d[3] == 2) x->f[CLF_F_ELEMS] |= CLF_E_WMM;
+                else if (d[3] == 4) x->f[CLF_F_ELEMS] |= CLF_E_WPS;
+            }
+            bool seen = false;
+            for (int i = 0; i < x->num_ouis; i++) seen |= x->ouis[i] == oui;
+            if (!seen && x->num_ouis < CLF_MAX_OUIS) x->ouis[x->num_ouis++] = oui;
+            break;
+        }
+        case 255:
+            if (n < 1) break;
+            sig = (sig ^ d[0]) * 16777619u;
+            if (d[0] == 35) x->f[CLF_F_ELEMS] |= CLF_E_HE_CAP;
+            break;
+        }
+    }
+    x->f[CLF_F_IE_SIG] = sig;
+    return true;
+}
+
+static bool test_holds(const clf_test_t *t, const clf_features_t *x)
+{
+    switch (t->op) {
+    case CLF_OP_LE:  return x->f[t->feature] <= t->value;
+    case CLF_OP_EQ:  return x->f[t->feature] == t->value;
+    case CLF_OP_ANY: return (x->f[t->feature] & t->value) != 0;
+    default:
+        for (int i = 0; i < x->num_ouis; i++)
+            if (x->ouis[i] == t->value) return true;
+        return false;
+    }
+}
+
+uint8_t clf_score(const clf_model_t *m, const clf_features_t *x)
+{
+    if (m->kind == CLF_KIND_TREE) {
+        int i = 0;
+        while (m->nodes[i].test != CLF_LEAF) {
+            const clf_node_t *n = &m->nodes[i];
+            i = test_holds(&m->tests[n->test], x) ? n->yes : n->no;
+        }
+        return m->nodes[i].yes;
+    }
+    if (m->kind != CLF_KIND_LOGISTIC) return 0;
+
+    int32_t s = m->bias;
+    for (int i = 0; i < m->num_items; i++)
+        if (test_holds(&m->tests[m->terms[i].test], x)) s += m->terms[i].weight;
+    if (s < -2048) s = -2048;
+    if (s > 2048) s = 2048;
+    uint32_t u = (uint32_t)(s + 2048);
+    uint32_t k = u >> 7, frac = u & 127;
+    if (k == 32) return sigmoid[32];
+    return (uint8_t)(sigmoid[k] + (((sigmoid[k + 1] - sigmoid[k]) * frac) >> 7));
+}
+
+/* FNV-1a over the address */
+static uint32_t mac_hash(const uint8_t mac[6])
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    return h ? h : 1; /* 0 marks an empty slot */
+}
+
+bool clf_admit(clf_t *c, const uint8_t mac[6], uint32_t now_ms, uint16_t *suppressed)
+{
+    *suppressed = 0;
+    if (c->model.holdoff_ms == 0) return true;
+
+    uint32_t h = mac_hash(mac);
+    uint32_t set_idx = (h ^ (h >> 16)) & (CLF_HOLD_SLOTS / CLF_HOLD_WAYS - 1);
+    clf_slot_t *set = &c->slots[set_idx * CLF_HOLD_WAYS];
+    clf_slot_t *slot = NULL, *victim = NULL;
+    for (int i = 0; i < CLF_HOLD_WAYS; i++) {
+        clf_slot_t *s = &set[i];
+        if (s->hash == h) {
+            slot = s;
+            break;
+        }
+        /* an empty way, else one whose hold-off has run out */
+        if (!victim || (victim->hash && (!s->hash || now_ms - s->last_ms > now_ms - victim->last_ms)))
+            victim = s;
+    }
+    if (slot && now_ms - slot->last_ms < c->model.holdoff_ms) {
+        if (slot->suppressed < UINT16_MAX) slot->suppressed++;
+        return false;
+    }
+    if (slot) {
+        *suppressed = slot->suppressed;
+    } else {
+        if (victim->hash && now_ms - victim->last_ms < c->model.holdoff_ms) return true; /* set full */
+        slot = victim;
+    }
+    slot->hash       = h;
+    slot->last_ms    = now_ms;
+    slot->suppressed = 0;
+    return true;
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+/*
+ * Beacon classifier: scores beacons and probe responses with a small model
+ * trained on the host (lib/py/classify.py) and uploaded as a table.
+ *
+ * A frame is reduced to a fixed feature vector (beacon interval, capability
+ * bits, IE-order signature, rates, element presence, HT capabilities, vendor
+ * OUIs). The model is a table of binary tests on those features plus either
+ * a decision tree over the tests or logistic-regression weights for them;
+ * both give a confidence of 0..255. Tree children always come after their
+ * parent, so scoring takes at most CLF_MAX_NODES steps (in practice the
+ * depth), and feature extraction is one pass over the elements.
+ *
+ * Detections are held back per transmitter for holdoff_ms, in a
+ * set-associative table of CLF_HOLD_WAYS transmitters per set. A way is only
+ * reused once its own hold-off has run out: with more targets in range than
+ * a set holds, the extra ones are reported on every hit rather than all of
+ * them evicting each other in turn.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CLF_VERSION         1
+#define CLF_MAX_TESTS       64
+#define CLF_MAX_NODES       255
+#define CLF_MAX_TERMS       64
+#define CLF_MAX_OUIS        8       /* distinct vendor OUIs kept per frame */
+#define CLF_HOLD_SLOTS      256     /* power of two */
+#define CLF_HOLD_WAYS       4
+
+/* model kinds */
+#define CLF_KIND_OFF        0
+#define CLF_KIND_TREE       1
+#define CLF_KIND_LOGISTIC   2
+
+/* features */
+enum {
+    CLF_F_SUBTYPE = 0,      /* 8 = beacon, 5 = probe response */
+    CLF_F_INTERVAL,         /* beacon interval, TU */
+    CLF_F_CAPS,             /* capability information */
+    CLF_F_IE_SIG,           /* FNV-1a of the element IDs in order (extension IDs too) */
+    CLF_F_NUM_IES,
+    CLF_F_SSID_LEN,
+    CLF_F_RATES,            /* CLF_RATE_* bits of the supported rates */
+    CLF_F_BASIC_RATES,      /* the same for the basic ones */
+    CLF_F_ELEMS,            /* CLF_E_* bits */
+    CLF_F_HT_CAPS,          /* HT capability information, 0 without HT */
+    CLF_F_NUM_VENDOR,       /* vendor-specific elements */
+    CLF_NUM_FEATURES
+};
+
+/* CLF_F_RATES bits: 1, 2, 5.5, 11, 6, 9, 12, 18, 24, 36, 48, 54 Mb/s, then
+ * the HT, VHT and HE membership selectors and any other value */
+#define CLF_RATE_HT         (1 << 12)
+#define CLF_RATE_VHT        (1 << 13)
+#define CLF_RATE_HE         (1 << 14)
+#define CLF_RATE_OTHER      (1 << 15)
+
+/* CLF_F_ELEMS bits */
+#define CLF_E_HT_CAP        (1 << 0)
+#define CLF_E_HT_OP         (1 << 1)
+#define CLF_E_VHT_CAP       (1 << 2)
+#define CLF_E_HE_CAP        (1 << 3)
+#define CLF_E_RSN           (1 << 4)
+#define CLF_E_WPA           (1 << 5)    /* vendor 00:50:f2 type 1 */
+#define CLF_E_WMM           (1 << 6)    /* vendor 00:50:f2 type 2 */
+#define CLF_E_WPS           (1 << 7)    /* vendor 00:50:f2 type 4 */
+#define CLF_E_COUNTRY       (1 << 8)
+#define CLF_E_EXT_CAP       (1 << 9)
+#define CLF_E_RM_CAP        (1 << 10)
+#define CLF_E_MOBILITY      (1 << 11)
+#define CLF_E_ERP           (1 << 12)
+#define CLF_E_POWER         (1 << 13)
+#define CLF_E_TIM           (1 << 14)
+#define CLF_E_DS            (1 << 15)
+
+/* test operators */
+#define CLF_OP_LE           0       /* x <= value */
+#define CLF_OP_EQ           1       /* x == value */
+#define CLF_OP_ANY          2       /* x & value != 0 */
+#define CLF_OP_OUI          3       /* a vendor element has OUI value (feature unused) */
+
+#define CLF_LEAF            0xFF    /* node test of a leaf */
+
+typedef struct {
+    uint32_t f[CLF_NUM_FEATURES];
+    uint8_t  num_ouis;
+    uint32_t ouis[CLF_MAX_OUIS];
+} clf_features_t;
+
+typedef struct {
+    uint8_t  feature;
+    uint8_t  op;
+    uint32_t value;
+} clf_test_t;
+
+typedef struct {
+    uint8_t test;           /* CLF_LEAF: yes is the confidence */
+    uint8_t yes;            /* next node if the test holds */
+    uint8_t no;
+} clf_node_t;
+
+typedef struct {
+    uint8_t test;
+    int16_t weight;         /* added to the logit (x 256) if the test holds */
+} clf_term_t;
+
+typedef struct {
+    uint8_t    kind;        /* CLF_KIND_* */
+    uint8_t    label;       /* reported with each detection */
+    uint8_t    threshold;   /* confidence at or above which a frame is a detection */
+    uint16_t   holdoff_ms;  /* per transmitter; 0 = every detection */
+    int16_t    bias;        /* logistic: logit x 256 */
+    uint8_t    num_tests;
+    uint8_t    num_items;   /* nodes or terms */
+    clf_test_t tests[CLF_MAX_TESTS];
+    union {
+        clf_node_t nodes[CLF_MAX_NODES];
+        clf_term_t terms[CLF_MAX_TERMS];
+    };
+} clf_model_t;
+
+typedef struct {
+    uint32_t hash;          /* 0 = empty */
+    uint32_t last_ms;       /* last detection sent */
+    uint16_t suppressed;    /* held back since then */
+} clf_slot_t;
+
+typedef struct {
+    clf_model_t model;
+    clf_slot_t  slots[CLF_HOLD_SLOTS];
+} clf_t;
+
+/*
+ * Parse a model blob (see the README). Returns false if it is malformed:
+ * unknown version or kind, counts over the limits, a length that does not
+ * match, or a tree child that does not come after its parent.
+ */
+bool clf_parse(const uint8_t *blob, size_t len, clf_model_t *m);
+
+/* Install a model and clear the hold-off table. */
+void clf_configure(clf_t *c, const clf_model_t *m);
+
+/*
+ * Features of a beacon or probe response (transmitter at frame + 10).
+ * Returns false for other frames or ones too short for the fixed fields;
+ * elements cut short by the capture end the walk.
+ */
+bool clf_extract(const uint8_t *frame, size_t len, clf_features_t *x);
+
+/* Confidence 0..255 that the frame is from a target. */
+uint8_t clf_score(const clf_model_t *m, const clf_features_t *x);
+
+/*
+ * Hold-off: whether to report a detection from mac now. When it is
+ * reported, *suppressed receives the detections held back for this
+ * transmitter since its previous one.
+ */
+bool clf_admit(clf_t *c, const uint8_t mac[6], uint32_t now_ms, uint16_t *suppressed);
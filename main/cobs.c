@@ -1,4 +1,4 @@
-#include "protocol.h"
+#include "cobs.h"
 
 size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst)
 {
@@ -0,0 +1,16 @@
+#pragma once
+
+/*
+ * Consistent Overhead Byte Stuffing for the serial framing.
+ *
+ * Encoded output is at most len + len / 254 + 1 bytes; decoded output is
+ * never longer than its input.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
+
+/* Returns the decoded length, or -1 if src is malformed or truncated. */
+int    cobs_decode(const uint8_t *src, size_t len, uint8_t *dst);
@@ -0,0 +1,79 @@
+#include "csi.h"
+#include <string.h>
+
+void csi_configure(csi_t *c, const csi_config_t *cfg)
+{
+    memset(c, 0, sizeof(*c));
+    c->cfg = *cfg;
+    if (c->cfg.num_match > CSI_MAX_MATCH) c->cfg.num_match = CSI_MAX_MATCH;
+}
+
+bool csi_matches(const csi_config_t *cfg, const uint8_t mac[6])
+{
+    if (cfg->num_match == 0) return true;
+    for (int i = 0; i < cfg->num_match; i++) {
+        const csi_match_t *m = &cfg->match[i];
+        if (memcmp(m->addr, mac, m->prefix) == 0) return true;
+    }
+    return false;
+}
+
+/* FNV-1a over the address */
+static uint32_t mac_hash(const uint8_t mac[6])
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) h = (h ^ mac[i]) * 16777619u;
+    return h ? h : 1; /* 0 marks an empty slot */
+}
+
+bool csi_admit(csi_t *c, const uint8_t mac[6], uint32_t now_ms, uint16_t *suppressed)
+{
+    *suppressed = 0;
+    if (c->cfg.interval_ms == 0) return true;
+
+    uint32_t h = mac_hash(mac);
+    csi_slot_t *slot = &c->slots[h & (CSI_RATE_SLOTS - 1)];
+    if (slot->hash == h && now_ms - slot->last_ms < c->cfg.interval_ms) {
+        if (slot->suppressed < UINT16_MAX) slot->suppressed++;
+        return false;
+    }
+    if (slot->hash == h) *suppressed = slot->suppressed;
+    slot->hash       = h;
+    slot->last_ms    = now_ms;
+    slot->suppressed = 0;
+    return true;
+}
+
+/* v / 2^shift, rounded, in -8..7 */
+static uint8_t quantize4(int v, uint8_t shift)
+{
+    int q = shift ? (v + (1 << (shift - 1))) >> shift : v;
+    if (q > 7) q = 7;
+    if (q < -8) q = -8;
+    return (uint8_t)q & 0x0F;
+}
+
+size_t csi_pack(const int8_t *buf, uint16_t len, uint8_t bits, uint8_t *out, uint8_t *shift)
+{
+    if (bits != CSI_BITS_4) {
+        memcpy(out, buf, len);
+        *shift = 0;
+        return len;
+    }
+
+    int lo = 0, hi = 0;
+    for (int i = 0; i < len; i++) {
+        if (buf[i] < lo) lo = buf[i];
+        if (buf[i] > hi) hi = buf[i];
+    }
+    uint8_t s = 0;
+    while (s < 4 && (((hi + (1 << s >> 1)) >> s) > 7 || (lo >> s) < -8)) s++;
+    *shift = s;
+
+    size_t n = 0;
+    for (int i = 0; i + 1 < len; i += 2) {
+        out[n++] = quantize4(buf[i], s) | (uint8_t)(quantize4(buf[i + 1], s) << 4);
+    }
+    if (len & 1) out[n++] = quantize4(buf[len - 1], s);
+    return n;
+}
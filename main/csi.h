@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+ * CSI (channel state information) report filtering and packing.
+ *
+ * A report is forwarded if its transmitter matches the address/OUI list
+ * (an empty list matches all) and, with an interval set, if that
+ * transmitter has not had a report forwarded within it. Rate-limit state
+ * is a direct-mapped table of CSI_RATE_SLOTS transmitters; a colliding
+ * transmitter takes over the slot, so memory stays fixed.
+ *
+ * Samples are the driver's int8 values (imaginary, real per subcarrier).
+ * CSI_BITS_4 packs two per byte: each is divided by 2^shift, rounded and
+ * clamped to -8..7, with the smallest shift (0..4) that fits the largest.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CSI_MAX_MATCH       16      /* addresses / OUIs in the filter */
+#define CSI_RATE_SLOTS      64      /* power of two */
+#define CSI_MAX_LEN         1024    /* int8 values per report */
+
+#define CSI_BITS_8          8       /* samples as received */
+#define CSI_BITS_4          4       /* two per byte, with a shared shift */
+
+typedef struct {
+    uint8_t  addr[6];
+    uint8_t  prefix;        /* bytes compared: 3 = OUI, 6 = full address */
+} csi_match_t;
+
+typedef struct {
+    uint8_t     bits;           /* CSI_BITS_* */
+    uint16_t    interval_ms;    /* per transmitter; 0 = forward every report */
+    uint8_t     num_match;      /* 0 = every transmitter */
+    csi_match_t match[CSI_MAX_MATCH];
+} csi_config_t;
+
+typedef struct {
+    uint32_t hash;          /* 0 = empty */
+    uint32_t last_ms;       /* last report forwarded */
+    uint16_t suppressed;    /* held back since then */
+} csi_slot_t;
+
+typedef struct {
+    csi_config_t cfg;
+    csi_slot_t   slots[CSI_RATE_SLOTS];
+} csi_t;
+
+/* Install a configuration and clear the rate-limit table. */
+void csi_configure(csi_t *c, const csi_config_t *cfg);
+
+/* Whether the transmitter is on the address/OUI list (or the list is empty). */
+bool csi_matches(const csi_config_t *cfg, const uint8_t mac[6]);
+
+/*
+ * Rate limit: whether to forward a report from mac now. When it is
+ * forwarded, *suppressed receives the reports held back for this
+ * transmitter since its previous one.
+ */
+bool csi_admit(csi_t *c, const uint8_t mac[6], uint32_t now_ms, uint16_t *suppressed);
+
+/* Bytes csi_pack writes for len values. */
+static inline size_t csi_packed_len(uint16_t len, uint8_t bits)
+{
+    return bits == CSI_BITS_4 ? (size_t)(len + 1) / 2 : len;
+}
+
+/*
+ * Pack len values into out (csi_packed_len bytes). For CSI_BITS_4 the
+ * first value of each pair goes in the low nibble, and *shift receives the
+ * scale exponent; for CSI_BITS_8 it is 0. Returns the bytes written.
+ */
+size_t csi_pack(const int8_t *buf, uint16_t len, uint8_t bits, uint8_t *out, uint8_t *shift);
@@ -0,0 +1,153 @@
+#include "deauth.h"
+#include <string.h>
+
+void deauth_init(deauth_det_t *d)
+{
+    deauth_config_t cfg = {
+        .threshold = 0,     /* off until DEAUTH_CONFIG */
+        .window_ms = 1000,
+        .report_ms = 5000,
+        .suppress  = false,
+    };
+    deauth_configure(d, &cfg);
+}
+
+void deauth_configure(deauth_det_t *d, const deauth_config_t *cfg)
+{
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    if (d->cfg.window_ms == 0) d->cfg.window_ms = 1;
+}
+
+/* find the entry for (bssid, target), claiming one if absent */
+static deauth_entry_t *lookup(deauth_det_t *d, const uint8_t *bssid,
+                              const uint8_t *target, uint32_t now_ms)
+{
+    deauth_entry_t *free_slot = NULL;
+    deauth_entry_t *victim = NULL;
+
+    for (int i = 0; i < DEAUTH_TABLE_SIZE; i++) {
+        deauth_entry_t *e = &d->table[i];
+        if (!e->used) {
+            if (!free_slot) free_slot = e;
+            continue;
+        }
+        if (memcmp(e->bssid, bssid, 6) == 0 && memcmp(e->target, target, 6) == 0) {
+            return e;
+        }
+        /* least recently seen, preferring entries that are not flooding */
+        if (!victim ||
+            (victim->flooding && !e->flooding) ||
+            (victim->flooding == e->flooding &&
+             now_ms - e->last_ms > now_ms - victim->last_ms)) {
+            victim = e;
+        }
+    }
+
+    deauth_entry_t *e = free_slot;
+    if (!e) {
+        e = victim;
+        d->evictions++;
+    }
+    memset(e, 0, sizeof(*e));
+    e->used = true;
+    memcpy(e->bssid, bssid, 6);
+    memcpy(e->target, target, 6);
+    e->window_start_ms = now_ms;
+    return e;
+}
+
+static void count_reason(deauth_entry_t *e, uint16_t code)
+{
+    for (int i = 0; i < DEAUTH_MAX_REASONS; i++) {
+        deauth_reason_t *r = &e->reasons[i];
+        if (r->count == 0) {
+            r->code = code;
+            r->count = 1;
+            return;
+        }
+        if (r->code == code) {
+            if (r->count < UINT16_MAX) r->count++;
+            return;
+        }
+    }
+    /* table full: further distinct codes are only reflected in the totals */
+}
+
+static void fill_report(const deauth_entry_t *e, uint8_t flags, uint32_t now_ms,
+                        deauth_report_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    r->flags          = flags;
+    memcpy(r->bssid, e->bssid, 6);
+    memcpy(r->target, e->target, 6);
+    r->channel        = e->channel;
+    r->rssi           = e->rssi;
+    r->window_count   = e->window_count;
+    r->duration_ms    = now_ms - e->flood_start_ms;
+    r->deauth_count   = e->deauth_count;
+    r->disassoc_count = e->disassoc_count;
+    r->suppressed     = e->suppressed;
+    for (int i = 0; i < DEAUTH_MAX_REASONS && e->reasons[i].count; i++) {
+        r->reasons[i] = e->reasons[i];
+        r->num_reasons++;
+    }
+}
+
+int deauth_observe(deauth_det_t *d, const uint8_t *frame, size_t len,
+                   uint8_t channel, int8_t rssi, uint32_t now_ms,
+                   deauth_report_t *report)
+{
+    if (d->cfg.threshold == 0 || !deauth_is_candidate(frame, len)) return 0;
+
+    bool is_deauth = (frame[0] >> 4) == DEAUTH_SUBTYPE_DEAUTH;
+    /* addr1 = target (receiver), addr3 = BSSID; the body starts with the reason */
+    deauth_entry_t *e = lookup(d, frame + 16, frame + 4, now_ms);
+    uint16_t reason = len >= 26 ? (uint16_t)(frame[24] | (frame[25] << 8)) : 0;
+
+    uint32_t elapsed = now_ms - e->window_start_ms;
+    if (elapsed >= d->cfg.window_ms) {
+        /* a whole window below threshold (or an empty one) ends the flood */
+        if (e->flooding && (e->window_count < d->cfg.threshold ||
+                            elapsed >= 2u * d->cfg.window_ms)) {
+            e->flooding = false;
+        }
+        if (!e->flooding) {
+            e->deauth_count = e->disassoc_count = e->suppressed = 0;
+            memset(e->reasons, 0, sizeof(e->reasons));
+        }
+        e->window_start_ms = now_ms;
+        e->window_count = 0;
+    }
+
+    e->last_ms = now_ms;
+    e->channel = channel;
+    e->rssi    = rssi;
+    if (e->window_count < UINT16_MAX) e->window_count++;
+    if (is_deauth) e->deauth_count++;
+    else           e->disassoc_count++;
+    count_reason(e, reason);
+
+    int act = 0;
+    if (!e->flooding) {
+        if (e->window_count >= d->cfg.threshold) {
+            e->flooding       = true;
+            e->flood_start_ms = e->window_start_ms;
+            e->last_report_ms = now_ms;
+            fill_report(e, DEAUTH_REPORT_ONSET, now_ms, report);
+            act |= DEAUTH_ACT_REPORT;
+        }
+        return act;
+    }
+
+    if (d->cfg.suppress) {
+        e->suppressed++;
+        act |= DEAUTH_ACT_SUPPRESS;
+    }
+    if (d->cfg.report_ms && now_ms - e->last_report_ms >= d->cfg.report_ms) {
+        e->last_report_ms = now_ms;
+        fill_report(e, 0, now_ms, report);
+        act |= DEAUTH_ACT_REPORT;
+    }
+    return act;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+/*
+ * Deauthentication / disassociation flood detector.
+ *
+ * Counts are kept per (BSSID, target) in a small fixed table. When the number
+ * of frames in one window reaches the threshold, a report is produced once at
+ * the onset and then at most every report_ms while the flood continues.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DEAUTH_TABLE_SIZE       32
+#define DEAUTH_MAX_REASONS      4       /* distinct reason codes tracked per entry */
+
+#define DEAUTH_SUBTYPE_DISASSOC 10
+#define DEAUTH_SUBTYPE_DEAUTH   12
+
+/* deauth_observe() result bits */
+#define DEAUTH_ACT_REPORT       (1 << 0)    /* *report was filled in */
+#define DEAUTH_ACT_SUPPRESS     (1 << 1)    /* drop the frame instead of forwarding */
+
+/* report flags */
+#define DEAUTH_REPORT_ONSET     (1 << 0)    /* first report of this flood */
+
+typedef struct {
+    uint16_t threshold;     /* frames per window that make a flood; 0 = off */
+    uint16_t window_ms;
+    uint16_t report_ms;     /* repeat interval while flooding; 0 = onset only */
+    bool     suppress;      /* drop the frames of an ongoing flood */
+} deauth_config_t;
+
+typedef struct {
+    uint16_t code;
+    uint16_t count;
+} deauth_reason_t;
+
+typedef struct {
+    uint8_t  bssid[6];
+    uint8_t  target[6];         /* ff:ff:ff:ff:ff:ff for broadcast floods */
+    bool     used;
+    bool     flooding;
+    uint8_t  channel;
+    int8_t   rssi;              /* of the last frame */
+
+    uint32_t window_start_ms;
+    uint16_t window_count;
+    uint32_t last_ms;
+    uint32_t flood_start_ms;
+    uint32_t last_report_ms;
+
+    /* since the flood started */
+    uint32_t deauth_count;
+    uint32_t disassoc_count;
+    uint32_t suppressed;
+    deauth_reason_t reasons[DEAUTH_MAX_REASONS];
+} deauth_entry_t;
+
+typedef struct {
+    uint8_t  flags;             /* DEAUTH_REPORT_* */
+    uint8_t  bssid[6];
+    uint8_t  target[6];
+    uint8_t  channel;
+    int8_t   rssi;
+    uint16_t window_count;      /* frames in the current window */
+    uint32_t duration_ms;       /* since the flood started */
+    uint32_t deauth_count;
+    uint32_t disassoc_count;
+    uint32_t suppressed;
+    uint8_t  num_reasons;
+    deauth_reason_t reasons[DEAUTH_MAX_REASONS];
+} deauth_report_t;
+
+typedef struct {
+    deauth_config_t cfg;
+    deauth_entry_t  table[DEAUTH_TABLE_SIZE];
+    uint32_t        evictions;
+} deauth_det_t;
+
+/* Default: off (threshold 0); 1 s windows, re-report every 5 s, no suppression. */
+void deauth_init(deauth_det_t *d);
+
+/* Replace the thresholds; the table is cleared. */
+void deauth_configure(deauth_det_t *d, const deauth_config_t *cfg);
+
+/* Whether the 802.11 frame control marks a deauth or disassoc frame. */
+static inline bool deauth_is_candidate(const uint8_t *frame, size_t len)
+{
+    if (len < 24) return false;
+    uint8_t fc0 = frame[0];
+    /* type 0 (mgmt), subtype 10 or 12 */
+    return (fc0 & 0x0C) == 0 &&
+           ((fc0 >> 4) == DEAUTH_SUBTYPE_DEAUTH ||
+            (fc0 >> 4) == DEAUTH_SUBTYPE_DISASSOC);
+}
+
+/*
+ * Account one deauth/disassoc frame (callers should check
+ * deauth_is_candidate() first; anything else returns 0).
+ * Returns DEAUTH_ACT_* bits.
+ */
+int deauth_observe(deauth_det_t *d, const uint8_t *frame, size_t len,
+                   uint8_t channel, int8_t rssi, uint32_t now_ms,
+                   deauth_report_t *report);
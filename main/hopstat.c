@@ -0,0 +1,30 @@
+#include "hopstat.h"
+#include <string.h>
+
+void hopstat_reset(hopstat_t *h)
+{
+    memset(h, 0, sizeof(*h));
+}
+
+void hopstat_switch(hopstat_t *h, uint32_t cost_us)
+{
+    h->switches++;
+    h->switch_us_total += cost_us;
+    if (cost_us > h->switch_us_max) h->switch_us_max = cost_us;
+    h->switch_hist[hopstat_bucket(cost_us)]++;
+}
+
+int hopstat_observe(hopstat_t *h, const hopstat_guard_t *g, uint32_t since_us, bool stale)
+{
+    if (since_us >= HOPSTAT_WINDOW_US) return HOPSTAT_PASS;
+
+    h->settle_frames++;
+    if (!stale) return HOPSTAT_PASS;
+
+    h->stale_frames++;
+    h->stale_hist[hopstat_bucket(since_us)]++;
+    if (since_us >= g->guard_us || g->mode == HOP_GUARD_OFF) return HOPSTAT_PASS;
+
+    h->guarded++;
+    return g->mode == HOP_GUARD_DROP ? HOPSTAT_DROP : HOPSTAT_RELABEL;
+}
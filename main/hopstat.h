@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ * Channel-switch cost and settle-window accounting.
+ *
+ * Each switch records how long the radio was held (driver filter and channel
+ * change). Frames arriving within HOPSTAT_WINDOW_US of a switch are counted,
+ * and those whose rx channel differs from the new hop's ("stale": in flight
+ * on the old channel) are binned by their arrival time after the switch.
+ * The stale histogram shows how long a guard interval needs to be; the
+ * switch histogram shows how short a dwell can get before switching
+ * dominates.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOPSTAT_BUCKETS         8
+#define HOPSTAT_BUCKET0_US      128     /* bucket i < 128 << i us; the last is open */
+#define HOPSTAT_WINDOW_US       16384   /* frames later than this are not looked at */
+
+/* what to do with a stale frame inside the guard interval */
+#define HOP_GUARD_OFF           0   /* count only; judged by the new hop's profile */
+#define HOP_GUARD_DROP          1   /* discard */
+#define HOP_GUARD_RELABEL       2   /* judge by the previous hop's profile instead */
+
+/* hopstat_observe() results */
+#define HOPSTAT_PASS            0
+#define HOPSTAT_DROP            1
+#define HOPSTAT_RELABEL         2
+
+typedef struct {
+    uint16_t guard_us;      /* 0 = no guard */
+    uint8_t  mode;          /* HOP_GUARD_* */
+} hopstat_guard_t;
+
+typedef struct {
+    uint32_t switches;
+    uint32_t switch_us_total;
+    uint32_t switch_us_max;
+    uint32_t settle_frames;     /* frames within HOPSTAT_WINDOW_US of a switch */
+    uint32_t stale_frames;      /* of those, rx channel != the hop's channel */
+    uint32_t guarded;           /* stale frames dropped or relabelled */
+    uint32_t switch_hist[HOPSTAT_BUCKETS];  /* by switch cost */
+    uint32_t stale_hist[HOPSTAT_BUCKETS];   /* by arrival after the switch */
+} hopstat_t;
+
+static inline int hopstat_bucket(uint32_t us)
+{
+    int b = 0;
+    for (uint32_t lim = HOPSTAT_BUCKET0_US; us >= lim && b < HOPSTAT_BUCKETS - 1; lim <<= 1) b++;
+    return b;
+}
+
+void hopstat_reset(hopstat_t *h);
+
+/* Record one channel switch that held the radio for cost_us. */
+void hopstat_switch(hopstat_t *h, uint32_t cost_us);
+
+/*
+ * Account a frame arriving since_us after the last switch completed, and
+ * return HOPSTAT_* for it. `stale` is whether its rx channel differs from
+ * the current hop's.
+ */
+int hopstat_observe(hopstat_t *h, const hopstat_guard_t *g, uint32_t since_us, bool stale);
@@ -0,0 +1,63 @@
+#include "macfilt.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t mac_load(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 40) | ((uint64_t)p[1] << 32) | ((uint64_t)p[2] << 24) |
+           ((uint64_t)p[3] << 16) | ((uint64_t)p[4] << 8)  | (uint64_t)p[5];
+}
+
+static int mac_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+bool macfilt_parse(const uint8_t *blob, size_t len, macfilt_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    if (len < 2 || (len - 2) % 6 != 0 || blob[0] > MACFILT_DENY) return false;
+
+    uint32_t n = (uint32_t)((len - 2) / 6);
+    uint64_t *macs = NULL;
+    if (n > 0) {
+        macs = malloc(n * sizeof(uint64_t));
+        if (!macs) return false;
+        for (uint32_t i = 0; i < n; i++) macs[i] = mac_load(blob + 2 + i * 6);
+        qsort(macs, n, sizeof(uint64_t), mac_cmp);
+    }
+    f->mode  = blob[0];
+    f->count = n;
+    f->macs  = macs;
+    return true;
+}
+
+static bool contains(const macfilt_t *f, uint64_t mac)
+{
+    uint32_t lo = 0, hi = f->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (f->macs[mid] < mac) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < f->count && f->macs[lo] == mac;
+}
+
+bool macfilt_admits(const macfilt_t *f, const uint8_t *frame, size_t len)
+{
+    if (f->mode == MACFILT_OFF) return true;
+
+    bool hit = false;
+    /* addr1 at 4, addr2 at 10, addr3 at 16 (control frames stop early) */
+    for (size_t off = 4; off + 6 <= len && off <= 16 && !hit; off += 6) {
+        hit = contains(f, mac_load(frame + off));
+    }
+    return f->mode == MACFILT_ALLOW ? hit : !hit;
+}
+
+void macfilt_free(macfilt_t *f)
+{
+    free(f->macs);
+    memset(f, 0, sizeof(*f));
+}
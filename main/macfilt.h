@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+ * MAC address filter applied in the capture path.
+ *
+ * Built from a blob uploaded with the bulk transfer: u8 mode, u8 reserved,
+ * then N 6-byte addresses in wire order. Addresses are kept as sorted 48-bit
+ * integers, so a lookup is a binary search (about 13 steps for a few
+ * thousand entries).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MACFILT_OFF         0   /* forward everything */
+#define MACFILT_ALLOW       1   /* forward only frames involving a listed address */
+#define MACFILT_DENY        2   /* drop frames involving a listed address */
+
+typedef struct {
+    uint8_t   mode;
+    uint32_t  count;
+    uint64_t *macs;         /* heap, sorted ascending */
+} macfilt_t;
+
+/* Parse a filter blob. Returns false (and leaves *f empty) if malformed or out of memory. */
+bool macfilt_parse(const uint8_t *blob, size_t len, macfilt_t *f);
+
+/* Whether a frame passes, checking addr1..addr3 as far as the frame has them. */
+bool macfilt_admits(const macfilt_t *f, const uint8_t *frame, size_t len);
+
+void macfilt_free(macfilt_t *f);
@@ -0,0 +1,92 @@
+#include "probe.h"
+#include <string.h>
+
+/* 2.4 GHz: 1, 2, 5.5, 11 (basic), 6, 9, 12, 18 Mb/s; then 24, 36, 48, 54 */
+static const uint8_t rates_2g[8]     = { 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24 };
+static const uint8_t rates_2g_ext[4] = { 0x30, 0x48, 0x60, 0x6c };
+/* 5 GHz: OFDM only, 6, 12, 24 basic */
+static const uint8_t rates_5g[8]     = { 0x8c, 0x12, 0x98, 0x24, 0xb0, 0x48, 0x60, 0x6c };
+
+void probe_configure(probe_t *p, const probe_config_t *cfg, uint32_t now_ms)
+{
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+    if (p->cfg.num_ssids > PROBE_MAX_SSIDS) p->cfg.num_ssids = PROBE_MAX_SSIDS;
+    if (p->cfg.rate > PROBE_MAX_RATE) p->cfg.rate = PROBE_MAX_RATE;
+    bool wildcard = (p->cfg.flags & PROBE_FLAG_BROADCAST) || p->cfg.num_ssids == 0;
+    p->wanted  = p->cfg.num_ssids + (wildcard ? 1 : 0);
+    p->tokens  = (uint32_t)p->wanted * 1000;
+    p->last_ms = now_ms;
+}
+
+int probe_dwell(probe_t *p, uint32_t now_ms)
+{
+    if (p->cfg.rate == 0 || p->wanted == 0) return 0;
+
+    uint32_t cap = (uint32_t)p->wanted * 1000;
+    uint32_t elapsed = now_ms - p->last_ms;
+    p->last_ms = now_ms;
+    /* elapsed * rate thousandths; clamp first so the product cannot wrap */
+    if (elapsed >= cap) elapsed = cap;
+    p->tokens += elapsed * p->cfg.rate;
+    if (p->tokens > cap) p->tokens = cap;
+
+    int n = (int)(p->tokens / 1000);
+    if (n > p->wanted) n = p->wanted;
+    p->tokens -= (uint32_t)n * 1000;
+    p->sent    += (uint32_t)n;
+    p->skipped += (uint32_t)(p->wanted - n);
+
+    /* the probes held back go first next time */
+    p->first = p->next;
+    p->next  = (uint8_t)((p->next + n) % p->wanted);
+    return n;
+}
+
+size_t probe_build(const probe_t *p, int i, uint8_t channel, uint8_t *out)
+{
+    int k = (p->first + i) % p->wanted;
+    size_t n = 0;
+
+    /* header: probe request, broadcast DA and BSSID */
+    out[n++] = 0x40;
+    out[n++] = 0x00;
+    out[n++] = 0x00;
+    out[n++] = 0x00;
+    memset(out + n, 0xff, 6);
+    n += 6;
+    memcpy(out + n, p->cfg.src, 6);
+    n += 6;
+    memset(out + n, 0xff, 6);
+    n += 6;
+    out[n++] = 0x00;
+    out[n++] = 0x00;
+
+    /* SSID: one of the list, or wildcard after it */
+    out[n++] = 0;
+    if (k < p->cfg.num_ssids) {
+        const probe_ssid_t *s = &p->cfg.ssids[k];
+        out[n++] = s->len;
+        memcpy(out + n, s->ssid, s->len);
+        n += s->len;
+    } else {
+        out[n++] = 0;
+    }
+
+    if (channel > 14) {
+        out[n++] = 1;
+        out[n++] = sizeof(rates_5g);
+        memcpy(out + n, rates_5g, sizeof(rates_5g));
+        n += sizeof(rates_5g);
+    } else {
+        out[n++] = 1;
+        out[n++] = sizeof(rates_2g);
+        memcpy(out + n, rates_2g, sizeof(rates_2g));
+        n += sizeof(rates_2g);
+        out[n++] = 50;
+        out[n++] = sizeof(rates_2g_ext);
+        memcpy(out + n, rates_2g_ext, sizeof(rates_2g_ext));
+        n += sizeof(rates_2g_ext);
+    }
+    return n;
+}
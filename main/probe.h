@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+ * Active probing: probe requests sent at the start of each Wi-Fi dwell so
+ * APs on the channel answer at once instead of at their next beacon.
+ *
+ * Each dwell wants one directed probe per configured SSID plus a wildcard
+ * (broadcast) one if PROBE_FLAG_BROADCAST is set or no SSID is listed. A
+ * token bucket refilled at `rate` probes per second, and holding at most
+ * one dwell's worth, decides how many go out; with fewer tokens than
+ * wanted, the SSIDs take turns across dwells.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define PROBE_MAX_SSIDS     4
+#define PROBE_MAX_SSID_LEN  32
+#define PROBE_MAX_RATE      200     /* probes per second */
+#define PROBE_MAX_FRAME     (24 + 2 + PROBE_MAX_SSID_LEN + 2 + 8 + 2 + 4)
+
+#define PROBE_FLAG_BROADCAST    (1 << 0)    /* wildcard probe besides the SSIDs */
+
+typedef struct {
+    uint8_t len;
+    uint8_t ssid[PROBE_MAX_SSID_LEN];
+} probe_ssid_t;
+
+typedef struct {
+    uint8_t      src[6];        /* transmitter address of the probes */
+    uint16_t     rate;          /* probes per second; 0 = probing off */
+    uint8_t      flags;         /* PROBE_FLAG_* */
+    uint8_t      num_ssids;
+    probe_ssid_t ssids[PROBE_MAX_SSIDS];
+} probe_config_t;
+
+typedef struct {
+    probe_config_t cfg;
+    uint8_t  wanted;            /* probes per dwell */
+    uint8_t  first;             /* first probe of the current dwell */
+    uint8_t  next;              /* first probe of the next one */
+    uint32_t tokens;            /* thousandths of a probe */
+    uint32_t last_ms;           /* last refill */
+    uint32_t sent;              /* probes granted since configure */
+    uint32_t skipped;           /* probes held back by the rate limit */
+} probe_t;
+
+/* Install a configuration with a full bucket. */
+void probe_configure(probe_t *p, const probe_config_t *cfg, uint32_t now_ms);
+
+/*
+ * A dwell starts at now_ms: refill the bucket and return how many probes to
+ * send now (0..wanted). Build them with probe_build(p, 0..n-1, ...).
+ */
+int probe_dwell(probe_t *p, uint32_t now_ms);
+
+/*
+ * Write the i-th probe request of the current dwell into out
+ * (PROBE_MAX_FRAME bytes) with supported rates for the channel's band.
+ * Sequence control is left 0 for the driver. Returns the frame length.
+ */
+size_t probe_build(const probe_t *p, int i, uint8_t channel, uint8_t *out);
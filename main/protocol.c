@@ -1,6 +1,9 @@
 #include "protocol.h"
+#include "sdkconfig.h"
 #include "driver/usb_serial_jtag.h"
 #include "freertos/queue.h"
+#include "esp_timer.h"
+#include <stdlib.h>
 #include <string.h>
 
 /* -------- buffer pool -------- */
@@ -11,15 +14,42 @@ static QueueHandle_t       pool_queue;   /* free-list: holds uint8_t* pointers *
 /* -------- TX queue -------- */
 
 typedef struct {
-    uint8_t *buf;   /* pointer into buf_pool */
-    size_t   len;   /* total message length (hdr + payload) */
+    uint8_t *buf;   /* pointer into buf_pool; NULL for a loss restart */
+    size_t   len;   /* total message length (hdr + payload), or the command to ACK */
 } tx_item_t;
 
 static QueueHandle_t       tx_queue;
 
-/* -------- frame sequence counter -------- */
+/* -------- frame sequence counter (advanced only by frames handed to TX) -------- */
 static volatile uint16_t   frame_seq = 0;
 
+/* -------- loss accounting (reported by MSG_EVT_LOSS from the TX task) -------- */
+static portMUX_TYPE        loss_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t            loss_counts[LOSS_NUM_REASONS];
+static bool                loss_pending;    /* new losses since the last event */
+static uint16_t            loss_seq_first;
+static uint16_t            loss_seq_last;
+
+/* -------- synthetic frame source (configured by RX, emitted by the TX task) -------- */
+static portMUX_TYPE        synth_mux = portMUX_INITIALIZER_UNLOCKED;
+static synth_t             synth;
+
+/* -------- bulk transfer in progress (RX task only) -------- */
+static bulk_t              bulk;
+
+/* -------- event trace (recorded by any task while on, dumped by the RX task) -------- */
+#if TRACE_BUILD
+static trace_t             trace_ring;
+static portMUX_TYPE        trace_mux = portMUX_INITIALIZER_UNLOCKED;   /* context additions */
+static trace_rec_t         trace_chunk[TRACE_CHUNK_RECS];
+#endif
+volatile bool              trace_on = false;
+
+/* -------- counters (reported by MSG_CMD_STATS_QUERY) -------- */
+static volatile uint32_t   frames_sent   = 0;
+static volatile uint32_t   ble_adv_sent  = 0;
+static volatile uint32_t   ble_adv_dedup = 0;
+
 /* -------- COBS encode scratch buffer (stack of tx_task) -------- */
 /* worst-case COBS output: input_len + input_len/254 + 1           */
 #define COBS_MAX_OUT  (BUF_SLOT_SIZE + BUF_SLOT_SIZE / 254 + 2)
@@ -46,13 +76,15 @@ static bool is_valid_channel(int ch)
 
 static void send_raw(const uint8_t *data, size_t len)
 {
+    TRACE(TRACE_EV_USB_BEGIN, (uint16_t)len);
     /* COBS encode into a stack buffer and write with delimiters */
-    uint8_t enc[64 + 64 / 254 + 2]; /* small messages only */
+    uint8_t enc[128 + 128 / 254 + 2]; /* small messages only */
     size_t enc_len = cobs_encode(data, len, enc);
     uint8_t delim = 0x00;
     usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(50));
     usb_serial_jtag_write_bytes(enc, enc_len, pdMS_TO_TICKS(50));
     usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(50));
+    TRACE(TRACE_EV_USB_END, 0);
 }
 
 void proto_send_ack(uint8_t cmd_type)
@@ -89,19 +121,131 @@ void proto_send_promisc_status(bool enabled)
     send_raw(msg, sizeof(msg));
 }
 
+static void proto_send_bulk_ack(uint32_t received)
+{
+    uint8_t msg[4 + 4];
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    hdr->msg_type    = MSG_RSP_BULK_ACK;
+    hdr->flags       = FLAG_ACK;
+    hdr->payload_len = 4;
+    memcpy(msg + 4, &received, 4);
+    send_raw(msg, sizeof(msg));
+}
+
+/* -------- loss accounting -------- */
+
+static void loss_add(uint8_t reason, uint32_t n)
+{
+    portENTER_CRITICAL(&loss_mux);
+    if (!loss_pending) {
+        loss_pending   = true;
+        loss_seq_first = frame_seq;
+    }
+    loss_seq_last = frame_seq;
+    loss_counts[reason] += n;
+    portEXIT_CRITICAL(&loss_mux);
+}
+
+static void loss_count(uint8_t reason)
+{
+    loss_add(reason, 1);
+}
+
+/*
+ * Send the cumulative counts if anything was lost since the last event, and
+ * with reset, start the counts again from zero in the same critical section.
+ * TX task only: written directly, so it gets out even with the pool empty.
+ */
+static void loss_flush(bool reset)
+{
+    uint8_t msg[sizeof(proto_msg_hdr_t) + sizeof(loss_meta_t)];
+    loss_meta_t ev;
+
+    portENTER_CRITICAL(&loss_mux);
+    bool pending = loss_pending;
+    if (pending) {
+        ev.seq_first = loss_seq_first;
+        ev.seq_last  = loss_seq_last;
+        memcpy(ev.counts, loss_counts, sizeof(ev.counts));
+        loss_pending = false;
+    }
+    if (reset) memset(loss_counts, 0, sizeof(loss_counts));
+    portEXIT_CRITICAL(&loss_mux);
+    if (!pending) return;
+
+    ev.timestamp = (uint32_t)esp_timer_get_time();
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    hdr->msg_type    = MSG_EVT_LOSS;
+    hdr->flags       = 0;
+    hdr->payload_len = sizeof(loss_meta_t);
+    memcpy(msg + sizeof(proto_msg_hdr_t), &ev, sizeof(ev));
+    send_raw(msg, sizeof(msg));
+}
+
+/* -------- pool / TX queue helpers -------- */
+
+/* grab a buffer from the pool (non-blocking); NULL if the pool is empty */
+static uint8_t *pool_get(void)
+{
+    uint8_t *buf = NULL;
+    if (xQueueReceive(pool_queue, &buf, 0) != pdTRUE) {
+        TRACE(TRACE_EV_POOL_GET, TRACE_ARG_NONE);
+        return NULL;
+    }
+    TRACE(TRACE_EV_POOL_GET, (uint16_t)uxQueueMessagesWaiting(pool_queue));
+    return buf;
+}
+
+/* give a buffer back to the pool */
+static void pool_put(uint8_t *buf)
+{
+    xQueueSend(pool_queue, &buf, 0);
+    TRACE(TRACE_EV_POOL_PUT, (uint16_t)uxQueueMessagesWaiting(pool_queue));
+}
+
+/* hand a filled buffer to the TX task; on a full queue it goes back to the pool */
+static bool tx_enqueue(uint8_t *buf, size_t len)
+{
+    tx_item_t item = { .buf = buf, .len = len };
+    if (xQueueSend(tx_queue, &item, 0) != pdTRUE) {
+        TRACE(TRACE_EV_Q_SEND, TRACE_ARG_NONE);
+        pool_put(buf);
+        return false;
+    }
+    TRACE(TRACE_EV_Q_SEND, (uint16_t)uxQueueMessagesWaiting(tx_queue));
+    return true;
+}
+
+/*
+ * Start new loss counts for a scan or synth run and ACK cmd_type. The TX task
+ * does it in queue order: it flushes the old run's counts, resets them and
+ * sends the ACK, so the host sees every count once, on the right side of it.
+ */
+static void loss_restart(uint8_t cmd_type)
+{
+    tx_item_t item = { .buf = NULL, .len = cmd_type };
+    xQueueSend(tx_queue, &item, portMAX_DELAY);
+}
+
 /* -------- frame enqueue (called from promiscuous callback) -------- */
 
 void proto_send_frame(const wifi_promiscuous_pkt_t *pkt,
-                      wifi_promiscuous_pkt_type_t type)
+                      wifi_promiscuous_pkt_type_t type, uint16_t snaplen)
 {
     if (!scanning) return;
 
-    uint16_t sig_len = pkt->rx_ctrl.sig_len;
-    if (sig_len > MAX_FRAME_LEN) return; /* oversized, drop */
+    uint16_t orig_len = pkt->rx_ctrl.sig_len;
+    uint16_t sig_len = (snaplen && snaplen < orig_len) ? snaplen : orig_len;
+    if (sig_len > MAX_FRAME_LEN) {
+        loss_count(LOSS_OVERSIZE);
+        return;
+    }
 
-    /* grab a buffer from the pool (non-blocking) */
-    uint8_t *buf = NULL;
-    if (xQueueReceive(pool_queue, &buf, 0) != pdTRUE) return; /* pool empty */
+    uint8_t *buf = pool_get();
+    if (!buf) {
+        loss_count(LOSS_POOL_EMPTY);
+        return;
+    }
 
     /* build header */
     proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
@@ -119,52 +263,475 @@ void proto_send_frame(const wifi_promiscuous_pkt_t *pkt,
     meta->pkt_type    = (uint8_t)type;
     meta->rx_state    = pkt->rx_ctrl.rx_state;
     meta->rate        = pkt->rx_ctrl.rate;
-    meta->seq_num     = frame_seq++;
-    meta->_reserved   = 0;
+    meta->seq_num     = frame_seq;
+    meta->orig_len    = (sig_len < orig_len) ? orig_len : 0;
 
     /* copy raw frame */
     memcpy(buf + sizeof(proto_msg_hdr_t) + sizeof(frame_meta_t),
            pkt->payload, sig_len);
 
-    /* enqueue for TX task */
-    tx_item_t item = {
-        .buf = buf,
-        .len = sizeof(proto_msg_hdr_t) + sizeof(frame_meta_t) + sig_len,
-    };
-    if (xQueueSend(tx_queue, &item, 0) != pdTRUE) {
-        /* TX queue full — return buffer to pool, frame is dropped */
-        xQueueSend(pool_queue, &buf, 0);
+    /*
+     * enqueue for TX task; on a full queue the frame is dropped. The sequence
+     * number only advances for frames that go out, so host-side gaps are
+     * transit losses and device-side drops are reported by reason instead.
+     */
+    if (tx_enqueue(buf, sizeof(proto_msg_hdr_t) + sizeof(frame_meta_t) + sig_len)) {
+        frame_seq++;
+        frames_sent++;
+    } else {
+        loss_count(LOSS_QUEUE_FULL);
+    }
+}
+
+/* -------- BLE advert enqueue (called from the BLE host task) -------- */
+
+void proto_send_ble_adv(const ble_adv_meta_t *meta, const uint8_t *data)
+{
+    if (!scanning) return;
+    if (meta->data_len > BLE_ADV_MAX_DATA) return;
+
+    uint8_t *buf = pool_get();
+    if (!buf) {
+        loss_count(LOSS_BLE);
+        return;
+    }
+
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
+    hdr->msg_type    = MSG_EVT_BLE_ADV;
+    hdr->flags       = 0;
+    hdr->payload_len = sizeof(ble_adv_meta_t) + meta->data_len;
+
+    memcpy(buf + sizeof(proto_msg_hdr_t), meta, sizeof(ble_adv_meta_t));
+    memcpy(buf + sizeof(proto_msg_hdr_t) + sizeof(ble_adv_meta_t),
+           data, meta->data_len);
+
+    if (tx_enqueue(buf, sizeof(proto_msg_hdr_t) + hdr->payload_len)) {
+        ble_adv_sent++;
+    } else {
+        loss_count(LOSS_BLE);
     }
 }
 
+/* -------- anomaly enqueue (called from promiscuous callback) -------- */
+
+void proto_send_anomaly(const deauth_report_t *report, uint32_t timestamp)
+{
+    uint8_t *buf = pool_get();
+    if (!buf) {
+        loss_count(LOSS_EVENT);
+        return;
+    }
+
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
+    hdr->msg_type    = MSG_EVT_ANOMALY;
+    hdr->flags       = 0;
+    hdr->payload_len = sizeof(anomaly_meta_t);
+
+    anomaly_meta_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.timestamp      = timestamp;
+    ev.kind           = ANOMALY_DEAUTH_FLOOD;
+    ev.flags          = (report->flags & DEAUTH_REPORT_ONSET) ? ANOMALY_FLAG_ONSET : 0;
+    memcpy(ev.bssid, report->bssid, 6);
+    memcpy(ev.target, report->target, 6);
+    ev.channel        = report->channel;
+    ev.rssi           = report->rssi;
+    ev.window_count   = report->window_count;
+    ev.num_reasons    = report->num_reasons;
+    ev.duration_ms    = report->duration_ms;
+    ev.deauth_count   = report->deauth_count;
+    ev.disassoc_count = report->disassoc_count;
+    ev.suppressed     = report->suppressed;
+    for (int i = 0; i < report->num_reasons; i++) {
+        ev.reasons[i][0] = report->reasons[i].code;
+        ev.reasons[i][1] = report->reasons[i].count;
+    }
+    memcpy(buf + sizeof(proto_msg_hdr_t), &ev, sizeof(ev));
+
+    if (!tx_enqueue(buf, sizeof(proto_msg_hdr_t) + sizeof(anomaly_meta_t))) {
+        loss_count(LOSS_EVENT);
+    }
+}
+
+/* -------- CSI enqueue (called from the Wi-Fi task's CSI callback) -------- */
+
+void proto_send_csi(const wifi_csi_info_t *info, uint8_t bits, uint16_t suppressed)
+{
+    uint16_t len = info->len > CSI_MAX_LEN ? CSI_MAX_LEN : info->len;
+
+    uint8_t *buf = pool_get();
+    if (!buf) {
+        loss_count(LOSS_EVENT);
+        return;
+    }
+
+    csi_meta_t *meta = (csi_meta_t *)(buf + sizeof(proto_msg_hdr_t));
+    memset(meta, 0, sizeof(*meta));
+    meta->timestamp   = info->rx_ctrl.timestamp;
+    memcpy(meta->mac, info->mac, 6);
+    meta->channel     = info->rx_ctrl.channel;
+    meta->rssi        = info->rx_ctrl.rssi;
+    meta->noise_floor = info->rx_ctrl.noise_floor;
+    meta->rate        = info->rx_ctrl.rate;
+    meta->flags       = info->first_word_invalid ? CSI_FLAG_FIRST_WORD_INVALID : 0;
+    meta->bits        = bits;
+    meta->sig_len     = info->rx_ctrl.sig_len;
+    meta->csi_len     = len;
+    meta->suppressed  = suppressed;
+
+    size_t n = csi_pack(info->buf, len, bits,
+                        buf + sizeof(proto_msg_hdr_t) + sizeof(csi_meta_t), &meta->shift);
+
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
+    hdr->msg_type    = MSG_EVT_CSI;
+    hdr->flags       = 0;
+    hdr->payload_len = sizeof(csi_meta_t) + n;
+
+    if (!tx_enqueue(buf, sizeof(proto_msg_hdr_t) + hdr->payload_len)) {
+        loss_count(LOSS_EVENT);
+    }
+}
+
+void proto_send_detection(const wifi_promiscuous_pkt_t *pkt, uint8_t label,
+                          const clf_features_t *x, uint8_t confidence, uint16_t suppressed)
+{
+    uint8_t *buf = pool_get();
+    if (!buf) {
+        loss_count(LOSS_EVENT);
+        return;
+    }
+
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
+    hdr->msg_type    = MSG_EVT_DETECTION;
+    hdr->flags       = 0;
+    hdr->payload_len = sizeof(detection_meta_t);
+
+    detection_meta_t *ev = (detection_meta_t *)(buf + sizeof(proto_msg_hdr_t));
+    memset(ev, 0, sizeof(*ev));
+    ev->timestamp  = pkt->rx_ctrl.timestamp;
+    memcpy(ev->mac, pkt->payload + 10, 6);
+    ev->channel    = pkt->rx_ctrl.channel;
+    ev->rssi       = pkt->rx_ctrl.rssi;
+    ev->label      = label;
+    ev->confidence = confidence;
+    ev->subtype    = (uint8_t)x->f[CLF_F_SUBTYPE];
+    ev->interval   = (uint16_t)x->f[CLF_F_INTERVAL];
+    ev->suppressed = suppressed;
+    ev->ie_sig     = x->f[CLF_F_IE_SIG];
+
+    if (!tx_enqueue(buf, sizeof(proto_msg_hdr_t) + sizeof(detection_meta_t))) {
+        loss_count(LOSS_EVENT);
+    }
+}
+
+void proto_count_ble_dedup(void)
+{
+    ble_adv_dedup++;
+}
+
+/* -------- stats response -------- */
+
+static void proto_send_stats(void)
+{
+    uint8_t msg[sizeof(proto_msg_hdr_t) + sizeof(proto_stats_t)];
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    hdr->msg_type    = MSG_RSP_STATS;
+    hdr->flags       = FLAG_ACK;
+    hdr->payload_len = sizeof(proto_stats_t);
+
+    uint32_t wifi_ms, ble_ms;
+    uint16_t wifi_pm, ble_pm;
+    scan_get_radio_time(&wifi_ms, &ble_ms, &wifi_pm, &ble_pm);
+
+    proto_stats_t st;
+    st.wifi_ms       = wifi_ms;
+    st.ble_ms        = ble_ms;
+    st.wifi_permille = wifi_pm;
+    st.ble_permille  = ble_pm;
+    st.frames_sent   = frames_sent;
+    st.ble_adv_sent  = ble_adv_sent;
+    st.ble_adv_dedup = ble_adv_dedup;
+    memcpy(msg + sizeof(proto_msg_hdr_t), &st, sizeof(st));
+    send_raw(msg, sizeof(msg));
+}
+
+static void proto_send_hop_stats(void)
+{
+    uint8_t msg[sizeof(proto_msg_hdr_t) + sizeof(hop_stats_msg_t)];
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    hdr->msg_type    = MSG_RSP_HOP_STATS;
+    hdr->flags       = FLAG_ACK;
+    hdr->payload_len = sizeof(hop_stats_msg_t);
+
+    hopstat_t hs;
+    hopstat_guard_t g;
+    scan_get_hop_stats(&hs, &g);
+
+    hop_stats_msg_t st;
+    st.guard_us        = g.guard_us;
+    st.mode            = g.mode;
+    st._reserved       = 0;
+    st.switches        = hs.switches;
+    st.switch_us_total = hs.switch_us_total;
+    st.switch_us_max   = hs.switch_us_max;
+    st.settle_frames   = hs.settle_frames;
+    st.stale_frames    = hs.stale_frames;
+    st.guarded         = hs.guarded;
+    memcpy(st.switch_hist, hs.switch_hist, sizeof(st.switch_hist));
+    memcpy(st.stale_hist, hs.stale_hist, sizeof(st.stale_hist));
+    memcpy(msg + sizeof(proto_msg_hdr_t), &st, sizeof(st));
+    send_raw(msg, sizeof(msg));
+}
+
+static void proto_send_pong(const uint8_t *echo, size_t len, uint32_t rx_us)
+{
+    uint8_t msg[sizeof(proto_msg_hdr_t) + sizeof(pong_meta_t) + PING_MAX_ECHO];
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    hdr->msg_type    = MSG_RSP_PONG;
+    hdr->flags       = FLAG_ACK;
+    hdr->payload_len = sizeof(pong_meta_t) + len;
+
+    memcpy(msg + sizeof(proto_msg_hdr_t) + sizeof(pong_meta_t), echo, len);
+    pong_meta_t pong = { .rx_us = rx_us, .tx_us = (uint32_t)esp_timer_get_time() };
+    memcpy(msg + sizeof(proto_msg_hdr_t), &pong, sizeof(pong));
+    send_raw(msg, sizeof(proto_msg_hdr_t) + hdr->payload_len);
+}
+
 /* -------- TX task -------- */
 
+/* COBS-encode one message into enc and write it with delimiters */
+static void tx_write(const uint8_t *msg, size_t len, uint8_t *enc)
+{
+    uint8_t delim = 0x00;
+    size_t enc_len = cobs_encode(msg, len, enc);
+
+    TRACE(TRACE_EV_USB_BEGIN, (uint16_t)len);
+    usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(100));
+    int n = usb_serial_jtag_write_bytes(enc, enc_len, pdMS_TO_TICKS(500));
+    usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(100));
+    TRACE(TRACE_EV_USB_END, n < (int)enc_len);
+    if (n < (int)enc_len) loss_count(LOSS_USB_TIMEOUT);
+}
+
+/*
+ * Write the synthetic frames that are due, built in msg (one slot) and sent
+ * directly. They take seq numbers like captured frames. Frames the link was
+ * too busy to take in time count as LOSS_QUEUE_FULL.
+ */
+static void synth_send_due(uint8_t *msg, uint8_t *enc)
+{
+    uint32_t missed;
+    portENTER_CRITICAL(&synth_mux);
+    uint32_t due = synth_due(&synth, (uint64_t)esp_timer_get_time(), &missed);
+    portEXIT_CRITICAL(&synth_mux);
+    if (missed) loss_add(LOSS_QUEUE_FULL, missed);
+
+    proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)msg;
+    frame_meta_t *meta = (frame_meta_t *)(msg + sizeof(proto_msg_hdr_t));
+    uint8_t *frame = msg + sizeof(proto_msg_hdr_t) + sizeof(frame_meta_t);
+    memset(meta, 0, sizeof(*meta));
+    meta->pkt_type = WIFI_PKT_DATA;
+
+    for (uint32_t i = 0; i < due; i++) {
+        uint32_t n;
+        portENTER_CRITICAL(&synth_mux);
+        uint16_t len = synth_next(&synth, &n);
+        portEXIT_CRITICAL(&synth_mux);
+        synth_fill(frame, len, n);
+
+        hdr->msg_type    = MSG_EVT_FRAME;
+        hdr->flags       = FLAG_SYNTH;
+        hdr->payload_len = sizeof(frame_meta_t) + len;
+        meta->timestamp  = (uint32_t)esp_timer_get_time();
+        meta->frame_len  = len;
+        meta->seq_num    = frame_seq++;
+        frames_sent++;
+        tx_write(msg, sizeof(proto_msg_hdr_t) + sizeof(frame_meta_t) + len, enc);
+    }
+}
+
 static void proto_tx_task(void *arg)
 {
     (void)arg;
     static uint8_t enc_buf[COBS_MAX_OUT];
+    static uint8_t synth_buf[BUF_SLOT_SIZE];
     tx_item_t item;
-    uint8_t delim = 0x00;
+    TickType_t loss_sent = xTaskGetTickCount();
 
     while (1) {
-        if (xQueueReceive(tx_queue, &item, portMAX_DELAY) != pdTRUE)
-            continue;
-
-        size_t enc_len = cobs_encode(item.buf, item.len, enc_buf);
+        /* wake at least once per interval so pending losses get reported */
+        TickType_t wait = pdMS_TO_TICKS(LOSS_INTERVAL_MS);
+        if (synth_active(&synth)) {
+            synth_send_due(synth_buf, enc_buf);
+            portENTER_CRITICAL(&synth_mux);
+            uint32_t us = synth_wait_us(&synth, (uint64_t)esp_timer_get_time());
+            portEXIT_CRITICAL(&synth_mux);
+            uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+            if (us < wait * tick_us) wait = (us + tick_us - 1) / tick_us;
+        }
 
-        usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(100));
-        usb_serial_jtag_write_bytes(enc_buf, enc_len, pdMS_TO_TICKS(500));
-        usb_serial_jtag_write_bytes(&delim, 1, pdMS_TO_TICKS(100));
+        if (xQueueReceive(tx_queue, &item, wait) == pdTRUE) {
+            TRACE(TRACE_EV_Q_RECV, (uint16_t)uxQueueMessagesWaiting(tx_queue));
+            if (item.buf) {
+                tx_write(item.buf, item.len, enc_buf);
+                pool_put(item.buf);
+            } else {
+                loss_flush(true);
+                proto_send_ack((uint8_t)item.len);
+            }
+        }
 
-        /* return buffer to pool */
-        xQueueSend(pool_queue, &item.buf, 0);
+        TickType_t now = xTaskGetTickCount();
+        if (now - loss_sent >= pdMS_TO_TICKS(LOSS_INTERVAL_MS)) {
+            loss_flush(false);
+            loss_sent = now;
+        }
     }
 }
 
 /* -------- RX task (command parsing) -------- */
 
-#define RX_BUF_SIZE   64
-#define RX_ACCUM_SIZE 128
+#define RX_BUF_SIZE   256
+#define RX_ACCUM_SIZE 320   /* fits a full SET_SCHEDULE (1 + 32 * 9 bytes) or BULK_CHUNK */
+
+/*
+ * Validate and install a schedule (count byte + entries).
+ * Returns 0 or an ERR_* code.
+ */
+static uint8_t apply_schedule(const uint8_t *payload, size_t plen)
+{
+    if (plen < 1) return ERR_INVALID_PARAM;
+    int n = payload[0];
+    if (n > SCHED_MAX_HOPS || plen < 1 + (size_t)n * sizeof(sched_entry_msg_t)) {
+        return ERR_INVALID_PARAM;
+    }
+    sched_hop_t new_hops[SCHED_MAX_HOPS];
+    for (int i = 0; i < n; i++) {
+        sched_entry_msg_t e;
+        memcpy(&e, payload + 1 + i * sizeof(e), sizeof(e));
+        if (!is_valid_channel(e.channel)) return ERR_INVALID_CHANNEL;
+        if (e.type_mask & ~0x07) return ERR_INVALID_FILTER;
+        if (e.dwell_ms == 0) return ERR_INVALID_PARAM;
+        new_hops[i].channel       = e.channel;
+        new_hops[i].dwell_ms      = e.dwell_ms;
+        new_hops[i].type_mask     = e.type_mask;
+        new_hops[i].mgmt_subtypes = e.mgmt_subtypes;
+        new_hops[i].snaplen       = e.snaplen;
+        new_hops[i].rssi_min      = e.rssi_min;
+    }
+    scan_set_schedule(new_hops, n);
+    /* restart a running all-channel scan on the new schedule */
+    if (scanning && scan_channel < 0 && scan_task_handle) {
+        xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+    }
+    return 0;
+}
+
+/* Apply a committed bulk blob. Returns 0 or an ERR_* code. */
+static uint8_t apply_bulk(uint8_t kind, const uint8_t *blob, uint32_t len)
+{
+    switch (kind) {
+    case BULK_KIND_SCHEDULE:
+        return apply_schedule(blob, len);
+    case BULK_KIND_MAC_FILTER: {
+        macfilt_t f;
+        if (!macfilt_parse(blob, len, &f)) return ERR_INVALID_PARAM;
+        scan_set_mac_filter(&f);
+        /* restart a running scan on the capture path that filters */
+        if (scanning && scan_task_handle) {
+            xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+        }
+        return 0;
+    }
+    case BULK_KIND_CLASSIFIER: {
+        static clf_model_t m;   /* RX task only; too large for its stack */
+        if (!clf_parse(blob, len, &m)) return ERR_INVALID_PARAM;
+        if (!scan_set_classifier(&m)) return ERR_NO_MEMORY;
+        /* restart a running scan so the driver filter admits beacons */
+        if (scanning && scan_task_handle) {
+            xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+        }
+        return 0;
+    }
+    default:
+        return ERR_INVALID_PARAM;
+    }
+}
+
+/* -------- event trace -------- */
+
+#if TRACE_BUILD
+void proto_trace(uint8_t ev, uint16_t arg)
+{
+    uint32_t ts = (uint32_t)esp_timer_get_time();
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    int ctx = trace_find_ctx(&trace_ring, task);
+    if (ctx < 0) {
+        portENTER_CRITICAL(&trace_mux);
+        ctx = trace_add_ctx(&trace_ring, task, pcTaskGetName(task));
+        portEXIT_CRITICAL(&trace_mux);
+    }
+    trace_put(&trace_ring, ts, ev, (uint8_t)ctx, arg);
+}
+
+/*
+ * Stop recording and send the ring as MSG_EVT_TRACE chunks: the context
+ * names, then the records oldest first. Chunks wait for pool buffers like
+ * nothing else does, since the dump was asked for; while scanning, frames
+ * may be lost to it instead.
+ */
+static void proto_send_trace(void)
+{
+    trace_on = false;
+    vTaskDelay(1);  /* let a writer that already claimed a slot fill it */
+
+    trace_meta_t meta = {
+        .now  = (uint32_t)esp_timer_get_time(),
+        .lost = trace_lost(&trace_ring),
+    };
+    uint32_t total = trace_ring.head - meta.lost;
+    uint32_t sent = 0;
+    do {
+        uint8_t *buf = NULL;
+        if (xQueueReceive(pool_queue, &buf, pdMS_TO_TICKS(500)) != pdTRUE) {
+            loss_count(LOSS_EVENT);
+            return;
+        }
+        uint8_t *data = buf + sizeof(proto_msg_hdr_t) + sizeof(trace_meta_t);
+        size_t len;
+        if (meta.seq == 0) {
+            meta.count = trace_ring.num_ctx;
+            meta.flags = TRACE_F_NAMES;
+            len = (size_t)meta.count * TRACE_NAME_LEN;
+            memcpy(data, trace_ring.names, len);
+        } else {
+            meta.count = (uint8_t)trace_read(&trace_ring, sent, trace_chunk, TRACE_CHUNK_RECS);
+            meta.flags = 0;
+            len = (size_t)meta.count * sizeof(trace_rec_t);
+            memcpy(data, trace_chunk, len);
+            sent += meta.count;
+        }
+        if (sent == total) meta.flags |= TRACE_F_LAST;
+
+        proto_msg_hdr_t *hdr = (proto_msg_hdr_t *)buf;
+        hdr->msg_type    = MSG_EVT_TRACE;
+        hdr->flags       = 0;
+        hdr->payload_len = sizeof(trace_meta_t) + len;
+        memcpy(buf + sizeof(proto_msg_hdr_t), &meta, sizeof(meta));
+        if (!tx_enqueue(buf, sizeof(proto_msg_hdr_t) + hdr->payload_len)) {
+            loss_count(LOSS_EVENT);
+            return;
+        }
+        meta.seq++;
+    } while (!(meta.flags & TRACE_F_LAST));
+}
+#else
+void proto_trace(uint8_t ev, uint16_t arg)
+{
+    (void)ev;
+    (void)arg;
+}
+#endif
 
 static void handle_command(const uint8_t *data, size_t len)
 {
@@ -201,6 +768,9 @@ static void handle_command(const uint8_t *data, size_t len)
                                   : (WIFI_PROMIS_FILTER_MASK_MGMT |
                                      WIFI_PROMIS_FILTER_MASK_CTRL |
                                      WIFI_PROMIS_FILTER_MASK_DATA);
+        portENTER_CRITICAL(&synth_mux);
+        synth_start(&synth, &(synth_config_t){ 0 }, 0);
+        portEXIT_CRITICAL(&synth_mux);
         scanning = true;
         wifi_promiscuous_filter_t filt = { .filter_mask = mask };
         esp_wifi_set_promiscuous_filter(&filt);
@@ -211,7 +781,7 @@ static void handle_command(const uint8_t *data, size_t len)
         if (scan_task_handle) {
             xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
         }
-        proto_send_ack(hdr.msg_type);
+        loss_restart(hdr.msg_type);
         break;
     }
 
@@ -250,6 +820,281 @@ static void handle_command(const uint8_t *data, size_t len)
         proto_send_promisc_status(promisc_on);
         break;
 
+    case MSG_CMD_BLE_CONFIG: {
+        if (plen < sizeof(ble_config_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        ble_config_t cfg;
+        memcpy(&cfg, payload, sizeof(cfg));
+        if (cfg.window_ms > 0 && !ble_available()) {
+            proto_send_error(hdr.msg_type, ERR_UNSUPPORTED);
+            return;
+        }
+        ble_set_dedup_ms(cfg.dedup_ms);
+        ble_window_ms = cfg.window_ms;
+        ble_every     = cfg.every ? cfg.every : 1;
+        /* restart the schedule so the new interleave takes effect */
+        if (scanning && scan_task_handle) {
+            xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_STATS_QUERY:
+        proto_send_stats();
+        break;
+
+    case MSG_CMD_DEAUTH_CONFIG: {
+        if (plen < sizeof(deauth_config_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        deauth_config_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+        if (msg.threshold > 0 && msg.window_ms == 0) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        deauth_config_t cfg = {
+            .threshold = msg.threshold,
+            .window_ms = msg.window_ms,
+            .report_ms = msg.report_ms,
+            .suppress  = msg.suppress != 0,
+        };
+        scan_set_deauth_config(&cfg);
+        /* restart a running scan on the capture path with (or without) the detector */
+        if (scanning && scan_task_handle) {
+            xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_SET_SCHEDULE: {
+        uint8_t err = apply_schedule(payload, plen);
+        if (err) {
+            proto_send_error(hdr.msg_type, err);
+            return;
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_BULK_BEGIN: {
+        if (plen < sizeof(bulk_begin_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        bulk_begin_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+        bulk_status_t st = bulk_begin(&bulk, msg.kind, msg.total_len, msg.crc32);
+        if (st != BULK_OK) {
+            proto_send_error(hdr.msg_type,
+                             st == BULK_ERR_NO_MEMORY ? ERR_NO_MEMORY : ERR_INVALID_PARAM);
+            return;
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_BULK_CHUNK: {
+        /* acknowledged with the contiguous byte count; the host windows on it */
+        if (!bulk_active(&bulk)) {
+            proto_send_bulk_ack(BULK_ACK_NONE);
+            return;
+        }
+        if (plen < 4 || plen > 4 + BULK_CHUNK_MAX) {
+            proto_send_bulk_ack(bulk.received);
+            return;
+        }
+        uint32_t offset;
+        memcpy(&offset, payload, 4);
+        proto_send_bulk_ack(bulk_chunk(&bulk, offset, payload + 4, plen - 4));
+        break;
+    }
+
+    case MSG_CMD_BULK_COMMIT: {
+        uint8_t kind = bulk.kind;
+        uint8_t *blob;
+        uint32_t blob_len;
+        bulk_status_t st = bulk_commit(&bulk, &blob, &blob_len);
+        if (st != BULK_OK) {
+            proto_send_error(hdr.msg_type, st == BULK_ERR_CRC ? ERR_CRC : ERR_INVALID_PARAM);
+            return;
+        }
+        uint8_t err = apply_bulk(kind, blob, blob_len);
+        free(blob);
+        if (err) {
+            proto_send_error(hdr.msg_type, err);
+            return;
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_HOP_GUARD: {
+        if (plen < sizeof(hop_guard_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        hop_guard_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+        if (msg.mode > HOP_GUARD_RELABEL || msg.guard_us > HOPSTAT_WINDOW_US) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        hopstat_guard_t g = { .guard_us = msg.guard_us, .mode = msg.mode };
+        scan_set_hop_guard(&g);
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_HOP_STATS_QUERY:
+        proto_send_hop_stats();
+        break;
+
+    case MSG_CMD_SYNTH: {
+        if (plen < sizeof(synth_config_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        synth_config_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+        if (msg.rate && scanning) {
+            proto_send_error(hdr.msg_type, ERR_SCAN_ACTIVE);
+            return;
+        }
+        if (msg.rate > SYNTH_MAX_RATE || msg.dist > SYNTH_DIST_IMIX ||
+            msg.len_min < SYNTH_HDR_LEN || msg.len_min > msg.len_max ||
+            msg.len_max > MAX_FRAME_LEN) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        synth_config_t cfg = {
+            .rate    = msg.rate,
+            .count   = msg.count,
+            .len_min = msg.len_min,
+            .len_max = msg.len_max,
+            .dist    = msg.dist,
+        };
+        portENTER_CRITICAL(&synth_mux);
+        synth_start(&synth, &cfg, (uint64_t)esp_timer_get_time());
+        portEXIT_CRITICAL(&synth_mux);
+        if (msg.rate) loss_restart(hdr.msg_type);
+        else proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_CSI_CONFIG: {
+        if (plen < sizeof(csi_config_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        csi_config_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+#if !CONFIG_ESP_WIFI_CSI_ENABLED
+        if (msg.enable) {
+            proto_send_error(hdr.msg_type, ERR_UNSUPPORTED);
+            return;
+        }
+#endif
+        if ((msg.bits != CSI_BITS_8 && msg.bits != CSI_BITS_4) ||
+            msg.num_match > CSI_MAX_MATCH ||
+            plen < sizeof(msg) + msg.num_match * sizeof(csi_match_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        csi_config_t cfg = {
+            .bits        = msg.bits,
+            .interval_ms = msg.interval_ms,
+            .num_match   = msg.num_match,
+        };
+        for (int i = 0; i < msg.num_match; i++) {
+            csi_match_msg_t m;
+            memcpy(&m, payload + sizeof(msg) + i * sizeof(m), sizeof(m));
+            if (m.prefix != 3 && m.prefix != 6) {
+                proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+                return;
+            }
+            memcpy(cfg.match[i].addr, m.addr, 6);
+            cfg.match[i].prefix = m.prefix;
+        }
+        if (!scan_set_csi(&cfg, msg.enable != 0)) {
+            proto_send_error(hdr.msg_type, ERR_WIFI_FAIL);
+            return;
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_PROBE_CONFIG: {
+        if (plen < sizeof(probe_config_msg_t)) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        probe_config_msg_t msg;
+        memcpy(&msg, payload, sizeof(msg));
+        if ((msg.enable && (msg.rate == 0 || msg.rate > PROBE_MAX_RATE)) ||
+            msg.num_ssids > PROBE_MAX_SSIDS) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        probe_config_t cfg = {
+            .rate      = msg.enable ? msg.rate : 0,
+            .flags     = msg.flags,
+            .num_ssids = msg.num_ssids,
+        };
+        memcpy(cfg.src, msg.src, 6);
+        size_t off = sizeof(msg);
+        for (int i = 0; i < msg.num_ssids; i++) {
+            uint8_t n = off < plen ? payload[off] : 0xFF;
+            if (n > PROBE_MAX_SSID_LEN || off + 1 + n > plen) {
+                proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+                return;
+            }
+            cfg.ssids[i].len = n;
+            memcpy(cfg.ssids[i].ssid, payload + off + 1, n);
+            off += 1 + n;
+        }
+        if (!scan_set_probe(&cfg)) {
+            proto_send_error(hdr.msg_type, ERR_WIFI_FAIL);
+            return;
+        }
+        /* a mode change can move the radio: restart on the schedule */
+        if (scanning && scan_task_handle) {
+            xTaskNotify(scan_task_handle, 1, eSetValueWithOverwrite);
+        }
+        proto_send_ack(hdr.msg_type);
+        break;
+    }
+
+    case MSG_CMD_PING: {
+        uint32_t rx_us = (uint32_t)esp_timer_get_time();
+        proto_send_pong(payload, plen < PING_MAX_ECHO ? plen : PING_MAX_ECHO, rx_us);
+        break;
+    }
+
+    case MSG_CMD_TRACE: {
+#if TRACE_BUILD
+        if (plen < 1 || payload[0] > TRACE_DUMP) {
+            proto_send_error(hdr.msg_type, ERR_INVALID_PARAM);
+            return;
+        }
+        trace_on = false;
+        if (payload[0] == TRACE_ON) {
+            trace_clear(&trace_ring);
+            trace_on = true;
+        }
+        proto_send_ack(hdr.msg_type);
+        if (payload[0] == TRACE_DUMP) proto_send_trace();
+#else
+        proto_send_error(hdr.msg_type, ERR_UNSUPPORTED);
+#endif
+        break;
+    }
+
     default:
         proto_send_error(hdr.msg_type, ERR_UNKNOWN_CMD);
         break;
@@ -275,7 +1120,9 @@ static void proto_rx_task(void *arg)
                 if (accum_len > 0) {
                     int dec_len = cobs_decode(accum, accum_len, decoded);
                     if (dec_len > 0) {
+                        TRACE(TRACE_EV_CMD_BEGIN, decoded[0]);
                         handle_command(decoded, (size_t)dec_len);
+                        TRACE(TRACE_EV_CMD_END, decoded[0]);
                     }
                     accum_len = 0;
                 }
@@ -298,7 +1145,7 @@ void proto_init(void)
     /* install USB serial JTAG driver */
     usb_serial_jtag_driver_config_t usb_cfg = {
         .tx_buffer_size = 4096,
-        .rx_buffer_size = 256,
+        .rx_buffer_size = 4096,     /* room for a window of bulk chunks */
     };
     usb_serial_jtag_driver_install(&usb_cfg);
 
@@ -6,6 +6,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_wifi.h"
+#include "sched.h"
+#include "deauth.h"
+#include "bulk.h"
+#include "macfilt.h"
+#include "cobs.h"
+#include "hopstat.h"
+#include "synth.h"
+#include "csi.h"
+#include "probe.h"
+#include "classify.h"
+#include "trace.h"
 
 /* -------- message types -------- */
 
@@ -15,18 +26,47 @@
 #define MSG_CMD_PROMISC_ON      0x03
 #define MSG_CMD_PROMISC_OFF     0x04
 #define MSG_CMD_PROMISC_QUERY   0x05
+#define MSG_CMD_BLE_CONFIG      0x06
+#define MSG_CMD_STATS_QUERY     0x07
+#define MSG_CMD_DEAUTH_CONFIG   0x08
+#define MSG_CMD_SET_SCHEDULE    0x09
+#define MSG_CMD_BULK_BEGIN      0x0A
+#define MSG_CMD_BULK_CHUNK      0x0B
+#define MSG_CMD_BULK_COMMIT     0x0C
+#define MSG_CMD_HOP_GUARD       0x0D
+#define MSG_CMD_HOP_STATS_QUERY 0x0E
+#define MSG_CMD_SYNTH           0x0F
+#define MSG_CMD_PING            0x10
+#define MSG_CMD_CSI_CONFIG      0x11
+#define MSG_CMD_PROBE_CONFIG    0x12
+#define MSG_CMD_TRACE           0x13
 
 /* responses (device -> client) */
 #define MSG_RSP_ACK             0x81
 #define MSG_RSP_ERROR           0x82
 #define MSG_RSP_PROMISC_STATUS  0x83
+#define MSG_RSP_STATS           0x84
+#define MSG_RSP_BULK_ACK        0x85
+#define MSG_RSP_HOP_STATS       0x86
+#define MSG_RSP_PONG            0x87
 
 /* async events (device -> client) */
 #define MSG_EVT_FRAME           0xC0
+#define MSG_EVT_BLE_ADV         0xC1
+#define MSG_EVT_ANOMALY         0xC2
+#define MSG_EVT_LOSS            0xC3
+#define MSG_EVT_CSI             0xC4
+#define MSG_EVT_DETECTION       0xC5
+#define MSG_EVT_TRACE           0xC6
+
+/* -------- anomaly kinds / flags -------- */
+#define ANOMALY_DEAUTH_FLOOD    0x01
+#define ANOMALY_FLAG_ONSET      (1 << 0)    /* first report of this anomaly */
 
 /* -------- flags -------- */
 #define FLAG_ERR                (1 << 0)
 #define FLAG_ACK                (1 << 1)
+#define FLAG_SYNTH              (1 << 2)    /* frame event from the synthetic source */
 
 /* -------- error codes -------- */
 #define ERR_UNKNOWN_CMD         0x01
@@ -34,6 +74,10 @@
 #define ERR_WIFI_FAIL           0x03
 #define ERR_SCAN_ACTIVE         0x04
 #define ERR_INVALID_FILTER      0x05
+#define ERR_INVALID_PARAM       0x06
+#define ERR_UNSUPPORTED         0x07
+#define ERR_CRC                 0x08
+#define ERR_NO_MEMORY           0x09
 
 /* -------- frame size limits -------- */
 #define MAX_FRAME_LEN           2300
@@ -60,17 +104,304 @@ typedef struct __attribute__((packed)) {
     uint8_t  rx_state;
     uint8_t  rate;
     uint16_t seq_num;
-    uint16_t _reserved;
+    uint16_t orig_len;      /* length on air when cut to the hop's snaplen, else 0 */
 } frame_meta_t;
 
 _Static_assert(sizeof(frame_meta_t) == 16, "frame_meta_t must be 16 bytes");
 
+/* -------- BLE advertisement metadata (14 bytes) -------- */
+#define BLE_ADV_MAX_DATA        31
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;
+    uint8_t  addr[6];
+    uint8_t  addr_type;
+    int8_t   rssi;
+    uint8_t  adv_type;
+    uint8_t  data_len;
+} ble_adv_meta_t;
+
+_Static_assert(sizeof(ble_adv_meta_t) == 14, "ble_adv_meta_t must be 14 bytes");
+
+/* -------- BLE config command payload (5 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint16_t window_ms;     /* 0 = BLE scanning off */
+    uint8_t  every;         /* BLE window after every N Wi-Fi hops */
+    uint16_t dedup_ms;      /* suppress repeats of the same addr+payload */
+} ble_config_t;
+
+_Static_assert(sizeof(ble_config_t) == 5, "ble_config_t must be 5 bytes");
+
+/* -------- stats response payload (24 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint32_t wifi_ms;           /* radio time accounted to Wi-Fi */
+    uint32_t ble_ms;            /* radio time accounted to BLE */
+    uint16_t wifi_permille;     /* duty cycle per radio */
+    uint16_t ble_permille;
+    uint32_t frames_sent;
+    uint32_t ble_adv_sent;
+    uint32_t ble_adv_dedup;     /* adverts suppressed as duplicates */
+} proto_stats_t;
+
+_Static_assert(sizeof(proto_stats_t) == 24, "proto_stats_t must be 24 bytes");
+
+/* -------- deauth config command payload (7 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint16_t threshold;     /* deauth/disassoc frames per window; 0 = detector off */
+    uint16_t window_ms;
+    uint16_t report_ms;     /* re-report interval while flooding; 0 = onset only */
+    uint8_t  suppress;      /* 1 = drop the frames of an ongoing flood */
+} deauth_config_msg_t;
+
+_Static_assert(sizeof(deauth_config_msg_t) == 7, "deauth_config_msg_t must be 7 bytes");
+
+/* -------- anomaly event payload (56 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;         /* rx timestamp of the triggering frame */
+    uint8_t  kind;              /* ANOMALY_* */
+    uint8_t  flags;             /* ANOMALY_FLAG_* */
+    uint8_t  bssid[6];
+    uint8_t  target[6];
+    uint8_t  channel;
+    int8_t   rssi;
+    uint16_t window_count;      /* frames in the current window */
+    uint8_t  num_reasons;
+    uint8_t  _reserved;
+    uint32_t duration_ms;
+    uint32_t deauth_count;      /* since the flood started */
+    uint32_t disassoc_count;
+    uint32_t suppressed;        /* frames dropped instead of forwarded */
+    uint16_t reasons[DEAUTH_MAX_REASONS][2];    /* (reason code, count) */
+} anomaly_meta_t;
+
+_Static_assert(sizeof(anomaly_meta_t) == 56, "anomaly_meta_t must be 56 bytes");
+
+/* -------- loss event payload: u32 timestamp, u16 seq range, u32 counts[] -------- */
+#define LOSS_POOL_EMPTY         0   /* frame: no TX buffer free */
+#define LOSS_QUEUE_FULL         1   /* frame: TX queue full */
+#define LOSS_OVERSIZE           2   /* frame: longer than MAX_FRAME_LEN */
+#define LOSS_USB_TIMEOUT        3   /* any message cut short by a USB write timeout */
+#define LOSS_BLE                4   /* BLE advert: no buffer or queue full */
+#define LOSS_EVENT              5   /* anomaly, CSI or detection event: no buffer or queue full */
+#define LOSS_NUM_REASONS        6
+
+#define LOSS_INTERVAL_MS        250 /* at most one loss event per interval */
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;         /* esp_timer, microseconds */
+    uint16_t seq_first;         /* next frame seq_num at the first / last loss */
+    uint16_t seq_last;          /* since the previous loss event */
+    uint32_t counts[LOSS_NUM_REASONS];  /* cumulative since the last SCAN_START */
+} loss_meta_t;
+
+_Static_assert(sizeof(loss_meta_t) == 32, "loss_meta_t must be 32 bytes");
+
+/* -------- hop guard command payload (3 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint16_t guard_us;      /* 0 = no guard, at most HOPSTAT_WINDOW_US */
+    uint8_t  mode;          /* HOP_GUARD_* */
+} hop_guard_msg_t;
+
+_Static_assert(sizeof(hop_guard_msg_t) == 3, "hop_guard_msg_t must be 3 bytes");
+
+/* -------- hop stats response payload (92 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint16_t guard_us;          /* current guard */
+    uint8_t  mode;
+    uint8_t  _reserved;
+    uint32_t switches;          /* channel switches since SCAN_START */
+    uint32_t switch_us_total;
+    uint32_t switch_us_max;
+    uint32_t settle_frames;     /* frames within HOPSTAT_WINDOW_US of a switch */
+    uint32_t stale_frames;      /* of those, from another channel */
+    uint32_t guarded;           /* stale frames dropped or relabelled */
+    uint32_t switch_hist[HOPSTAT_BUCKETS];
+    uint32_t stale_hist[HOPSTAT_BUCKETS];
+} hop_stats_msg_t;
+
+_Static_assert(sizeof(hop_stats_msg_t) == 92, "hop_stats_msg_t must be 92 bytes");
+
+/* -------- synthetic source command payload (13 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint32_t rate;          /* frames per second, at most SYNTH_MAX_RATE; 0 = stop */
+    uint32_t count;         /* frames to offer, then stop; 0 = until stopped */
+    uint16_t len_min;       /* at least SYNTH_HDR_LEN */
+    uint16_t len_max;       /* at least len_min, at most MAX_FRAME_LEN */
+    uint8_t  dist;          /* SYNTH_DIST_* */
+} synth_config_msg_t;
+
+_Static_assert(sizeof(synth_config_msg_t) == 13, "synth_config_msg_t must be 13 bytes");
+
+/* -------- ping: up to PING_MAX_ECHO opaque bytes, echoed after pong_meta_t -------- */
+#define PING_MAX_ECHO           32
+
+typedef struct __attribute__((packed)) {
+    uint32_t rx_us;         /* esp_timer when the ping was handled */
+    uint32_t tx_us;         /* esp_timer just before the pong was written */
+} pong_meta_t;
+
+_Static_assert(sizeof(pong_meta_t) == 8, "pong_meta_t must be 8 bytes");
+
+/* -------- CSI config command payload: header + num_match entries (7 bytes each) -------- */
+typedef struct __attribute__((packed)) {
+    uint8_t  enable;        /* 0 = CSI off */
+    uint8_t  bits;          /* CSI_BITS_8 or CSI_BITS_4 */
+    uint16_t interval_ms;   /* per-transmitter rate limit; 0 = none */
+    uint8_t  num_match;     /* at most CSI_MAX_MATCH; 0 = every transmitter */
+} csi_config_msg_t;
+
+_Static_assert(sizeof(csi_config_msg_t) == 5, "csi_config_msg_t must be 5 bytes");
+
+typedef struct __attribute__((packed)) {
+    uint8_t  prefix;        /* 3 = OUI, 6 = full address */
+    uint8_t  addr[6];
+} csi_match_msg_t;
+
+_Static_assert(sizeof(csi_match_msg_t) == 7, "csi_match_msg_t must be 7 bytes");
+
+/* -------- CSI event payload: csi_meta_t + packed samples (24 bytes + data) -------- */
+#define CSI_FLAG_FIRST_WORD_INVALID (1 << 0)    /* first four values are not valid */
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;
+    uint8_t  mac[6];        /* transmitter */
+    uint8_t  channel;
+    int8_t   rssi;
+    int8_t   noise_floor;
+    uint8_t  rate;
+    uint8_t  flags;         /* CSI_FLAG_* */
+    uint8_t  bits;          /* CSI_BITS_* of the data */
+    uint8_t  shift;         /* CSI_BITS_4: values were divided by 2^shift */
+    uint8_t  _reserved;
+    uint16_t sig_len;       /* length of the PPDU the CSI came from */
+    uint16_t csi_len;       /* int8 values before packing */
+    uint16_t suppressed;    /* reports from this transmitter held back by the rate limit */
+} csi_meta_t;
+
+_Static_assert(sizeof(csi_meta_t) == 24, "csi_meta_t must be 24 bytes");
+
+/* -------- probe config command payload: header + num_ssids × (u8 len, SSID) -------- */
+typedef struct __attribute__((packed)) {
+    uint8_t  enable;        /* 0 = probing off */
+    uint8_t  flags;         /* PROBE_FLAG_* */
+    uint8_t  src[6];        /* transmitter address; all zero = the radio's own */
+    uint16_t rate;          /* probes per second, 1..PROBE_MAX_RATE */
+    uint8_t  num_ssids;     /* at most PROBE_MAX_SSIDS; 0 = wildcard only */
+} probe_config_msg_t;
+
+_Static_assert(sizeof(probe_config_msg_t) == 11, "probe_config_msg_t must be 11 bytes");
+
+/* -------- detection event payload (24 bytes) -------- */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;     /* rx timestamp of the scored frame */
+    uint8_t  mac[6];        /* transmitter */
+    uint8_t  channel;
+    int8_t   rssi;
+    uint8_t  label;         /* of the model */
+    uint8_t  confidence;    /* 0..255 */
+    uint8_t  subtype;       /* 8 = beacon, 5 = probe response */
+    uint8_t  _reserved;
+    uint16_t interval;      /* beacon interval, TU */
+    uint16_t suppressed;    /* detections of this transmitter held back since the last one */
+    uint32_t ie_sig;        /* CLF_F_IE_SIG of the frame */
+} detection_meta_t;
+
+_Static_assert(sizeof(detection_meta_t) == 24, "detection_meta_t must be 24 bytes");
+
+/* -------- trace event payload: trace_meta_t + count records or names -------- */
+#define TRACE_F_NAMES           (1 << 0)    /* count × TRACE_NAME_LEN context names, by context */
+#define TRACE_F_LAST            (1 << 1)    /* the last chunk of the dump */
+#define TRACE_CHUNK_RECS        240         /* records per chunk */
+
+typedef struct __attribute__((packed)) {
+    uint32_t now;           /* esp_timer at the dump, for unwrapping record times */
+    uint32_t lost;          /* records overwritten before the dump */
+    uint16_t seq;           /* chunk index within the dump, names first */
+    uint8_t  count;
+    uint8_t  flags;         /* TRACE_F_* */
+} trace_meta_t;
+
+_Static_assert(sizeof(trace_meta_t) == 12, "trace_meta_t must be 12 bytes");
+
+/* -------- set-schedule command payload: u8 count + count entries (9 bytes each) -------- */
+typedef struct __attribute__((packed)) {
+    uint8_t  channel;
+    uint16_t dwell_ms;
+    uint8_t  type_mask;     /* 0x01=mgmt 0x02=ctrl 0x04=data, 0 = all */
+    uint16_t mgmt_subtypes; /* bit n admits mgmt subtype n, 0 = all */
+    uint16_t snaplen;       /* 0 = whole frame */
+    int8_t   rssi_min;      /* -128 = no gate */
+} sched_entry_msg_t;
+
+_Static_assert(sizeof(sched_entry_msg_t) == 9, "sched_entry_msg_t must be 9 bytes");
+
+/* -------- bulk transfer (BULK_KIND_* in bulk.h) -------- */
+#define BULK_CHUNK_MAX          256     /* data bytes per BULK_CHUNK */
+#define BULK_ACK_NONE           0xFFFFFFFFu /* BULK_ACK when no transfer is active */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  kind;          /* BULK_KIND_* */
+    uint32_t total_len;
+    uint32_t crc32;         /* CRC-32 (zlib) of the whole blob */
+} bulk_begin_msg_t;
+
+_Static_assert(sizeof(bulk_begin_msg_t) == 9, "bulk_begin_msg_t must be 9 bytes");
+
+/* BULK_CHUNK payload: u32 offset + up to BULK_CHUNK_MAX data bytes.
+ * BULK_ACK payload:   u32 contiguous bytes received (or BULK_ACK_NONE). */
+
 /* -------- shared state (owned by sniffer.c, used by protocol.c) -------- */
 extern volatile bool     scanning;
 extern volatile bool     promisc_on;
 extern volatile int      scan_channel;    /* -1 = all, >0 = specific */
 extern volatile uint8_t  scan_filter;     /* bitmask: 0x01=mgmt 0x02=ctrl 0x04=data, 0=all */
 extern TaskHandle_t      scan_task_handle;
+extern volatile uint16_t ble_window_ms;   /* 0 = BLE scanning off */
+extern volatile uint8_t  ble_every;
+extern volatile bool     trace_on;        /* owned by protocol.c */
+
+/* Copy out per-radio time accounted by the scan scheduler. */
+void scan_get_radio_time(uint32_t *wifi_ms, uint32_t *ble_ms,
+                         uint16_t *wifi_permille, uint16_t *ble_permille);
+
+/*
+ * Install a custom hop schedule used for all-channel scans (n = 0 restores
+ * the default table built from scan_filter). Takes effect at the next
+ * (re)start of the scan.
+ */
+void scan_set_schedule(const sched_hop_t *hops, int n);
+
+/* Swap in a new MAC filter (takes ownership of f's table) and free the old one. */
+void scan_set_mac_filter(const macfilt_t *f);
+
+/* Replace the deauth flood detector thresholds (clears its table). */
+void scan_set_deauth_config(const deauth_config_t *cfg);
+
+/* Set the post-switch guard interval applied to frames from the old channel. */
+void scan_set_hop_guard(const hopstat_guard_t *g);
+
+/* Copy out channel-switch accounting (reset at every scan start) and the guard. */
+void scan_get_hop_stats(hopstat_t *out, hopstat_guard_t *g);
+
+/*
+ * Install the CSI filter and turn CSI reporting on or off. Returns false if
+ * CSI is not built in (CONFIG_ESP_WIFI_CSI_ENABLED) or the driver refuses.
+ */
+bool scan_set_csi(const csi_config_t *cfg, bool enable);
+
+/*
+ * Send probe requests at the start of every Wi-Fi dwell (rate 0 = off). An
+ * all-zero cfg->src is replaced by the station address. Probing needs the
+ * station interface, so the Wi-Fi mode is switched to STA while it is on.
+ * Returns false if the driver refuses.
+ */
+bool scan_set_probe(const probe_config_t *cfg);
+
+/*
+ * Replace the beacon classifier (CLF_KIND_OFF turns it off) and clear its
+ * hold-off table. Returns false if there is no memory for it.
+ */
+bool scan_set_classifier(const clf_model_t *m);
 
 /* -------- protocol API -------- */
 
@@ -78,11 +409,12 @@ extern TaskHandle_t      scan_task_handle;
 void proto_init(void);
 
 /*
- * Called from the promiscuous callback to enqueue a captured frame.
+ * Called from the promiscuous callback to enqueue a captured frame, cut to
+ * snaplen bytes (0 = whole frame).
  * Non-blocking: drops the frame if no buffer is available or TX queue is full.
  */
 void proto_send_frame(const wifi_promiscuous_pkt_t *pkt,
-                      wifi_promiscuous_pkt_type_t type);
+                      wifi_promiscuous_pkt_type_t type, uint16_t snaplen);
 
 /* Send an ACK response for the given command type. */
 void proto_send_ack(uint8_t cmd_type);
@@ -93,6 +425,54 @@ void proto_send_error(uint8_t cmd_type, uint8_t error_code);
 /* Send promiscuous mode status. */
 void proto_send_promisc_status(bool enabled);
 
-/* -------- COBS -------- */
-size_t cobs_encode(const uint8_t *src, size_t len, uint8_t *dst);
-int    cobs_decode(const uint8_t *src, size_t len, uint8_t *dst);
+/*
+ * Enqueue a BLE advertisement on the same TX pipeline as frames.
+ * Non-blocking; safe to call from the BLE host task.
+ */
+void proto_send_ble_adv(const ble_adv_meta_t *meta, const uint8_t *data);
+
+/* Enqueue a deauth flood report (non-blocking, from the promiscuous callback). */
+void proto_send_anomaly(const deauth_report_t *report, uint32_t timestamp);
+
+/*
+ * Enqueue a CSI report, packed to bits per value (non-blocking, from the
+ * Wi-Fi task's CSI callback).
+ */
+void proto_send_csi(const wifi_csi_info_t *info, uint8_t bits, uint16_t suppressed);
+
+/* Enqueue a classifier detection (non-blocking, from the promiscuous callback). */
+void proto_send_detection(const wifi_promiscuous_pkt_t *pkt, uint8_t label,
+                          const clf_features_t *x, uint8_t confidence, uint16_t suppressed);
+
+/* Count an advert suppressed by device-side dedup (for stats). */
+void proto_count_ble_dedup(void);
+
+/*
+ * Record a trace event for the calling task (see trace.h). Trace points use
+ * TRACE(), which skips the call and the argument while tracing is off and
+ * compiles to nothing without TRACE_BUILD.
+ */
+void proto_trace(uint8_t ev, uint16_t arg);
+
+#if TRACE_BUILD
+#define TRACE(ev, arg)  do { if (trace_on) proto_trace((ev), (arg)); } while (0)
+#else
+#define TRACE(ev, arg)  do { } while (0)
+#endif
+
+/* -------- BLE passive scanning (ble.c) -------- */
+
+/* Bring up the BLE host stack. Returns false if BLE is not built in. */
+bool ble_init(void);
+
+/* Whether BLE scanning is compiled in and the host stack is synced. */
+bool ble_available(void);
+
+/* Set the window in which a repeated addr+payload is suppressed. */
+void ble_set_dedup_ms(uint16_t dedup_ms);
+
+/* Start a passive scan window; it ends on its own after duration_ms. */
+void ble_scan_window_start(uint32_t duration_ms);
+
+/* Cancel the scan window early (e.g. scan stopped). */
+void ble_scan_window_stop(void);
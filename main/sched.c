@@ -0,0 +1,66 @@
+#include "sched.h"
+#include <string.h>
+
+void sched_init(sched_t *s, const sched_hop_t *hops, int num_hops)
+{
+    memset(s, 0, sizeof(*s));
+    s->hops      = hops;
+    s->num_hops  = num_hops;
+    s->ble_every = 1;
+}
+
+void sched_set_ble(sched_t *s, uint16_t window_ms, uint8_t every)
+{
+    s->ble_window_ms  = window_ms;
+    s->ble_every      = every ? every : 1;
+    s->hops_since_ble = 0;
+}
+
+static void account(sched_t *s, uint32_t now_ms)
+{
+    if (!s->running) return;
+    /* unsigned subtraction handles wrap of the ms clock */
+    s->radio_ms[s->cur_radio] += now_ms - s->slot_start_ms;
+    s->running = false;
+}
+
+void sched_next(sched_t *s, uint32_t now_ms, sched_slot_t *out)
+{
+    account(s, now_ms);
+
+    bool ble_due = s->ble_window_ms > 0 &&
+                   (s->num_hops == 0 || s->hops_since_ble >= s->ble_every);
+
+    if (ble_due) {
+        s->hops_since_ble = 0;
+        out->radio       = SCHED_RADIO_BLE;
+        out->channel     = 0;
+        out->duration_ms = s->ble_window_ms;
+        out->hop         = NULL;
+    } else {
+        const sched_hop_t *hop = &s->hops[s->hop_idx];
+        s->hop_idx = (s->hop_idx + 1) % s->num_hops;
+        if (s->hops_since_ble < 0xFF) s->hops_since_ble++;
+        out->radio       = SCHED_RADIO_WIFI;
+        out->channel     = hop->channel;
+        out->duration_ms = hop->dwell_ms;
+        out->hop         = hop;
+    }
+
+    s->running       = true;
+    s->cur_radio     = out->radio;
+    s->slot_start_ms = now_ms;
+}
+
+void sched_stop(sched_t *s, uint32_t now_ms)
+{
+    account(s, now_ms);
+}
+
+uint16_t sched_duty_permille(const sched_t *s, sched_radio_t radio)
+{
+    uint64_t total = 0;
+    for (int r = 0; r < SCHED_NUM_RADIOS; r++) total += s->radio_ms[r];
+    if (total == 0) return 0;
+    return (uint16_t)(((uint64_t)s->radio_ms[radio] * 1000) / total);
+}
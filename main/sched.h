@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+ * Radio time-slicing scheduler.
+ *
+ * Hands out slots in turn: the Wi-Fi hops of the schedule, in order, with a
+ * BLE window after every `ble_every` of them. Each radio is charged the time
+ * its slots were actually held, from one sched_next() call to the next.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    SCHED_RADIO_WIFI = 0,
+    SCHED_RADIO_BLE  = 1,
+    SCHED_NUM_RADIOS
+} sched_radio_t;
+
+#define SCHED_MAX_HOPS      32
+#define SCHED_RSSI_ANY      (-128)      /* rssi_min that admits every frame */
+
+/*
+ * One Wi-Fi hop-schedule entry with the capture profile applied while the
+ * radio dwells on it.
+ */
+typedef struct {
+    uint8_t  channel;
+    uint16_t dwell_ms;
+    uint8_t  type_mask;         /* 0x01=mgmt 0x02=ctrl 0x04=data, 0 = all */
+    uint16_t mgmt_subtypes;     /* bit n admits mgmt subtype n, 0 = all */
+    uint16_t snaplen;           /* bytes of each frame forwarded, 0 = whole frame */
+    int8_t   rssi_min;          /* drop weaker frames; SCHED_RSSI_ANY = no gate */
+} sched_hop_t;
+
+/*
+ * Whether a hop's profile admits a frame, from the first frame-control byte
+ * and its RSSI. The driver-level type filter is applied separately.
+ */
+static inline bool sched_hop_admits(const sched_hop_t *hop, uint8_t fc0, int8_t rssi)
+{
+    if (rssi < hop->rssi_min) return false;
+    uint8_t type = (fc0 >> 2) & 0x03;
+    if (hop->type_mask && !(hop->type_mask & (1u << type))) return false;
+    if (type == 0 && hop->mgmt_subtypes && !(hop->mgmt_subtypes & (1u << (fc0 >> 4))))
+        return false;
+    return true;
+}
+
+/* what the radio should do next, and for how long */
+typedef struct {
+    sched_radio_t      radio;
+    uint8_t            channel;      /* Wi-Fi slots only */
+    uint32_t           duration_ms;
+    const sched_hop_t *hop;          /* Wi-Fi slots only: entry and its profile */
+} sched_slot_t;
+
+typedef struct {
+    const sched_hop_t *hops;
+    int                num_hops;
+    int                hop_idx;
+
+    uint16_t           ble_window_ms;   /* 0 = BLE disabled */
+    uint8_t            ble_every;       /* BLE window after every N Wi-Fi hops */
+    uint8_t            hops_since_ble;
+
+    /* duty-cycle accounting */
+    bool               running;
+    sched_radio_t      cur_radio;
+    uint32_t           slot_start_ms;
+    uint32_t           radio_ms[SCHED_NUM_RADIOS];
+} sched_t;
+
+/* Reset the scheduler to the start of the given hop table (not copied). */
+void sched_init(sched_t *s, const sched_hop_t *hops, int num_hops);
+
+/* Interleave a BLE window of window_ms after every `every` Wi-Fi hops. */
+void sched_set_ble(sched_t *s, uint16_t window_ms, uint8_t every);
+
+/*
+ * Close the current slot at now_ms (charging its time to its radio) and
+ * pick the next one.
+ */
+void sched_next(sched_t *s, uint32_t now_ms, sched_slot_t *out);
+
+/* Close the current slot without starting another. */
+void sched_stop(sched_t *s, uint32_t now_ms);
+
+/* Share of accounted radio time spent on `radio`, in permille. */
+uint16_t sched_duty_permille(const sched_t *s, sched_radio_t radio);
@@ -3,7 +3,10 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
+#include "esp_timer.h"
+#include <stdlib.h>
 #include <string.h>
+#include "sdkconfig.h"
 #include "protocol.h"
 
 /* -------- shared state (declared in protocol.h) -------- */
@@ -12,6 +15,8 @@ volatile bool     promisc_on      = false;
 volatile int      scan_channel    = -1;   /* -1 = all channels */
 volatile uint8_t  scan_filter     = 0;    /* 0 = all frame types */
 TaskHandle_t      scan_task_handle = NULL;
+volatile uint16_t ble_window_ms   = 0;    /* 0 = BLE scanning off */
+volatile uint8_t  ble_every       = 1;
 
 /* -------- channel table -------- */
 static const uint8_t channels[] = {
@@ -22,57 +27,391 @@ static const uint8_t channels[] = {
 };
 static const int num_channels = sizeof(channels) / sizeof(channels[0]);
 
-/* -------- packet handler -------- */
-static void wifi_sniffer_packet_handler(void *buf,
-                                        wifi_promiscuous_pkt_type_t type)
+#define SCAN_DWELL_MS   2500
+
+/* -------- scheduler (owned by scan_task) -------- */
+static sched_hop_t   hops[SCHED_MAX_HOPS];
+static sched_t       sched;
+static portMUX_TYPE  sched_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* custom schedule from MSG_CMD_SET_SCHEDULE (guarded by sched_mux) */
+static sched_hop_t   custom_hops[SCHED_MAX_HOPS];
+static int           num_custom_hops = 0;
+
+/*
+ * Hop whose capture profile the packet handler applies; NULL while the scan
+ * task is switching, so no frame is judged by a half-applied profile.
+ */
+static const sched_hop_t *volatile cur_hop = NULL;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void scan_get_radio_time(uint32_t *wifi_ms, uint32_t *ble_ms,
+                         uint16_t *wifi_permille, uint16_t *ble_permille)
+{
+    portENTER_CRITICAL(&sched_mux);
+    *wifi_ms      = sched.radio_ms[SCHED_RADIO_WIFI];
+    *ble_ms       = sched.radio_ms[SCHED_RADIO_BLE];
+    *wifi_permille = sched_duty_permille(&sched, SCHED_RADIO_WIFI);
+    *ble_permille  = sched_duty_permille(&sched, SCHED_RADIO_BLE);
+    portEXIT_CRITICAL(&sched_mux);
+}
+
+/* -------- deauth flood detector (fed by the packet handler) -------- */
+static deauth_det_t  deauth_det;
+static portMUX_TYPE  deauth_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* -------- MAC filter (swapped in by bulk upload) -------- */
+static macfilt_t     mac_filter;
+static portMUX_TYPE  mac_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void scan_set_mac_filter(const macfilt_t *f)
+{
+    macfilt_t old;
+    portENTER_CRITICAL(&mac_mux);
+    old = mac_filter;
+    mac_filter = *f;
+    portEXIT_CRITICAL(&mac_mux);
+    macfilt_free(&old);
+}
+
+/* -------- beacon classifier (swapped in by bulk upload) -------- */
+static clf_t         *clf;     /* heap, non-NULL once one was installed */
+static portMUX_TYPE   clf_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool  clf_on = false;
+
+bool scan_set_classifier(const clf_model_t *m)
+{
+    /* built outside the lock: the packet handler only waits for the swap */
+    clf_t *next = malloc(sizeof(*next));
+    if (!next) return false;
+    clf_configure(next, m);
+
+    portENTER_CRITICAL(&clf_mux);
+    clf_t *old = clf;
+    clf = next;
+    clf_on = m->kind != CLF_KIND_OFF;
+    portEXIT_CRITICAL(&clf_mux);
+    free(old);
+    return true;
+}
+
+void scan_set_deauth_config(const deauth_config_t *cfg)
+{
+    portENTER_CRITICAL(&deauth_mux);
+    deauth_configure(&deauth_det, cfg);
+    portEXIT_CRITICAL(&deauth_mux);
+}
+
+/* -------- channel-switch accounting -------- */
+static hopstat_t       hop_stats;
+static hopstat_guard_t hop_guard;
+static portMUX_TYPE    hop_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/* set by the scan task before cur_hop, read by the packet handler */
+static volatile uint32_t hop_switched_us;              /* esp_timer at the end of the last switch */
+static const sched_hop_t *volatile prev_hop = NULL;    /* hop before it, for HOP_GUARD_RELABEL */
+
+void scan_set_hop_guard(const hopstat_guard_t *g)
+{
+    portENTER_CRITICAL(&hop_mux);
+    hop_guard = *g;
+    portEXIT_CRITICAL(&hop_mux);
+}
+
+void scan_get_hop_stats(hopstat_t *out, hopstat_guard_t *g)
+{
+    portENTER_CRITICAL(&hop_mux);
+    *out = hop_stats;
+    *g   = hop_guard;
+    portEXIT_CRITICAL(&hop_mux);
+}
+
+/* -------- CSI reports (off unless enabled by CSI_CONFIG) -------- */
+#if CONFIG_ESP_WIFI_CSI_ENABLED
+
+static csi_t         csi;
+static portMUX_TYPE  csi_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool csi_on = false;
+
+static void wifi_csi_handler(void *ctx, wifi_csi_info_t *info)
+{
+    (void)ctx;
+    if (!csi_on || !scanning || !info || !info->buf || info->len == 0) return;
+
+    TRACE(TRACE_EV_CB_BEGIN, TRACE_CB_CSI);
+    uint16_t suppressed;
+    uint8_t bits;
+    portENTER_CRITICAL(&csi_mux);
+    bool pass = csi_matches(&csi.cfg, info->mac) &&
+                csi_admit(&csi, info->mac, now_ms(), &suppressed);
+    bits = csi.cfg.bits;
+    portEXIT_CRITICAL(&csi_mux);
+    if (pass) proto_send_csi(info, bits, suppressed);
+    TRACE(TRACE_EV_CB_END, TRACE_CB_CSI);
+}
+
+bool scan_set_csi(const csi_config_t *cfg, bool enable)
+{
+    csi_on = false;
+    portENTER_CRITICAL(&csi_mux);
+    csi_configure(&csi, cfg);
+    portEXIT_CRITICAL(&csi_mux);
+    if (!enable) return esp_wifi_set_csi(false) == ESP_OK;
+
+#if CONFIG_SOC_WIFI_HE_SUPPORT
+    wifi_csi_config_t csi_cfg = {
+        .enable             = 1,
+        .acquire_csi_legacy = 1,
+        .acquire_csi_ht20   = 1,
+        .acquire_csi_ht40   = 1,
+        .acquire_csi_su     = 1,
+    };
+#else
+    wifi_csi_config_t csi_cfg = {
+        .lltf_en           = true,
+        .htltf_en          = true,
+        .stbc_htltf2_en    = true,
+        .ltf_merge_en      = true,
+        .channel_filter_en = true,
+    };
+#endif
+    if (esp_wifi_set_csi_config(&csi_cfg) != ESP_OK ||
+        esp_wifi_set_csi_rx_cb(wifi_csi_handler, NULL) != ESP_OK ||
+        esp_wifi_set_csi(true) != ESP_OK) {
+        return false;
+    }
+    csi_on = true;
+    return true;
+}
+
+#else /* !CONFIG_ESP_WIFI_CSI_ENABLED */
+
+bool scan_set_csi(const csi_config_t *cfg, bool enable)
+{
+    (void)cfg;
+    return !enable;
+}
+
+#endif
+
+/* -------- active probing (sent by the scan task at each dwell start) -------- */
+static probe_t       probe;
+static portMUX_TYPE  probe_mux = portMUX_INITIALIZER_UNLOCKED;
+
+bool scan_set_probe(const probe_config_t *cfg)
+{
+    probe_config_t c = *cfg;
+    wifi_mode_t mode = cfg->rate ? WIFI_MODE_STA : WIFI_MODE_NULL;
+    wifi_mode_t cur;
+    if (esp_wifi_get_mode(&cur) != ESP_OK) return false;
+    if (cur != mode && esp_wifi_set_mode(mode) != ESP_OK) return false;
+    static const uint8_t zero[6];
+    if (cfg->rate && memcmp(c.src, zero, 6) == 0 &&
+        esp_wifi_get_mac(WIFI_IF_STA, c.src) != ESP_OK) {
+        return false;
+    }
+    portENTER_CRITICAL(&probe_mux);
+    probe_configure(&probe, &c, now_ms());
+    portEXIT_CRITICAL(&probe_mux);
+    return true;
+}
+
+/* Send this dwell's probe requests (from the scan task, on the new channel). */
+static void probe_send_dwell(uint8_t channel)
+{
+    if (probe.cfg.rate == 0) return;
+    static uint8_t frames[PROBE_MAX_SSIDS + 1][PROBE_MAX_FRAME];
+    size_t lens[PROBE_MAX_SSIDS + 1];
+    portENTER_CRITICAL(&probe_mux);
+    int n = probe_dwell(&probe, now_ms());
+    for (int i = 0; i < n; i++) lens[i] = probe_build(&probe, i, channel, frames[i]);
+    portEXIT_CRITICAL(&probe_mux);
+    for (int i = 0; i < n; i++) esp_wifi_80211_tx(WIFI_IF_STA, frames[i], (int)lens[i], true);
+}
+
+/* -------- capture path (capture.h), one variant per common configuration -------- */
+
+#define CAP_LOCK(name)      portENTER_CRITICAL(&name##_mux)
+#define CAP_UNLOCK(name)    portEXIT_CRITICAL(&name##_mux)
+#define CAP_NOW_US()        ((uint32_t)esp_timer_get_time())
+#define CAP_NOW_MS()        now_ms()
+#define CAP_SEND_FRAME(f, snaplen) \
+    proto_send_frame((f)->pkt, (wifi_promiscuous_pkt_type_t)(f)->type, (snaplen))
+#define CAP_SEND_ANOMALY(report, timestamp) \
+    proto_send_anomaly((report), (timestamp))
+#define CAP_SEND_DETECTION(f, label, x, confidence, suppressed) \
+    proto_send_detection((f)->pkt, (label), (x), (confidence), (suppressed))
+
+#include "capture.h"
+
+#define CAP_DEFINE(name, feats)                                                 \
+    static void capture_##name(void *buf, wifi_promiscuous_pkt_type_t type)    \
+    {                                                                           \
+        const wifi_promiscuous_pkt_t *pkt = buf;                                \
+        cap_frame_t f = {                                                       \
+            .payload   = pkt->payload,                                          \
+            .len       = pkt->rx_ctrl.sig_len,                                  \
+            .channel   = pkt->rx_ctrl.channel,                                  \
+            .rssi      = pkt->rx_ctrl.rssi,                                     \
+            .mgmt      = type == WIFI_PKT_MGMT,                                 \
+            .timestamp = pkt->rx_ctrl.timestamp,                                \
+            .pkt       = pkt,                                                   \
+            .type      = type,                                                  \
+        };                                                                      \
+        TRACE(TRACE_EV_CB_BEGIN, TRACE_CB_PROMISC);                             \
+        cap_run(&f, (feats));                                                   \
+        TRACE(TRACE_EV_CB_END, TRACE_CB_PROMISC);                               \
+    }
+CAP_VARIANTS(CAP_DEFINE)
+
+#define CAP_FEATS(name, feats)  (feats),
+#define CAP_CB(name, feats)     capture_##name,
+static const unsigned capture_feats[] = { CAP_VARIANTS(CAP_FEATS) };
+static const wifi_promiscuous_cb_t capture_cbs[] = { CAP_VARIANTS(CAP_CB) };
+#define CAP_NUM_VARIANTS    (int)(sizeof(capture_feats) / sizeof(capture_feats[0]))
+
+/*
+ * Install the first variant that covers the configuration (scan task, at
+ * every scan (re)start). Setters that turn a stage on or off restart a
+ * running scan to get here.
+ */
+static void capture_install(void)
+{
+    unsigned needed = cap_sched_features(hops, sched.num_hops);
+    if (deauth_det.cfg.threshold) needed |= CAP_DEAUTH;
+    if (clf_on) needed |= CAP_CLF;
+    if (mac_filter.mode != MACFILT_OFF) needed |= CAP_MACFILT;
+    esp_wifi_set_promiscuous_rx_cb(capture_cbs[cap_pick(capture_feats, CAP_NUM_VARIANTS, needed)]);
+}
+
+void scan_set_schedule(const sched_hop_t *new_hops, int n)
 {
-    const wifi_promiscuous_pkt_t *pkt = (wifi_promiscuous_pkt_t *)buf;
-    proto_send_frame(pkt, type);
+    if (n > SCHED_MAX_HOPS) n = SCHED_MAX_HOPS;
+    portENTER_CRITICAL(&sched_mux);
+    memcpy(custom_hops, new_hops, (size_t)n * sizeof(sched_hop_t));
+    num_custom_hops = n;
+    portEXIT_CRITICAL(&sched_mux);
 }
 
 /* -------- scan task -------- */
+
+static void default_hop(sched_hop_t *hop, uint8_t channel)
+{
+    hop->channel       = channel;
+    hop->dwell_ms      = SCAN_DWELL_MS;
+    hop->type_mask     = scan_filter;
+    hop->mgmt_subtypes = 0;
+    hop->snaplen       = 0;
+    hop->rssi_min      = SCHED_RSSI_ANY;
+}
+
+/*
+ * Build the hop table for the current scan_channel (or the custom schedule)
+ * and reset the scheduler. The packet handler must not be using hops[].
+ */
+static void sched_reset(void)
+{
+    int n;
+    portENTER_CRITICAL(&sched_mux);
+    if (scan_channel > 0) {
+        default_hop(&hops[0], (uint8_t)scan_channel);
+        n = 1;
+    } else if (num_custom_hops > 0) {
+        memcpy(hops, custom_hops, (size_t)num_custom_hops * sizeof(sched_hop_t));
+        n = num_custom_hops;
+    } else {
+        for (int i = 0; i < num_channels; i++) default_hop(&hops[i], channels[i]);
+        n = num_channels;
+    }
+    sched_init(&sched, hops, n);
+    sched_set_ble(&sched, ble_window_ms, ble_every);
+    portEXIT_CRITICAL(&sched_mux);
+}
+
 static void scan_task(void *arg)
 {
     (void)arg;
-    int ch_idx = 0;
+    bool restart = false;
 
     while (1) {
-        /* block until notified to start */
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-        ch_idx = 0;
-
-        if (scan_channel > 0) {
-            /* single-channel mode */
-            esp_wifi_set_channel((uint8_t)scan_channel, WIFI_SECOND_CHAN_NONE);
-
-            while (scanning) {
-                if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2500))) {
-                    /* re-notified: either restart or stop */
-                    if (!scanning) break;
-                    /* if still scanning, re-apply channel (may have changed) */
-                    if (scan_channel > 0) {
-                        esp_wifi_set_channel((uint8_t)scan_channel,
-                                             WIFI_SECOND_CHAN_NONE);
-                    } else {
-                        break; /* switched to all-channel mode, restart outer */
-                    }
+        /* block until notified to start (unless restarting a live scan) */
+        if (!restart) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        restart = false;
+        if (!scanning) continue;
+
+        cur_hop = NULL;
+        prev_hop = NULL;
+        sched_reset();
+        capture_install();
+        portENTER_CRITICAL(&hop_mux);
+        hopstat_reset(&hop_stats);
+        portEXIT_CRITICAL(&hop_mux);
+        uint8_t  cur_ch = 0;
+        uint32_t cur_mask = UINT32_MAX;   /* force the first driver filter update */
+        const sched_hop_t *last_hop = NULL;
+
+        while (scanning) {
+            sched_slot_t slot;
+            portENTER_CRITICAL(&sched_mux);
+            sched_next(&sched, now_ms(), &slot);
+            portEXIT_CRITICAL(&sched_mux);
+
+            if (slot.radio == SCHED_RADIO_WIFI && slot.hop != cur_hop) {
+                /* hold frames while channel and driver filter change together */
+                TRACE(TRACE_EV_HOP_BEGIN, slot.channel);
+                uint32_t t0 = (uint32_t)esp_timer_get_time();
+                cur_hop = NULL;
+                uint32_t mask = slot.hop->type_mask
+                                    ? slot.hop->type_mask
+                                    : (WIFI_PROMIS_FILTER_MASK_MGMT |
+                                       WIFI_PROMIS_FILTER_MASK_CTRL |
+                                       WIFI_PROMIS_FILTER_MASK_DATA);
+                /* the classifier sees beacons whatever the hop captures */
+                if (clf_on) mask |= WIFI_PROMIS_FILTER_MASK_MGMT;
+                if (mask != cur_mask) {
+                    wifi_promiscuous_filter_t filt = { .filter_mask = mask };
+                    esp_wifi_set_promiscuous_filter(&filt);
+                    cur_mask = mask;
                 }
-            }
-        } else {
-            /* all-channel mode */
-            while (scanning) {
-                uint8_t ch = channels[ch_idx];
-                esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
-                ch_idx = (ch_idx + 1) % num_channels;
-
-                if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2500))) {
-                    if (!scanning) break;
-                    /* re-notified while scanning: restart loop */
-                    break;
+                if (slot.channel != cur_ch) {
+                    esp_wifi_set_channel(slot.channel, WIFI_SECOND_CHAN_NONE);
+                    cur_ch = slot.channel;
+
+                    uint32_t t1 = (uint32_t)esp_timer_get_time();
+                    portENTER_CRITICAL(&hop_mux);
+                    hopstat_switch(&hop_stats, t1 - t0);
+                    portEXIT_CRITICAL(&hop_mux);
+                    prev_hop = last_hop;
+                    hop_switched_us = t1;
                 }
+                cur_hop = slot.hop;
+                last_hop = slot.hop;
+                TRACE(TRACE_EV_HOP_END, slot.channel);
+            } else if (slot.radio == SCHED_RADIO_BLE) {
+                ble_scan_window_start(slot.duration_ms);
+            }
+            if (slot.radio == SCHED_RADIO_WIFI) probe_send_dwell(slot.channel);
+
+            uint32_t notified =
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(slot.duration_ms));
+
+            if (slot.radio == SCHED_RADIO_BLE) ble_scan_window_stop();
+
+            if (notified) {
+                /* re-notified: stop, or restart with the new config */
+                restart = scanning;
+                break;
             }
         }
+
+        cur_hop = NULL;
+        portENTER_CRITICAL(&sched_mux);
+        sched_stop(&sched, now_ms());
+        portEXIT_CRITICAL(&sched_mux);
     }
 }
 
@@ -88,12 +427,17 @@ void app_main(void)
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_NULL));
     ESP_ERROR_CHECK(esp_wifi_start());
 
-    /* register promiscuous callback but don't enable yet */
-    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(wifi_sniffer_packet_handler));
+    deauth_init(&deauth_det);
+
+    /* register the generic capture path; scan start installs a specialized one */
+    ESP_ERROR_CHECK(esp_wifi_set_promiscuous_rx_cb(capture_generic));
 
     /* initialize binary protocol (USB serial, buffer pool, TX/RX tasks) */
     proto_init();
 
+    /* BLE host stack (no-op unless built with NimBLE) */
+    ble_init();
+
     /* create scan task */
     xTaskCreate(scan_task, "scan_task", 4096, NULL, 5, &scan_task_handle);
 }
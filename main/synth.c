@@ -0,0 +1,80 @@
+#include "synth.h"
+#include <string.h>
+
+static const uint8_t synth_hdr[SYNTH_HDR_LEN] = {
+    0x08, 0x02, 0x00, 0x00,                 /* data, from DS */
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,     /* addr1: broadcast */
+    0x02, 'S', 'Y', 'N', 'T', 0x00,         /* addr2: BSSID */
+    0x02, 'S', 'Y', 'N', 'T', 0x00,         /* addr3: SA */
+    0x00, 0x00,                             /* sequence control */
+};
+
+void synth_start(synth_t *s, const synth_config_t *cfg, uint64_t now_us)
+{
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    s->period_ns = cfg->rate ? 1000000000ull / cfg->rate : 0;
+    s->next_ns = now_us * 1000;
+    s->rng = 0x2545f491;
+}
+
+uint32_t synth_due(synth_t *s, uint64_t now_us, uint32_t *missed)
+{
+    *missed = 0;
+    uint64_t now_ns = now_us * 1000;
+    if (!s->cfg.rate || now_ns < s->next_ns) return 0;
+
+    uint64_t due = (now_ns - s->next_ns) / s->period_ns + 1;
+    if (s->cfg.count && due > s->cfg.count - s->offered) due = s->cfg.count - s->offered;
+    s->next_ns += due * s->period_ns;
+    s->offered += (uint32_t)due;
+    if (s->cfg.count && s->offered >= s->cfg.count) s->cfg.rate = 0;
+
+    uint64_t keep = (uint64_t)SYNTH_MAX_LAG_US * 1000 / s->period_ns + 1;
+    if (due > keep) {
+        *missed = (uint32_t)(due - keep);
+        due = keep;
+    }
+    return (uint32_t)due;
+}
+
+uint32_t synth_wait_us(const synth_t *s, uint64_t now_us)
+{
+    if (!s->cfg.rate) return UINT32_MAX;
+    uint64_t now_ns = now_us * 1000;
+    if (now_ns >= s->next_ns) return 0;
+    return (uint32_t)((s->next_ns - now_ns + 999) / 1000);
+}
+
+uint16_t synth_next(synth_t *s, uint32_t *n)
+{
+    /* xorshift32 */
+    uint32_t r = s->rng;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    s->rng = r;
+    *n = s->frames++;
+
+    const synth_config_t *c = &s->cfg;
+    switch (c->dist) {
+    case SYNTH_DIST_UNIFORM:
+        return c->len_min + r % (c->len_max - c->len_min + 1u);
+    case SYNTH_DIST_IMIX:
+        r %= 12;
+        if (r < 7) return c->len_min;
+        if (r < 11) return (c->len_min + c->len_max) / 2;
+        return c->len_max;
+    default:
+        return c->len_min;
+    }
+}
+
+void synth_fill(uint8_t *frame, uint16_t len, uint32_t n)
+{
+    memcpy(frame, synth_hdr, SYNTH_HDR_LEN);
+    frame[15] = frame[21] = (uint8_t)(n >> 12);
+    frame[22] = (uint8_t)(n << 4);
+    frame[23] = (uint8_t)(n >> 4);
+    memset(frame + SYNTH_HDR_LEN, (uint8_t)n, len - SYNTH_HDR_LEN);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/*
+ * Synthetic frame source for link benchmarks.
+ *
+ * Frames fall due at a fixed rate. A sender that was busy emits the ones
+ * that fell due in the last SYNTH_MAX_LAG_US back to back. Older ones are
+ * returned as missed, so a link that cannot keep up shows up as loss rather
+ * than as a quietly lower rate.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYNTH_HDR_LEN           24      /* 802.11 data header; the shortest frame */
+#define SYNTH_MAX_RATE          1000000 /* frames per second */
+#define SYNTH_MAX_LAG_US        20000   /* frames due longer ago than this are missed */
+
+/* length distributions */
+#define SYNTH_DIST_FIXED        0   /* always len_min */
+#define SYNTH_DIST_UNIFORM      1   /* uniform over len_min..len_max */
+#define SYNTH_DIST_IMIX         2   /* len_min, midpoint, len_max at 7:4:1 */
+
+typedef struct {
+    uint32_t rate;          /* frames per second; 0 = off */
+    uint32_t count;         /* frames to offer, then stop; 0 = until stopped */
+    uint16_t len_min;
+    uint16_t len_max;
+    uint8_t  dist;          /* SYNTH_DIST_* */
+} synth_config_t;
+
+typedef struct {
+    synth_config_t cfg;
+    uint64_t period_ns;
+    uint64_t next_ns;       /* when the next frame falls due */
+    uint32_t offered;       /* frames due so far, emitted or missed */
+    uint32_t frames;        /* frames emitted */
+    uint32_t rng;
+} synth_t;
+
+/* Start (or with cfg->rate == 0, stop) generating from now_us. */
+void synth_start(synth_t *s, const synth_config_t *cfg, uint64_t now_us);
+
+static inline bool synth_active(const synth_t *s)
+{
+    return s->cfg.rate != 0;
+}
+
+/*
+ * Frames to emit now. Frames due more than SYNTH_MAX_LAG_US ago are skipped
+ * and counted in *missed. Once cfg.count frames have been offered, the
+ * generator stops.
+ */
+uint32_t synth_due(synth_t *s, uint64_t now_us, uint32_t *missed);
+
+/* Microseconds until the next frame is due (UINT32_MAX when stopped). */
+uint32_t synth_wait_us(const synth_t *s, uint64_t now_us);
+
+/* Draw the next frame's length; *n receives its number. */
+uint16_t synth_next(synth_t *s, uint32_t *n);
+
+/*
+ * Write frame number n: a from-DS data frame from 02:53:59:4e:54:xx to
+ * broadcast, with the low 12 bits of n as its sequence number and the
+ * body filled with n's low byte.
+ */
+void synth_fill(uint8_t *frame, uint16_t len, uint32_t n);
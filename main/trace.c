@@ -0,0 +1,49 @@
+#include "trace.h"
+#include <string.h>
+
+void trace_clear(trace_t *t)
+{
+    __atomic_store_n(&t->head, 0, __ATOMIC_RELAXED);
+}
+
+void trace_put(trace_t *t, uint32_t ts, uint8_t ev, uint8_t ctx, uint16_t arg)
+{
+    uint32_t i = __atomic_fetch_add(&t->head, 1, __ATOMIC_RELAXED);
+    trace_rec_t *r = &t->recs[i & (TRACE_RING_LEN - 1)];
+    r->ts  = ts;
+    r->ev  = ev;
+    r->ctx = ctx;
+    r->arg = arg;
+}
+
+int trace_find_ctx(const trace_t *t, const void *task)
+{
+    for (int i = 0; i < t->num_ctx; i++)
+        if (t->tasks[i] == task) return i;
+    return -1;
+}
+
+uint8_t trace_add_ctx(trace_t *t, const void *task, const char *name)
+{
+    int i = trace_find_ctx(t, task);
+    if (i >= 0) return (uint8_t)i;
+    if (t->num_ctx >= TRACE_CTX_OTHER) return TRACE_CTX_OTHER;
+
+    i = t->num_ctx;
+    memset(t->names[i], 0, TRACE_NAME_LEN);
+    strncpy(t->names[i], name ? name : "?", TRACE_NAME_LEN - 1);
+    t->tasks[i] = task;
+    /* published last: a concurrent lookup sees the whole entry or none */
+    __atomic_store_n(&t->num_ctx, (uint8_t)(i + 1), __ATOMIC_RELEASE);
+    return (uint8_t)i;
+}
+
+uint32_t trace_read(const trace_t *t, uint32_t first, trace_rec_t *out, uint32_t max)
+{
+    uint32_t head = t->head;
+    uint32_t start = trace_lost(t) + first;
+    uint32_t n = 0;
+    for (uint32_t i = start; i < head && n < max; i++, n++)
+        out[n] = t->recs[i & (TRACE_RING_LEN - 1)];
+    return n;
+}
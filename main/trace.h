@@ -0,0 +1,96 @@
+#pragma once
+
+/*
+ * Event trace ring.
+ *
+ * Each record is 8 bytes: timestamp, event, the context (task) that
+ * recorded it and one argument. Writers claim slots with an atomic
+ * increment, so any task may record without a lock; the oldest records are
+ * overwritten once the ring is full. Contexts are numbered in the order
+ * they first record, up to TRACE_MAX_CTX, and their names go out with a
+ * dump so the host can label its tracks.
+ *
+ * Tracing is built in unless TRACE_BUILD is 0, and records nothing until
+ * turned on, so the cost of an idle trace point is one load and a branch.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TRACE_BUILD
+#define TRACE_BUILD             1
+#endif
+
+#define TRACE_RING_LEN          2048    /* records, a power of two (16 KB) */
+#define TRACE_MAX_CTX           16
+#define TRACE_NAME_LEN          16      /* bytes per context name, NUL padded */
+#define TRACE_CTX_OTHER         (TRACE_MAX_CTX - 1) /* every task past the table */
+
+/* events; a _BEGIN is closed by the _END of the same context */
+#define TRACE_EV_CB_BEGIN       1   /* arg: TRACE_CB_* */
+#define TRACE_EV_CB_END         2
+#define TRACE_EV_POOL_GET       3   /* arg: buffers left, TRACE_ARG_NONE if the pool was empty */
+#define TRACE_EV_POOL_PUT       4   /* arg: buffers free after */
+#define TRACE_EV_Q_SEND         5   /* arg: TX queue depth after, TRACE_ARG_NONE if it was full */
+#define TRACE_EV_Q_RECV         6   /* arg: TX queue depth after */
+#define TRACE_EV_USB_BEGIN      7   /* arg: message length */
+#define TRACE_EV_USB_END        8   /* arg: 1 if the write timed out */
+#define TRACE_EV_HOP_BEGIN      9   /* arg: channel */
+#define TRACE_EV_HOP_END        10  /* arg: channel */
+#define TRACE_EV_CMD_BEGIN      11  /* arg: command type */
+#define TRACE_EV_CMD_END        12  /* arg: command type */
+
+#define TRACE_ARG_NONE          0xFFFF
+
+/* callbacks for TRACE_EV_CB_BEGIN */
+#define TRACE_CB_PROMISC        0   /* promiscuous rx */
+#define TRACE_CB_CSI            1
+
+/* trace command actions */
+#define TRACE_OFF               0   /* stop recording */
+#define TRACE_ON                1   /* clear the ring and record */
+#define TRACE_DUMP              2   /* stop recording and send the ring */
+
+typedef struct {
+    uint32_t ts;            /* microseconds, wraps */
+    uint8_t  ev;            /* TRACE_EV_* */
+    uint8_t  ctx;
+    uint16_t arg;
+} trace_rec_t;
+
+_Static_assert(sizeof(trace_rec_t) == 8, "trace_rec_t must be 8 bytes");
+
+typedef struct {
+    trace_rec_t   recs[TRACE_RING_LEN];
+    uint32_t      head;     /* records written since the last clear */
+    const void   *tasks[TRACE_MAX_CTX];
+    char          names[TRACE_MAX_CTX][TRACE_NAME_LEN];
+    uint8_t       num_ctx;
+} trace_t;
+
+/* Drop every record (the context table is kept). */
+void trace_clear(trace_t *t);
+
+/* Record an event. Safe to call from several tasks at once. */
+void trace_put(trace_t *t, uint32_t ts, uint8_t ev, uint8_t ctx, uint16_t arg);
+
+/* Context of task, or -1 if it has not been added. */
+int trace_find_ctx(const trace_t *t, const void *task);
+
+/*
+ * Add task under name (cut to TRACE_NAME_LEN - 1) and return its context;
+ * TRACE_CTX_OTHER once the table is full. Callers serialize additions.
+ */
+uint8_t trace_add_ctx(trace_t *t, const void *task, const char *name);
+
+/* Records overwritten before they could be read. */
+static inline uint32_t trace_lost(const trace_t *t)
+{
+    return t->head > TRACE_RING_LEN ? t->head - TRACE_RING_LEN : 0;
+}
+
+/*
+ * Copy up to max records, oldest first, starting at the first'th record
+ * still in the ring. Returns the number copied. Writers must be stopped.
+ */
+uint32_t trace_read(const trace_t *t, uint32_t first, trace_rec_t *out, uint32_t max);